@@ -19,11 +19,15 @@
 #include <boost/foreach.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <Poco/File.h>
 #include <Poco/Path.h>
 
+#include <algorithm>
 #include <typeinfo>
 #include <iostream>
 #include <fstream>
+#include <mutex>
+#include <unordered_map>
 #include <boost/regex.hpp>
 #include <boost/filesystem.hpp>
 
@@ -93,144 +97,431 @@ static std::string filePathRelativeTo( const std::string &base, const std::strin
 	return ret;
 }
 
-static void setSpriteProperty( ds::ui::Sprite &sprite, ci::XmlTree::Attr &attr, const std::string &referer="" ) {
-	std::string property = attr.getName();
-	
-	// TODO: make these a map? or something for faster lookup?
+typedef std::function<void(ds::ui::Sprite&)> PropertyApplier;
+// Parse a property's value once and answer what sets it
+typedef std::function<PropertyApplier(const std::string &value, const std::string &referer)> PropertyCompiler;
+typedef std::function<ds::ui::Sprite*(ds::ui::SpriteEngine&)> SpriteCreator;
 
-	if ( property == "name" || property == "class") {
-		// Do nothing, these are handled elsewhere
+static float parseFloat( const std::string &s ) {
+	return std::stof( s );
+}
+
+// Answer an applier that only works on sprites of type T, and complains about the rest
+template <typename T>
+static PropertyApplier forType( const std::string &property, const std::function<void(T &)> &func ) {
+	return [property, func](ds::ui::Sprite &sprite) {
+		auto typed = dynamic_cast<T *>( &sprite );
+		if (typed) {
+			func( *typed );
+		} else {
+			DS_LOG_WARNING( "Trying to set incompatible attribute _" << property << "_ on sprite of type: " << typeid(sprite).name() );
+		}
+	};
+}
+
+static std::unordered_map<std::string, PropertyCompiler> buildPropertyCompilers() {
+	std::unordered_map<std::string, PropertyCompiler> m;
+
+	m["width"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const float f = parseFloat( v );
+		return [f](ds::ui::Sprite &sprite) { sprite.setSize( f, sprite.getHeight() ); };
+	};
+	m["height"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const float f = parseFloat( v );
+		return [f](ds::ui::Sprite &sprite) { sprite.setSize( sprite.getWidth(), f ); };
+	};
+	m["depth"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const float f = parseFloat( v );
+		return [f](ds::ui::Sprite &sprite) { sprite.setSizeAll( sprite.getWidth(), sprite.getHeight(), f ); };
+	};
+	m["size"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const ci::Vec3f vec = parseVector( v );
+		return [vec](ds::ui::Sprite &sprite) { sprite.setSize( vec.x, vec.y ); };
+	};
+	m["color"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const ci::ColorA c = parseColor( v );
+		return [c](ds::ui::Sprite &sprite) {
+			sprite.setTransparent( false );
+			sprite.setColorA( c );
+		};
+	};
+	m["opacity"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const float f = parseFloat( v );
+		return [f](ds::ui::Sprite &sprite) { sprite.setOpacity( f ); };
+	};
+	m["position"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const ci::Vec3f vec = parseVector( v );
+		return [vec](ds::ui::Sprite &sprite) { sprite.setPosition( vec ); };
+	};
+	m["rotation"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const ci::Vec3f vec = parseVector( v );
+		return [vec](ds::ui::Sprite &sprite) { sprite.setRotation( vec ); };
+	};
+	m["scale"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const ci::Vec3f vec = parseVector( v );
+		return [vec](ds::ui::Sprite &sprite) { sprite.setScale( vec ); };
+	};
+	m["center"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const ci::Vec3f vec = parseVector( v );
+		return [vec](ds::ui::Sprite &sprite) { sprite.setCenter( vec ); };
+	};
+	m["clipping"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const bool b = parseBoolean( v );
+		return [b](ds::ui::Sprite &sprite) { sprite.setClipping( b ); };
+	};
+	m["blend_mode"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const ds::ui::BlendMode mode = parseBlendMode( v );
+		return [mode](ds::ui::Sprite &sprite) { sprite.setBlendMode( mode ); };
+	};
+
+	// Text, MultilineText specific attributes
+	m["font"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		return forType<Text>( "font", [v](Text &text) {
+			auto cfg = text.getEngine().getEngineCfg().getText( v );
+			cfg.configure( text );
+		} );
+	};
+	m["resize_limit"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const ci::Vec3f vec = parseVector( v );
+		return forType<Text>( "resize_limit", [vec](Text &text) { text.setResizeLimit( vec.x, vec.y ); } );
+	};
+
+	// Image properties
+	m["filename"] = [](const std::string &v, const std::string &referer) -> PropertyApplier {
+		const std::string file = filePathRelativeTo( referer, v );
+		return forType<Image>( "filename", [file](Image &image) { image.setImageFile( file ); } );
+	};
+	m["src"] = m["filename"];
+
+	// Image Button properties
+	m["down_image"] = [](const std::string &v, const std::string &referer) -> PropertyApplier {
+		const std::string file = filePathRelativeTo( referer, v );
+		return forType<ImageButton>( "down_image", [file](ImageButton &image) { image.setHighImage( file ); } );
+	};
+	m["up_image"] = [](const std::string &v, const std::string &referer) -> PropertyApplier {
+		const std::string file = filePathRelativeTo( referer, v );
+		return forType<ImageButton>( "up_image", [file](ImageButton &image) { image.setNormalImage( file ); } );
+	};
+	m["btn_touch_padding"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const float f = parseFloat( v );
+		return forType<ImageButton>( "btn_touch_padding", [f](ImageButton &image) { image.setTouchPad( f ); } );
+	};
+
+	// Gradient sprite properties
+	m["colorTop"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const ci::ColorA c = parseColor( v );
+		return forType<GradientSprite>( "colorTop", [c](GradientSprite &gradient) { gradient.setColorsV( c, gradient.getColorBL() ); } );
+	};
+	m["colorBot"] = [](const std::string &v, const std::string &) -> PropertyApplier {
+		const ci::ColorA c = parseColor( v );
+		return forType<GradientSprite>( "colorBot", [c](GradientSprite &gradient) { gradient.setColorsV( gradient.getColorTL(), c ); } );
+	};
+
+	return m;
+}
+
+static const std::unordered_map<std::string, PropertyCompiler> PROPERTY_COMPILERS = buildPropertyCompilers();
+
+static PropertyApplier compileProperty( const std::string &property, const std::string &value, const std::string &referer ) {
+	auto found = PROPERTY_COMPILERS.find( property );
+	if (found == PROPERTY_COMPILERS.end()) {
+		DS_LOG_WARNING( "Unknown Sprite property: " << property << " in " << referer );
+		return nullptr;
 	}
-	else if ( property == "width" ) {
-		sprite.setSize( attr.getValue<float>(), sprite.getHeight() );
+	try {
+		return found->second( value, referer );
+	} catch (std::exception &e) {
+		DS_LOG_WARNING( "Bad value for Sprite property: " << property << "=" << value << " in " << referer << " ex=" << e.what() );
 	}
-	else if ( property == "height" ) {
-		sprite.setSize( sprite.getWidth(), attr.getValue<float>() );
+	return nullptr;
+}
+
+// Answer nothing for types the custom importer has to make
+static SpriteCreator compileCreator( const std::string &type, const std::string &content ) {
+	if (type == "sprite") {
+		return [](ds::ui::SpriteEngine &engine) -> ds::ui::Sprite* { return new ds::ui::Sprite(engine); };
 	}
-	else if ( property == "depth" ) {
-		sprite.setSizeAll( sprite.getWidth(), sprite.getHeight(), attr.getValue<float>() );
+	else if (type == "image") {
+		// The file is set as a property
+		return [](ds::ui::SpriteEngine &engine) -> ds::ui::Sprite* { return new ds::ui::Image(engine); };
 	}
-	else if ( property == "size" ) {
-		ci::Vec3f v = parseVector( attr.getValue() );
-		sprite.setSize( v.x, v.y );
+	else if (type == "text") {
+		return [content](ds::ui::SpriteEngine &engine) -> ds::ui::Sprite* {
+			auto text = new ds::ui::Text(engine);
+			text->setText(content);
+			return text;
+		};
 	}
-	else if ( property == "color" ) {
-		sprite.setTransparent( false );
-		sprite.setColorA( parseColor(attr.getValue()) );
+	else if (type == "multiline_text") {
+		return [content](ds::ui::SpriteEngine &engine) -> ds::ui::Sprite* {
+			auto text = new ds::ui::MultilineText(engine);
+			text->setText(content);
+			return text;
+		};
 	}
-	else if ( property == "opacity" ) {
-		sprite.setOpacity( attr.getValue<float>() );
+	else if (type == "image_button") {
+		float touchPad = 0.0f;
+		if (content.size() > 0) touchPad = (float)atof(content.c_str());
+		return [touchPad](ds::ui::SpriteEngine &engine) -> ds::ui::Sprite* { return new ds::ui::ImageButton(engine, "", "", touchPad); };
 	}
-	else if ( property == "position" ) {
-		sprite.setPosition( parseVector( attr.getValue() ) );
+	else if (type == "gradient") {
+		return [](ds::ui::SpriteEngine &engine) -> ds::ui::Sprite* { return new ds::ui::GradientSprite(engine); };
 	}
-	else if ( property == "rotation" ) {
-		sprite.setRotation( parseVector( attr.getValue() ) );
-	} 
-	else if(property == "scale") {
-		sprite.setScale(parseVector(attr.getValue()));
+	return nullptr;
+}
+
+static void addProperty( XmlImporter::Template::Node &node, const std::string &name, const std::string &value, const std::string &referer ) {
+	XmlImporter::Template::Property prop;
+	prop.mName = name;
+	prop.mValue = value;
+	prop.mReferer = referer;
+	prop.mApply = compileProperty( name, value, referer );
+	node.mProperties.push_back( prop );
+}
+
+static void compileNode( ci::XmlTree &xml, const std::vector<Stylesheet*> &stylesheets, const std::string &xmlFile, XmlImporter::Template::Node &node ) {
+	node.mType = xml.getTag();
+	node.mContent = xml.getValue();
+	boost::trim( node.mContent );
+	node.mName = xml.getAttributeValue<std::string>( "name", "" );
+	node.mCreate = compileCreator( node.mType, node.mContent );
+	if (!node.mCreate) node.mXml = std::make_shared<ci::XmlTree>( xml );
+
+	if (node.mType == "image" && node.mContent != "") {
+		addProperty( node, "filename", node.mContent, "" );
 	}
-	else if ( property == "center" ) {
-		sprite.setCenter( parseVector( attr.getValue() ) );
+
+	// Apply stylesheet(s)
+	const auto classes = ds::split( xml.getAttributeValue<std::string>( "class", "" ), " ", true );
+	std::vector<size_t> rules;
+	BOOST_FOREACH( auto stylesheet, stylesheets ) {
+		stylesheet->matchRules( node.mName, classes, rules );
+		BOOST_FOREACH( auto i, rules ) {
+			BOOST_FOREACH( auto &prop, stylesheet->mRules[i].properties ) {
+				addProperty( node, prop.property_name, prop.property_value, stylesheet->mReferer );
+			}
+		}
 	}
-	else if ( property == "clipping" ) {
-		sprite.setClipping( parseBoolean( attr.getValue() ) );
+
+	// Set properties from xml attributes, overwriting those from the stylesheet(s)
+	BOOST_FOREACH( auto &attr, xml.getAttributes() ) {
+		const std::string &name = attr.getName();
+		// Handled above
+		if (name == "name" || name == "class") continue;
+		addProperty( node, name, attr.getValue(), xmlFile );
 	}
-	else if ( property == "blend_mode" ) {
-		sprite.setBlendMode( parseBlendMode( attr.getValue() ) );
+
+	BOOST_FOREACH( auto &child, xml.getChildren() ) {
+		node.mChildren.push_back( XmlImporter::Template::Node() );
+		compileNode( *child, stylesheets, xmlFile, node.mChildren.back() );
 	}
+}
 
-	// Text, MultilineText specific attributes
-	else if ( property == "font" ) {
-		// Try to set the font
-		auto text = dynamic_cast<Text *>( &sprite );
-		if (text) {
-			auto cfg = text->getEngine().getEngineCfg().getText(attr.getValue());
-			cfg.configure(*text);
-		}
-		else {
-			DS_LOG_WARNING( "Trying to set incompatible attribute _" << property << "_ on sprite of type: " << typeid(sprite).name() );
-		}
+// Fill in what can't be written to a file
+static void resolveNode( XmlImporter::Template::Node &node ) {
+	node.mCreate = compileCreator( node.mType, node.mContent );
+	BOOST_FOREACH( auto &prop, node.mProperties ) {
+		prop.mApply = compileProperty( prop.mName, prop.mValue, prop.mReferer );
 	}
-	else if (property == "resize_limit" ) {
-		// Try to set the resize limit
-		auto text = dynamic_cast<Text *>( &sprite );
-		if (text) {
-			auto v = parseVector( attr.getValue() );
-			text->setResizeLimit( v.x, v.y );
-		}
-		else {
-			DS_LOG_WARNING( "Trying to set incompatible attribute _" << property << "_ on sprite of type: " << typeid(sprite).name() );
-		}
+	BOOST_FOREACH( auto &child, node.mChildren ) {
+		resolveNode( child );
 	}
+}
 
-	// Image properties
-	else if (property == "filename" || property == "src") {
-		auto image = dynamic_cast<Image *>( &sprite );
-		if (image) {
-			image->setImageFile( filePathRelativeTo( referer, attr.getValue() ) );
-		}
-		else {
-			DS_LOG_WARNING( "Trying to set incompatible attribute _" << property << "_ on sprite of type: " << typeid(sprite).name() );
-		}
+static bool hasCustomTypes( const std::vector<XmlImporter::Template::Node> &nodes ) {
+	BOOST_FOREACH( auto &node, nodes ) {
+		if (!node.mCreate || hasCustomTypes( node.mChildren )) return true;
 	}
+	return false;
+}
 
+static int64_t lastModified( const std::string &filename ) {
+	try {
+		return Poco::File( filename ).getLastModified().epochMicroseconds();
+	} catch (std::exception const&) {
+	}
+	return -1;
+}
 
-	// Image Button properties
-	else if(property == "down_image") {
-		auto image = dynamic_cast<ImageButton *>(&sprite);
-		if(image) {
-			image->setHighImage(filePathRelativeTo(referer, attr.getValue()));
-		} else {
-			DS_LOG_WARNING("Trying to set incompatible attribute _" << property << "_ on sprite of type: " << typeid(sprite).name());
-		}
+// True if nothing the template was compiled from has changed
+static bool isCurrent( const XmlImporter::Template &t ) {
+	BOOST_FOREACH( auto &source, t.mSources ) {
+		if (lastModified( source.first ) != source.second) return false;
 	}
-	else if(property == "up_image") {
-		auto image = dynamic_cast<ImageButton *>(&sprite);
-		if(image) {
-			image->setNormalImage(filePathRelativeTo(referer, attr.getValue()));
-		} else {
-			DS_LOG_WARNING("Trying to set incompatible attribute _" << property << "_ on sprite of type: " << typeid(sprite).name());
-		}
-	} 
-	else if(property == "btn_touch_padding") {
-		auto image = dynamic_cast<ImageButton *>(&sprite);
-		if(image) {
-			image->setTouchPad(attr.getValue<float>());
-		} else {
-			DS_LOG_WARNING("Trying to set incompatible attribute _" << property << "_ on sprite of type: " << typeid(sprite).name());
-		}
+	return true;
+}
+
+namespace {
+// 'DSXT', little endian
+const uint32_t			TEMPLATE_MAGIC = 0x54585344;
+const uint32_t			TEMPLATE_VERSION = 1;
+// Anything bigger is a corrupt file. Counts are checked too, and lists
+// are still read an element at a time, so a bad count can't allocate
+// more than the file actually holds.
+const uint32_t			MAX_STRING_SIZE = 16 * 1024 * 1024;
+const uint32_t			MAX_SOURCES = 4 * 1024;
+const uint32_t			MAX_PROPERTIES = 4 * 1024;
+const uint32_t			MAX_NODES = 64 * 1024;
+const int				MAX_DEPTH = 256;
+// Reserved up front, so a good file rarely copies what it has already read
+const uint32_t			RESERVE_LIMIT = 256;
+
+// Templates compiled by loadXMLto(filename), so loading the same layout again
+// only checks its files' times
+std::mutex				TEMPLATE_CACHE_MUTEX;
+std::unordered_map<std::string, std::shared_ptr<const XmlImporter::Template>>
+						TEMPLATE_CACHE;
+
+void					writeString( std::ostream &os, const std::string &s ) {
+	const uint32_t		size = static_cast<uint32_t>(s.size());
+	os.write( reinterpret_cast<const char*>(&size), sizeof(size) );
+	if (size > 0) os.write( s.data(), size );
+}
+
+bool					readString( std::istream &is, std::string &s ) {
+	uint32_t			size = 0;
+	is.read( reinterpret_cast<char*>(&size), sizeof(size) );
+	if (!is.good() || size > MAX_STRING_SIZE) return false;
+	s.resize( size );
+	if (size > 0) is.read( &s[0], size );
+	return is.good();
+}
+
+void					writeCount( std::ostream &os, const size_t count ) {
+	const uint32_t		n = static_cast<uint32_t>(count);
+	os.write( reinterpret_cast<const char*>(&n), sizeof(n) );
+}
+
+bool					readCount( std::istream &is, uint32_t &n, const uint32_t max ) {
+	is.read( reinterpret_cast<char*>(&n), sizeof(n) );
+	return is.good() && n <= max;
+}
+
+void					writeNode( std::ostream &os, const XmlImporter::Template::Node &node ) {
+	writeString( os, node.mType );
+	writeString( os, node.mName );
+	writeString( os, node.mContent );
+	writeCount( os, node.mProperties.size() );
+	BOOST_FOREACH( auto &prop, node.mProperties ) {
+		writeString( os, prop.mName );
+		writeString( os, prop.mValue );
+		writeString( os, prop.mReferer );
+	}
+	writeCount( os, node.mChildren.size() );
+	BOOST_FOREACH( auto &child, node.mChildren ) {
+		writeNode( os, child );
 	}
+}
 
-	// Gradient sprite properties
-	else if(property == "colorTop"){
-		auto gradient = dynamic_cast<GradientSprite*>(&sprite);
-		if(gradient){
-			gradient->setColorsV(parseColor(attr.getValue()), gradient->getColorBL());
-		} else {
-			DS_LOG_WARNING("Trying to set incompatible attribute _" << property << "_ on sprite of type: " << typeid(sprite).name());
-		}
-	} else if(property == "colorBot"){
-		auto gradient = dynamic_cast<GradientSprite*>(&sprite);
-		if(gradient){
-			gradient->setColorsV(gradient->getColorTL(), parseColor(attr.getValue()));
-		} else {
-			DS_LOG_WARNING("Trying to set incompatible attribute _" << property << "_ on sprite of type: " << typeid(sprite).name());
-		}
+bool					readNode( std::istream &is, XmlImporter::Template::Node &node, const int depth ) {
+	uint32_t			count = 0;
+	if (depth > MAX_DEPTH) return false;
+	if (!readString( is, node.mType ) || !readString( is, node.mName ) || !readString( is, node.mContent )) return false;
+	if (!readCount( is, count, MAX_PROPERTIES )) return false;
+	node.mProperties.reserve( std::min( count, RESERVE_LIMIT ) );
+	for (uint32_t k=0; k<count; ++k) {
+		node.mProperties.push_back( XmlImporter::Template::Property() );
+		auto&			prop = node.mProperties.back();
+		if (!readString( is, prop.mName ) || !readString( is, prop.mValue ) || !readString( is, prop.mReferer )) return false;
+	}
+	if (!readCount( is, count, MAX_NODES )) return false;
+	node.mChildren.reserve( std::min( count, RESERVE_LIMIT ) );
+	for (uint32_t k=0; k<count; ++k) {
+		node.mChildren.push_back( XmlImporter::Template::Node() );
+		if (!readNode( is, node.mChildren.back(), depth + 1 )) return false;
 	}
+	return true;
+}
+}
 
-	else {
-		DS_LOG_WARNING("Unknown Sprite property: " << property << " in " << referer);
+/**
+ * \class ds::ui::XmlImporter::Template
+ */
+XmlImporter::Template::Template() {
+}
+
+bool XmlImporter::Template::empty() const {
+	return mNodes.empty();
+}
+
+bool XmlImporter::Template::write( const std::string &filename ) const {
+	if (hasCustomTypes( mNodes )) {
+		DS_LOG_WARNING( "XmlImporter::Template::write() can't write custom sprite types from " << mFilename );
+		return false;
 	}
+	try {
+		// Write beside and rename, so a reader never sees a partial file
+		const std::string	tmp( filename + ".tmp" );
+		{
+			std::ofstream	os( tmp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+			if (!os.is_open()) return false;
+			const uint32_t	header[2] = { TEMPLATE_MAGIC, TEMPLATE_VERSION };
+			os.write( reinterpret_cast<const char*>(header), sizeof(header) );
+			writeString( os, mFilename );
+			writeCount( os, mSources.size() );
+			BOOST_FOREACH( auto &source, mSources ) {
+				writeString( os, source.first );
+				os.write( reinterpret_cast<const char*>(&source.second), sizeof(source.second) );
+			}
+			writeCount( os, mNodes.size() );
+			BOOST_FOREACH( auto &node, mNodes ) {
+				writeNode( os, node );
+			}
+			if (!os.good()) return false;
+		}
+		Poco::File			dst( filename );
+		if (dst.exists()) dst.remove();
+		Poco::File( tmp ).renameTo( filename );
+		return true;
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING( "XmlImporter::Template::write() failed on " << filename << " ex=" << ex.what() );
+	}
+	return false;
 }
 
-XmlImporter::~XmlImporter() {
-	BOOST_FOREACH( auto s, mStylesheets ) {
-		delete s;
+bool XmlImporter::Template::read( const std::string &filename ) {
+	try {
+		std::ifstream		is( filename.c_str(), std::ios::in | std::ios::binary );
+		if (!is.is_open()) return false;
+		uint32_t			header[2] = { 0, 0 };
+		is.read( reinterpret_cast<char*>(header), sizeof(header) );
+		if (!is.good() || header[0] != TEMPLATE_MAGIC || header[1] != TEMPLATE_VERSION) return false;
+
+		Template			t;
+		uint32_t			count = 0;
+		if (!readString( is, t.mFilename ) || !readCount( is, count, MAX_SOURCES )) return false;
+		for (uint32_t k=0; k<count; ++k) {
+			std::pair<std::string, int64_t>	source( std::string(), 0 );
+			if (!readString( is, source.first )) return false;
+			is.read( reinterpret_cast<char*>(&source.second), sizeof(source.second) );
+			if (!is.good()) return false;
+			t.mSources.push_back( source );
+		}
+		// Stale if anything it was compiled from has changed
+		if (!isCurrent( t )) return false;
+		if (!readCount( is, count, MAX_NODES )) return false;
+		t.mNodes.reserve( std::min( count, RESERVE_LIMIT ) );
+		for (uint32_t k=0; k<count; ++k) {
+			t.mNodes.push_back( Node() );
+			if (!readNode( is, t.mNodes.back(), 0 )) {
+				DS_LOG_WARNING( "XmlImporter::Template::read() bad file " << filename );
+				return false;
+			}
+			resolveNode( t.mNodes.back() );
+		}
+		*this = std::move( t );
+		return true;
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING( "XmlImporter::Template::read() failed on " << filename << " ex=" << ex.what() );
 	}
+	return false;
 }
 
-bool XmlImporter::preloadXml(const std::string& filename, XmlPreloadData& outData){
+/**
+ * \class ds::ui::XmlImporter
+ */
+// Read the xml and the stylesheets it links to
+static bool readXmlAndStylesheets( const std::string& filename, XmlImporter::XmlPreloadData& outData ) {
 	outData.mFilename = filename;
 	try {
 		outData.mXmlTree = ci::XmlTree(cinder::loadFile(filename));
@@ -273,189 +564,143 @@ bool XmlImporter::preloadXml(const std::string& filename, XmlPreloadData& outDat
 	return true;
 }
 
-bool XmlImporter::loadXMLto( ds::ui::Sprite* parent, const std::string& filename, NamedSpriteMap &map, SpriteImporter customImporter ) {
-
-	XmlImporter xmlImporter( parent, filename, map, customImporter );
-
-	// Here you could look up your preloaded stuff from a static cache based on filename
-
-	XmlPreloadData preloadData;
-	preloadData.mFilename = filename;
-	if(!preloadXml(filename, preloadData)){
+bool XmlImporter::preloadXml(const std::string& filename, XmlPreloadData& outData){
+	if(!readXmlAndStylesheets(filename, outData)){
 		return false;
 	}
 
-	// copy each stylesheet, cause the xml importer will delete it's copies when it destructs
-	for(auto it = preloadData.mStylesheets.begin(); it < preloadData.mStylesheets.end(); ++it){
-		Stylesheet* ss = new Stylesheet();
-		ss->mRules = (*it)->mRules;
-		ss->mReferer = (*it)->mReferer;
-		xmlImporter.mStylesheets.push_back(ss);
+	auto compiled = std::make_shared<Template>();
+	if(compileXml(outData.mXmlTree, outData.mStylesheets, filename, *compiled)){
+		outData.mTemplate = compiled;
 	}
-
-	return xmlImporter.load(preloadData.mXmlTree);
+	return true;
 }
 
-bool XmlImporter::loadXMLto(ds::ui::Sprite * parent, XmlPreloadData& preloadData, NamedSpriteMap &map, SpriteImporter customImporter){
-	XmlImporter xmlImporter(parent, preloadData.mFilename, map, customImporter);
+bool XmlImporter::compileXml(const std::string& filename, Template& outTemplate){
+	XmlPreloadData preloadData;
+	const bool ok = readXmlAndStylesheets(filename, preloadData)
+			&& compileXml(preloadData.mXmlTree, preloadData.mStylesheets, filename, outTemplate);
 
-	// copy each stylesheet, cause the xml importer will delete it's copies when it destructs
-	for(auto it = preloadData.mStylesheets.begin(); it < preloadData.mStylesheets.end(); ++it){
-		Stylesheet* ss = new Stylesheet();
-		ss->mRules = (*it)->mRules;
-		ss->mReferer = (*it)->mReferer;
-		xmlImporter.mStylesheets.push_back(ss);
+	BOOST_FOREACH(auto s, preloadData.mStylesheets) {
+		delete s;
 	}
-
-	return xmlImporter.load(preloadData.mXmlTree);
+	return ok;
 }
 
+bool XmlImporter::compileXml(ci::XmlTree& xml, const std::vector<Stylesheet*>& stylesheets, const std::string& filename, Template& outTemplate){
+	outTemplate = Template();
+	outTemplate.mFilename = filename;
 
-bool XmlImporter::load( ci::XmlTree &xml ) {
 	if (!xml.hasChild("interface")) {
-		DS_LOG_WARNING( "No interface found in xml file: " << mXmlFile );
+		DS_LOG_WARNING( "No interface found in xml file: " << filename );
 		return false;
 	}
 
 	auto interface = xml.getChild( "interface" );
 	auto& sprites = interface.getChildren();
-	int count = sprites.size();
-	if ( count < 1 ) {
-		DS_LOG_WARNING( "No sprites found in xml file: " << mXmlFile );
+	if ( sprites.empty() ) {
+		DS_LOG_WARNING( "No sprites found in xml file: " << filename );
 		return false;
 	}
 
-	BOOST_FOREACH( auto &xmlNode, sprites ) {
-		readSprite(mTargetSprite, xmlNode );
+	outTemplate.mSources.push_back(std::make_pair(filename, lastModified(filename)));
+	BOOST_FOREACH( auto stylesheet, stylesheets ) {
+		outTemplate.mSources.push_back(std::make_pair(stylesheet->mFilename, lastModified(stylesheet->mFilename)));
 	}
 
+	BOOST_FOREACH( auto &xmlNode, sprites ) {
+		outTemplate.mNodes.push_back(Template::Node());
+		compileNode(*xmlNode, stylesheets, filename, outTemplate.mNodes.back());
+	}
 	return true;
 }
 
-struct SelectorMatchChecker : public boost::static_visitor<bool> {
-	SelectorMatchChecker( const std::vector< std::string > &classesToCheck, const std::string &idToCheck )
-		: mClassesToCheck(classesToCheck)
-		, mIdToCheck(idToCheck)
-	{}
-	bool operator()(const ds::ui::stylesheets::IdSelector &s) const {
-		return mIdToCheck == s.selector;
-	}
-	bool operator()(const ds::ui::stylesheets::ClassSelector &s) const {
-		return (std::find( mClassesToCheck.begin(), mClassesToCheck.end(), s.selector ) != mClassesToCheck.end() );
-	}
-
-	const std::vector<std::string> &mClassesToCheck;
-	const std::string &mIdToCheck;
-};
-
-static void applyStylesheet( const Stylesheet &stylesheet, ds::ui::Sprite &sprite, const std::string &name, const std::string &classes ) {
-	BOOST_FOREACH( auto &rule, stylesheet.mRules ) {
-		auto classes_vec = ds::split(classes, " ", true );
-		bool matches_rule = false;
-		BOOST_FOREACH( auto &matcher, rule.matchers ) {
-
-			// Iterate through .class_rules and #name(id)_rules
-			// ALL the sub-matchers have to match for this matcher to match
-			bool all_submatchers_match = true;
-			BOOST_FOREACH( auto &selector, matcher ) {
-				if (! boost::apply_visitor( SelectorMatchChecker(classes_vec, name), selector) ) {
-					all_submatchers_match = false;
-					break;
-				}
-			}
-			matches_rule = all_submatchers_match;
-			if (matches_rule) break;
+bool XmlImporter::loadXMLto( ds::ui::Sprite* parent, const std::string& filename, NamedSpriteMap &map, SpriteImporter customImporter ) {
+	std::shared_ptr<const Template> compiled;
+	{
+		std::lock_guard<std::mutex> lock(TEMPLATE_CACHE_MUTEX);
+		auto found = TEMPLATE_CACHE.find(filename);
+		if(found != TEMPLATE_CACHE.end()) compiled = found->second;
+	}
+	// Checked unlocked; the files are what's slow
+	if(!compiled || !isCurrent(*compiled)){
+		auto fresh = std::make_shared<Template>();
+		const bool ok = compileXml(filename, *fresh);
+		std::lock_guard<std::mutex> lock(TEMPLATE_CACHE_MUTEX);
+		if(!ok){
+			TEMPLATE_CACHE.erase(filename);
+			return false;
 		}
+		TEMPLATE_CACHE[filename] = fresh;
+		compiled = fresh;
+	}
+	return loadXMLto(parent, *compiled, map, customImporter);
+}
 
-		if (matches_rule) {
-			BOOST_FOREACH( auto &prop, rule.properties ) {
-				cinder::XmlTree::Attr attr(nullptr, prop.property_name, prop.property_value );
-				setSpriteProperty( sprite, attr, stylesheet.mReferer );
-			}
+bool XmlImporter::loadXMLto(ds::ui::Sprite * parent, XmlPreloadData& preloadData, NamedSpriteMap &map, SpriteImporter customImporter){
+	// Compile once, if it wasn't preloaded
+	if(!preloadData.mTemplate){
+		auto compiled = std::make_shared<Template>();
+		if(!compileXml(preloadData.mXmlTree, preloadData.mStylesheets, preloadData.mFilename, *compiled)){
+			return false;
 		}
+		preloadData.mTemplate = compiled;
 	}
+	return loadXMLto(parent, *preloadData.mTemplate, map, customImporter);
 }
-bool XmlImporter::readSprite(ds::ui::Sprite* parent, std::unique_ptr<ci::XmlTree>& node) {
-	std::string type = node->getTag();
 
-	ds::ui::Sprite* spriddy = nullptr;
+bool XmlImporter::loadXMLto(ds::ui::Sprite * parent, const Template& compiled, NamedSpriteMap &map, SpriteImporter customImporter){
+	XmlImporter xmlImporter(parent, compiled.mFilename, map, customImporter);
+	return xmlImporter.load(compiled);
+}
 
-	auto &engine = parent->getEngine();
-	if (type == "sprite") {
-		spriddy = new ds::ui::Sprite(engine);
-	}
-	else if (type == "image") {
-		auto image = new ds::ui::Image(engine);
-		std::string relative_file = node->getValue();
-		boost::trim(relative_file);
-		if (relative_file != "") {
-			setSpriteProperty(*image, ci::XmlTree::Attr(nullptr, "filename", relative_file));
-		}
-		spriddy = image;
-	}
-	else if (type == "text") {
-		auto text = new ds::ui::Text(engine);
-		auto content = node->getValue();
-		boost::trim(content);
-		text->setText(content);
-		spriddy = text;
+bool XmlImporter::load( const Template &compiled ) {
+	if ( compiled.empty() ) {
+		DS_LOG_WARNING( "No sprites found in xml file: " << mXmlFile );
+		return false;
 	}
-	else if (type == "multiline_text") {
-		auto text = new ds::ui::MultilineText(engine);
-		auto content = node->getValue();
-		boost::trim(content);
-		text->setText(content);
-		spriddy = text;
-	}
-	else if(type == "image_button") {
-		auto content = node->getValue();
-		boost::trim(content);
-		float touchPad = 0.0f;
-		if(content.size() > 0) touchPad = (float)atof(content.c_str());
-		auto imgButton = new ds::ui::ImageButton(engine, "", "", touchPad);
-		spriddy = imgButton;
+
+	BOOST_FOREACH( auto &node, compiled.mNodes ) {
+		readSprite(mTargetSprite, node );
 	}
-	else if(type == "gradient"){
-		auto gradient = new ds::ui::GradientSprite(engine);
-		spriddy = gradient;
+
+	return true;
+}
+
+bool XmlImporter::readSprite(ds::ui::Sprite* parent, const Template::Node& node) {
+	ds::ui::Sprite* spriddy = nullptr;
+
+	if (node.mCreate) {
+		spriddy = node.mCreate(parent->getEngine());
 	}
-	else if (mCustomImporter) {
-		spriddy = mCustomImporter(type, *node);
+	else if (mCustomImporter && node.mXml) {
+		spriddy = mCustomImporter(node.mType, *node.mXml);
 	}
 
 	if (!spriddy) {
-		DS_LOG_WARNING("Error creating sprite! Type=" << type);
+		DS_LOG_WARNING("Error creating sprite! Type=" << node.mType);
 		return false;
 	}
 
-	BOOST_FOREACH(auto &sprite, node->getChildren()) {
-		readSprite(spriddy, sprite);
+	BOOST_FOREACH(auto &child, node.mChildren) {
+		readSprite(spriddy, child);
 	}
 
 	parent->addChild(*spriddy);
 
-	// Get sprite name and classes
-	std::string sprite_name = node->getAttributeValue<std::string>("name", "");
-	std::string sprite_classes = node->getAttributeValue<std::string>("class", "");
-
 	// Put sprite in named sprites map
-	if (sprite_name != "") {
-		if (mNamedSpriteMap.find(sprite_name) != mNamedSpriteMap.end()) {
-			DS_LOG_WARNING("Interface xml file contains duplicate sprites named:" << sprite_name << ", only the first one will be identified.");
+	if (node.mName != "") {
+		if (mNamedSpriteMap.find(node.mName) != mNamedSpriteMap.end()) {
+			DS_LOG_WARNING("Interface xml file contains duplicate sprites named:" << node.mName << ", only the first one will be identified.");
 		}
 		else {
-			mNamedSpriteMap.insert(std::make_pair(sprite_name, spriddy));
+			mNamedSpriteMap.insert(std::make_pair(node.mName, spriddy));
 		}
 	}
 
-	// Apply stylesheet(s)
-	BOOST_FOREACH(auto stylesheet, mStylesheets) {
-		applyStylesheet(*stylesheet, *spriddy, sprite_name, sprite_classes);
-	}
-
-	// Set properties from xml attributes, overwriting those from the stylesheet(s)
-	BOOST_FOREACH(auto &attr, node->getAttributes()) {
-		setSpriteProperty(*spriddy, attr, mXmlFile);
+	// Stylesheet properties, then the xml attributes that overwrite them
+	BOOST_FOREACH(auto &prop, node.mProperties) {
+		if (prop.mApply) prop.mApply(*spriddy);
 	}
 
 	return true;
@@ -2,23 +2,74 @@
 #ifndef DS_UI_XML_IMPORT_H_
 #define DS_UI_XML_IMPORT_H_
 
+#include <cstdint>
 #include <functional>
 #include <cinder/Xml.h>
 #include <map>
+#include <memory>
 
 namespace ds{
 namespace ui{
 
 class Sprite;
+class SpriteEngine;
 struct Stylesheet;
 
 class XmlImporter {
 
 public:
+	// A layout compiled once, so it can be built any number of times without parsing anything.
+	// Each node has its sprite type and contents, and the properties from its stylesheet rules
+	// and attributes, in the order they're applied, with their values already parsed.
+	class Template {
+	public:
+		struct Property {
+			std::string				mName;
+			std::string				mValue;
+			std::string				mReferer;
+			// Empty if the property is unknown or the value wouldn't parse
+			std::function<void(ds::ui::Sprite&)>
+									mApply;
+		};
+
+		struct Node {
+			std::string				mType;
+			std::string				mName;
+			std::string				mContent;
+			std::vector<Property>	mProperties;
+			std::vector<Node>		mChildren;
+			// Empty for types the custom importer makes
+			std::function<ds::ui::Sprite*(ds::ui::SpriteEngine&)>
+									mCreate;
+			// Only kept for types the custom importer makes, which get handed the xml
+			std::shared_ptr<ci::XmlTree>
+									mXml;
+		};
+
+		Template();
+
+		bool						empty() const;
+
+		// A binary copy so warm starts can skip the xml and stylesheets entirely. Templates with
+		// custom types can't be written. read() answers false if the file is missing or from
+		// another version, or if the xml or any stylesheet has changed since it was written.
+		bool						write(const std::string& filename) const;
+		bool						read(const std::string& filename);
+
+		std::string					mFilename;
+		std::vector<Node>			mNodes;
+		// The xml and stylesheet files, and when they were modified
+		std::vector<std::pair<std::string, int64_t>>
+									mSources;
+	};
+
 	struct XmlPreloadData {
 		ci::XmlTree					mXmlTree;
 		std::vector<Stylesheet*>	mStylesheets;
 		std::string					mFilename;
+		// Compiled by preloadXml()
+		std::shared_ptr<const Template>
+									mTemplate;
 	};
 
 	typedef std::function< ds::ui::Sprite*(const std::string &typeName, ci::XmlTree &) > SpriteImporter;
@@ -27,12 +78,18 @@ public:
 	// reads the xml at the specified path and creates any sprites found on the parent
 	// Returns true if the xml was loaded and sprites were successfully created
 	// False indicates either xml load failure or failure to create sprites
+	// The compiled file is kept, and only compiled again once it or one of its stylesheets changes
 	static bool loadXMLto(ds::ui::Sprite * parent, const std::string& xmlFile, NamedSpriteMap &map, SpriteImporter customImporter = nullptr);
 	static bool loadXMLto(ds::ui::Sprite * parent, XmlPreloadData& xmldata, NamedSpriteMap &map, SpriteImporter customImporter = nullptr);
+	static bool loadXMLto(ds::ui::Sprite * parent, const Template&, NamedSpriteMap &map, SpriteImporter customImporter = nullptr);
 
 	// Pre-loads the xml & related css files in preparation for creating sprites later. Removes a lot of the dynamic disk reads associated with importing stuff
 	static bool preloadXml(const std::string& xmlFile, XmlPreloadData& outData);
 
+	// Loads the xml & related css files and compiles them into a template.
+	static bool compileXml(const std::string& xmlFile, Template& outTemplate);
+	static bool compileXml(ci::XmlTree&, const std::vector<Stylesheet*>&, const std::string& xmlFile, Template& outTemplate);
+
 protected:
 	XmlImporter( ds::ui::Sprite *targetSprite, const std::string& xmlFile, NamedSpriteMap &map, SpriteImporter customImporter = nullptr)
 		: mTargetSprite(targetSprite)
@@ -40,17 +97,15 @@ protected:
 		, mNamedSpriteMap( map )
 		, mCustomImporter( customImporter )
 	{}
-	~XmlImporter();
 
-	bool load(ci::XmlTree &);
+	bool load(const Template&);
 
-	bool readSprite(ds::ui::Sprite *, std::unique_ptr<ci::XmlTree>& );
+	bool readSprite(ds::ui::Sprite *, const Template::Node&);
 
 	NamedSpriteMap &			mNamedSpriteMap;
 	std::string 				mXmlFile;
 	ds::ui::Sprite *			mTargetSprite;
 	SpriteImporter				mCustomImporter;
-	std::vector< Stylesheet * >	mStylesheets;
 };
 
 } // namespace ui
@@ -12,6 +12,7 @@
 
 #include <ds/debug/logger.h>
 
+#include <algorithm>
 #include <fstream>
 
 BOOST_FUSION_ADAPT_STRUCT(
@@ -145,6 +146,7 @@ bool Stylesheet::loadFile( const std::string &filename, const std::string &refer
 		return false;
 	}
 	mReferer = referer;
+	mFilename = filename;
 	namespace spirit = boost::spirit;
 
 	// open file, disable skipping of whitespace
@@ -156,7 +158,92 @@ bool Stylesheet::loadFile( const std::string &filename, const std::string &refer
 	spirit::istream_iterator end;
 
 	// Parse the file into a Stylesheet
-	return stylesheets::parse_stylesheet( begin, end, mRules );
+	if (!stylesheets::parse_stylesheet( begin, end, mRules )) return false;
+	buildIndex();
+	return true;
+}
+
+namespace {
+struct FirstSelectorIndexer : public boost::static_visitor<void> {
+	FirstSelectorIndexer( Stylesheet &s, const size_t rule )
+		: mStylesheet(s)
+		, mRule(rule)
+	{}
+	void operator()(const stylesheets::IdSelector &s) const {
+		add( mStylesheet.mRulesById[s.selector] );
+	}
+	void operator()(const stylesheets::ClassSelector &s) const {
+		add( mStylesheet.mRulesByClass[s.selector] );
+	}
+	void add( std::vector<size_t> &rules ) const {
+		if (rules.empty() || rules.back() != mRule) rules.push_back( mRule );
+	}
+
+	Stylesheet &mStylesheet;
+	const size_t mRule;
+};
+
+struct SelectorMatchChecker : public boost::static_visitor<bool> {
+	SelectorMatchChecker( const std::vector< std::string > &classesToCheck, const std::string &idToCheck )
+		: mClassesToCheck(classesToCheck)
+		, mIdToCheck(idToCheck)
+	{}
+	bool operator()(const stylesheets::IdSelector &s) const {
+		return mIdToCheck == s.selector;
+	}
+	bool operator()(const stylesheets::ClassSelector &s) const {
+		return (std::find( mClassesToCheck.begin(), mClassesToCheck.end(), s.selector ) != mClassesToCheck.end() );
+	}
+
+	const std::vector<std::string> &mClassesToCheck;
+	const std::string &mIdToCheck;
+};
+}
+
+void Stylesheet::buildIndex() {
+	mRulesByClass.clear();
+	mRulesById.clear();
+	// Every selector in a matcher has to match, so the first one is enough to find it by
+	for (size_t i = 0; i < mRules.size(); ++i) {
+		BOOST_FOREACH( auto &matcher, mRules[i].matchers ) {
+			if (!matcher.empty()) boost::apply_visitor( FirstSelectorIndexer(*this, i), matcher.front() );
+		}
+	}
+}
+
+void Stylesheet::matchRules( const std::string &name, const std::vector<std::string> &classes, std::vector<size_t> &out ) const {
+	out.clear();
+	if (!name.empty()) {
+		auto found = mRulesById.find( name );
+		if (found != mRulesById.end()) out.insert( out.end(), found->second.begin(), found->second.end() );
+	}
+	BOOST_FOREACH( auto &c, classes ) {
+		auto found = mRulesByClass.find( c );
+		if (found != mRulesByClass.end()) out.insert( out.end(), found->second.begin(), found->second.end() );
+	}
+	std::sort( out.begin(), out.end() );
+	out.erase( std::unique( out.begin(), out.end() ), out.end() );
+
+	// Now check the candidates properly
+	const SelectorMatchChecker checker( classes, name );
+	auto keep = out.begin();
+	BOOST_FOREACH( auto i, out ) {
+		bool matches_rule = false;
+		BOOST_FOREACH( auto &matcher, mRules[i].matchers ) {
+			// ALL the sub-matchers have to match for this matcher to match
+			bool all_submatchers_match = true;
+			BOOST_FOREACH( auto &selector, matcher ) {
+				if (!boost::apply_visitor( checker, selector )) {
+					all_submatchers_match = false;
+					break;
+				}
+			}
+			matches_rule = all_submatchers_match;
+			if (matches_rule) break;
+		}
+		if (matches_rule) *keep++ = i;
+	}
+	out.erase( keep, out.end() );
 }
 
 }} // namespace ds::ui
@@ -3,6 +3,7 @@
 #define DS_UI_STYLESHEET_PARSER_H_
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/variant.hpp>
@@ -44,7 +45,15 @@ bool parse_stylesheet(Iter first, Iter last, Rules& s);
 struct Stylesheet {
 	stylesheets::Rules mRules;
 	std::string mReferer;
+	std::string mFilename;
+	// Rule indices by the first selector of each of their matchers, so a sprite
+	// only has to check the rules that name one of its classes or its name.
+	std::unordered_map< std::string, std::vector<size_t> > mRulesByClass;
+	std::unordered_map< std::string, std::vector<size_t> > mRulesById;
 	bool loadFile( const std::string &filename, const std::string &referer );
+	void buildIndex();
+	// Answer the rules that match, in stylesheet order.
+	void matchRules( const std::string &name, const std::vector<std::string> &classes, std::vector<size_t> &out ) const;
 };
 
 }} // namespace ds::ui
@@ -1,5 +1,8 @@
 #include "scroll_list.h"
 
+#include <algorithm>
+#include <limits>
+#include <Poco/Runnable.h>
 #include <ds/ui/sprite/sprite_engine.h>
 #include <ds/ui/scroll/scroll_area.h>
 #include <ds/debug/logger.h>
@@ -7,15 +10,41 @@
 namespace ds{
 namespace ui{
 
+namespace {
+// Runs the prepare callback for one item off the main thread
+class PrepareItem : public Poco::Runnable {
+public:
+	PrepareItem(const std::function<void(const int)>& func, const int generation, const size_t index, const int dbId)
+		: mFunc(func), mGeneration(generation), mIndex(index), mDbId(dbId) { }
+
+	virtual void run(){
+		if(mFunc) mFunc(mDbId);
+	}
+
+	std::function<void(const int)>	mFunc;
+	const int						mGeneration;
+	const size_t					mIndex;
+	const int						mDbId;
+};
+}
+
 ScrollList::ScrollList(ds::ui::SpriteEngine& engine, const bool vertical)
 	: ds::ui::Sprite(engine)
+	, mVisibleBegin(0)
+	, mVisibleEnd(0)
 	, mScrollArea(nullptr)
+	, mVerticalScrolling(vertical)
+	, mStartPositionY(10.0f)
 	, mStartPositionX(10.0f)
 	, mIncrementAmount(50.0f)
+	, mFillFromTop(true)
+	, mItemsPerLine(1)
+	, mCrossIncrement(0.0f)
+	, mBindsPerUpdate(0)
+	, mContentGeneration(0)
+	, mPrepareClient(engine, [this](std::unique_ptr<Poco::Runnable>& r){ handlePrepared(r); })
 	, mAnimateOnDeltaDelay(0.0f)
 	, mAnimateOnStartDelay(0.0f)
-	, mVerticalScrolling(vertical)
-	, mFillFromTop(true)
 {
 	mScrollArea = new ds::ui::ScrollArea(mEngine, getWidth(), getHeight(), mVerticalScrolling);
 	if(mScrollArea){
@@ -40,6 +69,7 @@ ScrollList::ScrollList(ds::ui::SpriteEngine& engine, const bool vertical)
 void ScrollList::setContent(const std::vector<int>& models){
 	clearItems();
 
+	mItemPlaceHolders.reserve(models.size());
 	for(auto it = models.begin(); it < models.end(); ++it){
 		mItemPlaceHolders.push_back(ItemPlaceHolder((*it)));
 	}
@@ -53,9 +83,11 @@ void ScrollList::setContent(const std::vector<int>& models){
 
 void ScrollList::animateItemsOn(){
 	float theDelay = mAnimateOnStartDelay;
-	for(auto it = mItemPlaceHolders.begin(), it2 = mItemPlaceHolders.end(); it != it2; ++it){
-		if((*it).mAssociatedSprite){
-			if(mAnimateOnCallback) mAnimateOnCallback((*it).mAssociatedSprite, theDelay);
+	const size_t end = std::min(mVisibleEnd, mItemPlaceHolders.size());
+	for(size_t i = mVisibleBegin; i < end; ++i){
+		auto& placeHolder = mItemPlaceHolders[i];
+		if(placeHolder.mAssociatedSprite){
+			if(mAnimateOnCallback) mAnimateOnCallback(placeHolder.mAssociatedSprite, theDelay);
 			theDelay += mAnimateOnDeltaDelay;
 		}
 	}
@@ -64,7 +96,7 @@ void ScrollList::animateItemsOn(){
 void ScrollList::layout(){
 
 	layoutItems();
-
+	measureLines();
 
 	if(mVerticalScrolling){
 		float scrollyHeight = mScrollableHolder->getHeight();
@@ -105,152 +137,272 @@ void ScrollList::layout(){
 }
 
 void ScrollList::pushItemsTop(){
-	if (mVerticalScrolling){
-		float scrollHeight = mScrollableHolder->getHeight();
-		if(getPerspective()){
-			if(!mItemPlaceHolders.empty() &&
-			   mItemPlaceHolders[0].mY < scrollHeight - mStartPositionY - mIncrementAmount
-			   ){
-				float delta = scrollHeight - mItemPlaceHolders[0].mY - mStartPositionY - mIncrementAmount;
-				for(auto it = mItemPlaceHolders.begin(); it < mItemPlaceHolders.end(); ++it){
-					(*it).mY += delta;
-				}
-			}
-		} else {
-			if(!mItemPlaceHolders.empty() &&
-			   mItemPlaceHolders.back().mY < scrollHeight - mIncrementAmount
-			   ){
-				float delta = scrollHeight - mItemPlaceHolders.back().mY - mIncrementAmount;
-				for(auto it = mItemPlaceHolders.begin(); it < mItemPlaceHolders.end(); ++it){
-					(*it).mY += delta;
-				}
-			}
+	if(!mVerticalScrolling || mItemPlaceHolders.empty()) return;
+
+	const float scrollHeight = mScrollableHolder->getHeight();
+	// The first and last lines, as tall as their tallest item
+	const float firstLine = lineSize(0);
+	const float lastLine = lineSize((mItemPlaceHolders.size() - 1) / static_cast<size_t>(std::max(1, mItemsPerLine)));
+	float delta = 0.0f;
+	if(getPerspective()){
+		const float firstY = mItemPlaceHolders.front().mY;
+		if(firstY < scrollHeight - mStartPositionY - firstLine){
+			delta = scrollHeight - firstY - mStartPositionY - firstLine;
+		}
+	} else {
+		const float lastY = mItemPlaceHolders.back().mY;
+		if(lastY < scrollHeight - lastLine){
+			delta = scrollHeight - lastY - lastLine;
 		}
-
 	}
+	if(delta == 0.0f) return;
 
+	for(auto it = mItemPlaceHolders.begin(); it < mItemPlaceHolders.end(); ++it){
+		(*it).mY += delta;
+	}
+	measureLines();
 }
 
 // Override if you need to do something special with the layout, otherwise just set start positions and increment amounts
 void ScrollList::layoutItems(){
-	float xp = mStartPositionX;
-	float yp = mStartPositionY;
-	const bool isPerspective = Sprite::getPerspective();
-	float totalHeight = yp;
-	if (mVerticalScrolling){
-		totalHeight = (float)(mItemPlaceHolders.size()) * mIncrementAmount + mStartPositionY * 2.0f;
-		if(isPerspective) yp = totalHeight - mIncrementAmount - mStartPositionY;
+	const size_t count = mItemPlaceHolders.size();
+	const size_t perLine = static_cast<size_t>(std::max(1, mItemsPerLine));
+	const size_t lines = (count + perLine - 1) / perLine;
+	const bool isPerspective = mVerticalScrolling && Sprite::getPerspective();
+	const float axisStart = (mVerticalScrolling ? mStartPositionY : mStartPositionX);
+	const float crossStart = (mVerticalScrolling ? mStartPositionX : mStartPositionY);
+
+	// Measure each line, then turn the sizes into offsets from the first
+	std::vector<float> offsets(lines + 1, 0.0f);
+	for(size_t i = 0; i < count; ++i){
+		auto& placeHolder = mItemPlaceHolders[i];
+		const int itemType = (mItemTypeCallback ? mItemTypeCallback(placeHolder.mDbId) : 0);
+		// A sprite from another pool can't stay on this item
+		if(itemType != placeHolder.mType) releaseSprite(placeHolder);
+		placeHolder.mType = itemType;
+		placeHolder.mSize = (mItemSizeCallback ? mItemSizeCallback(placeHolder.mDbId) : mIncrementAmount);
+		float& lineSize = offsets[i / perLine + 1];
+		lineSize = std::max(lineSize, placeHolder.mSize);
 	}
-
-	for(auto it = mItemPlaceHolders.begin(); it < mItemPlaceHolders.end(); ++it){
-		(*it).mX = xp;
-		(*it).mY = yp;
-
-		if(mVerticalScrolling){
-			if(isPerspective){
-				yp -= mIncrementAmount;
-			} else {
-				yp += mIncrementAmount;
-			}
-		} else {
-			xp += mIncrementAmount;
-		}
+	for(size_t i = 1; i <= lines; ++i){
+		offsets[i] += offsets[i - 1];
+	}
+	const float totalExtent = offsets.back() + axisStart * 2.0f;
+
+	for(size_t i = 0; i < count; ++i){
+		const size_t line = i / perLine;
+		const float axis = (isPerspective ? totalExtent - axisStart - offsets[line + 1] : axisStart + offsets[line]);
+		const float cross = crossStart + static_cast<float>(i % perLine) * mCrossIncrement;
+		auto& placeHolder = mItemPlaceHolders[i];
+		placeHolder.mX = (mVerticalScrolling ? cross : axis);
+		placeHolder.mY = (mVerticalScrolling ? axis : cross);
 	}
-
 
 	if(mVerticalScrolling){
-		mScrollableHolder->setSize(getWidth(), totalHeight);
+		mScrollableHolder->setSize(getWidth(), totalExtent);
 	} else {
-		xp += mStartPositionX;
-		mScrollableHolder->setSize(xp, getHeight());
+		mScrollableHolder->setSize(totalExtent, getHeight());
 	}
 }
 
+void ScrollList::measureLines(){
+	const size_t count = mItemPlaceHolders.size();
+	const size_t perLine = static_cast<size_t>(std::max(1, mItemsPerLine));
+	const size_t lines = (count + perLine - 1) / perLine;
+	// Perspective lines run up the holder; negating keeps them in order
+	const float sign = (mVerticalScrolling && Sprite::getPerspective() ? -1.0f : 1.0f);
+
+	mLineStarts.assign(lines, std::numeric_limits<float>::max());
+	mLineEnds.assign(lines, -std::numeric_limits<float>::max());
+	for(size_t i = 0; i < count; ++i){
+		const auto& placeHolder = mItemPlaceHolders[i];
+		const float pos = (mVerticalScrolling ? placeHolder.mY : placeHolder.mX);
+		const float a = sign * pos, b = sign * (pos + itemSize(placeHolder));
+		const size_t line = i / perLine;
+		mLineStarts[line] = std::min(mLineStarts[line], std::min(a, b));
+		mLineEnds[line] = std::max(mLineEnds[line], std::max(a, b));
+	}
+	// A layout that puts lines out of order only loosens the search, it never hides anything
+	for(size_t i = 1; i < lines; ++i){
+		mLineEnds[i] = std::max(mLineEnds[i], mLineEnds[i - 1]);
+	}
+	for(size_t i = lines; i > 1; --i){
+		mLineStarts[i - 2] = std::min(mLineStarts[i - 2], mLineStarts[i - 1]);
+	}
+}
+
+float ScrollList::itemSize(const ItemPlaceHolder& placeHolder) const {
+	return (placeHolder.mSize > 0.0f ? placeHolder.mSize : mIncrementAmount);
+}
+
+float ScrollList::lineSize(const size_t line) const {
+	const size_t perLine = static_cast<size_t>(std::max(1, mItemsPerLine));
+	const size_t end = std::min((line + 1) * perLine, mItemPlaceHolders.size());
+	float ans = 0.0f;
+	for(size_t i = line * perLine; i < end; ++i){
+		ans = std::max(ans, itemSize(mItemPlaceHolders[i]));
+	}
+	return ans;
+}
+
 
 void ScrollList::clearItems(){
-	for(auto it = mItemPlaceHolders.begin(), it2 = mItemPlaceHolders.end(); it != it2; ++it){
-		if(it->mAssociatedSprite){
-			it->mAssociatedSprite->hide();
-			mReserveItems.push_back(it->mAssociatedSprite);
-		}
+	const size_t end = std::min(mVisibleEnd, mItemPlaceHolders.size());
+	for(size_t i = mVisibleBegin; i < end; ++i){
+		releaseSprite(mItemPlaceHolders[i]);
 	}
 
 	mItemPlaceHolders.clear();
+	mLineStarts.clear();
+	mLineEnds.clear();
+	mVisibleBegin = mVisibleEnd = 0;
+	mBindQueue.clear();
+	// Anything still being prepared is for the old content
+	++mContentGeneration;
 
 	if(mScrollArea){
 		mScrollArea->setScrollSize(mScrollArea->getWidth(), mScrollArea->getHeight());
 	}
 }
 
+void ScrollList::findVisibleRange(size_t& begin, size_t& end){
+	begin = end = 0;
+	if(mItemPlaceHolders.empty() || mLineStarts.empty()) return;
+
+	const float scroll = (mVerticalScrolling ? mScrollArea->getScrollerPosition().y : mScrollArea->getScrollerPosition().x);
+	const float view = (mVerticalScrolling ? mScrollArea->getHeight() : mScrollArea->getWidth());
+
+	// The window onscreen, in the same terms as the lines
+	float lo = -scroll;
+	float hi = lo + view;
+	if(mVerticalScrolling && Sprite::getPerspective()){
+		lo = scroll - view;
+		hi = scroll;
+	}
+
+	// Lines that end past the top of the window and start before its bottom
+	const size_t first = std::upper_bound(mLineEnds.begin(), mLineEnds.end(), lo) - mLineEnds.begin();
+	const size_t last = std::lower_bound(mLineStarts.begin(), mLineStarts.end(), hi) - mLineStarts.begin();
+	if(last <= first) return;
+
+	const size_t perLine = static_cast<size_t>(std::max(1, mItemsPerLine));
+	begin = first * perLine;
+	end = std::min(last * perLine, mItemPlaceHolders.size());
+	if(end < begin) end = begin;
+}
+
 void ScrollList::assignItems(){
 	if(!mScrollArea || !mScrollableHolder) return;
 
-	float y = mScrollArea->getScrollerPosition().y;
-	float x = mScrollArea->getScrollerPosition().x;
-	float scrollHeight = mScrollArea->getHeight();
-	float scrollWidth = mScrollArea->getWidth();
-
+	size_t begin, end;
+	findVisibleRange(begin, end);
 
-	std::vector<int> needsSprite;
+	// Only the items that were onscreen can have sprites to give back
+	const size_t oldEnd = std::min(mVisibleEnd, mItemPlaceHolders.size());
+	for(size_t i = mVisibleBegin; i < oldEnd; ++i){
+		if(i < begin || i >= end) releaseSprite(mItemPlaceHolders[i]);
+	}
+	mVisibleBegin = begin;
+	mVisibleEnd = end;
 
-	// Look through all the placeholdser and find all the items that should be onscreen
-	// push the offscreen sprites into the reserve vector
-	for(auto it = mItemPlaceHolders.begin(), it2 = mItemPlaceHolders.end(); it != it2; ++it){
-		float itemY = y + it->mY;
-		float itemX = x + it->mX;
+	for(size_t i = begin; i < end; ++i){
+		assignSprite(i);
+	}
+}
 
-		if((mVerticalScrolling && ((itemY + mIncrementAmount > 0.0f) && (itemY < scrollHeight))) ||
-			(!mVerticalScrolling && ((itemX + mIncrementAmount > 0.0f) && (itemX < scrollWidth)))
-			){
-			if(it->mAssociatedSprite){
-				it->mAssociatedSprite->setPosition(it->mX, it->mY);
-			} else {
-				needsSprite.push_back(it - mItemPlaceHolders.begin());
-			}
-		} else {
-			if(it->mAssociatedSprite){
-				mReserveItems.push_back(it->mAssociatedSprite);
-			}
-			it->mAssociatedSprite = nullptr;
-		}
+void ScrollList::assignSprite(const size_t index){
+	auto& placeHolder = mItemPlaceHolders[index];
+	if(placeHolder.mAssociatedSprite){
+		placeHolder.mAssociatedSprite->setPosition(placeHolder.mX, placeHolder.mY);
+		return;
 	}
 
-	// give all the placeholders that need a sprite
-	for(auto it = needsSprite.begin(), it2 = needsSprite.end(); it != it2; ++it){
-		ds::ui::Sprite* sprite = nullptr;
-		if(!mReserveItems.empty()){
-			sprite = mReserveItems.back();
-			mReserveItems.pop_back();
-		} else {
-			if(mCreateItemCallback) sprite = mCreateItemCallback();
-			if(sprite){
-				sprite->setProcessTouchCallback([this](ds::ui::Sprite* sp, const ds::ui::TouchInfo& ti){ handleItemTouchInfo(sp, ti); });
-				sprite->setTapCallback([this, sprite](ds::ui::Sprite* bs, const ci::Vec3f cent){
-					if(mItemTappedCallback) mItemTappedCallback(sprite, cent);
-				});
-				mScrollableHolder->addChildPtr(sprite);
-			} else {
-				DS_LOG_WARNING("Didn't create a sprite for scroll list! Use the callback and make sprites when we need them!!");
-			}
-		}
+	ds::ui::Sprite* sprite = nullptr;
+	auto& reserve = mReserveItems[placeHolder.mType];
+	if(!reserve.empty()){
+		sprite = reserve.back();
+		reserve.pop_back();
+	} else {
+		sprite = createItem(placeHolder.mType);
+	}
+	if(!sprite) return;
 
-		auto &placeHolder = mItemPlaceHolders[*it];
+	sprite->setPosition(placeHolder.mX, placeHolder.mY);
+	placeHolder.mAssociatedSprite = sprite;
+	placeHolder.mBound = false;
 
-		if(sprite){
+	if(mBindsPerUpdate < 1){
+		bindItem(placeHolder);
+		return;
+	}
 
-			if(mSetDataCallback) mSetDataCallback(sprite, placeHolder.mDbId);
-			sprite->setPosition(placeHolder.mX, placeHolder.mY);
-			sprite->show();
-			placeHolder.mAssociatedSprite = sprite;
-		}
+	// Stays hidden until it has its data
+	sprite->hide();
+	if(mPrepareDataCallback){
+		std::unique_ptr<Poco::Runnable> r(new PrepareItem(mPrepareDataCallback, mContentGeneration, index, placeHolder.mDbId));
+		if(mPrepareClient.run(r)) return;
 	}
+	mBindQueue.push_back(index);
+}
+
+void ScrollList::releaseSprite(ItemPlaceHolder& placeHolder){
+	if(!placeHolder.mAssociatedSprite) return;
+
+	placeHolder.mAssociatedSprite->hide();
+	mReserveItems[placeHolder.mType].push_back(placeHolder.mAssociatedSprite);
+	placeHolder.mAssociatedSprite = nullptr;
+	placeHolder.mBound = false;
+}
 
-	// hide any extras
-	for(auto it = mReserveItems.begin(), it2 = mReserveItems.end(); it != it2; ++it){
-		auto sprite = *it;
-		sprite->hide();
+ds::ui::Sprite* ScrollList::createItem(const int itemType){
+	ds::ui::Sprite* sprite = nullptr;
+	if(mCreateTypedItemCallback) sprite = mCreateTypedItemCallback(itemType);
+	else if(mCreateItemCallback) sprite = mCreateItemCallback();
+	if(!sprite){
+		DS_LOG_WARNING("Didn't create a sprite for scroll list! Use the callback and make sprites when we need them!!");
+		return nullptr;
 	}
 
+	sprite->setProcessTouchCallback([this](ds::ui::Sprite* sp, const ds::ui::TouchInfo& ti){ handleItemTouchInfo(sp, ti); });
+	sprite->setTapCallback([this, sprite](ds::ui::Sprite* bs, const ci::Vec3f cent){
+		if(mItemTappedCallback) mItemTappedCallback(sprite, cent);
+	});
+	mScrollableHolder->addChildPtr(sprite);
+	return sprite;
+}
+
+void ScrollList::bindItem(ItemPlaceHolder& placeHolder){
+	if(!placeHolder.mAssociatedSprite) return;
+
+	if(mSetDataCallback) mSetDataCallback(placeHolder.mAssociatedSprite, placeHolder.mDbId);
+	placeHolder.mAssociatedSprite->show();
+	placeHolder.mBound = true;
+}
+
+void ScrollList::handlePrepared(std::unique_ptr<Poco::Runnable>& r){
+	PrepareItem* prepared = dynamic_cast<PrepareItem*>(r.get());
+	if(!prepared || prepared->mGeneration != mContentGeneration || prepared->mIndex >= mItemPlaceHolders.size()) return;
+
+	// Only if it's still onscreen and waiting
+	const auto& placeHolder = mItemPlaceHolders[prepared->mIndex];
+	if(placeHolder.mDbId != prepared->mDbId || !placeHolder.mAssociatedSprite || placeHolder.mBound) return;
+	mBindQueue.push_back(prepared->mIndex);
+}
+
+void ScrollList::updateServer(const ds::UpdateParams& p){
+	ds::ui::Sprite::updateServer(p);
+
+	int binds = 0;
+	while(!mBindQueue.empty() && binds < mBindsPerUpdate){
+		const size_t index = mBindQueue.front();
+		mBindQueue.pop_front();
+		if(index >= mItemPlaceHolders.size()) continue;
+
+		auto& placeHolder = mItemPlaceHolders[index];
+		if(!placeHolder.mAssociatedSprite || placeHolder.mBound) continue;
+		bindItem(placeHolder);
+		++binds;
+	}
 }
 
 void ScrollList::handleItemTouchInfo(ds::ui::Sprite* bs, const TouchInfo& ti){
@@ -289,6 +441,39 @@ void ScrollList::setStateChangeCallback(const std::function<void(ds::ui::Sprite*
 	mStateChangeCallback = func;
 }
 
+void ScrollList::setItemSizeCallback(const std::function<float(const int dbId)>& func){
+	mItemSizeCallback = func;
+}
+
+void ScrollList::setItemTypeCallback(const std::function<int(const int dbId)>& func){
+	mItemTypeCallback = func;
+}
+
+void ScrollList::setCreateTypedItemCallback(const std::function<ds::ui::Sprite*(const int itemType)>& func){
+	mCreateTypedItemCallback = func;
+}
+
+void ScrollList::setGridLayout(const int itemsPerLine, const float crossIncrement){
+	mItemsPerLine = std::max(1, itemsPerLine);
+	mCrossIncrement = crossIncrement;
+}
+
+void ScrollList::setDeferredBinding(const int bindsPerUpdate){
+	mBindsPerUpdate = std::max(0, bindsPerUpdate);
+	if(mBindsPerUpdate > 0) return;
+
+	// Catch up anything that was waiting
+	const size_t end = std::min(mVisibleEnd, mItemPlaceHolders.size());
+	for(size_t i = mVisibleBegin; i < end; ++i){
+		if(!mItemPlaceHolders[i].mBound) bindItem(mItemPlaceHolders[i]);
+	}
+	mBindQueue.clear();
+}
+
+void ScrollList::setPrepareDataCallback(const std::function<void(const int dbId)>& func){
+	mPrepareDataCallback = func;
+}
+
 void ScrollList::setLayoutParams(const float startPositionX, const float startPositionY, const float incremenetAmount, const bool fill_from_top){
 	mStartPositionX = startPositionX;
 	mStartPositionY = startPositionY;
@@ -2,6 +2,9 @@
 #ifndef DS_UI_SCROLL_SCROLL_LIST
 #define DS_UI_SCROLL_SCROLL_LIST
 
+#include <deque>
+#include <unordered_map>
+#include <ds/thread/runnable_client.h>
 #include <ds/ui/sprite/sprite.h>
 
 namespace ds{
@@ -14,6 +17,8 @@ class ScrollArea;
 	* ScrollList is an advanced Scroll Area that handles an arbitrarily large set of items.
 	* ScrollList handles keeping a cache of placeholders and assigning sprites to onscreen items.
 	* This assumes that you can refer to your content by integers only, so you may have to keep a map in your super class.
+	* Items are laid out in lines (rows when scrolling vertically, columns when horizontal), one item per line unless
+	* it's a grid. Where each line starts and ends is measured after layout, so each scroll update only touches the items on screen.
 	*
 	* NOTE: In perspective sprites, the list will fill up from the bottom. If you need to modify this, leave filling from the bottom the default.
 	*/
@@ -39,6 +44,27 @@ class ScrollArea;
 		// OPTIONAL: If you want to show highlighted states you can react here
 		void						setStateChangeCallback(const std::function<void(ds::ui::Sprite*, const bool highlighted)>&func);
 
+		// OPTIONAL: How much room an item takes along the scroll direction, including the gap after it. Default is the increment amount.
+		// Asked for every item each time the list is laid out. In a grid, a line is as big as its biggest item.
+		void						setItemSizeCallback(const std::function<float(const int dbId)>& func);
+
+		// OPTIONAL: Items come in types, each with its own pool of recycled sprites. Default is every item is type 0.
+		void						setItemTypeCallback(const std::function<int(const int dbId)>& func);
+		// Create a sprite for an item type. Used in place of the create item callback when set.
+		void						setCreateTypedItemCallback(const std::function<ds::ui::Sprite*(const int itemType)>& func);
+
+		// OPTIONAL: Lay the items out in a grid, itemsPerLine across a vertical list (or down a horizontal one), crossIncrement apart.
+		void						setGridLayout(const int itemsPerLine, const float crossIncrement);
+
+		// OPTIONAL: Bind data to at most bindsPerUpdate items each update, instead of as they come on screen, so a fast
+		// flick never waits on the data callback. Items stay hidden until bound. 0 (the default) binds right away.
+		void						setDeferredBinding(const int bindsPerUpdate);
+		// OPTIONAL: Called on a worker thread for each item before it's bound (to load its record, for instance),
+		// so it must be thread safe. Only used with deferred binding.
+		void						setPrepareDataCallback(const std::function<void(const int dbId)>& func);
+
+		virtual void				updateServer(const ds::UpdateParams&);
+
 		void						animateItemsOn();
 
 		// REQUIRED TO LOOK OK: 
@@ -60,7 +86,9 @@ class ScrollArea;
 		// We only create enough sprites that are onscreen at one time.
 		// Here's how this crap works (roughly in order):
 		//		- Set Data: clear out old data, and build a list of placeholders. These are just the data (product), a position and a pointer to a sprite
-		//		- layoutItems: place the placeholders on a virtual grid.
+		//		- layoutItems: place the placeholders on a virtual grid. An override only has to set mX and mY (and mSize, if items
+		//						aren't mIncrementAmount big). Every mItemsPerLine placeholders make a line; afterwards layout() measures
+		//						the lines from the placeholders, so keep lines in order along the scroll direction for the tightest search.
 		//		- assignItems: figure out which placeholders should be onscreen and associate sprites with them. New sprites can be created here if needeed.
 		//						extra sprites are kept in mReserveI tems.
 
@@ -71,6 +99,9 @@ class ScrollArea;
 				: mDbId(dbId)
 				, mX(x)
 				, mY(y)
+				, mSize(0.0f)
+				, mType(0)
+				, mBound(false)
 				, mAssociatedSprite(associatedSprite)
 			{
 			};
@@ -78,6 +109,12 @@ class ScrollArea;
 			int							mDbId;
 			float						mX;
 			float						mY;
+			// Extent along the scroll direction; 0 means mIncrementAmount
+			float						mSize;
+			// Which reserve pool the sprite goes back to
+			int							mType;
+			// Whether the sprite has had its data set
+			bool						mBound;
 			ds::ui::Sprite*				mAssociatedSprite;
 		};
 
@@ -91,8 +128,19 @@ class ScrollArea;
 
 		void								handleItemTouchInfo(ds::ui::Sprite* bs, const TouchInfo& ti);
 
+		// Answer the range of placeholders [begin, end) that overlap the scroll area.
+		void								findVisibleRange(size_t& begin, size_t& end);
+		// Give the placeholder a sprite from its pool (or a new one), and bind it or queue it for binding.
+		void								assignSprite(const size_t index);
+		void								releaseSprite(ItemPlaceHolder&);
+		ds::ui::Sprite*						createItem(const int itemType);
+		void								bindItem(ItemPlaceHolder&);
+		void								handlePrepared(std::unique_ptr<Poco::Runnable>&);
+
 		std::vector<ItemPlaceHolder>		mItemPlaceHolders;
-		std::vector<ds::ui::Sprite*>		mReserveItems;
+		// Only placeholders in this range have sprites
+		size_t								mVisibleBegin,
+											mVisibleEnd;
 
 		ds::ui::ScrollArea*					mScrollArea;
 		ds::ui::Sprite*						mScrollableHolder;
@@ -103,6 +151,15 @@ class ScrollArea;
 		float								mStartPositionX;
 		float								mIncrementAmount;
 		bool								mFillFromTop;
+		int									mItemsPerLine;
+		float								mCrossIncrement;
+
+		// Deferred binding. Queued placeholder indices are checked when they come up,
+		// since the item may have scrolled away; the generation changes with the content.
+		int									mBindsPerUpdate;
+		std::deque<size_t>					mBindQueue;
+		int									mContentGeneration;
+		ds::RunnableClient					mPrepareClient;
 
 		// for animate on
 		float								mAnimateOnDeltaDelay;
@@ -113,6 +170,25 @@ class ScrollArea;
 		std::function<void(ds::ui::Sprite*, const int dbId)>		mSetDataCallback;
 		std::function<void(ds::ui::Sprite*, const float delay)>	mAnimateOnCallback;
 		std::function<void(ds::ui::Sprite*, const bool highli)>	mStateChangeCallback;
+		std::function<float(const int dbId)>						mItemSizeCallback;
+		std::function<int(const int dbId)>							mItemTypeCallback;
+		std::function<ds::ui::Sprite*(const int itemType)>			mCreateTypedItemCallback;
+		std::function<void(const int dbId)>							mPrepareDataCallback;
+
+	private:
+		// Measure where each line starts and ends from the placed placeholders.
+		void								measureLines();
+		float								itemSize(const ItemPlaceHolder&) const;
+		float								lineSize(const size_t line) const;
+
+		// Spare sprites, hidden, by item type
+		std::unordered_map<int, std::vector<ds::ui::Sprite*>>
+											mReserveItems;
+		// Where each line starts and ends along the scroll direction, in the scroll holder
+		// (negated in perspective, where lines run up). Starts are held to no more than the
+		// next line's and ends to no less than the last's, so both can be binary searched.
+		std::vector<float>					mLineStarts;
+		std::vector<float>					mLineEnds;
 	};
 }
 }
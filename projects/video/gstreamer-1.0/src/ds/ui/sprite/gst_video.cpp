@@ -83,6 +83,8 @@ GstVideo::GstVideo(SpriteEngine& engine)
 	, mAutoExtendIdle(false)
 	, mGenerateAudioBuffer(false)
 	, mColorType(kColorTypeTransparent)
+	, mPboIndex(0)
+	, mPboChecked(false)
 {
 	mBlobType = GstVideoNet::mBlobType;
 
@@ -151,33 +153,15 @@ void GstVideo::drawLocalClient(){
 			unloadVideo();
 		} else {
 
-			int videoDepth = mVideoSize.x * 4; // BGRA: therefore there is 4x8 bits per pixel, therefore 4 bytes per pixel.
-			ci::SurfaceChannelOrder co = ci::SurfaceChannelOrder::BGRA;
-			if(mColorType == kColorTypeSolid){
-				videoDepth = mVideoSize.x * 3;
-				co = ci::SurfaceChannelOrder::BGR;
-			} else if(mColorType == kColorTypeShaderTransform){
-				videoDepth = mVideoSize.x;
-				co = ci::SurfaceChannelOrder::CHAN_RED;
-			}
-
-			unsigned char * dat = mGstreamerWrapper->getVideo();
-			if(dat){
-				if(mColorType == kColorTypeShaderTransform){
-					ci::Channel8u yChannel(mVideoSize.x, mVideoSize.y, mVideoSize.x, 1, dat);
-					ci::Channel8u uChannel(mVideoSize.x / 2, mVideoSize.y / 2, mVideoSize.x / 2, 1, dat + mVideoSize.x * mVideoSize.y);
-					ci::Channel8u vChannel(mVideoSize.x / 2, mVideoSize.y / 2, mVideoSize.x / 2, 1, dat + mVideoSize.x * mVideoSize.y + mVideoSize.x * (mVideoSize.y / 4));
-
-					mFrameTexture.update(yChannel, ci::Area(0, 0, mVideoSize.x, mVideoSize.y));
-					mUFrameTexture.update(uChannel, ci::Area(0, 0, mVideoSize.x / 2, mVideoSize.y / 2));
-					mVFrameTexture.update(vChannel, ci::Area(0, 0, mVideoSize.x / 2, mVideoSize.y / 2));
-
-				} else {
-					ci::Surface video_surface(dat, mVideoSize.x, mVideoSize.y, videoDepth, co);
-					mFrameTexture.update(video_surface);
+			int frameSize = 0;
+			const unsigned char* frame = mGstreamerWrapper->lockVideoFrame(&frameSize);
+			if(frame){
+				// A short buffer would read past the end; skip it and wait for the next one
+				if(frameSize >= getFrameBytes() && mFrameTexture){
+					uploadFrame(frame);
+					mDrawable = true;
 				}
-
-				mDrawable = true;
+				mGstreamerWrapper->unlockVideoFrame();
 			}
 
 			if(mPlaySingleFrame){
@@ -224,6 +208,76 @@ void GstVideo::drawLocalClient(){
 	}
 }
 
+int GstVideo::getFrameBytes() const {
+	// The color types share their numbering with the wrapper's color spaces
+	GStreamerWrapper::VideoPlane planes[3];
+	size_t frameBytes = 0;
+	GStreamerWrapper::getVideoPlanes(mColorType, mVideoSize.x, mVideoSize.y, planes, &frameBytes);
+	return static_cast<int>(frameBytes);
+}
+
+void GstVideo::uploadFrame(const unsigned char* frame){
+	if(!mPboChecked){
+		mPboChecked = true;
+		if(ci::gl::isExtensionAvailable("GL_ARB_pixel_buffer_object")){
+			mPbo[0] = ci::gl::Vbo(GL_PIXEL_UNPACK_BUFFER_ARB);
+			mPbo[1] = ci::gl::Vbo(GL_PIXEL_UNPACK_BUFFER_ARB);
+		}
+	}
+
+	// With a PBO bound, the pixel pointers below are offsets into it. The
+	// copy into the PBO replaces the one the driver would make anyway, and
+	// the transfer to the texture happens without blocking.
+	const int frameBytes = getFrameBytes();
+	const unsigned char* src = frame;
+	ci::gl::Vbo* pbo = nullptr;
+	if(mPbo[mPboIndex]){
+		pbo = &mPbo[mPboIndex];
+		mPboIndex = 1 - mPboIndex;
+		pbo->bind();
+		// Orphan the old storage, so we never wait on its transfer
+		pbo->bufferData(frameBytes, nullptr, GL_STREAM_DRAW);
+		uint8_t* dst = pbo->map(GL_WRITE_ONLY);
+		if(dst){
+			memcpy(dst, frame, frameBytes);
+			pbo->unmap();
+			src = nullptr;
+		} else {
+			pbo->unbind();
+			pbo = nullptr;
+		}
+	}
+
+	auto upload = [src](ci::gl::Texture& tex, const size_t offset, const int w, const int h, const GLenum format){
+		const GLvoid* pixels = src ? static_cast<const GLvoid*>(src + offset) : reinterpret_cast<const GLvoid*>(offset);
+		tex.bind();
+		glTexSubImage2D(tex.getTarget(), 0, 0, 0, w, h, format, GL_UNSIGNED_BYTE, pixels);
+		tex.unbind();
+	};
+
+	// GStreamer pads every row to 4 bytes, which is what the default
+	// GL_UNPACK_ALIGNMENT of 4 expects, so the strides line up as they are.
+	GStreamerWrapper::VideoPlane planes[3];
+	GStreamerWrapper::getVideoPlanes(mColorType, mVideoSize.x, mVideoSize.y, planes);
+	if(mColorType == kColorTypeShaderTransform){
+		upload(mFrameTexture, planes[0].m_Offset, planes[0].m_Width, planes[0].m_Height, GL_LUMINANCE);
+		if(mUFrameTexture) upload(mUFrameTexture, planes[1].m_Offset, planes[1].m_Width, planes[1].m_Height, GL_LUMINANCE);
+		if(mVFrameTexture) upload(mVFrameTexture, planes[2].m_Offset, planes[2].m_Width, planes[2].m_Height, GL_LUMINANCE);
+	} else {
+		upload(mFrameTexture, 0, planes[0].m_Width, planes[0].m_Height, mColorType == kColorTypeSolid ? GL_BGR : GL_BGRA);
+	}
+
+	if(pbo) pbo->unbind();
+}
+
+int GstVideo::getDroppedFrames() const {
+	return mGstreamerWrapper ? mGstreamerWrapper->getDroppedFrames() : 0;
+}
+
+double GstVideo::getFrameLatencyMs() const {
+	return mGstreamerWrapper ? mGstreamerWrapper->getFrameLatencyMs() : 0.0;
+}
+
 void GstVideo::setSize( float width, float height ){
 	setScale( width / getWidth(), height / getHeight() );
 }
@@ -326,10 +380,13 @@ void GstVideo::doLoadVideo(const std::string &filename){
 		ci::gl::Texture::Format fmt;
 
 		if(mColorType == kColorTypeShaderTransform){
+			// Chroma planes round up, so an odd sized frame keeps its last row and column
+			GStreamerWrapper::VideoPlane planes[3];
+			GStreamerWrapper::getVideoPlanes(mColorType, mVideoSize.x, mVideoSize.y, planes);
 			fmt.setInternalFormat(GL_LUMINANCE);
-			mFrameTexture = ci::gl::Texture(static_cast<int>(getWidth()), static_cast<int>(getHeight()), fmt);
-			mUFrameTexture = ci::gl::Texture(static_cast<int>(getWidth() / 2.0f), static_cast<int>(getHeight() / 2.0f), fmt);
-			mVFrameTexture = ci::gl::Texture(static_cast<int>(getWidth() / 2.0f), static_cast<int>(getHeight() / 2.0f), fmt);
+			mFrameTexture = ci::gl::Texture(planes[0].m_Width, planes[0].m_Height, fmt);
+			mUFrameTexture = ci::gl::Texture(planes[1].m_Width, planes[1].m_Height, fmt);
+			mVFrameTexture = ci::gl::Texture(planes[2].m_Width, planes[2].m_Height, fmt);
 		} else {
 			mFrameTexture = ci::gl::Texture(static_cast<int>(getWidth()), static_cast<int>(getHeight()), fmt);
 		}
@@ -2,6 +2,7 @@
 #define DS_UI_SPRITE_GST_VIDEO_H_
 
 #include <cinder/gl/Texture.h>
+#include <cinder/gl/Vbo.h>
 
 #include <ds/ui/sprite/sprite.h>
 #include <ds/data/resource.h>
@@ -134,6 +135,10 @@ public:
 
 	// Calculates a rough fps for how many actual buffers we're displaying per second
 	float				getVideoPlayingFramerate();
+	// Frames decoded but never drawn because a newer one arrived first, since the video was loaded
+	int					getDroppedFrames() const;
+	// Milliseconds between the last drawn frame being decoded and being uploaded
+	double				getFrameLatencyMs() const;
 
 protected:
 	virtual void		drawLocalClient() override;
@@ -155,6 +160,10 @@ private:
 	void				checkOutOfBounds();
 	void				setStatus(const int);
 	void				checkStatus();
+	// Bytes in a frame of the current size and color type
+	int					getFrameBytes() const;
+	// Upload a frame straight from the decoder's buffer into the frame textures
+	void				uploadFrame(const unsigned char* frame);
 
 private:
 	GstVideoNet			mNetHandler;
@@ -169,6 +178,11 @@ private:
 	ci::gl::Texture		mFrameTexture;
 	ci::gl::Texture		mUFrameTexture;
 	ci::gl::Texture		mVFrameTexture;
+	// Double-buffered pixel unpack buffers, so the texture upload doesn't wait
+	// on the GPU. Only used if the driver supports them.
+	ci::gl::Vbo			mPbo[2];
+	int					mPboIndex;
+	bool				mPboChecked;
 
 	ci::Vec2i			mVideoSize;
 	std::string			mFilename;
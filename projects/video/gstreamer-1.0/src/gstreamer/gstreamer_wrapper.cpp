@@ -24,6 +24,13 @@ GStreamerWrapper::GStreamerWrapper()
 	, m_VideoLock(m_VideoMutex, std::defer_lock)
 	, m_VerboseLogging(false)
 	, m_cVideoBufferSize(0)
+	, m_bVideoEnabled(false)
+	, m_PendingSample(NULL)
+	, m_PendingTime(0)
+	, m_LockedSample(NULL)
+	, m_iDroppedFrames(0)
+	, m_iDeliveredFrames(0)
+	, m_dFrameLatencyMs(0.0)
 {
 	gst_init( NULL, NULL );
 	m_CurrentPlayState = NOT_INITIALIZED;
@@ -72,6 +79,9 @@ void GStreamerWrapper::resetProperties(){
 	m_LoopMode = LOOP;
 	m_PendingSeek = false;
 	m_cVideoBufferSize = 0;
+	m_iDroppedFrames = 0;
+	m_iDeliveredFrames = 0;
+	m_dFrameLatencyMs = 0.0;
 }
 
 void GStreamerWrapper::parseFilename(const std::string& theFile){
@@ -87,6 +97,38 @@ void GStreamerWrapper::parseFilename(const std::string& theFile){
 	m_strFilename = strFilename;
 }
 
+int GStreamerWrapper::getVideoPlanes(const int colorSpace, const int width, const int height, VideoPlane planes[3], size_t* frameBytes){
+	const int w = width > 0 ? width : 0;
+	const int h = height > 0 ? height : 0;
+	int count = 1;
+	planes[0].m_Offset = 0;
+	planes[0].m_Width = w;
+	planes[0].m_Height = h;
+	if(colorSpace == kColorSpaceI420){
+		// Same rounding as gst_video_info_set_format(): chroma is half size rounded up, every row padded to 4
+		const int chromaWidth = (w + 1) / 2;
+		const int chromaHeight = (h + 1) / 2;
+		planes[0].m_Stride = (w + 3) & ~3;
+		for(int i = 1; i < 3; ++i){
+			planes[i].m_Width = chromaWidth;
+			planes[i].m_Height = chromaHeight;
+			planes[i].m_Stride = (chromaWidth + 3) & ~3;
+		}
+		planes[1].m_Offset = (size_t)planes[0].m_Stride * (size_t)(chromaHeight * 2);
+		planes[2].m_Offset = planes[1].m_Offset + (size_t)planes[1].m_Stride * (size_t)chromaHeight;
+		count = 3;
+	} else if(colorSpace == kColorSpaceSolid){
+		planes[0].m_Stride = (w * 3 + 3) & ~3;
+	} else {
+		planes[0].m_Stride = w * 4;
+	}
+	if(frameBytes){
+		const VideoPlane& last = planes[count - 1];
+		*frameBytes = last.m_Offset + (size_t)last.m_Stride * (size_t)last.m_Height;
+	}
+	return count;
+}
+
 void GStreamerWrapper::enforceModFourWidth(const int vidWidth, const int vidHeight){
 	int videoWidth = vidWidth;
 	int videoHeight = vidHeight;
@@ -122,61 +164,11 @@ bool GStreamerWrapper::open(const std::string& strFilename, const bool bGenerate
 	if ( bGenerateVideoBuffer ){
 		// Create the video appsink and configure it
 		m_GstVideoSink = gst_element_factory_make("appsink", "videosink");
-
-	//	gst_app_sink_set_max_buffers( GST_APP_SINK( m_GstVideoSink ), 2 );
-		//gst_app_sink_set_drop( GST_APP_SINK( m_GstVideoSink ), true );
-		gst_base_sink_set_qos_enabled(GST_BASE_SINK(m_GstVideoSink), true);
-		gst_base_sink_set_max_lateness(GST_BASE_SINK(m_GstVideoSink), -1); // 1000000000 = 1 second, 40000000 = 40 ms, 20000000 = 20 ms
-
-		// Set some fix caps for the video sink
-		GstCaps* caps;
-
-		if(colorSpace == kColorSpaceTransparent){
-			m_cVideoBufferSize = 4 * m_iWidth * m_iHeight;
-			caps = gst_caps_new_simple("video/x-raw",
-									   "format", G_TYPE_STRING, "BGRA",
-									   "width", G_TYPE_INT, m_iWidth,
-									   "height", G_TYPE_INT, m_iHeight,
-									   NULL);
-
-		} else if(colorSpace == kColorSpaceSolid){
-			m_cVideoBufferSize = 3 * m_iWidth * m_iHeight;
-
-			caps = gst_caps_new_simple("video/x-raw",
-									   "format", G_TYPE_STRING, "BGR",
-									   "width", G_TYPE_INT, m_iWidth,
-									   "height", G_TYPE_INT, m_iHeight,
-									   NULL);
-
-		} else if(colorSpace == kColorSpaceI420){
-			// 1.5 * w * h, for I420 color space, which has a full-size luma channel, and 1/4 size U and V color channels
-			m_cVideoBufferSize = (int)(1.5 * m_iWidth * m_iHeight);
-
-
-			caps = gst_caps_new_simple("video/x-raw",
-									   "format", G_TYPE_STRING, "I420",
-									   "width", G_TYPE_INT, m_iWidth,
-									   "height", G_TYPE_INT, m_iHeight,
-									   NULL);
-		}
-
-		m_cVideoBuffer = new unsigned char[m_cVideoBufferSize];
-
-		gst_app_sink_set_caps( GST_APP_SINK( m_GstVideoSink ), caps );
-		gst_caps_unref( caps );
+		setupVideoSink(colorSpace);
 
 		// Set the configured video appsink to the main pipeline
 		g_object_set( m_GstPipeline, "video-sink", m_GstVideoSink, (void*)NULL );
 
-		// Tell the video appsink that it should not emit signals as the buffer retrieving is handled via callback methods
-		g_object_set( m_GstVideoSink, "emit-signals", false, "sync", true, "async", true, (void*)NULL );
-
-		// Set Video Sink callback methods
-		m_GstVideoSinkCallbacks.eos = &GStreamerWrapper::onEosFromVideoSource;
-		m_GstVideoSinkCallbacks.new_preroll = &GStreamerWrapper::onNewPrerollFromVideoSource;
-		m_GstVideoSinkCallbacks.new_sample = &GStreamerWrapper::onNewBufferFromVideoSource;
-		gst_app_sink_set_callbacks( GST_APP_SINK( m_GstVideoSink ), &m_GstVideoSinkCallbacks, this, NULL );
-
 	} else {
 
 		if(m_iHeight > 0 && m_iWidth > 0){
@@ -218,6 +210,92 @@ bool GStreamerWrapper::open(const std::string& strFilename, const bool bGenerate
 		g_object_set ( m_GstPipeline, "audio-sink", audioSink, NULL );
 	}
 
+	startPipeline();
+	return true;
+}
+
+bool GStreamerWrapper::openPipeline(const std::string& description, const int colorSpace, const int videoWidth, const int videoHeight){
+	resetProperties();
+
+	if( m_bFileIsOpen )	{
+		stop();
+		close();
+	}
+
+	m_strFilename = description;
+	enforceModFourWidth(videoWidth, videoHeight);
+
+	// Convert and scale whatever the source makes into the caps the sink asks for
+	const std::string launch = description + " ! videoconvert ! videoscale ! appsink name=videosink";
+	GError* err = NULL;
+	m_GstPipeline = gst_parse_launch(launch.c_str(), &err);
+	if(err){
+		DS_LOG_WARNING("GStreamerWrapper::openPipeline() can't parse " << description << ": " << err->message);
+		g_error_free(err);
+		if(m_GstPipeline) gst_object_unref(m_GstPipeline);
+		m_GstPipeline = NULL;
+		return false;
+	}
+
+	// The pipeline holds the sink, so don't keep a second reference
+	m_GstVideoSink = gst_bin_get_by_name(GST_BIN(m_GstPipeline), "videosink");
+	if(!m_GstVideoSink){
+		gst_object_unref(m_GstPipeline);
+		m_GstPipeline = NULL;
+		return false;
+	}
+	gst_object_unref(m_GstVideoSink);
+	setupVideoSink(colorSpace);
+
+	// No playbin to ask, but there's only ever the one video stream
+	m_ContentType = VIDEO;
+	m_iNumVideoStreams = 1;
+
+	startPipeline();
+	return true;
+}
+
+void GStreamerWrapper::setupVideoSink(const int colorSpace){
+	gst_base_sink_set_qos_enabled(GST_BASE_SINK(m_GstVideoSink), true);
+	gst_base_sink_set_max_lateness(GST_BASE_SINK(m_GstVideoSink), -1); // 1000000000 = 1 second, 40000000 = 40 ms, 20000000 = 20 ms
+
+	// Set some fix caps for the video sink
+	const char* format = "BGRA";
+	if(colorSpace == kColorSpaceSolid){
+		format = "BGR";
+	} else if(colorSpace == kColorSpaceI420){
+		// A full-size luma channel, and 1/4 size U and V color channels
+		format = "I420";
+	}
+	size_t frameBytes = 0;
+	VideoPlane planes[3];
+	getVideoPlanes(colorSpace, m_iWidth, m_iHeight, planes, &frameBytes);
+	m_cVideoBufferSize = (int)frameBytes;
+
+	GstCaps* caps = gst_caps_new_simple("video/x-raw",
+										"format", G_TYPE_STRING, format,
+										"width", G_TYPE_INT, m_iWidth,
+										"height", G_TYPE_INT, m_iHeight,
+										NULL);
+	{
+		std::lock_guard<decltype(m_VideoLock)> lock(m_VideoLock);
+		m_bVideoEnabled = true;
+	}
+
+	gst_app_sink_set_caps( GST_APP_SINK( m_GstVideoSink ), caps );
+	gst_caps_unref( caps );
+
+	// Tell the video appsink that it should not emit signals as the buffer retrieving is handled via callback methods
+	g_object_set( m_GstVideoSink, "emit-signals", false, "sync", true, "async", true, (void*)NULL );
+
+	// Set Video Sink callback methods
+	m_GstVideoSinkCallbacks.eos = &GStreamerWrapper::onEosFromVideoSource;
+	m_GstVideoSinkCallbacks.new_preroll = &GStreamerWrapper::onNewPrerollFromVideoSource;
+	m_GstVideoSinkCallbacks.new_sample = &GStreamerWrapper::onNewBufferFromVideoSource;
+	gst_app_sink_set_callbacks( GST_APP_SINK( m_GstVideoSink ), &m_GstVideoSinkCallbacks, this, NULL );
+}
+
+void GStreamerWrapper::startPipeline(){
 	// BUS
 	// Set GstBus
 	m_GstBus = gst_pipeline_get_bus( GST_PIPELINE( m_GstPipeline ) );
@@ -244,8 +322,6 @@ bool GStreamerWrapper::open(const std::string& strFilename, const bool bGenerate
 
 	// A file has been opened
 	m_bFileIsOpen = true;
-
-	return true;
 }
 
 void GStreamerWrapper::close(){
@@ -269,7 +345,16 @@ void GStreamerWrapper::close(){
 		m_GstBus = NULL;
 	}
 
+	unlockVideoFrame();
+
 	std::lock_guard<decltype(m_VideoLock)> lock(m_VideoLock);
+	m_bVideoEnabled = false;
+	if(m_PendingSample){
+		gst_sample_unref(m_PendingSample);
+		m_PendingSample = NULL;
+	}
+	m_bIsNewVideoFrame = false;
+
 	delete [] m_cVideoBuffer;
 	m_cVideoBuffer = NULL;
 
@@ -402,11 +487,67 @@ std::string GStreamerWrapper::getFileName(){
 }
 
 unsigned char* GStreamerWrapper::getVideo(){
-	std::lock_guard<decltype(m_VideoLock)> lock(m_VideoLock);
-	m_bIsNewVideoFrame = false;
+	int size = 0;
+	const unsigned char* frame = lockVideoFrame(&size);
+	if(frame){
+		if(!m_cVideoBuffer || m_cVideoBufferSize != size){
+			delete[] m_cVideoBuffer;
+			m_cVideoBufferSize = size;
+			m_cVideoBuffer = new unsigned char[m_cVideoBufferSize];
+		}
+		memcpy(m_cVideoBuffer, frame, size);
+	}
+	unlockVideoFrame();
 	return m_cVideoBuffer;
 }
 
+const unsigned char* GStreamerWrapper::lockVideoFrame(int* size){
+	unlockVideoFrame();
+
+	GstSample* sample = NULL;
+	gint64 arrived = 0;
+	{
+		std::lock_guard<decltype(m_VideoLock)> lock(m_VideoLock);
+		sample = m_PendingSample;
+		arrived = m_PendingTime;
+		m_PendingSample = NULL;
+		m_bIsNewVideoFrame = false;
+	}
+	if(!sample) return NULL;
+
+	GstBuffer* buff = gst_sample_get_buffer(sample);
+	if(!buff || !gst_buffer_map(buff, &m_LockedMap, GST_MAP_READ)){
+		gst_sample_unref(sample);
+		return NULL;
+	}
+	m_LockedSample = sample;
+	++m_iDeliveredFrames;
+	m_dFrameLatencyMs = (double)(g_get_monotonic_time() - arrived) / 1000.0;
+
+	if(size) *size = (int)m_LockedMap.size;
+	return m_LockedMap.data;
+}
+
+void GStreamerWrapper::unlockVideoFrame(){
+	if(!m_LockedSample) return;
+
+	gst_buffer_unmap(gst_sample_get_buffer(m_LockedSample), &m_LockedMap);
+	gst_sample_unref(m_LockedSample);
+	m_LockedSample = NULL;
+}
+
+int GStreamerWrapper::getDroppedFrames() const {
+	return m_iDroppedFrames;
+}
+
+int GStreamerWrapper::getDeliveredFrames() const {
+	return m_iDeliveredFrames;
+}
+
+double GStreamerWrapper::getFrameLatencyMs() const {
+	return m_dFrameLatencyMs;
+}
+
 int GStreamerWrapper::getCurrentVideoStream(){
 	return m_iCurrentVideoStream;
 }
@@ -625,11 +766,14 @@ void GStreamerWrapper::retrieveVideoInfo(){
 	m_dDurationInMs = (double)(GST_TIME_AS_MSECONDS( m_iDurationInNs ));
 
 	////////////////////////////////////////////////////////////////////////// Stream Info
-	// Number of Video Streams
-	g_object_get( m_GstPipeline, "n-video", &m_iNumVideoStreams, NULL );
+	// Only playbin knows its streams; openPipeline() set them already
+	if(g_object_class_find_property(G_OBJECT_GET_CLASS(m_GstPipeline), "n-video")){
+		// Number of Video Streams
+		g_object_get( m_GstPipeline, "n-video", &m_iNumVideoStreams, NULL );
 
-	// Number of Audio Streams
-	g_object_get( m_GstPipeline, "n-audio", &m_iNumAudioStreams, NULL );
+		// Number of Audio Streams
+		g_object_get( m_GstPipeline, "n-audio", &m_iNumAudioStreams, NULL );
+	}
 
 	// Set Content Type according to the number of available Video and Audio streams
 	if ( m_iNumVideoStreams > 0 && m_iNumAudioStreams > 0 ){
@@ -866,57 +1010,32 @@ GstFlowReturn GStreamerWrapper::onNewBufferFromAudioSource( GstAppSink* appsink,
 }
 
 void GStreamerWrapper::newVideoSinkPrerollCallback(GstSample* videoSinkSample){
-	if(!m_cVideoBuffer) return;
-
-	std::lock_guard<decltype(m_VideoLock)> lock(m_VideoLock);
-	GstBuffer* buff = gst_sample_get_buffer(videoSinkSample);	
-
-
-	GstMapInfo map;
-	GstMapFlags flags = GST_MAP_READ;
-	gst_buffer_map(buff, &map, flags);
-
-	unsigned int videoBufferSize = map.size; 
-
-	// sanity check on buffer size, in case something weird happened.
-	// In practice, this can fuck up the look of the video, but it plays and doesn't crash
-	if(m_cVideoBufferSize != videoBufferSize){
-		delete[] m_cVideoBuffer;
-		m_cVideoBufferSize = videoBufferSize;
-		m_cVideoBuffer = new unsigned char[m_cVideoBufferSize];
-	} 
-
-	memcpy((unsigned char *)m_cVideoBuffer, map.data, videoBufferSize);
-	if(!m_PendingSeek) m_bIsNewVideoFrame = true;
-	
-
-	gst_buffer_unmap(buff, &map);
+	storeVideoSample(videoSinkSample, false);
 }
 
 void GStreamerWrapper::newVideoSinkBufferCallback( GstSample* videoSinkSample ){
-	if(!m_cVideoBuffer) return;
-
-	std::lock_guard<decltype(m_VideoLock)> lock(m_VideoLock);
-	if(!m_PendingSeek) m_bIsNewVideoFrame = true;
-
-	GstBuffer* buff = gst_sample_get_buffer(videoSinkSample);	
-	GstMapInfo map;
-	GstMapFlags flags = GST_MAP_READ;
-	gst_buffer_map(buff, &map, flags);
-
+	storeVideoSample(videoSinkSample, true);
+}
 
-	unsigned int videoBufferSize = map.size;
+void GStreamerWrapper::storeVideoSample( GstSample* videoSinkSample, const bool countDropped ){
+	if(!videoSinkSample) return;
 
-	if(m_cVideoBufferSize != videoBufferSize){
-		delete[] m_cVideoBuffer;
-		m_cVideoBufferSize = videoBufferSize;
-		m_cVideoBuffer = new unsigned char[m_cVideoBufferSize];
+	GstSample* replaced = NULL;
+	{
+		std::lock_guard<decltype(m_VideoLock)> lock(m_VideoLock);
+		if(!m_bVideoEnabled) return;
+
+		replaced = m_PendingSample;
+		m_PendingSample = gst_sample_ref(videoSinkSample);
+		m_PendingTime = g_get_monotonic_time();
+		if(!m_PendingSeek){
+			if(replaced && countDropped) ++m_iDroppedFrames;
+			m_bIsNewVideoFrame = true;
+		}
 	}
 
-	memcpy((unsigned char *)m_cVideoBuffer, map.data, videoBufferSize);
-	if(!m_PendingSeek) m_bIsNewVideoFrame = true;
-
-	gst_buffer_unmap(buff, &map);
+	// Releasing the old sample can hand its buffer back to the decoder, so do it outside the lock
+	if(replaced) gst_sample_unref(replaced);
 }
 
 void GStreamerWrapper::newAudioSinkPrerollCallback( GstSample* audioSinkBuffer ){
@@ -94,6 +94,20 @@ public:
 
 	typedef enum { kColorSpaceTransparent = 0, kColorSpaceSolid, kColorSpaceI420 } ColorSpace;
 
+	/* Where one plane of a raw frame sits in the buffer, in bytes, laid out the way GStreamer lays it out. */
+	struct VideoPlane {
+		size_t				m_Offset;
+		int					m_Width;
+		int					m_Height;
+		int					m_Stride;
+	};
+
+	/*
+	Fills in the planes for a frame of the color space and returns how many there are (1 for BGRA and BGR, 3 for I420).
+	GStreamer pads every row to 4 bytes, so BGR and odd sized I420 frames are bigger than the pixel count suggests.
+	*/
+	static int				getVideoPlanes(const int colorSpace, const int width, const int height, VideoPlane planes[3], size_t* frameBytes = NULL);
+
 	/*
 	Opens a file according to the string parameter. Sets the wrapper's PlayState to OPENED
 
@@ -118,6 +132,12 @@ public:
 	*/
 	bool					open(const std::string& strFilename, const bool bGenerateVideoBuffer, const bool bGenerateAudioBuffer, const int colorSpace, const int videoWidth, const int videoHeight);
 
+	/*
+	Opens a gst-launch style description in place of a file, e.g. "videotestsrc num-buffers=30". The wrapper appends the
+	converter and its own appsink, so the description should end in a source pad. Video only.
+	*/
+	bool					openPipeline(const std::string& description, const int colorSpace, const int videoWidth, const int videoHeight);
+
 	/*
 	Closes the file and frees allocated memory for both video and audio buffers as well as various GStreamer references
 	*/
@@ -250,10 +270,37 @@ public:
 	/*
 	Returns an unsigned char pointer containing the pixel data for the currently decoded frame.
 	Returns NULL if there is either no video stream in the media file, no media file has been opened or something
-	went wrong while streaming
+	went wrong while streaming.
+	Note: This copies the frame. Uploading from lockVideoFrame() avoids that.
 	*/
 	unsigned char*			getVideo();
 
+	/*
+	Returns the pixels of the newest decoded frame without copying them, or NULL if there's no new frame.
+	The frame stays mapped in GStreamer's buffer until unlockVideoFrame(), so upload it and unlock right away.
+	Frames that arrive while one is locked queue behind it; only the newest is kept.
+
+	params:
+	@size: If not NULL, set to the number of bytes in the frame
+	*/
+	const unsigned char*	lockVideoFrame(int* size = NULL);
+	void					unlockVideoFrame();
+
+	/*
+	Returns the number of decoded frames that were replaced by a newer frame before they were locked, since open()
+	*/
+	int						getDroppedFrames() const;
+
+	/*
+	Returns the number of frames locked since open()
+	*/
+	int						getDeliveredFrames() const;
+
+	/*
+	Returns the milliseconds between the last locked frame arriving from GStreamer and being locked
+	*/
+	double					getFrameLatencyMs() const;
+
 	/*
 	Returns the index of the current video stream
 	*/
@@ -527,6 +574,15 @@ private:
 	*/
 	void					newVideoSinkBufferCallback( GstSample* videoSinkBuffer );
 
+	/*
+	Holds a reference to the sample as the pending frame, replacing (and dropping) any frame that wasn't locked yet
+
+	params:
+	@videoSinkSample: The sample that was gathered from the video sink
+	@countDropped: False for preroll samples, which are usually repeated by the first buffer
+	*/
+	void					storeVideoSample( GstSample* videoSinkSample, const bool countDropped );
+
 	/*
 	Non-static method that is called inside "onNewPrerollFromAudioSource()" in order to handle
 	member variables that are non-static. Here the unsigned char array with the audio data is actually filled
@@ -560,6 +616,12 @@ private:
 	// Makes sure videos widths are divisible by 4, for video blanking
 	void					enforceModFourWidth(const int videoWidth, const int videoHeight);
 
+	// Caps, buffer size and callbacks for m_GstVideoSink
+	void					setupVideoSink(const int colorSpace);
+
+	// Moves a freshly built pipeline to PAUSED (or PLAYING) and marks it open
+	void					startPipeline();
+
 protected:
 
 	int						m_iAudioBufferSize; /* Size of the audio buffer */
@@ -609,8 +671,19 @@ private:
 	PlayState				m_CurrentPlayState; /* The current state of the wrapper */
 	PlayDirection			m_PlayDirection; /* The current playback direction */
 	ContentType				m_ContentType; /* Describes whether the currently loaded media file contains only video / audio streams or both */
-	unsigned char*			m_cVideoBuffer; /* Stores the video pixels */
+	unsigned char*			m_cVideoBuffer; /* Copy of the video pixels, only made by getVideo() */
 	int						m_cVideoBufferSize; /* Number of bytes in m_cVideoBuffer */
+	bool					m_bVideoEnabled; /* Video frames are being kept, guarded by m_VideoLock */
+	// Frames are never copied out of GStreamer. The newest sample waits in m_PendingSample (guarded by
+	// m_VideoLock) until it's locked, then stays mapped in m_LockedSample until it's unlocked, so at most
+	// two decoder buffers are held at once.
+	GstSample*				m_PendingSample;
+	gint64					m_PendingTime; /* When the pending sample arrived, from g_get_monotonic_time() */
+	GstSample*				m_LockedSample;
+	GstMapInfo				m_LockedMap;
+	std::atomic<int>		m_iDroppedFrames;
+	std::atomic<int>		m_iDeliveredFrames;
+	double					m_dFrameLatencyMs;
 	GstElement*				m_GstVideoSink; /* Video sink that contains the raw video buffer. Gathered from the pipeline */
 	GstAppSinkCallbacks		m_GstVideoSinkCallbacks; /* Stores references to the callback methods for video preroll, new video buffer and video eos */
 	GstAppSinkCallbacks		m_GstAudioSinkCallbacks; /* Stores references to the callback methods for audio preroll, new audio buffer and audio eos */
@@ -10,7 +10,9 @@
 #include "ds/app/engine/engine_standalone.h"
 #include "ds/app/engine/engine_stats_view.h"
 #include "ds/app/environment.h"
+#include "ds/debug/benchmark.h"
 #include "ds/debug/console.h"
+#include "ds/debug/frame_profiler.h"
 #include "ds/debug/logger.h"
 #include "ds/debug/debug_defines.h"
 
@@ -31,6 +33,7 @@
 #include "ds/ui/mesh_source/mesh_cache_service.h"
 
 // For installing the framework services
+#include "ds/ui/service/generated_image_service.h"
 #include "ds/ui/service/glsl_image_service.h"
 
 // For verifying that the resources are installed
@@ -123,7 +126,8 @@ App::App(const RootList& roots)
 
 	// Install the framework services
 	mEngine.addService(ds::glsl::IMAGE_SERVICE, *(new ds::glsl::ImageService(mEngine)));
-	mEngine.addService(ds::MESH_CACHE_SERVICE_NAME, *(new ds::MeshCacheService()));
+	mEngine.addService(ds::ui::GENERATED_IMAGE_SERVICE, *(new ds::ui::GeneratedImageService(mEngine)));
+	mEngine.addService(ds::MESH_CACHE_SERVICE_NAME, *(new ds::MeshCacheService(mEngine)));
 
 	if (mArrowKeyCameraControl) {
 		// Currently this is necessary for the keyboard commands
@@ -174,9 +178,16 @@ void App::setup() {
 
 	mEngine.setup(*this);
 	mEngine.setupTuio(*this);
+
+	ds::Benchmark		benchmark(mEngine, mEngine.getDebugSettings());
+	if (benchmark.isEnabled()) {
+		benchmark.run();
+		if (benchmark.quitWhenDone()) quit();
+	}
 }
 
 void App::update() {
+	ds::getFrameProfiler().beginFrame();
 	mEngine.setAverageFps(getAverageFps());
 	if (mEngine.hideMouse()) {
 		hideCursor();
@@ -255,6 +266,9 @@ void App::keyDown(KeyEvent e) {
 		mEngine.nextTouchMode();
 	} else if(KeyEvent::KEY_F8 == code){
 		saveTransparentScreenshot();
+	} else if(KeyEvent::KEY_F9 == code){
+		// Chrome trace of the next frames; see ds::FrameProfiler
+		ds::getFrameProfiler().requestTrace();
 	}
 
 	if (mArrowKeyCameraControl) {
@@ -46,6 +46,11 @@ RootList& RootList::pickSelect() {
 	return *this;
 }
 
+RootList& RootList::pickGeometric() {
+	if (!mRoots.empty()) mRoots.back().mPick = Root::kGeometric;
+	return *this;
+}
+
 RootList& RootList::pickColor() {
 	if (!mRoots.empty()) mRoots.back().mPick = Root::kColor;
 	return *this;
@@ -49,8 +49,10 @@ public:
 	RootList&						persp();
 
 	// SET ROOT PARAMETERS. All of these apply to the currently active root.
-	// Use OpenGL SELECT for picking.
+	// Use OpenGL SELECT for picking, or the geometric picker if the engine "picking:cpu" setting is on.
 	RootList&						pickSelect();
+	// Cast a ray against the sprite quads on the CPU for picking.
+	RootList&						pickGeometric();
 	// Use unique colour rendering for picking.
 	RootList&						pickColor();
 	
@@ -72,7 +74,7 @@ public:
 
 		enum Type					{ kOrtho, kPerspective };
 		Type						mType;
-		enum Pick					{ kDefault, kSelect, kColor };
+		enum Pick					{ kDefault, kSelect, kColor, kGeometric };
 		Pick						mPick;
 		enum Master					{ kIndependent, kMaster, kSlave };
 		Master						mMaster;
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <Poco/Timestamp.h>
 #include "ds/app/auto_update.h"
+#include "ds/debug/frame_profiler.h"
 #include "ds/params/update_params.h"
 
 namespace ds {
@@ -16,6 +17,7 @@ AutoUpdateList::AutoUpdateList() {
 }
 
 void AutoUpdateList::update(const ds::UpdateParams &p) {
+	DS_PROFILE_SCOPE("AutoUpdateList::update");
 	if (!mWaiting.empty()) {
 		for (auto it=mWaiting.begin(), end=mWaiting.end(); it!=end; ++it) {
 			mRunning.push_back(*it);
@@ -8,10 +8,15 @@
 #include "ds/app/error.h"
 #include "ds/cfg/settings.h"
 #include "ds/debug/debug_defines.h"
+#include "ds/debug/frame_profiler.h"
 #include "ds/debug/logger.h"
 #include "ds/math/math_defs.h"
+#include "ds/network/http_client.h"
 #include "ds/ui/ip/ip_defs.h"
+#include "ds/ui/ip/functions/ip_blur.h"
 #include "ds/ui/ip/functions/ip_circle_mask.h"
+#include "ds/ui/ip/functions/ip_premultiply.h"
+#include "ds/ui/ip/functions/ip_rounded_rect_mask.h"
 
 //! This entire header is included for one single
 //! function Poco::Path::expand. This slowly needs
@@ -146,6 +151,7 @@ const int Engine::NumberOfNetworkThreads = 2;
 Engine::Engine(	ds::App& app, const ds::cfg::Settings &settings,
 				ds::EngineData& ed, const RootList& _roots)
 	: ds::ui::SpriteEngine(ed)
+	, mIdleTracker(*this)
 	, mTweenline(app.timeline())
 	, mIdling(true)
 	, mTouchMode(ds::ui::TouchMode::kTuioAndMouse)
@@ -174,17 +180,24 @@ Engine::Engine(	ds::App& app, const ds::cfg::Settings &settings,
 	// so lightweight it probably makes sense just to have them always available for clients instead
 	// of requiring some sort of configuration.
 	mIpFunctions.add(ds::ui::ip::CIRCLE_MASK, ds::ui::ip::FunctionRef(new ds::ui::ip::CircleMask()));
+	mIpFunctions.add(ds::ui::ip::ROUNDED_RECT_MASK, ds::ui::ip::FunctionRef(new ds::ui::ip::RoundedRectMask()));
+	mIpFunctions.add(ds::ui::ip::BLUR, ds::ui::ip::FunctionRef(new ds::ui::ip::Blur()));
+	mIpFunctions.add(ds::ui::ip::PREMULTIPLY, ds::ui::ip::FunctionRef(new ds::ui::ip::Premultiply()));
 
 	if (mAutoDraw) addService("AUTODRAW", *mAutoDraw);
 
 	// Construct the root sprites
 	RootList				roots(_roots.runInitFn());
 	if (roots.empty()) roots.ortho();
+	const bool				cpu_picking = settings.getBool("picking:cpu", 0, false);
 	sprite_id_t							root_id = EMPTY_SPRITE_ID-1;
 	for (auto it=roots.mRoots.begin(), end=roots.mRoots.end(); it!=end; ++it) {
-		const RootList::Root&			r(*it);
+		RootList::Root					r(*it);
 		Picking*						picking = nullptr;
-		if (r.mPick == r.kSelect) picking = &mSelectPicking;
+		if (r.mPick == r.kSelect) {
+			if (cpu_picking) r.mPick = r.kGeometric;
+			else picking = &mSelectPicking;
+		}
 		std::unique_ptr<EngineRoot>		root;
 		if (r.mType == r.kOrtho) root.reset(new OrthRoot(*this, r, root_id));
 		else if (r.mType == r.kPerspective) root.reset(new PerspRoot(*this, r, root_id, r.mPersp, picking));
@@ -199,6 +212,7 @@ Engine::Engine(	ds::App& app, const ds::cfg::Settings &settings,
 
 	ds::Environment::loadSettings("debug.xml", mDebugSettings);
 	ds::Logger::setup(mDebugSettings);
+	ds::FrameProfiler::setup(mDebugSettings);
 
 	// touch settings
 	mTouchMode = ds::ui::TouchMode::fromSettings(settings);
@@ -216,12 +230,22 @@ Engine::Engine(	ds::App& app, const ds::cfg::Settings &settings,
 	mData.mSwipeQueueSize = settings.getInt("touch:swipe:queue_size", 0, 4);
 	mData.mSwipeMinVelocity = settings.getFloat("touch:swipe:minimum_velocity", 0, 800.0f);
 	mData.mSwipeMaxTime = settings.getFloat("touch:swipe:maximum_time", 0, 0.5f);
+	mTouchMovedEvents.setCoalesce(settings.getBool("touch:coalesce_moves", 0, true));
 	mData.mFrameRate = settings.getFloat("frame_rate", 0, 60.0f);
 	mFxaaOptions.mApplyFxAA = settings.getBool("FxAA", 0, false);
 	mFxaaOptions.mFxAASpanMax = settings.getFloat("FxAA:SpanMax", 0, 2.0);
 	mFxaaOptions.mFxAAReduceMul = settings.getFloat("FxAA:ReduceMul", 0, 8.0);
 	mFxaaOptions.mFxAAReduceMin = settings.getFloat("FxAA:ReduceMin", 0, 128.0);
 
+	mDrawParams.mCull = settings.getBool("cull:client", 0, false);
+	mDrawParams.mStats = &mDrawStats;
+
+	mTextLayoutCache.setup(settings);
+
+	ds::HttpClient::setKeepAlive(settings.getBool("http:keep_alive", 0, true));
+	const std::string		http_cache = settings.getText("http:cache_folder", 0, "");
+	if (!http_cache.empty()) ds::HttpClient::setCacheFolder(ds::Environment::expand(http_cache));
+
 	mData.mWorldSize = settings.getSize("world_dimensions", 0, Vec2f(640.0f, 400.0f));
 	// Backwards compatibility with pre src-dst rect days
 	const float				DEFAULT_WINDOW_SCALE = 1.0f;
@@ -463,6 +487,7 @@ const RootList::Root& Engine::getRootBuilder(const size_t index){
 }
 
 void Engine::updateClient() {
+	DS_PROFILE_SCOPE("Engine::updateClient");
 	float curr = static_cast<float>(getElapsedSeconds());
 	float dt = curr - mLastTime;
 	mLastTime = curr;
@@ -474,14 +499,24 @@ void Engine::updateClient() {
 	mUpdateParams.setDeltaTime(dt);
 	mUpdateParams.setElapsedTime(curr);
 
+	// The app has already stepped the timeline, so tweens land before anything else updates
+	mTweenline.update();
+	mIdleTracker.update();
+	mTextLayoutCache.update();
 	mAutoUpdateClient.update(mUpdateParams);
 
-	for (auto it=mRoots.begin(), end=mRoots.end(); it!=end; ++it) {
-		(*it)->updateClient(mUpdateParams);
+	{
+		DS_PROFILE_SCOPE("EngineRoot::updateClient");
+		for (auto it=mRoots.begin(), end=mRoots.end(); it!=end; ++it) {
+			(*it)->updateClient(mUpdateParams);
+		}
 	}
+
+	deliverPostedEvents();
 }
 
 void Engine::updateServer() {
+	DS_PROFILE_SCOPE("Engine::updateServer");
 	if (mCachedWindowW != getWindowWidth() || mCachedWindowH != getWindowHeight()) {
 		mCachedWindowW = getWindowWidth();
 		mCachedWindowH = getWindowHeight();
@@ -493,34 +528,7 @@ void Engine::updateServer() {
 	const float		dt = curr - mLastTime;
 	mLastTime = curr;
 
-	//////////////////////////////////////////////////////////////////////////
-	{
-		std::lock_guard<std::mutex> lock(mTouchMutex);
-		mMouseBeginEvents.lockedUpdate();
-		mMouseMovedEvents.lockedUpdate();
-		mMouseEndEvents.lockedUpdate();
-
-		mTouchBeginEvents.lockedUpdate();
-		mTouchMovedEvents.lockedUpdate();
-		mTouchEndEvents.lockedUpdate();
-
-		mTuioObjectsBegin.lockedUpdate();
-		mTuioObjectsMoved.lockedUpdate();
-		mTuioObjectsEnd.lockedUpdate();
-	} // unlock touch mutex
-	//////////////////////////////////////////////////////////////////////////
-
-	mMouseBeginEvents.update(curr);
-	mMouseMovedEvents.update(curr);
-	mMouseEndEvents.update(curr);
-
-	mTouchBeginEvents.update(curr);
-	mTouchMovedEvents.update(curr);
-	mTouchEndEvents.update(curr);
-
-	mTuioObjectsBegin.update(curr);
-	mTuioObjectsMoved.update(curr);
-	mTuioObjectsEnd.update(curr);
+	updateTouches(curr);
 
 	if (!mIdling && (curr - mLastTouchTime) >= (float)getIdleTimeout()) {
 		mIdling = true;
@@ -529,10 +537,27 @@ void Engine::updateServer() {
 	mUpdateParams.setDeltaTime(dt);
 	mUpdateParams.setElapsedTime(curr);
 
+	// The app has already stepped the timeline, so tweens land before anything else updates
+	mTweenline.update();
+	mIdleTracker.update();
+	mTextLayoutCache.update();
 	mAutoUpdateServer.update(mUpdateParams);
 
-	for (auto it=mRoots.begin(), end=mRoots.end(); it!=end; ++it) {
-		(*it)->updateServer(mUpdateParams);
+	{
+		DS_PROFILE_SCOPE("EngineRoot::updateServer");
+		for (auto it=mRoots.begin(), end=mRoots.end(); it!=end; ++it) {
+			(*it)->updateServer(mUpdateParams);
+		}
+	}
+
+	deliverPostedEvents();
+}
+
+void Engine::deliverPostedEvents() {
+	DS_PROFILE_SCOPE("Engine::deliverPostedEvents");
+	mData.mNotifier.deliverPosted();
+	for (auto it=mChannels.begin(), end=mChannels.end(); it!=end; ++it) {
+		it->second.mNotifier.deliverPosted();
 	}
 }
 
@@ -628,10 +653,14 @@ void Engine::registerForTuioObjects(tuio::Client& client) {
 }
 
 void Engine::drawClient() {
+	DS_PROFILE_SCOPE("Engine::drawClient");
+	mDrawStats.clear();
 	mRenderer->drawClient();
+	mLastDrawStats = mDrawStats;
 }
 
 void Engine::drawServer() {
+	DS_PROFILE_SCOPE("Engine::drawServer");
 	mRenderer->drawServer();
 }
 
@@ -762,6 +791,42 @@ ci::Color8u Engine::getUniqueColor() {
 	return mUniqueColor;
 }
 
+void Engine::updateTouches(const float curr) {
+	DS_PROFILE_SCOPE("Engine::touches");
+	{
+		std::lock_guard<std::mutex> lock(mTouchMutex);
+		mMouseBeginEvents.lockedUpdate();
+		mMouseMovedEvents.lockedUpdate();
+		mMouseEndEvents.lockedUpdate();
+
+		mTouchBeginEvents.lockedUpdate();
+		mTouchMovedEvents.lockedUpdate();
+		mTouchEndEvents.lockedUpdate();
+
+		mTuioObjectsBegin.lockedUpdate();
+		mTuioObjectsMoved.lockedUpdate();
+		mTuioObjectsEnd.lockedUpdate();
+	} // unlock touch mutex
+
+	// Begins, then moves, then ends, so a finger that comes and goes
+	// within a frame is still seen in order.
+	mMouseBeginEvents.update(curr);
+	mMouseMovedEvents.update(curr);
+	mMouseEndEvents.update(curr);
+
+	mTouchBeginEvents.update(curr);
+	mTouchMovedEvents.update(curr);
+	mTouchEndEvents.update(curr);
+
+	mTuioObjectsBegin.update(curr);
+	mTuioObjectsMoved.update(curr);
+	mTuioObjectsEnd.update(curr);
+}
+
+const std::vector<ci::app::TouchEvent::Touch>& Engine::getTouchMoveSamples() const {
+	return mTouchMovedEvents.getSamples();
+}
+
 namespace {
 
 void		alter_touch_events(	const ds::ui::TouchTranslator &trans, const TouchEvent &src,
@@ -24,12 +24,15 @@
 #include "TuioClient.h"
 
 #include "ds/app/engine/renderers/engine_renderer_interface.h"
+#include "ds/app/engine/engine_touch_move_queue.h"
 #include "ds/app/engine/engine_touch_queue.h"
 #include "ds/data/font_list.h"
 #include "ds/data/resource_list.h"
 #include "ds/data/tuio_object.h"
 #include "ds/cfg/settings.h"
 #include "ds/ui/ip/ip_function_list.h"
+#include "ds/ui/sprite/idle_tracker.h"
+#include "ds/ui/sprite/text_layout_cache.h"
 #include "ds/ui/sprite/sprite_engine.h"
 #include "ds/ui/touch/select_picking.h"
 #include "ds/ui/touch/touch_manager.h"
@@ -41,6 +44,7 @@ namespace ds {
 class App;
 class AutoDrawService;
 class AutoUpdate;
+class Benchmark;
 class EngineRoot;
 
 extern const ds::BitMask	ENGINE_LOG;
@@ -67,6 +71,8 @@ public:
 	virtual ds::AutoUpdateList&			getAutoUpdateList(const int = AutoUpdateType::SERVER);
 	virtual ds::ImageRegistry&			getImageRegistry() { return mImageRegistry; }
 	virtual ds::ui::Tweenline&			getTweenline() { return mTweenline; }
+	virtual ds::ui::IdleTracker&		getIdleTracker() { return mIdleTracker; }
+	virtual ds::ui::TextLayoutCache&	getTextLayoutCache() { return mTextLayoutCache; }
 	virtual const ds::cfg::Settings&	getDebugSettings() { return mDebugSettings; }
 	// I take ownership of any services added to me.
 	void								addService(const std::string&, ds::EngineService&);
@@ -130,6 +136,11 @@ public:
 	void								mouseTouchMoved(const ci::app::MouseEvent&, int id);
 	void								mouseTouchEnded(const ci::app::MouseEvent&, int id);
 	ci::app::MouseEvent					alteredMouseEvent(const ci::app::MouseEvent&) const;
+	// Every touch move sample that arrived for this frame, oldest first. When moves
+	// are coalesced ("touch:coalesce_moves"), the touch manager and App::onTouchesMoved()
+	// only see the latest sample per finger, so use these for velocity and the like.
+	const std::vector<ci::app::TouchEvent::Touch>&
+										getTouchMoveSamples() const;
 
 	// If you want to create touch events from your client app, use these functions.
 	// The touch events will use the same pathways that normal touches would.
@@ -238,6 +249,8 @@ public:
 	inline const std::vector<std::unique_ptr<EngineRoot>>&
 										getRoots() const { return mRoots; }
 	inline const ds::DrawParams&		getDrawParams() const { return mDrawParams; }
+	// Sprites drawn and culled by the last complete client draw
+	inline const ds::DrawStats&			getDrawStats() const { return mLastDrawStats; }
 	inline ds::AutoDrawService* const	getAutoDrawService() { return mAutoDraw; }
 	inline const FxaaOptions&			getFxaaOptions() const { return mFxaaOptions; }
 
@@ -246,10 +259,18 @@ private:
 	std::unique_ptr<EngineRenderer>		mRenderer;
 	//! decides a renderer based on engine configurations. MUST be called inside "setup".
 	void								setupRenderer();
+	//! hand out everything queued with EventNotifier::post() this frame.
+	void								deliverPostedEvents();
+	//! dispatch the mouse, touch and TUIO object events that arrived since the last frame.
+	void								updateTouches(const float currTime);
 
 private:
 	void								setTouchMode(const ds::ui::TouchMode::Enum&);
 	friend class EngineStatsView;
+	friend class Benchmark;
+	// Ahead of the roots, so they outlive every sprite
+	ds::ui::IdleTracker					mIdleTracker;
+	ds::ui::TextLayoutCache				mTextLayoutCache;
 	std::vector<std::unique_ptr<EngineRoot> >
 										mRoots;
 	const ds::cfg::Settings&			mSettings;
@@ -260,6 +281,8 @@ private:
 	FontList							mFonts;
 	UpdateParams						mUpdateParams;
 	DrawParams							mDrawParams;
+	DrawStats							mDrawStats,
+										mLastDrawStats;
 	float								mLastTime;
 	bool								mIdling;
 	float								mLastTouchTime;
@@ -278,8 +301,7 @@ private:
 	std::mutex							mTouchMutex;
 	ds::EngineTouchQueue<ci::app::TouchEvent>
 										mTouchBeginEvents;
-	ds::EngineTouchQueue<ci::app::TouchEvent>
-										mTouchMovedEvents;
+	ds::EngineTouchMoveQueue			mTouchMovedEvents;
 	ds::EngineTouchQueue<ci::app::TouchEvent>
 										mTouchEndEvents;
 	typedef std::pair<ci::app::MouseEvent, int> MousePair;
@@ -1,6 +1,8 @@
 #include "ds/app/engine/engine_client.h"
 
 #include <ds/app/engine/engine_io_defs.h>
+#include "ds/app/environment.h"
+#include "ds/debug/frame_profiler.h"
 #include "ds/debug/logger.h"
 #include "ds/debug/debug_defines.h"
 #include "ds/ui/sprite/image.h"
@@ -30,8 +32,9 @@ EngineClient::EngineClient(	ds::App& app, const ds::cfg::Settings& settings,
 		, mLoadImageService(mLoadImageThread, mIpFunctions)
 		, mRenderTextService(mRenderTextThread)
 //		, mConnection(NumberOfNetworkThreads)
+		, mReplaying(!settings.getText("client:replay_file", 0, "").empty())
 		, mSender(mSendConnection)
-		, mReceiver(mReceiveConnection)
+		, mReceiver(mReplaying ? static_cast<ds::NetConnection&>(mReplayConnection) : mReceiveConnection)
 		, mBlobReader(mReceiver.getData(), *this)
 		, mSessionId(0)
 		, mConnectionRenewed(false)
@@ -46,7 +49,18 @@ EngineClient::EngineClient(	ds::App& app, const ds::cfg::Settings& settings,
 	DELETE_SPRITE_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveDeleteSprite(r.mDataBuffer);});
 	CLIENT_STATUS_BLOB = mBlobRegistry.add([this](BlobReader& r) {receiveClientStatus(r.mDataBuffer);});
 	mReceiver.setHeaderAndCommandIds(HEADER_BLOB, COMMAND_BLOB);
-	
+
+	if (mReplaying) {
+		mReplayConnection.setSpeed(settings.getFloat("client:replay_speed", 0, 1.0f));
+		mReplayConnection.setLoop(settings.getBool("client:replay_loop", 0, false));
+		mReplayConnection.initialize(false, ds::Environment::expand(settings.getText("client:replay_file")), "");
+		// There's no server to hand out a session, and the recorded replies are
+		// for other clients, so take any session and wait for the recorded world.
+		mSessionId = 1;
+		setState(mBlankState);
+		return;
+	}
+
 	try {
 		if (settings.getBool("server:connect", 0, true)) {
 			mSendConnection.initialize(true, settings.getText("server:ip"), ds::value_to_string(settings.getInt("server:listen_port")));
@@ -77,6 +91,7 @@ ds::sprite_id_t EngineClient::nextSpriteId() {
 void EngineClient::setup(ds::App& app) {
 	inherited::setup(app);
 
+	mLoadImageService.setup(getSettings("engine"));
 	mLoadImageThread.start(true);
 	mRenderTextThread.start(true);
 }
@@ -88,7 +103,11 @@ void EngineClient::update() {
 	updateClient();
 	mRenderTextService.update();
 
-	if (!mConnectionRenewed && mReceiver.hasLostConnection()) {
+	if (mReplaying) {
+		mReplayConnection.update();
+		// Nothing more is coming, so the world stays as the recording left it
+		if (mReplayConnection.isFinished()) return;
+	} else if (!mConnectionRenewed && mReceiver.hasLostConnection()) {
 		mConnectionRenewed = true;
 		// This can happen because the network connection drops, so
 		// refresh it, and let the world now I'm ready again.
@@ -98,6 +117,7 @@ void EngineClient::update() {
 		return;
 	}
 	// Every update, receive data
+	DS_PROFILE_SCOPE("EngineClient::receive");
 	mReceiver.setHeaderAndCommandOnly(mState->getHeaderAndCommandOnly());
 //	mReceiver.setHeaderAndCommandOnly(false);
 	if (!mReceiver.receiveAndHandle(mBlobRegistry, mBlobReader)) {
@@ -118,7 +138,7 @@ void EngineClient::update() {
 	// slurp up, to guarantee I don't go into an infinite loop on some
 	// weird condition.
 	int32_t		limit = 10;
-	while (mReceiveConnection.canRecv()) {
+	while (mReplaying ? mReplayConnection.canRecv() : mReceiveConnection.canRecv()) {
 		mReceiver.receiveAndHandle(mBlobRegistry, mBlobReader);
 		if (--limit <= 0) break;
 	}
@@ -257,6 +277,7 @@ void EngineClient::RunningState::begin(EngineClient &c) {
 }
 
 void EngineClient::RunningState::update(EngineClient &e) {
+	DS_PROFILE_SCOPE("EngineClient::send");
 	EngineSender::AutoSend  send(e.mSender);
 	ds::DataBuffer&   buf = send.mData;
 	buf.add(COMMAND_BLOB);
@@ -6,6 +6,7 @@
 #include "ds/app/engine/engine.h"
 #include "ds/app/engine/engine_io.h"
 #include "ds/app/engine/engine_io_defs.h"
+#include "ds/app/engine/engine_stream_file.h"
 #include "ds/network/udp_connection.h"
 #include "ds/thread/gl_thread.h"
 #include "ds/thread/work_manager.h"
@@ -61,6 +62,10 @@ private:
 //	ds::ZmqConnection				mConnection;
 	ds::UdpConnection				mSendConnection;
 	ds::UdpConnection				mReceiveConnection;
+	// When replaying a recorded server stream, I receive from this
+	// instead of the network, and never send.
+	EngineStreamReplay				mReplayConnection;
+	bool							mReplaying;
 	EngineSender					mSender;
 	EngineReceiver					mReceiver;
 	ds::BlobReader					mBlobReader;
@@ -20,6 +20,7 @@ EngineClientServer::~EngineClientServer() {
 void EngineClientServer::setup(ds::App& app) {
 	inherited::setup(app);
 
+	mLoadImageService.setup(getSettings("engine"));
 	mLoadImageThread.start(true);
 	mRenderTextThread.start(true);
 }
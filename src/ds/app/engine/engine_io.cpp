@@ -2,6 +2,7 @@
 
 #include "ds/app/blob_reader.h"
 #include "ds/app/blob_registry.h"
+#include "ds/app/engine/engine_stream_file.h"
 #include "ds/debug/logger.h"
 #include "ds/util/string_util.h"
 #include "snappy.h"
@@ -12,7 +13,12 @@ namespace ds {
  * \class ds::EngineSender
  */
 EngineSender::EngineSender(ds::NetConnection& con)
-		: mConnection(con) {
+		: mConnection(con)
+		, mRecorder(nullptr) {
+}
+
+void EngineSender::setRecorder(EngineStreamRecorder* r) {
+	mRecorder = r;
 }
 
 /**
@@ -26,14 +32,17 @@ EngineSender::AutoSend::AutoSend(EngineSender& sender)
 
 EngineSender::AutoSend::~AutoSend() {
 	// Send data to client
-	if (!mSender.mConnection.initialized()) return;
+	const bool	send = mSender.mConnection.initialized(),
+				record = (mSender.mRecorder && mSender.mRecorder->isOpen());
+	if (!send && !record) return;
 	if (mData.size() < 1) return;
 
 	const int size = mData.size();
 	mSender.mRawDataBuffer.setSize(size);
 	mData.readRaw(mSender.mRawDataBuffer.data(), size);
 	snappy::Compress(mSender.mRawDataBuffer.data(), size, &mSender.mCompressionBuffer);
-	mSender.mConnection.sendMessage(mSender.mCompressionBuffer);
+	if (send) mSender.mConnection.sendMessage(mSender.mCompressionBuffer);
+	if (record) mSender.mRecorder->record(mSender.mCompressionBuffer);
 	mData.clear();
 }
 
@@ -13,6 +13,7 @@
 namespace ds {
 class BlobReader;
 class BlobRegistry;
+class EngineStreamRecorder;
 
 /**
  * \class ds::EngineSender
@@ -22,8 +23,13 @@ class EngineSender {
 public:
 	EngineSender(ds::NetConnection&);
 
+	// Optionally copy everything sent to a recorder. I send to it even
+	// if my connection isn't initialized.
+	void						setRecorder(EngineStreamRecorder*);
+
 private:
 	ds::NetConnection&			mConnection;
+	EngineStreamRecorder*		mRecorder;
 	ds::DataBuffer				mSendBuffer;
 	RecycleArray<char>			mRawDataBuffer;
 	std::string					mCompressionBuffer;
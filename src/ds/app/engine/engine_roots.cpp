@@ -2,6 +2,7 @@
 
 #include "ds/app/engine/engine.h"
 #include "ds/app/auto_draw.h"
+#include "ds/debug/frame_profiler.h"
 #include "ds/gl/save_camera.h"
 
 namespace ds {
@@ -87,6 +88,34 @@ void OrthRoot::updateServer(const ds::UpdateParams& p) {
 }
 
 void OrthRoot::drawClient(const DrawParams& p, AutoDrawService* auto_draw) {
+	DS_PROFILE_SCOPE("OrthRoot::drawClient");
+	const ci::Matrix44f	m(setClientCamera());
+	if (p.mCull) {
+		// The ortho camera shows the screen rect, so that's what sprites are culled against
+		DrawParams			cull_p(p);
+		const ci::Rectf&	screen_rect(mEngine.getScreenRect());
+		if (cull_p.mCullRect.getWidth() > 0.0f && cull_p.mCullRect.getHeight() > 0.0f) {
+			cull_p.mCullRect = cull_p.mCullRect.getClipBy(screen_rect);
+		} else {
+			cull_p.mCullRect = screen_rect;
+		}
+		mSprite->drawClient(m, cull_p);
+	} else {
+		mSprite->drawClient(m, p);
+	}
+
+	if (auto_draw) auto_draw->drawClient(m, p);
+}
+
+bool OrthRoot::culls(const DrawParams& p) const {
+	return p.mCull;
+}
+
+void OrthRoot::drawAutoClient(const DrawParams& p, AutoDrawService& auto_draw) {
+	auto_draw.drawClient(setClientCamera(), p);
+}
+
+ci::Matrix44f OrthRoot::setClientCamera() {
 	if (mCameraDirty) {
 		setCinderCamera();
 	}
@@ -100,9 +129,7 @@ void OrthRoot::drawClient(const DrawParams& p, AutoDrawService* auto_draw) {
 		m.translate(ci::Vec3f(-mSrcRect.x1*sx, -mSrcRect.y1*sy, 0.0f));
 		m.scale(ci::Vec3f(sx, sy, 1.0f));
 	}
-	mSprite->drawClient(m, p);
-
-	if (auto_draw) auto_draw->drawClient(m, p);
+	return m;
 }
 
 void OrthRoot::drawServer(const DrawParams& p) {
@@ -154,7 +181,8 @@ PerspRoot::PerspRoot(Engine& e, const RootList::Root& r, const sprite_id_t id, c
 		, mSprite(EngineRoot::make(e, id, true))
 		, mMaster(nullptr)
 		, mOldPick(mCamera)
-		, mPicking(picking ? *picking : mOldPick) {
+		, mGeometricPick(mCamera)
+		, mPicking(picking ? *picking : r.mPick == r.kGeometric ? static_cast<Picking&>(mGeometricPick) : mOldPick) {
 	mCamera.setEyePoint(p.mPosition);
 	mCamera.setCenterOfInterestPoint(p.mTarget);
 	mCamera.setFov(p.mFov);
@@ -174,6 +202,7 @@ void PerspRoot::postAppSetup() {
 void PerspRoot::slaveTo(EngineRoot* r) {
 	mMaster = dynamic_cast<PerspRoot*>(r);
 	if (!mMaster) return;
+	mGeometricPick.setCamera(mMaster->mCamera);
 }
 
 ds::ui::Sprite* PerspRoot::getSprite() {
@@ -192,14 +221,20 @@ void PerspRoot::updateServer(const ds::UpdateParams& p) {
 	mSprite->updateServer(p);
 }
 
-void PerspRoot::drawClient(const DrawParams& p, AutoDrawService* auto_draw) {
+void PerspRoot::drawClient(const DrawParams& _p, AutoDrawService* auto_draw) {
+	DS_PROFILE_SCOPE("PerspRoot::drawClient");
+	// Sprites only know their 2D extent, which says nothing through a perspective camera
+	DrawParams				p(_p);
+	p.mCull = false;
 	drawFunc([this, &p](){mSprite->drawClient(ci::gl::getModelView(), p);});
 
 	if (auto_draw) auto_draw->drawClient(ci::gl::getModelView(), p);
 }
 
-void PerspRoot::drawServer(const DrawParams& p) {
+void PerspRoot::drawServer(const DrawParams& _p) {
 	// Redirect to client draw for now
+	DrawParams				p(_p);
+	p.mCull = false;
 	drawFunc([this, &p](){mSprite->drawClient(ci::gl::getModelView(), p);});
 }
 
@@ -9,6 +9,7 @@
 #include "ds/params/camera_params.h"
 #include "ds/params/draw_params.h"
 #include "ds/params/update_params.h"
+#include "ds/ui/touch/geometric_picking.h"
 #include "ds/ui/touch/picking.h"
 
 namespace ds {
@@ -55,6 +56,14 @@ public:
 	virtual void					updateServer(const ds::UpdateParams&) = 0;
 	virtual void					drawClient(const DrawParams&, AutoDrawService*) = 0;
 	virtual void					drawServer(const DrawParams&) = 0;
+	// Whether drawClient() with these params only draws what lands in
+	// DrawParams::mCullRect. Renderers that draw a root once per region use
+	// this to tell if that's cheap, or if it draws the whole root every time.
+	virtual bool					culls(const DrawParams&) const { return false; }
+	// Just the auto draws, as drawClient() does them after my sprites. Only
+	// needed by roots that cull, so a renderer can draw the sprites per
+	// region and these once.
+	virtual void					drawAutoClient(const DrawParams&, AutoDrawService&) { }
 	// Camera
 	virtual void					markCameraDirty() = 0;
 	virtual void					setCinderCamera() = 0;
@@ -89,6 +98,8 @@ public:
 	virtual void					updateServer(const ds::UpdateParams&);
 	virtual void					drawClient(const DrawParams&, AutoDrawService*);
 	virtual void					drawServer(const DrawParams&);
+	virtual bool					culls(const DrawParams&) const;
+	virtual void					drawAutoClient(const DrawParams&, AutoDrawService&);
 	virtual void					setCinderCamera();
 	virtual void					setViewport(const bool b);
 	virtual void					markCameraDirty();
@@ -100,6 +111,8 @@ public:
 
 private:
 	void							setGlCamera();
+	// Set up the camera and answer the transform my sprites draw with
+	ci::Matrix44f					setClientCamera();
 
 	typedef EngineRoot				inherited;
 	OrthRoot(const OrthRoot&);
@@ -175,6 +188,7 @@ private:
 		ci::Camera&					mCamera;
 	};
 	OldPick							mOldPick;
+	GeometricPicking				mGeometricPick;
 	Picking&						mPicking;
 };
 
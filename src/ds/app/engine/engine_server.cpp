@@ -3,7 +3,9 @@
 #include <ds/app/engine/engine_io_defs.h>
 #include "ds/app/app.h"
 #include "ds/app/blob_reader.h"
+#include "ds/app/environment.h"
 #include <ds/app/error.h>
+#include "ds/debug/frame_profiler.h"
 #include "ds/debug/logger.h"
 #include "ds/util/string_util.h"
 
@@ -51,6 +53,12 @@ AbstractEngineServer::AbstractEngineServer(	ds::App& app, const ds::cfg::Setting
 		DS_LOG_ERROR_M("EngineServer() initializing 0MQ: " << e.what(), ds::ENGINE_LOG);
 	}
 
+	// Recording starts in the send world state, so a replay always begins with the whole world.
+	const std::string		record_file(settings.getText("server:record_file", 0, ""));
+	if (!record_file.empty() && mRecorder.open(ds::Environment::expand(record_file))) {
+		mSender.setRecorder(&mRecorder);
+	}
+
 	setState(mSendWorldState);
 }
 
@@ -231,6 +239,7 @@ void EngineServer::RunningState::update(AbstractEngineServer& engine) {
 
 	// Send data to clients
 	{
+		DS_PROFILE_SCOPE("EngineServer::send");
 		EngineSender::AutoSend  send(engine.mSender);
 		// Always send the header
 		addHeader(send.mData, mFrame);
@@ -250,10 +259,13 @@ void EngineServer::RunningState::update(AbstractEngineServer& engine) {
 	// behind (which could be as simple as LogMeIn taking over a
 	// machine). It might be that we just want to wait until all
 	// registered clients have reported the current frame.
-	int32_t		limit = 100;
-	while (engine.mReceiveConnection.canRecv()) {
-		engine.mReceiver.receiveAndHandle(engine.mBlobRegistry, engine.mBlobReader);
-		if (--limit <= 0) break;
+	{
+		DS_PROFILE_SCOPE("EngineServer::receive");
+		int32_t		limit = 100;
+		while (engine.mReceiveConnection.canRecv()) {
+			engine.mReceiver.receiveAndHandle(engine.mBlobRegistry, engine.mBlobReader);
+			if (--limit <= 0) break;
+		}
 	}
 
 	// Track how far behind any clients are
@@ -335,6 +347,7 @@ void EngineServer::SendWorldState::begin(AbstractEngineServer&) {
 
 void EngineServer::SendWorldState::update(AbstractEngineServer& engine) {
 	{
+		DS_PROFILE_SCOPE("EngineServer::sendWorld");
 		EngineSender::AutoSend  send(engine.mSender);
 		DS_LOG_INFO_M("SEND WORLD " << std::time(0), ds::IO_LOG);
 		// Always send the header
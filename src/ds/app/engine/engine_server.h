@@ -6,6 +6,7 @@
 #include "ds/app/engine/engine.h"
 #include "ds/app/engine/engine_client_list.h"
 #include "ds/app/engine/engine_io.h"
+#include "ds/app/engine/engine_stream_file.h"
 #include "ds/network/udp_connection.h"
 #include "ds/thread/gl_thread.h"
 #include "ds/thread/work_manager.h"
@@ -56,6 +57,8 @@ private:
 //    ds::ZmqConnection             mConnection;
 	ds::UdpConnection				mSendConnection;
 	ds::UdpConnection				mReceiveConnection;
+	// Optional copy of everything sent, for replay by a client
+	EngineStreamRecorder			mRecorder;
 	EngineSender					mSender;
 	EngineReceiver					mReceiver;
 	ds::BlobReader					mBlobReader;
@@ -78,6 +78,8 @@ EngineSettings::EngineSettings() {
 
 		readFrom(ds::Environment::getLocalSettingsPath(localFilename), true);
 
+		ds::Environment::setSettingsCache(getBool("settings:binary_cache", 0, false));
+
 		// Load the configuration settings, which can be used to modify settings even more.
 		// Currently used to provide alternate layout sizes.
 		ds::Environment::loadSettings("configuration.xml", CONFIGURATION_SETTINGS);
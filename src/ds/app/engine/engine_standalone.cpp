@@ -33,6 +33,7 @@ void EngineStandalone::installSprite(	const std::function<void(ds::BlobRegistry&
 void EngineStandalone::setup(ds::App& app) {
 	inherited::setup(app);
 
+	mLoadImageService.setup(getSettings("engine"));
 	mLoadImageThread.start(true);
 	mRenderTextThread.start(true);
 
@@ -1,5 +1,8 @@
 #include "engine_stats_view.h"
 
+#include <algorithm>
+#include <sstream>
+
 #include "ds/app/blob_reader.h"
 #include "ds/data/data_buffer.h"
 #include "engine_data.h"
@@ -63,9 +66,28 @@ EngineStatsView::EngineStatsView(ds::ui::SpriteEngine &e)
 void EngineStatsView::updateServer(const ds::UpdateParams &p) {
 	inherited::updateServer(p);
 
+	updateStats();
+}
+
+void EngineStatsView::updateClient(const ds::UpdateParams &p) {
+	inherited::updateClient(p);
+
+	updateStats();
+}
+
+void EngineStatsView::updateStats() {
 	if (!visible()) {
 		mTextureFont = ci::gl::TextureFontRef();
+		mPhaseStats.clear();
+		return;
+	}
+
+	if (ds::FrameProfiler::isEnabled()) {
+		ds::getFrameProfiler().getStats(mPhaseStats);
+	} else {
+		mPhaseStats.clear();
 	}
+	updateSize();
 }
 
 void EngineStatsView::drawLocalClient() {
@@ -88,6 +110,34 @@ void EngineStatsView::drawLocalClient() {
 	y = drawLine(make_line("Sprites", (int)mEngine.mSprites.size()), y) + gap;
 	y = drawLine(make_line("Touch mode (t)", ds::ui::TouchMode::toString(mEngine.mTouchMode)), y) + gap;
 	y = drawLine(make_line("FPS", mEngine.getAverageFps()), y) + gap;
+	{
+		const ds::DrawStats&	stats = mEngine.getDrawStats();
+		std::stringstream		buf;
+		buf << stats.mDrawn << " (" << stats.mCulled << " culled)";
+		y = drawLine(make_line("Drawn", buf.str()), y) + gap;
+	}
+	{
+		const ds::ui::TextLayoutCache&	cache = mEngine.mTextLayoutCache;
+		std::stringstream		buf;
+		buf << cache.size() << " (" << cache.getHits() << " hits, " << cache.getMisses() << " misses)";
+		y = drawLine(make_line("Text layouts", buf.str()), y) + gap;
+	}
+
+	// Per-phase timings as average (max) in ms over the profiler history
+	for (auto it=mPhaseStats.begin(), end=mPhaseStats.end(); it!=end; ++it) {
+		std::stringstream	buf;
+		buf.precision(2);
+		buf << std::fixed << it->mAverageMs << " (" << it->mMaxMs << ")";
+		y = drawLine(make_line(it->mName, buf.str()), y) + gap;
+	}
+}
+
+void EngineStatsView::updateSize() {
+	// Base size fits the fixed lines, then grow for each profiler phase.
+	const float			line_h = mFontSize + 5.0f;
+	const float			w = (mPhaseStats.empty() ? 400.0f : 640.0f);
+	const float			h = std::max(400.0f, mBorder.y*2.0f + line_h*static_cast<float>(5 + mPhaseStats.size()));
+	if (getWidth() != w || getHeight() != h) setSize(w, h);
 }
 
 float EngineStatsView::drawLine(const std::string &v, const float y) {
@@ -11,6 +11,7 @@
 #include "ds/app/blob_registry.h"
 #include "ds/app/event.h"
 #include "ds/app/event_client.h"
+#include "ds/debug/frame_profiler.h"
 #include "ds/ui/sprite/sprite.h"
 
 namespace ds {
@@ -27,10 +28,14 @@ public:
 	EngineStatsView(ds::ui::SpriteEngine&);
 
 	virtual void				updateServer(const ds::UpdateParams&);
+	virtual void				updateClient(const ds::UpdateParams&);
 	virtual void				drawLocalClient();
 
 private:
 	float						drawLine(const std::string&, const float y);
+	// Refresh the profiler phases, which every process times for itself
+	void						updateStats();
+	void						updateSize();
 	void						onAppEvent(const ds::Event&);
 	void						makeTextureFont();
 
@@ -44,6 +49,9 @@ private:
 	const float					mFontSize;
 	const ci::Vec2f				mLT;
 	const ci::Vec2f				mBorder;
+	// Profiler phases, refreshed each update while visible
+	std::vector<ds::FrameProfiler::Stats>
+								mPhaseStats;
 
 	// EVENTS
 public:
@@ -0,0 +1,193 @@
+#include "ds/app/engine/engine_stream_file.h"
+
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include "ds/debug/logger.h"
+
+namespace ds {
+
+namespace {
+// 'DSWS', little endian
+const uint32_t			MAGIC = 0x53575344;
+// Anything bigger is a corrupt or truncated record
+const uint32_t			MAX_RECORD_SIZE = 64 * 1024 * 1024;
+// The server records once a frame, so this is about a second at 60 fps. A
+// crash loses at most that much of the recording.
+const uint32_t			FLUSH_RECORDS = 60;
+}
+
+/**
+ * \class ds::EngineStreamRecorder
+ */
+EngineStreamRecorder::EngineStreamRecorder()
+		: mUnflushed(0) {
+}
+
+EngineStreamRecorder::~EngineStreamRecorder() {
+	close();
+}
+
+bool EngineStreamRecorder::open(const std::string& filename) {
+	close();
+	try {
+		Poco::Path			path(filename);
+		if (path.depth() > 0) Poco::File(path.parent()).createDirectories();
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING("EngineStreamRecorder::open() can't create folder for " << filename << " ex=" << ex.what());
+	}
+	mFile.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!mFile.is_open()) {
+		DS_LOG_WARNING("EngineStreamRecorder::open() can't open " << filename);
+		return false;
+	}
+	const uint32_t			header[2] = { MAGIC, FORMAT_VERSION };
+	mFile.write(reinterpret_cast<const char*>(header), sizeof(header));
+	mFilename = filename;
+	mStart.update();
+	mUnflushed = 0;
+	DS_LOG_INFO("EngineStreamRecorder recording to " << filename);
+	return mFile.good();
+}
+
+void EngineStreamRecorder::close() {
+	if (!mFile.is_open()) return;
+	mFile.close();
+	DS_LOG_INFO("EngineStreamRecorder closed " << mFilename);
+	mFilename.clear();
+}
+
+bool EngineStreamRecorder::isOpen() const {
+	return mFile.is_open();
+}
+
+void EngineStreamRecorder::record(const std::string& msg) {
+	if (!mFile.is_open() || msg.empty()) return;
+
+	const uint64_t			time = static_cast<uint64_t>(mStart.elapsed());
+	const uint32_t			size = static_cast<uint32_t>(msg.size());
+	mFile.write(reinterpret_cast<const char*>(&time), sizeof(time));
+	mFile.write(reinterpret_cast<const char*>(&size), sizeof(size));
+	mFile.write(msg.data(), msg.size());
+	if (++mUnflushed >= FLUSH_RECORDS) {
+		mFile.flush();
+		mUnflushed = 0;
+	}
+	if (!mFile.good()) {
+		DS_LOG_WARNING("EngineStreamRecorder write failed, stopping " << mFilename);
+		close();
+	}
+}
+
+/**
+ * \class ds::EngineStreamReplay
+ */
+EngineStreamReplay::EngineStreamReplay()
+		: mInitialized(false)
+		, mSpeed(1.0)
+		, mLoop(false)
+		, mClock(0)
+		, mFirstTime(0)
+		, mHasNext(false)
+		, mNextTime(0)
+		, mNextSize(0)
+		, mTaken(false) {
+}
+
+bool EngineStreamReplay::initialize(bool, const std::string& filename, const std::string&) {
+	mInitialized = false;
+	if (mFile.is_open()) mFile.close();
+	mFile.open(filename.c_str(), std::ios::in | std::ios::binary);
+	if (!mFile.is_open()) {
+		DS_LOG_WARNING("EngineStreamReplay can't open " << filename);
+		return false;
+	}
+	uint32_t				header[2] = { 0, 0 };
+	mFile.read(reinterpret_cast<char*>(header), sizeof(header));
+	if (!mFile.good() || header[0] != MAGIC || header[1] != EngineStreamRecorder::FORMAT_VERSION) {
+		DS_LOG_WARNING("EngineStreamReplay not a stream file, or the wrong version " << filename);
+		mFile.close();
+		return false;
+	}
+	mInitialized = rewind();
+	if (!mInitialized) DS_LOG_WARNING("EngineStreamReplay empty file " << filename);
+	return mInitialized;
+}
+
+void EngineStreamReplay::setSpeed(const double speed) {
+	mSpeed = speed;
+}
+
+void EngineStreamReplay::setLoop(const bool loop) {
+	mLoop = loop;
+}
+
+void EngineStreamReplay::update() {
+	mClock = static_cast<uint64_t>(static_cast<double>(mStart.elapsed()) * mSpeed);
+	mTaken = false;
+}
+
+bool EngineStreamReplay::sendMessage(const std::string&) {
+	return false;
+}
+
+bool EngineStreamReplay::sendMessage(const char*, int) {
+	return false;
+}
+
+int EngineStreamReplay::recvMessage(std::string& msg) {
+	if (!canRecv()) return 0;
+
+	msg.resize(mNextSize);
+	mFile.read(&msg[0], mNextSize);
+	if (!mFile.good()) {
+		mHasNext = false;
+		msg.clear();
+		return 0;
+	}
+	mTaken = true;
+	readNext();
+	if (!mHasNext && mLoop) rewind();
+	return static_cast<int>(msg.size());
+}
+
+bool EngineStreamReplay::canRecv() const {
+	if (!mInitialized || !mHasNext) return false;
+	if (mSpeed <= 0.0) return !mTaken;
+	return mNextTime - mFirstTime <= mClock;
+}
+
+bool EngineStreamReplay::isFinished() const {
+	return mInitialized && !mHasNext;
+}
+
+bool EngineStreamReplay::isServer() const {
+	return false;
+}
+
+bool EngineStreamReplay::initialized() const {
+	return mInitialized;
+}
+
+bool EngineStreamReplay::rewind() {
+	mFile.clear();
+	mFile.seekg(sizeof(uint32_t) * 2, std::ios::beg);
+	readNext();
+	mFirstTime = mNextTime;
+	mStart.update();
+	mClock = 0;
+	return mHasNext;
+}
+
+void EngineStreamReplay::readNext() {
+	mHasNext = false;
+	mFile.read(reinterpret_cast<char*>(&mNextTime), sizeof(mNextTime));
+	mFile.read(reinterpret_cast<char*>(&mNextSize), sizeof(mNextSize));
+	if (!mFile.good()) return;
+	if (mNextSize < 1 || mNextSize > MAX_RECORD_SIZE) {
+		DS_LOG_WARNING("EngineStreamReplay bad record size=" << mNextSize << ", stopping");
+		return;
+	}
+	mHasNext = true;
+}
+
+} // namespace ds
@@ -0,0 +1,103 @@
+#pragma once
+#ifndef DS_APP_ENGINE_ENGINESTREAMFILE_H_
+#define DS_APP_ENGINE_ENGINESTREAMFILE_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <Poco/Timestamp.h>
+#include "ds/network/net_connection.h"
+
+namespace ds {
+
+/**
+ * \class ds::EngineStreamRecorder
+ * \brief Write every message the server sends to a file, exactly as it goes
+ * out on the wire (compressed), stamped with the time since recording started.
+ * The file is an 8 byte header ('DSWS' and a version) followed by records of
+ * a uint64 time in microseconds, a uint32 size and the message bytes. The
+ * file is flushed every so many records, so a crash leaves a usable file.
+ */
+class EngineStreamRecorder {
+public:
+	static const uint32_t		FORMAT_VERSION = 1;
+
+	EngineStreamRecorder();
+	~EngineStreamRecorder();
+
+	// Answer false if the file can't be created. Recording starts over.
+	bool						open(const std::string& filename);
+	void						close();
+	bool						isOpen() const;
+
+	void						record(const std::string& msg);
+
+private:
+	EngineStreamRecorder(const EngineStreamRecorder&);
+	EngineStreamRecorder&		operator=(const EngineStreamRecorder&);
+
+	std::ofstream				mFile;
+	std::string					mFilename;
+	Poco::Timestamp				mStart;
+	// Records written since the last flush
+	uint32_t					mUnflushed;
+};
+
+/**
+ * \class ds::EngineStreamReplay
+ * \brief A receive-only connection that plays back a file written by the
+ * EngineStreamRecorder. Messages come out at the recorded times, scaled by
+ * the speed, or one per update() if the speed is 0 (as fast as the client
+ * can go). Sending does nothing.
+ */
+class EngineStreamReplay : public NetConnection {
+public:
+	EngineStreamReplay();
+
+	// Open the file, which is passed in place of the ip. The rest is ignored.
+	virtual bool				initialize(bool server, const std::string &filename, const std::string &port);
+	void						setSpeed(const double);
+	void						setLoop(const bool);
+
+	// Advance the playback clock. Call once a frame, before receiving.
+	void						update();
+
+	virtual bool				sendMessage(const std::string &data);
+	virtual bool				sendMessage(const char *data, int size);
+
+	virtual int					recvMessage(std::string &msg);
+	// Answer true if the next message is due.
+	bool						canRecv() const;
+	// Answer true once the last message has been read and I'm not looping.
+	bool						isFinished() const;
+
+	virtual bool				isServer() const;
+	virtual bool				initialized() const;
+
+private:
+	EngineStreamReplay(const EngineStreamReplay&);
+	EngineStreamReplay&			operator=(const EngineStreamReplay&);
+
+	bool						rewind();
+	// Read the time and size of the next record, if there is one.
+	void						readNext();
+
+	std::ifstream				mFile;
+	bool						mInitialized;
+	double						mSpeed;
+	bool						mLoop;
+	// Playback clock and the time of the next message, in microseconds.
+	// The clock starts at the first message, not when recording started.
+	Poco::Timestamp				mStart;
+	uint64_t					mClock,
+								mFirstTime;
+	bool						mHasNext;
+	uint64_t					mNextTime;
+	uint32_t					mNextSize;
+	// At speed 0, whether this update's message has been taken
+	bool						mTaken;
+};
+
+} // namespace ds
+
+#endif // DS_APP_ENGINE_ENGINESTREAMFILE_H_
@@ -0,0 +1,78 @@
+#include "ds/app/engine/engine_touch_move_queue.h"
+
+namespace ds {
+
+/**
+ * \class ds::EngineTouchMoveQueue
+ */
+EngineTouchMoveQueue::EngineTouchMoveQueue(	std::mutex& m, float& lastTouchTime, bool& idling,
+											const std::function<void(const ci::app::TouchEvent&)>& updateFn)
+		: mMutex(m)
+		, mLastTouchTime(lastTouchTime)
+		, mIdling(idling)
+		, mUpdateFn(updateFn)
+		, mCoalesce(true) {
+	mIncoming.reserve(32);
+	mUpdating.reserve(32);
+	mSamples.reserve(64);
+	mLatest.reserve(32);
+}
+
+void EngineTouchMoveQueue::setUpdateFn(const std::function<void(const ci::app::TouchEvent&)>& fn) {
+	mUpdateFn = fn;
+}
+
+void EngineTouchMoveQueue::setCoalesce(const bool on) {
+	mCoalesce = on;
+}
+
+bool EngineTouchMoveQueue::getCoalesce() const {
+	return mCoalesce;
+}
+
+void EngineTouchMoveQueue::incoming(const ci::app::TouchEvent& e) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	mIncoming.push_back(e);
+}
+
+void EngineTouchMoveQueue::lockedUpdate() {
+	mUpdating.clear();
+	mUpdating.swap(mIncoming);
+}
+
+void EngineTouchMoveQueue::update(const float currTime) {
+	mSamples.clear();
+	if (mUpdating.empty()) return;
+
+	mLastTouchTime = currTime;
+	mIdling = false;
+	for (auto it=mUpdating.begin(), end=mUpdating.end(); it!=end; ++it) {
+		mSamples.insert(mSamples.end(), it->getTouches().begin(), it->getTouches().end());
+	}
+
+	if (!mCoalesce) {
+		for (auto it=mUpdating.begin(), end=mUpdating.end(); it!=end; ++it) {
+			mUpdateFn(*it);
+		}
+		return;
+	}
+
+	// There are rarely more than a couple dozen fingers, so a linear search beats a map
+	mLatest.clear();
+	for (auto it=mSamples.begin(), end=mSamples.end(); it!=end; ++it) {
+		auto		f = mLatest.begin();
+		while (f != mLatest.end() && f->getId() != it->getId()) ++f;
+		if (f == mLatest.end()) {
+			mLatest.push_back(*it);
+		} else {
+			*f = ci::app::TouchEvent::Touch(it->getPos(), f->getPrevPos(), it->getId(), it->getTime(), (void*)it->getNative());
+		}
+	}
+	mUpdateFn(ci::app::TouchEvent(mUpdating.front().getWindow(), mLatest));
+}
+
+const std::vector<ci::app::TouchEvent::Touch>& EngineTouchMoveQueue::getSamples() const {
+	return mSamples;
+}
+
+} // namespace ds
@@ -0,0 +1,64 @@
+#pragma once
+#ifndef DS_APP_ENGINE_ENGINETOUCHMOVEQUEUE_H_
+#define DS_APP_ENGINE_ENGINETOUCHMOVEQUEUE_H_
+
+#include <functional>
+#include <vector>
+#include <cinder/app/TouchEvent.h>
+#include <cinder/Thread.h>
+
+namespace ds {
+
+/**
+ * \class ds::EngineTouchMoveQueue
+ * \brief The EngineTouchQueue for touch moves. High rate sources send many
+ * moves per finger between frames. When coalescing, update() hands out a
+ * single event with the latest sample for every finger that moved, carrying
+ * the previous position of that finger's first sample, so the frame's motion
+ * is all there. The raw samples stay available until the next update, for
+ * anything that wants the full history (velocity, say).
+ */
+class EngineTouchMoveQueue {
+public:
+	EngineTouchMoveQueue(	std::mutex&, float& lastTouchTime, bool& idling,
+							const std::function<void(const ci::app::TouchEvent&)>&);
+
+	void					setUpdateFn(const std::function<void(const ci::app::TouchEvent&)>&);
+	void					setCoalesce(const bool);
+	bool					getCoalesce() const;
+
+	// Call this as new events arrive. I will handle locking
+	void					incoming(const ci::app::TouchEvent&);
+
+	// When updating, first call this while the mutex is locked...
+	void					lockedUpdate();
+	// ... then call this after the lock has been released.
+	void					update(const float currTime);
+
+	// Every sample handed out by the last update(), in the order they
+	// arrived, whether or not they were coalesced.
+	const std::vector<ci::app::TouchEvent::Touch>&
+							getSamples() const;
+
+private:
+	EngineTouchMoveQueue(const EngineTouchMoveQueue&);
+
+	std::mutex&				mMutex;
+	float&					mLastTouchTime;
+	bool&					mIdling;
+	std::function<void(const ci::app::TouchEvent&)>
+							mUpdateFn;
+	bool					mCoalesce;
+	// Incoming stores the events as they arrive, the
+	// Updating holds them temporarily for processing.
+	std::vector<ci::app::TouchEvent>
+							mIncoming,
+							mUpdating;
+	std::vector<ci::app::TouchEvent::Touch>
+							mSamples,
+							mLatest;
+};
+
+} // namespace ds
+
+#endif // DS_APP_ENGINE_ENGINETOUCHMOVEQUEUE_H_
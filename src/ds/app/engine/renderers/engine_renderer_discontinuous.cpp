@@ -25,9 +25,45 @@ void EngineRendererDiscontinuous::drawClient()
 	mFbo.bindFramebuffer();
 	ci::gl::enableAlphaBlending();
 	clearScreen();
+
+	// Only the parts of the world that get shown are rendered. A root that
+	// culls draws once per slice, with a scissor over the slice's source
+	// region and its sprites culled to it, then its auto draws once. Any
+	// other root (perspective, or culling turned off) would draw everything
+	// every time, so it draws once, scissored to all the slices together.
+	// Roots go one at a time so they keep their order.
+	const auto& slices = mEngine.getEngineData().mWorldSlices;
+	const auto fbo_h = mFbo.getHeight();
+	ci::Area all(0, 0, 0, 0);
+	for (const auto& world_slice : slices)
+	{
+		if (all.getWidth() <= 0 || all.getHeight() <= 0) all = world_slice.first;
+		else all.include(world_slice.first);
+	}
+
+	const DrawParams& draw_params(mEngine.getDrawParams());
+	AutoDrawService* auto_draw = mEngine.getAutoDrawService();
+	glEnable(GL_SCISSOR_TEST);
 	for (auto it = mEngine.getRoots().cbegin(), end = mEngine.getRoots().cend(); it != end; ++it) {
-		(*it)->drawClient(mEngine.getDrawParams(), mEngine.getAutoDrawService());
+		if (!(*it)->culls(draw_params)) {
+			scissor(all, fbo_h);
+			(*it)->drawClient(draw_params, auto_draw);
+			continue;
+		}
+		for (const auto& world_slice : slices)
+		{
+			const ci::Area& src = world_slice.first;
+			scissor(src, fbo_h);
+			DrawParams params(draw_params);
+			params.mCullRect = ci::Rectf(src);
+			(*it)->drawClient(params, nullptr);
+		}
+		if (auto_draw) {
+			scissor(all, fbo_h);
+			(*it)->drawAutoClient(draw_params, *auto_draw);
+		}
 	}
+	glDisable(GL_SCISSOR_TEST);
 	mFbo.unbindFramebuffer();
 
 	clearScreen();
@@ -37,6 +73,12 @@ void EngineRendererDiscontinuous::drawClient()
 	}
 }
 
+void EngineRendererDiscontinuous::scissor(const ci::Area& a, const int fbo_h)
+{
+	// GL counts scissor rows from the bottom, the world counts from the top
+	glScissor(a.x1, fbo_h - a.y2, a.getWidth(), a.getHeight());
+}
+
 void EngineRendererDiscontinuous::drawServer()
 {
 	glAlphaFunc(GL_GREATER, 0.001f);
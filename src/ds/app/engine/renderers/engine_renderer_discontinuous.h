@@ -24,6 +24,8 @@ public:
 	virtual void	drawServer() override;
 
 private:
+	static void		scissor(const ci::Area&, const int fbo_h);
+
 	ci::gl::Fbo		mFbo;
 };
 
@@ -1,17 +1,22 @@
 #include "ds/app/environment.h"
 
 #include <boost/algorithm/string.hpp>
+#include <Poco/DigestEngine.h>
 #include <Poco/File.h>
+#include <Poco/MD5Engine.h>
 #include <Poco/Path.h>
 #include "ds/app/app.h"
 #include "ds/app/engine/engine_settings.h"
+#include "ds/util/string_util.h"
 
 static std::string    folder_from(const Poco::Path&, const std::string& folder, const std::string& fileName);
+static bool           settings_cache_key(const std::vector<std::string>& files, std::string& key, std::string& path);
 
 namespace ds {
 
 namespace {
 std::string				DOCUMENTS("%DOCUMENTS%");
+bool					SETTINGS_CACHE = false;
 }
 
 bool Environment::initialize() {
@@ -100,14 +105,27 @@ std::string Environment::getLocalSettingsPath(const std::string& fileName)
 }
 
 void Environment::loadSettings(const std::string& filename, ds::cfg::Settings& settings) {
-	settings.readFrom(ds::Environment::getAppFolder(ds::Environment::SETTINGS(), filename), false);
-	settings.readFrom(ds::Environment::getLocalSettingsPath(filename), true);
+	// In merge order
+	std::vector<std::string>	files;
+	files.push_back(ds::Environment::getAppFolder(ds::Environment::SETTINGS(), filename));
+	files.push_back(ds::Environment::getLocalSettingsPath(filename));
 	if (!ds::EngineSettings::getConfigurationFolder().empty()) {
-		const std::string		app = ds::Environment::expand("%APP%/settings/%CFG_FOLDER%/" + filename);
-		const std::string		local = ds::Environment::expand("%LOCAL%/settings/%PP%/%CFG_FOLDER%/" + filename);
-		settings.readFrom(app, true);
-		settings.readFrom(local, true);
+		files.push_back(ds::Environment::expand("%APP%/settings/%CFG_FOLDER%/" + filename));
+		files.push_back(ds::Environment::expand("%LOCAL%/settings/%PP%/%CFG_FOLDER%/" + filename));
 	}
+
+	std::string					key, path;
+	const bool					cached = SETTINGS_CACHE && settings_cache_key(files, key, path);
+	if (cached && settings.readBinaryFrom(path, key)) return;
+
+	settings.readFrom(files.front(), false);
+	for (auto it=files.begin()+1, end=files.end(); it != end; ++it) settings.readFrom(*it, true);
+
+	if (cached) settings.writeBinaryTo(path, key);
+}
+
+void Environment::setSettingsCache(const bool on) {
+	SETTINGS_CACHE = on;
 }
 
 void Environment::saveSettings(const std::string& filename, ds::cfg::Settings& settings) {
@@ -179,3 +197,33 @@ static std::string    folder_from(const Poco::Path& parentP, const std::string&
 	}
 	return "";
 }
+
+static bool           settings_cache_key(const std::vector<std::string>& files, std::string& key, std::string& path) {
+	try {
+		// Without the app file, loading doesn't replace what's already in the settings, so it can't be cached.
+		if (files.empty() || files.front().empty() || !Poco::File(files.front()).exists()) return false;
+
+		// Every source, present or not, is part of the key, so adding an override invalidates it too.
+		key.clear();
+		for (auto it=files.begin(), end=files.end(); it != end; ++it) {
+			key += *it;
+			if (!it->empty() && Poco::File(*it).exists()) {
+				const Poco::File  f(*it);
+				key += "|" + ds::value_to_string(f.getLastModified().epochMicroseconds()) + "|" + ds::value_to_string(f.getSize());
+			}
+			key += ";";
+		}
+
+		Poco::MD5Engine     md5;
+		md5.update(files.front());
+		Poco::Path          p(ds::Environment::getDownstreamDocumentsFolder());
+		p.pushDirectory("cache");
+		p.pushDirectory("settings");
+		Poco::File(p).createDirectories();
+		p.setFileName(Poco::DigestEngine::digestToHex(md5.digest()) + ".bin");
+		path = p.toString();
+		return true;
+	} catch (std::exception const&) {
+	}
+	return false;
+}
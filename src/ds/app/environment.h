@@ -43,6 +43,9 @@ public:
 
 	// Convenience to load in a settings file, first from the app path, then the local path
 	static void					loadSettings(const std::string& filename, ds::cfg::Settings&);
+	// When on, loadSettings() keeps a binary snapshot of each merged result in %LOCAL%/cache/settings/
+	// and uses that, instead of parsing the XML, for as long as none of the source files change.
+	static void					setSettingsCache(const bool on);
 	
 	// Convenience to save a settings file to the local path
 	static void					saveSettings(const std::string& filename, ds::cfg::Settings&);
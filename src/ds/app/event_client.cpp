@@ -27,4 +27,8 @@ void EventClient::request(ds::Event& e) {
 	mNotifier.mEventNotifier.request(e);
 }
 
+void EventClient::listenToEvents(const int what, const std::function<void(const ds::Event *)>& fn) {
+	mNotifier.mEventNotifier.addListener(this, what, fn);
+}
+
 } // namespace ds
@@ -25,10 +25,27 @@ public:
 	void			notify(const ds::Event&);
 	void			request(ds::Event&);
 
+	/**
+	 * Add a listener for a single event type, in addition to the constructor's.
+	 * example: mEventClient.listenToEvents<MyEvent>([this](const MyEvent& e){ ... });
+	 */
+	template<typename T>
+	void			listenToEvents(const std::function<void(const T&)>&);
+
 private:
+	void			listenToEvents(const int what, const std::function<void(const ds::Event *)>&);
+
 	EventNotifier&	mNotifier;
 };
 
+// Template impl
+template<typename T>
+void EventClient::listenToEvents(const std::function<void(const T&)>& fn) {
+	if (!fn) return;
+	listenToEvents(T::WHAT(), [fn](const ds::Event *e) { if (e) fn(static_cast<const T&>(*e)); });
+}
+// End of Template impl
+
 } // namespace ds
 
 #endif // DS_APP_EVENTCLIENT_H
@@ -15,10 +15,18 @@ void EventNotifier::addListener(void *id, const std::function<void(const ds::Eve
 	mEventNotifier.addListener(id, fn);
 }
 
+void EventNotifier::addListener(void *id, const int what, const std::function<void(const ds::Event*)>& fn) {
+	mEventNotifier.addListener(id, what, fn);
+}
+
 void EventNotifier::addRequestListener(void *id, const std::function<void(ds::Event&)>& fn) {
 	mEventNotifier.addRequestListener(id, fn);
 }
 
+void EventNotifier::addRequestListener(void *id, const int what, const std::function<void(ds::Event&)>& fn) {
+	mEventNotifier.addRequestListener(id, what, fn);
+}
+
 void EventNotifier::removeListener(void *id) {
 	mEventNotifier.removeListener(id);
 }
@@ -31,6 +39,17 @@ void EventNotifier::notify(const ds::Event& e) {
 	mEventNotifier.notify(&e);
 }
 
+void EventNotifier::deliverPosted() {
+	if (mPosted.empty()) return;
+
+	// Swap out first, so anything posted by a listener waits for the next frame.
+	mDelivering.swap(mPosted);
+	for (auto it=mDelivering.begin(), end=mDelivering.end(); it!=end; ++it) {
+		if (*it) mEventNotifier.notify(it->get());
+	}
+	mDelivering.clear();
+}
+
 void EventNotifier::request(ds::Event& e) {
 	mEventNotifier.request(e);
 }
@@ -2,6 +2,8 @@
 #ifndef DS_APP_EVENTNOTIFIER_H
 #define DS_APP_EVENTNOTIFIER_H
 
+#include <memory>
+#include <vector>
 #include <ds/app/event.h>
 #include <ds/util/notifier.h>
 
@@ -10,6 +12,10 @@ namespace ds {
 /**
  * \class ds::EventNotifier
  * \brief Holder for an event notifier.
+ * Listeners can hear every event, or subscribe to a single event type
+ * (the RegisteredEvent<> WHAT()), which is much cheaper when there are many.
+ * Events can be delivered immediately with notify(), or queued with post()
+ * and delivered together when the engine calls deliverPosted() once a frame.
  */
 class EventNotifier {
 public:
@@ -17,7 +23,10 @@ public:
 	virtual ~EventNotifier();
 
 	void						addListener(void *id, const std::function<void(const ds::Event*)>&);
+	// Only called for events of type what (i.e. MyEvent::WHAT())
+	void						addListener(void *id, const int what, const std::function<void(const ds::Event*)>&);
 	void						addRequestListener(void *id, const std::function<void(ds::Event&)>&);
+	void						addRequestListener(void *id, const int what, const std::function<void(ds::Event&)>&);
 	void						removeListener(void *id);
 	void						removeRequestListener(void *id);
 
@@ -25,6 +34,15 @@ public:
 	// an EventClient (i.e. don't need to receive events)
 	void						notify(const ds::Event&);
 
+	/**
+	* Queue a copy of the event, to be delivered at the end of the current update.
+	* Main thread only. Events posted while delivering go out on the next frame.
+	*/
+	template<typename T>
+	void						post(const T&);
+	// Called by the engine once per frame.
+	void						deliverPosted();
+
 	/**
 	* Request information from the system.
 	* \param requestEvent The event to be sent as a request to the event system
@@ -42,8 +60,22 @@ protected:
 	friend class EventClient;
 
 	ds::Notifier<ds::Event>    mEventNotifier;
+	// Shared pointers so the notifier stays copyable
+	std::vector<std::shared_ptr<ds::Event>>
+								mPosted,
+								mDelivering;
 };
 
+// Template impl
+template<typename T>
+void EventNotifier::post(const T& e) {
+	try {
+		mPosted.push_back(std::shared_ptr<ds::Event>(new T(e)));
+	} catch (std::exception const&) {
+	}
+}
+// End of Template impl
+
 } // namespace ds
 
 #endif // DS_APP_EVENTNOTIFIER_H
@@ -1,6 +1,7 @@
 #include "ds/arc/arc_render_circle.h"
 
 #include "ds/math/math_func.h"
+#include "ds/ui/ip/ip_kernels.h"
 
 namespace ds {
 namespace arc {
@@ -38,29 +39,42 @@ bool RenderCircle::on(const Input& input, ci::Surface8u& s, ds::arc::Arc& a)
 {
 	s.setPremultiplied(false);
 
-	RenderCircleParams	params;
-	params.mW = s.getWidth();
-	params.mH = s.getHeight();
-	params.mCenX = (s.getWidth()-1)/2.0;
-	params.mCenY = (s.getHeight()-1)/2.0;
-	params.mMaxDist = ds::math::dist(params.mCenX, params.mCenY, params.mCenX, 0.0);
+	if (!s) return false;
 
-	auto			pix = s.getIter();
-	params.mY = 0.0;
-	while (pix.line()) {
-		params.mX = 0.0;
-		while (pix.pixel()) {
-			params.mOutput = ci::ColorA(0.0f, 0.0f, 0.0f, 0.0f);
-			a.renderCircle(input, params);
-			pix.r() = to_color(un_premult(params.mOutput.r, params.mOutput.a));
-			pix.g() = to_color(un_premult(params.mOutput.g, params.mOutput.a));
-			pix.b() = to_color(un_premult(params.mOutput.b, params.mOutput.a));
-			pix.a() = to_color(params.mOutput.a);
+	RenderCircleParams	base;
+	base.mW = s.getWidth();
+	base.mH = s.getHeight();
+	base.mCenX = (s.getWidth()-1)/2.0;
+	base.mCenY = (s.getHeight()-1)/2.0;
+	base.mMaxDist = ds::math::dist(base.mCenX, base.mCenY, base.mCenX, 0.0);
 
-			++params.mX;
+	// Arcs are const and only read the input, so each range of rows gets its own params.
+	uint8_t*			data = s.getData();
+	const int32_t		w = s.getWidth();
+	const int32_t		row_bytes = s.getRowBytes();
+	const int			pixel_inc = s.getPixelInc();
+	const int			r_off = s.getRedOffset(),
+						g_off = s.getGreenOffset(),
+						b_off = s.getBlueOffset(),
+						a_off = (s.hasAlpha() ? s.getAlphaOffset() : -1);
+	ds::ui::ip::parallel_rows(s.getHeight(), [&](const int begin, const int end) {
+		RenderCircleParams	params(base);
+		for (int y=begin; y<end; ++y) {
+			uint8_t*		pix = data + y * row_bytes;
+			params.mY = static_cast<double>(y);
+			params.mX = 0.0;
+			for (int x=0; x<w; ++x, pix += pixel_inc) {
+				params.mOutput = ci::ColorA(0.0f, 0.0f, 0.0f, 0.0f);
+				a.renderCircle(input, params);
+				pix[r_off] = to_color(un_premult(params.mOutput.r, params.mOutput.a));
+				pix[g_off] = to_color(un_premult(params.mOutput.g, params.mOutput.a));
+				pix[b_off] = to_color(un_premult(params.mOutput.b, params.mOutput.a));
+				if (a_off >= 0) pix[a_off] = to_color(params.mOutput.a);
+
+				++params.mX;
+			}
 		}
-		++params.mY;
-	}
+	}, 8);
 
 	return true;
 }
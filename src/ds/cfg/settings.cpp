@@ -1,6 +1,9 @@
 #include "ds/cfg/settings.h"
 
+#include <cstring>
+#include <fstream>
 #include <cinder/Xml.h>
+#include <Poco/AtomicCounter.h>
 #include <Poco/File.h>
 #include <Poco/String.h>
 #include "ds/debug/logger.h"
@@ -38,6 +41,15 @@ static const ci::Vec3f			POINT_TYPE;
 
 namespace {
 
+// Source for Settings::mStamp. Global so a stamp never repeats, even across instances.
+Poco::AtomicCounter				STAMP;
+
+// Binary snapshot file header. Bump the version whenever the layout changes.
+const char						BINARY_MAGIC[4] = { 'D', 'S', 'C', 'F' };
+const int32_t					BINARY_VERSION = 1;
+// Sanity limit on any count or string length read from a snapshot
+const uint32_t					BINARY_MAX_COUNT = 16 * 1024 * 1024;
+
 // A is a map between a string and a vector
 template <typename A>
 static int get_size(const std::string& name, A& container)
@@ -107,6 +119,85 @@ const V& get(const std::string& name, const A& container, const int index, const
 	return defaultValue;
 }
 
+void write_raw(std::ostream& os, const void* data, const size_t size)
+{
+	os.write(static_cast<const char*>(data), size);
+}
+
+bool read_raw(std::istream& is, void* data, const size_t size)
+{
+	is.read(static_cast<char*>(data), size);
+	return is.good();
+}
+
+void write_value(std::ostream& os, const float v)			{ write_raw(os, &v, sizeof(v)); }
+void write_value(std::ostream& os, const int v)				{ const int32_t i = v; write_raw(os, &i, sizeof(i)); }
+void write_value(std::ostream& os, const uint32_t v)		{ write_raw(os, &v, sizeof(v)); }
+void write_value(std::ostream& os, const ci::Rectf& v)		{ write_value(os, v.x1); write_value(os, v.y1); write_value(os, v.x2); write_value(os, v.y2); }
+void write_value(std::ostream& os, const Resource::Id& v)	{ write_raw(os, &v.mType, sizeof(v.mType)); write_value(os, v.mValue); }
+void write_value(std::ostream& os, const ci::Color& v)		{ write_value(os, v.r); write_value(os, v.g); write_value(os, v.b); }
+void write_value(std::ostream& os, const ci::ColorA& v)		{ write_value(os, v.r); write_value(os, v.g); write_value(os, v.b); write_value(os, v.a); }
+void write_value(std::ostream& os, const ci::Vec2f& v)		{ write_value(os, v.x); write_value(os, v.y); }
+void write_value(std::ostream& os, const ci::Vec3f& v)		{ write_value(os, v.x); write_value(os, v.y); write_value(os, v.z); }
+void write_value(std::ostream& os, const std::string& v)	{ write_value(os, static_cast<uint32_t>(v.size())); write_raw(os, v.data(), v.size()); }
+void write_value(std::ostream& os, const std::wstring& v)	{ write_value(os, ds::utf8_from_wstr(v)); }
+
+bool read_value(std::istream& is, float& v)					{ return read_raw(is, &v, sizeof(v)); }
+bool read_value(std::istream& is, int& v)					{ int32_t i = 0; if (!read_raw(is, &i, sizeof(i))) return false; v = i; return true; }
+bool read_value(std::istream& is, uint32_t& v)				{ return read_raw(is, &v, sizeof(v)) && v <= BINARY_MAX_COUNT; }
+bool read_value(std::istream& is, ci::Rectf& v)				{ return read_value(is, v.x1) && read_value(is, v.y1) && read_value(is, v.x2) && read_value(is, v.y2); }
+bool read_value(std::istream& is, Resource::Id& v)			{ return read_raw(is, &v.mType, sizeof(v.mType)) && read_value(is, v.mValue); }
+bool read_value(std::istream& is, ci::Color& v)				{ return read_value(is, v.r) && read_value(is, v.g) && read_value(is, v.b); }
+bool read_value(std::istream& is, ci::ColorA& v)			{ return read_value(is, v.r) && read_value(is, v.g) && read_value(is, v.b) && read_value(is, v.a); }
+bool read_value(std::istream& is, ci::Vec2f& v)				{ return read_value(is, v.x) && read_value(is, v.y); }
+bool read_value(std::istream& is, ci::Vec3f& v)				{ return read_value(is, v.x) && read_value(is, v.y) && read_value(is, v.z); }
+
+bool read_value(std::istream& is, std::string& v)
+{
+	uint32_t			size = 0;
+	if (!read_value(is, size)) return false;
+	v.resize(size);
+	return size == 0 || read_raw(is, &v[0], size);
+}
+
+bool read_value(std::istream& is, std::wstring& v)
+{
+	std::string			utf8;
+	if (!read_value(is, utf8)) return false;
+	v = ds::wstr_from_utf8(utf8);
+	return true;
+}
+
+// V = std::map<std::string, std::vector<V>>
+template <typename V>
+void write_map(std::ostream& os, const V& src)
+{
+	write_value(os, static_cast<uint32_t>(src.size()));
+	for (auto it=src.begin(), end=src.end(); it != end; ++it) {
+		write_value(os, it->first);
+		write_value(os, static_cast<uint32_t>(it->second.size()));
+		for (auto vit=it->second.begin(), vend=it->second.end(); vit != vend; ++vit) write_value(os, *vit);
+	}
+}
+
+template <typename V>
+bool read_map(std::istream& is, V& dst)
+{
+	uint32_t			count = 0;
+	if (!read_value(is, count)) return false;
+	for (uint32_t k=0; k<count; ++k) {
+		std::string		name;
+		uint32_t		size = 0;
+		if (!read_value(is, name) || !read_value(is, size)) return false;
+		auto&			vec = dst[name];
+		vec.resize(size);
+		for (uint32_t j=0; j<size; ++j) {
+			if (!read_value(is, vec[j])) return false;
+		}
+	}
+	return true;
+}
+
 } // namespace
 
 /**
@@ -114,12 +205,55 @@ const V& get(const std::string& name, const A& container, const int index, const
  */
 Settings::Settings()
 	: mChanged(false)
+	, mStamp(++STAMP)
 {
 }
 
+Settings::Settings(const Settings& o)
+	: mChanged(o.mChanged)
+	, mStamp(++STAMP)
+	, mFloat(o.mFloat)
+	, mRect(o.mRect)
+	, mInt(o.mInt)
+	, mRes(o.mRes)
+	, mColor(o.mColor)
+	, mColorA(o.mColorA)
+	, mSize(o.mSize)
+	, mText(o.mText)
+	, mTextW(o.mTextW)
+	, mPoints(o.mPoints)
+{
+}
+
+Settings& Settings::operator=(const Settings& o)
+{
+	if (this != &o) {
+		mChanged = o.mChanged;
+		mFloat = o.mFloat;
+		mRect = o.mRect;
+		mInt = o.mInt;
+		mRes = o.mRes;
+		mColor = o.mColor;
+		mColorA = o.mColorA;
+		mSize = o.mSize;
+		mText = o.mText;
+		mTextW = o.mTextW;
+		mPoints = o.mPoints;
+		// My slots were just replaced
+		touch();
+	}
+	return *this;
+}
+
+void Settings::touch()
+{
+	mStamp = ++STAMP;
+}
+
 void Settings::readFrom(const std::string& filename, const bool append, const bool rawXmlText)
 {
 	mChanged = false;
+	touch();
 	if (!append) {
 		directReadFrom(filename, true, rawXmlText);
 		return;
@@ -364,6 +498,81 @@ void Settings::writeTo(const std::string& filename)
 	tree.write(cinder::writeFile(filename));
 }
 
+bool Settings::readBinaryFrom(const std::string& filename, const std::string& key)
+{
+	try {
+		std::ifstream		is(filename.c_str(), std::ios::in | std::ios::binary);
+		if (!is.is_open()) return false;
+
+		char				magic[sizeof(BINARY_MAGIC)];
+		int32_t				version = 0;
+		std::string			file_key;
+		if (!read_raw(is, magic, sizeof(magic)) || memcmp(magic, BINARY_MAGIC, sizeof(magic)) != 0) return false;
+		if (!read_raw(is, &version, sizeof(version)) || version != BINARY_VERSION) return false;
+		if (!read_value(is, file_key) || file_key != key) return false;
+
+		// Read into a temporary so a bad file can't leave me half loaded
+		Settings			s;
+		if (!read_map(is, s.mFloat) || !read_map(is, s.mRect) || !read_map(is, s.mInt)
+				|| !read_map(is, s.mRes) || !read_map(is, s.mColor) || !read_map(is, s.mColorA)
+				|| !read_map(is, s.mSize) || !read_map(is, s.mText) || !read_map(is, s.mTextW)
+				|| !read_map(is, s.mPoints)) {
+			return false;
+		}
+
+		mFloat.swap(s.mFloat);
+		mRect.swap(s.mRect);
+		mInt.swap(s.mInt);
+		mRes.swap(s.mRes);
+		mColor.swap(s.mColor);
+		mColorA.swap(s.mColorA);
+		mSize.swap(s.mSize);
+		mText.swap(s.mText);
+		mTextW.swap(s.mTextW);
+		mPoints.swap(s.mPoints);
+		mChanged = false;
+		touch();
+		return true;
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING("ds::cfg::Settings::readBinaryFrom() failed on " << filename << " exception=" << ex.what());
+	}
+	return false;
+}
+
+bool Settings::writeBinaryTo(const std::string& filename, const std::string& key) const
+{
+	try {
+		// Write beside and rename, so a reader never sees a partial file
+		const std::string	tmp(filename + ".tmp");
+		{
+			std::ofstream	os(tmp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!os.is_open()) return false;
+
+			write_raw(os, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+			write_raw(os, &BINARY_VERSION, sizeof(BINARY_VERSION));
+			write_value(os, key);
+			write_map(os, mFloat);
+			write_map(os, mRect);
+			write_map(os, mInt);
+			write_map(os, mRes);
+			write_map(os, mColor);
+			write_map(os, mColorA);
+			write_map(os, mSize);
+			write_map(os, mText);
+			write_map(os, mTextW);
+			write_map(os, mPoints);
+			if (!os.good()) return false;
+		}
+		Poco::File			dst(filename);
+		if (dst.exists()) dst.remove();
+		Poco::File(tmp).renameTo(filename);
+		return true;
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING("ds::cfg::Settings::writeBinaryTo() failed on " << filename << " exception=" << ex.what());
+	}
+	return false;
+}
+
 bool Settings::empty() const {
 	if (!mFloat.empty()) return false;
 	if (!mRect.empty()) return false;
@@ -377,6 +586,7 @@ bool Settings::empty() const {
 }
 
 void Settings::clear() {
+	touch();
 	mFloat.clear();
 	mInt.clear();
 	mRect.clear();
@@ -535,6 +745,56 @@ bool Settings::getBool(const std::string& name, const int index, const bool defa
 	return check_bool(getText(name, index, defaultValue ? TRUE_SZ : FALSE_SZ), false);
 }
 
+void Settings::findSlot(const std::string& name, const std::vector<float>*& out) const {
+	auto it = mFloat.find(name);
+	out = (it == mFloat.end() ? nullptr : &it->second);
+}
+
+void Settings::findSlot(const std::string& name, const std::vector<ci::Rectf>*& out) const {
+	auto it = mRect.find(name);
+	out = (it == mRect.end() ? nullptr : &it->second);
+}
+
+void Settings::findSlot(const std::string& name, const std::vector<int>*& out) const {
+	auto it = mInt.find(name);
+	out = (it == mInt.end() ? nullptr : &it->second);
+}
+
+void Settings::findSlot(const std::string& name, const std::vector<Resource::Id>*& out) const {
+	auto it = mRes.find(name);
+	out = (it == mRes.end() ? nullptr : &it->second);
+}
+
+void Settings::findSlot(const std::string& name, const std::vector<ci::Color>*& out) const {
+	auto it = mColor.find(name);
+	out = (it == mColor.end() ? nullptr : &it->second);
+}
+
+void Settings::findSlot(const std::string& name, const std::vector<ci::ColorA>*& out) const {
+	auto it = mColorA.find(name);
+	out = (it == mColorA.end() ? nullptr : &it->second);
+}
+
+void Settings::findSlot(const std::string& name, const std::vector<ci::Vec2f>*& out) const {
+	auto it = mSize.find(name);
+	out = (it == mSize.end() ? nullptr : &it->second);
+}
+
+void Settings::findSlot(const std::string& name, const std::vector<std::string>*& out) const {
+	auto it = mText.find(name);
+	out = (it == mText.end() ? nullptr : &it->second);
+}
+
+void Settings::findSlot(const std::string& name, const std::vector<std::wstring>*& out) const {
+	auto it = mTextW.find(name);
+	out = (it == mTextW.end() ? nullptr : &it->second);
+}
+
+void Settings::findSlot(const std::string& name, const std::vector<ci::Vec3f>*& out) const {
+	auto it = mPoints.find(name);
+	out = (it == mPoints.end() ? nullptr : &it->second);
+}
+
 void Settings::forEachColorAKey(const std::function<void(const std::string&)>& fn) const {
 	if (!fn || mColorA.empty()) return;
 
@@ -612,6 +872,7 @@ static void clear_vec(A& container)
 Settings::Editor& Settings::Editor::clear()
 {
 	mSettings.mChanged = true;
+	mSettings.touch();
 
 	mSettings.mFloat.clear();
 	mSettings.mRect.clear();
@@ -683,6 +944,7 @@ static void editor_delete_vec(const int mode, const std::string& name, A& contai
 
 Settings::Editor& Settings::Editor::setColor(const std::string& name, const ci::Color &v) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_set_vec(mMode, name, mSettings.mColor, v);
 	editor_set_vec(mMode, name, mSettings.mColorA, ci::ColorA(v.r, v.g, v.b, 1.0f));
 	return *this;
@@ -690,6 +952,7 @@ Settings::Editor& Settings::Editor::setColor(const std::string& name, const ci::
 
 Settings::Editor& Settings::Editor::setColorA(const std::string& name, const ci::ColorA &v) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_set_vec(mMode, name, mSettings.mColorA, v);
 	editor_set_vec(mMode, name, mSettings.mColor, ci::Color(v.r, v.g, v.b));
 	return *this;
@@ -697,66 +960,77 @@ Settings::Editor& Settings::Editor::setColorA(const std::string& name, const ci:
 
 Settings::Editor& Settings::Editor::setFloat(const std::string& name, const float v) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_set_vec(mMode, name, mSettings.mFloat, v);
 	return *this;
 }
 
 Settings::Editor& Settings::Editor::setInt(const std::string& name, const int v) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_set_vec(mMode, name, mSettings.mInt, v);
 	return *this;
 }
 
 Settings::Editor& Settings::Editor::setRect(const std::string& name, const ci::Rectf& v) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_set_vec(mMode, name, mSettings.mRect, v);
 	return *this;
 }
 
 Settings::Editor& Settings::Editor::setResourceId(const std::string& name, const Resource::Id& v) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_set_vec(mMode, name, mSettings.mRes, v);
 	return *this;
 }
 
 Settings::Editor& Settings::Editor::setSize(const std::string& name, const ci::Vec2f& v) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_set_vec(mMode, name, mSettings.mSize, v);
 	return *this;
 }
 
 Settings::Editor& Settings::Editor::setText(const std::string& name, const std::string& v) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_set_vec(mMode, name, mSettings.mText, v);
 	return *this;
 }
 
 Settings::Editor& Settings::Editor::setPoint(const std::string& name, const ci::Vec3f& v) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_set_vec(mMode, name, mSettings.mPoints, v);
 	return *this;
 }
 
 Settings::Editor& Settings::Editor::addInt(const std::string& name, const int v) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_add_vec(mMode, name, mSettings.mInt, v);
 	return *this;
 }
 
 Settings::Editor& Settings::Editor::addResourceId(const std::string& name, const Resource::Id& v) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_add_vec(mMode, name, mSettings.mRes, v);
 	return *this;
 }
 
 Settings::Editor& Settings::Editor::addTextW(const std::string& name, const std::wstring& v) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_add_vec(mMode, name, mSettings.mTextW, v);
 	return *this;
 }
 
 Settings::Editor& Settings::Editor::deleteColor(const std::string& name) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_delete_vec(mMode, name, mSettings.mColor);
 	editor_delete_vec(mMode, name, mSettings.mColorA);
 	return *this;
@@ -764,6 +1038,7 @@ Settings::Editor& Settings::Editor::deleteColor(const std::string& name) {
 
 Settings::Editor& Settings::Editor::deleteColorA(const std::string& name) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_delete_vec(mMode, name, mSettings.mColor);
 	editor_delete_vec(mMode, name, mSettings.mColorA);
 	return *this;
@@ -771,12 +1046,14 @@ Settings::Editor& Settings::Editor::deleteColorA(const std::string& name) {
 
 Settings::Editor& Settings::Editor::deleteFloat(const std::string& name) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_delete_vec(mMode, name, mSettings.mFloat);
 	return *this;
 }
 
 Settings::Editor& Settings::Editor::deleteInt(const std::string& name) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_delete_vec(mMode, name, mSettings.mInt);
 	return *this;
 }
@@ -784,6 +1061,7 @@ Settings::Editor& Settings::Editor::deleteInt(const std::string& name) {
 
 Settings::Editor& Settings::Editor::deleteResourceId(const std::string& name) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_delete_vec(mMode, name, mSettings.mRes);
 	return *this;
 }
@@ -791,6 +1069,7 @@ Settings::Editor& Settings::Editor::deleteResourceId(const std::string& name) {
 
 Settings::Editor& Settings::Editor::deleteRect(const std::string& name) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_delete_vec(mMode, name, mSettings.mRect);
 	return *this;
 }
@@ -798,6 +1077,7 @@ Settings::Editor& Settings::Editor::deleteRect(const std::string& name) {
 
 Settings::Editor& Settings::Editor::deleteSize(const std::string& name) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_delete_vec(mMode, name, mSettings.mSize);
 	return *this;
 }
@@ -805,6 +1085,7 @@ Settings::Editor& Settings::Editor::deleteSize(const std::string& name) {
 
 Settings::Editor& Settings::Editor::deleteText(const std::string& name) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_delete_vec(mMode, name, mSettings.mText);
 	return *this;
 }
@@ -812,6 +1093,7 @@ Settings::Editor& Settings::Editor::deleteText(const std::string& name) {
 
 Settings::Editor& Settings::Editor::deletePoint(const std::string& name) {
 	mSettings.mChanged = true;
+	mSettings.touch();
 	editor_delete_vec(mMode, name, mSettings.mPoints);
 	return *this;
 }
@@ -15,6 +15,29 @@ class XmlTree;
 namespace ds {
 namespace cfg {
 
+namespace detail {
+// How a Settings::Handle<T> is stored and answered. Bools live in the text fields.
+template <typename T>
+struct HandleTraits {
+	typedef T							stored;
+	typedef const T&					result;
+	static result						convert(const stored& v, const T&) { return v; }
+};
+
+// Same as Settings::getBool(): t or f, anything else is the default
+template <>
+struct HandleTraits<bool> {
+	typedef std::string					stored;
+	typedef bool						result;
+	static result						convert(const stored& v, const bool defaultValue) {
+		if (v.empty()) return defaultValue;
+		if (v[0] == 't' || v[0] == 'T') return true;
+		if (v[0] == 'f' || v[0] == 'F') return false;
+		return defaultValue;
+	}
+};
+} // namespace detail
+
 /**
  * \class ds::cfg::Settings
  * \brief Store generic settings info.
@@ -22,6 +45,9 @@ namespace cfg {
 class Settings {
 public:
 	Settings();
+	// Copies take a new stamp, so no handle mistakes one for the settings it last resolved on.
+	Settings(const Settings&);
+	Settings&							operator=(const Settings&);
 	
 	// Load the supplied file/string.  Currently only XML format is supported.
 	// If append is true, merge all results into my existing data.  If it's
@@ -31,6 +57,12 @@ public:
 	
 	void								writeTo(const std::string&);
 
+	// Binary snapshot of everything I hold, so a warm start can skip the XML parse.
+	// The key identifies the sources (i.e. their paths and timestamps). Reading answers
+	// false and leaves me alone if the file is missing, corrupt or has a different key.
+	bool								readBinaryFrom(const std::string& filename, const std::string& key);
+	bool								writeBinaryTo(const std::string& filename, const std::string& key) const;
+
 	bool								isChanged() const { return mChanged; }
 	bool								empty() const;
 	void							  	clear();
@@ -87,6 +119,8 @@ public:
 
 private:
 	bool								mChanged;
+	// Changes whenever a slot might have been added or removed, so handles know to resolve again.
+	int									mStamp;
 
 	std::map<std::string, std::vector<float>>			mFloat;
 	std::map<std::string, std::vector<ci::Rectf>>		mRect;
@@ -103,6 +137,19 @@ private:
 	void								directReadXmlFrom(const std::string& filename, const bool clear);
 	void								directReadXmlFromString(const std::string& xmlStr, const bool clear);
 	void								directReadXmlFromTree(const cinder::XmlTree& tree, const bool clear);
+	void								touch();
+
+	// Handle storage lookup, answer nullptr if the name doesn't exist.
+	void								findSlot(const std::string&, const std::vector<float>*&) const;
+	void								findSlot(const std::string&, const std::vector<ci::Rectf>*&) const;
+	void								findSlot(const std::string&, const std::vector<int>*&) const;
+	void								findSlot(const std::string&, const std::vector<Resource::Id>*&) const;
+	void								findSlot(const std::string&, const std::vector<ci::Color>*&) const;
+	void								findSlot(const std::string&, const std::vector<ci::ColorA>*&) const;
+	void								findSlot(const std::string&, const std::vector<ci::Vec2f>*&) const;
+	void								findSlot(const std::string&, const std::vector<std::string>*&) const;
+	void								findSlot(const std::string&, const std::vector<std::wstring>*&) const;
+	void								findSlot(const std::string&, const std::vector<ci::Vec3f>*&) const;
 
 public:
 	class Editor {
@@ -145,8 +192,110 @@ public:
 		Settings&						mSettings;
 		int							  	mMode;
 	};
+
+	/**
+	 * \class ds::cfg::Settings::Handle
+	 * \brief A setting name that's looked up once, then read straight from its
+	 * slot, for settings read every frame in update and layout code. The slot is
+	 * found again if the handle is used on different settings, or after they've
+	 * been loaded or edited. T is any of the getter types, i.e. float, ci::Rectf,
+	 * ci::Color, std::string, etc. Bools read the text fields, same as getBool().
+	 * Not thread safe, keep a handle to one thread.
+	 *
+	 * static const ds::cfg::Settings::Handle<float>	SPEED("menu:speed", 1.0f);
+	 * const float		speed = SPEED.get(settings);
+	 */
+	template <typename T>
+	class Handle {
+	public:
+		typedef typename detail::HandleTraits<T>::stored	stored;
+		typedef typename detail::HandleTraits<T>::result	result;
+
+		Handle(const std::string& name, const T& defaultValue = T());
+		// Copies resolve again on first use, rather than share the original's slot.
+		Handle(const Handle&);
+		Handle&							operator=(const Handle&);
+
+		const std::string&				getName() const			{ return mName; }
+		int								getSize(const Settings&) const;
+		// Answer the default if not found
+		result							get(const Settings&, const int index = 0) const;
+
+	private:
+		const std::vector<stored>*		resolve(const Settings&) const;
+
+		std::string						mName;
+		T								mDefault;
+		mutable const Settings*			mOwner;
+		mutable int						mStamp;
+		mutable const std::vector<stored>*
+										mSlot;
+	};
 };
 
+/**
+ * ds::cfg::Settings::Handle
+ */
+template <typename T>
+Settings::Handle<T>::Handle(const std::string& name, const T& defaultValue)
+	: mName(name)
+	, mDefault(defaultValue)
+	, mOwner(nullptr)
+	, mStamp(0)
+	, mSlot(nullptr)
+{
+}
+
+template <typename T>
+Settings::Handle<T>::Handle(const Handle& o)
+	: mName(o.mName)
+	, mDefault(o.mDefault)
+	, mOwner(nullptr)
+	, mStamp(0)
+	, mSlot(nullptr)
+{
+}
+
+template <typename T>
+Settings::Handle<T>& Settings::Handle<T>::operator=(const Handle& o)
+{
+	if (this != &o) {
+		mName = o.mName;
+		mDefault = o.mDefault;
+		mOwner = nullptr;
+		mStamp = 0;
+		mSlot = nullptr;
+	}
+	return *this;
+}
+
+template <typename T>
+int Settings::Handle<T>::getSize(const Settings& s) const
+{
+	const std::vector<stored>*		slot = resolve(s);
+	return slot ? static_cast<int>(slot->size()) : 0;
+}
+
+template <typename T>
+typename Settings::Handle<T>::result Settings::Handle<T>::get(const Settings& s, const int index) const
+{
+	const std::vector<stored>*		slot = resolve(s);
+	if (slot && index >= 0 && index < static_cast<int>(slot->size())) return detail::HandleTraits<T>::convert((*slot)[index], mDefault);
+	return mDefault;
+}
+
+template <typename T>
+const std::vector<typename Settings::Handle<T>::stored>* Settings::Handle<T>::resolve(const Settings& s) const
+{
+	if (mOwner != &s || mStamp != s.mStamp) {
+		mSlot = nullptr;
+		s.findSlot(mName, mSlot);
+		mOwner = &s;
+		mStamp = s.mStamp;
+	}
+	return mSlot;
+}
+
 } // namespace cfg
 } // namespace ds
 
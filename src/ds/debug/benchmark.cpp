@@ -0,0 +1,358 @@
+#include "ds/debug/benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include <Poco/Timestamp.h>
+#include "ds/app/blob_reader.h"
+#include "ds/app/engine/engine.h"
+#include "ds/app/environment.h"
+#include "ds/cfg/settings.h"
+#include "ds/data/data_buffer.h"
+#include "ds/debug/logger.h"
+#include "ds/params/update_params.h"
+#include "ds/ui/sprite/image.h"
+#include "ds/ui/sprite/sprite.h"
+#include "ds/ui/sprite/text.h"
+#include "ds/ui/sprite/util/sprite_pool.h"
+#include "ds/util/string_util.h"
+
+namespace ds {
+
+namespace {
+// Phases, in the order they run each frame. Only the touch scene has a touch phase.
+enum { UPDATE, SORT, SERIALIZE, DESERIALIZE, HIT_TEST, PHASE_COUNT, TOUCH = PHASE_COUNT };
+const char*			PHASE_NAMES[PHASE_COUNT] = { "update", "sort", "serialize", "deserialize", "hit_test" };
+
+const float			SPRITE_SIZE = 24.0f;
+const float			SPACING = 32.0f;
+const float			FRAME_RATE = 60.0f;
+
+double				ms_since(const Poco::Timestamp& t) {
+	return static_cast<double>(t.elapsed()) / 1000.0;
+}
+
+// Sample at fraction f of the sorted samples
+double				percentile(const std::vector<double>& sorted, const double f) {
+	if (sorted.empty()) return 0.0;
+	const size_t	i = static_cast<size_t>(f * static_cast<double>(sorted.size() - 1) + 0.5);
+	return sorted[std::min(i, sorted.size() - 1)];
+}
+
+// A cheap, repeatable wobble so every run moves the same way
+float				wobble(const size_t index, const int frame) {
+	return std::sin(static_cast<float>(index) * 0.37f + static_cast<float>(frame) * 0.11f);
+}
+}
+
+/**
+ * \class ds::Benchmark
+ */
+Benchmark::Benchmark(ds::Engine& e, const ds::cfg::Settings& settings)
+		: Benchmark(e, e.getRootSprite(), settings) {
+	mTouchEngine = &e;
+}
+
+Benchmark::Benchmark(ds::ui::SpriteEngine& e, ds::ui::Sprite& parent, const ds::cfg::Settings& settings)
+		: mEngine(e)
+		, mTouchEngine(nullptr)
+		, mParent(parent)
+		, mEnabled(settings.getBool("benchmark:enabled", 0, false))
+		, mQuit(settings.getBool("benchmark:quit", 0, true))
+		, mScenes(ds::split(settings.getText("benchmark:scenes", 0, "deep,wide,static,text,image,touch"), ", ", true))
+		, mFrames(std::max(1, settings.getInt("benchmark:frames", 0, 120)))
+		, mSprites(std::max(1, settings.getInt("benchmark:sprites", 0, 10000)))
+		, mDepth(std::max(1, settings.getInt("benchmark:depth", 0, 64)))
+		, mHits(std::max(0, settings.getInt("benchmark:hits", 0, 100)))
+		, mTouchRate(std::max(0, settings.getInt("benchmark:touch_rate", 0, 1000)))
+		, mFingers(std::max(1, settings.getInt("benchmark:fingers", 0, 20)))
+		, mFont(settings.getText("benchmark:font", 0, ""))
+		, mImage(settings.getText("benchmark:image", 0, ""))
+		, mFolder(settings.getText("benchmark:file", 0, "%LOCAL%/benchmarks/")) {
+}
+
+bool Benchmark::isEnabled() const {
+	return mEnabled;
+}
+
+bool Benchmark::quitWhenDone() const {
+	return mQuit;
+}
+
+std::string Benchmark::run() {
+	std::vector<Scene>		scenes;
+	for (auto it=mScenes.begin(), end=mScenes.end(); it!=end; ++it) {
+		Scene				scene(*it);
+		try {
+			if (runScene(*it, scene)) scenes.push_back(scene);
+		} catch (std::exception const& ex) {
+			DS_LOG_WARNING("Benchmark scene " << *it << " failed ex=" << ex.what());
+		}
+	}
+	return write(scenes);
+}
+
+bool Benchmark::runScene(const std::string& name, Scene& scene) {
+	std::vector<ds::ui::Sprite*>	all, parents;
+	const size_t					pool_before = ds::ui::SpritePool::get().getBytesInUse();
+	if (name == "touch" && !mTouchEngine) {
+		DS_LOG_WARNING("Benchmark touch scene needs a full engine, skipping");
+		return false;
+	}
+	ds::ui::Sprite*					root = build(name, all, parents);
+	if (!root) {
+		DS_LOG_WARNING("Benchmark unknown scene " << name);
+		return false;
+	}
+	scene.mSprites = all.size();
+	if (!all.empty()) {
+		const size_t				pool_after = ds::ui::SpritePool::get().getBytesInUse();
+		scene.mPoolBytesPerSprite = static_cast<double>(pool_after - pool_before) / static_cast<double>(all.size());
+	}
+	for (auto it=all.begin(), end=all.end(); it!=end; ++it) {
+		if ((*it)->mExtra) ++scene.mExtraSprites;
+	}
+	const bool						is_touch = (name == "touch");
+	for (int k=0; k<PHASE_COUNT; ++k) {
+		scene.mPhases.push_back(Phase(PHASE_NAMES[k]));
+		scene.mPhases.back().mMs.reserve(mFrames);
+	}
+	if (is_touch) {
+		scene.mPhases.push_back(Phase("touch"));
+		scene.mPhases.back().mMs.reserve(mFrames);
+	}
+
+	// Hit points on a grid over the scene
+	std::vector<ci::Vec3f>			hits;
+	const int						side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(mHits))));
+	const float						extent = SPACING * std::sqrt(static_cast<float>(all.size()));
+	for (int k=0; k<mHits; ++k) {
+		hits.push_back(ci::Vec3f(extent * (static_cast<float>(k % side) + 0.5f) / static_cast<float>(side),
+								 extent * (static_cast<float>(k / side) + 0.5f) / static_cast<float>(side), 0.0f));
+	}
+
+	ds::DataBuffer					buf;
+	ds::BlobReader					reader(buf, mEngine);
+	ds::UpdateParams				params;
+	params.setDeltaTime(1.0f / FRAME_RATE);
+	const bool						is_text = (name == "text");
+	const bool						is_static = (name == "static");
+	// The static scene wobbles around where it was built, so it needs to know where that was
+	std::vector<ci::Vec2f>			home;
+	if (is_static) {
+		home.reserve(all.size());
+		for (auto it=all.begin(), end=all.end(); it!=end; ++it) home.push_back((*it)->getPosition().xy());
+	}
+	double							touch_due = 0.0;
+	int								touch_sent = 0;
+	for (int frame=0; frame<mFrames; ++frame) {
+		params.setElapsedTime(static_cast<float>(frame) / FRAME_RATE);
+
+		// Touches arrive before the frame, the way they would from the TUIO thread
+		if (is_touch) {
+			feedTouches(frame, extent, touch_due, touch_sent);
+			Poco::Timestamp			t;
+			mTouchEngine->updateTouches(params.getElapsedTime());
+			scene.mPhases[TOUCH].mMs.push_back(ms_since(t));
+		}
+
+		// Move everything (untimed), which dirties every sprite, and every sort
+		// unless z is left alone
+		for (size_t k=0; k<all.size(); ++k) {
+			ds::ui::Sprite*			s = all[k];
+			const ci::Vec3f&		p = s->getPosition();
+			if (is_static) s->setPosition(home[k].x + wobble(k, frame), home[k].y, p.z);
+			else s->setPosition(p.x, p.y, wobble(k, frame));
+			// An eighth of the text changes every frame, so layout is part of the update
+			if (is_text && k % 8 == static_cast<size_t>(frame % 8)) {
+				std::stringstream	str;
+				str << "Sprite " << k << " frame " << frame;
+				static_cast<ds::ui::Text*>(s)->setText(str.str());
+			}
+		}
+
+		Poco::Timestamp				t;
+		root->updateServer(params);
+		scene.mPhases[UPDATE].mMs.push_back(ms_since(t));
+
+		t.update();
+		for (auto it=parents.begin(), end=parents.end(); it!=end; ++it) (*it)->makeSortedChildren();
+		scene.mPhases[SORT].mMs.push_back(ms_since(t));
+
+		buf.clear();
+		t.update();
+		root->writeTo(buf);
+		scene.mPhases[SERIALIZE].mMs.push_back(ms_since(t));
+		scene.mSerializedBytes = buf.size();
+
+		// The same work a client does for sprites it already has
+		buf.seekBegin();
+		t.update();
+		while (buf.canRead<char>()) {
+			buf.read<char>();
+			if (!buf.canRead<char>() || buf.read<char>() != ds::ui::SPRITE_ID_ATTRIBUTE) break;
+			ds::ui::Sprite*			s = mEngine.findSprite(buf.read<ds::sprite_id_t>());
+			if (!s) break;
+			s->readFrom(reader);
+		}
+		scene.mPhases[DESERIALIZE].mMs.push_back(ms_since(t));
+
+		t.update();
+		for (auto it=hits.begin(), end=hits.end(); it!=end; ++it) root->getHit(*it);
+		scene.mPhases[HIT_TEST].mMs.push_back(ms_since(t));
+	}
+
+	root->release();
+	return true;
+}
+
+void Benchmark::feedTouches(const int frame, const float extent, double& due, int& sent) const {
+	// Every finger goes down on the first frame and up on the last, and each
+	// sample moves one finger, round robin, along its own circle.
+	const ci::app::WindowRef					window = ci::app::getWindow();
+	std::vector<ci::app::TouchEvent::Touch>		touches;
+	auto										make_touch = [&](const int finger, const int step)->ci::app::TouchEvent::Touch {
+		const float			a = static_cast<float>(step) * 0.05f + static_cast<float>(finger);
+		const ci::Vec2f		center(extent * (static_cast<float>(finger % 5) + 0.5f) / 5.0f,
+								   extent * (static_cast<float>(finger / 5 % 5) + 0.5f) / 5.0f);
+		const ci::Vec2f		pos(center + ci::Vec2f(std::cos(a), std::sin(a)) * SPACING);
+		return ci::app::TouchEvent::Touch(pos, pos, finger, static_cast<double>(frame) / FRAME_RATE, nullptr);
+	};
+
+	if (frame == 0) {
+		for (int k=0; k<mFingers; ++k) touches.push_back(make_touch(k, 0));
+		mTouchEngine->touchesBegin(ci::app::TouchEvent(window, touches));
+	}
+
+	// Carry the remainder, so the rate holds over the run
+	due += static_cast<double>(mTouchRate) / FRAME_RATE;
+	for (; due >= 1.0; due -= 1.0, ++sent) {
+		touches.clear();
+		touches.push_back(make_touch(sent % mFingers, sent / mFingers + 1));
+		mTouchEngine->touchesMoved(ci::app::TouchEvent(window, touches));
+	}
+
+	if (frame == mFrames - 1) {
+		touches.clear();
+		for (int k=0; k<mFingers; ++k) touches.push_back(make_touch(k, 0));
+		mTouchEngine->touchesEnded(ci::app::TouchEvent(window, touches));
+	}
+}
+
+ds::ui::Sprite* Benchmark::build(const std::string& name, std::vector<ds::ui::Sprite*>& all,
+								 std::vector<ds::ui::Sprite*>& parents) const {
+	const bool					deep = (name == "deep");
+	if (!deep && name != "wide" && name != "static" && name != "text" && name != "image" && name != "touch") return nullptr;
+
+	ds::ui::Sprite*				root = new ds::ui::Sprite(mEngine);
+	root->setDrawSorted(true);
+	mParent.addChild(*root);
+	parents.push_back(root);
+
+	// Lay everything out on a square grid, so hits land on something
+	const int					columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(mSprites))));
+	ds::ui::Sprite*				parent = root;
+	ci::Vec2f					parent_pos(0.0f, 0.0f);
+	for (int k=0; k<mSprites; ++k) {
+		ds::ui::Sprite*			s = nullptr;
+		if (name == "text") {
+			ds::ui::Text*		t = new ds::ui::Text(mEngine);
+			if (!mFont.empty()) t->setFont(mFont, 12.0f);
+			t->setText("Sprite");
+			s = t;
+		} else if (name == "image") {
+			s = (mImage.empty() ? new ds::ui::Image(mEngine) : new ds::ui::Image(mEngine, mImage));
+		} else {
+			s = new ds::ui::Sprite(mEngine);
+		}
+		s->setSize(SPRITE_SIZE, SPRITE_SIZE);
+		s->enable(true);
+
+		// The deep scene nests chains of mDepth sprites, each placed relative to its parent
+		const float				x = SPACING * static_cast<float>(k % columns),
+								y = SPACING * static_cast<float>(k / columns);
+		if (!deep || k % mDepth == 0) {
+			parent = root;
+			parent_pos = ci::Vec2f(0.0f, 0.0f);
+		}
+		s->setPosition(x - parent_pos.x, y - parent_pos.y);
+		parent->addChild(*s);
+		all.push_back(s);
+		if (deep && k % mDepth != mDepth - 1) {
+			parents.push_back(s);
+			parent = s;
+			parent_pos = ci::Vec2f(x, y);
+		}
+	}
+	return root;
+}
+
+std::string Benchmark::write(const std::vector<Scene>& scenes) const {
+	try {
+		Poco::Path				path(ds::Environment::expand(mFolder));
+		path.makeDirectory();
+		Poco::File(path).createDirectories();
+		std::stringstream		fn;
+		fn << "ds_benchmark." << Poco::Timestamp().epochMicroseconds() << ".json";
+		path.setFileName(fn.str());
+
+		std::ofstream			out(path.toString().c_str(), std::ios_base::out | std::ios_base::trunc);
+		if (!out.is_open()) {
+			DS_LOG_WARNING("Benchmark::write() can't open " << path.toString());
+			return "";
+		}
+		out << "{\"frames\":" << mFrames << ",\"sprites\":" << mSprites << ",\"depth\":" << mDepth
+			<< ",\"hits\":" << mHits << ",\"touch_rate\":" << mTouchRate << ",\"fingers\":" << mFingers
+			<< ",\"sizeof_sprite\":" << sizeof(ds::ui::Sprite) << ",\"scenes\":[" << std::endl;
+		for (auto sit=scenes.begin(), send=scenes.end(); sit!=send; ++sit) {
+			if (sit != scenes.begin()) out << "," << std::endl;
+			// Scene names come from the settings, but only known names make it this far
+			out << "{\"name\":\"" << sit->mName << "\",\"sprites\":" << sit->mSprites
+				<< ",\"serialized_bytes\":" << sit->mSerializedBytes << ",\"pool_bytes_per_sprite\":" << sit->mPoolBytesPerSprite
+				<< ",\"extra_sprites\":" << sit->mExtraSprites << ",\"phases\":{";
+			for (auto pit=sit->mPhases.begin(), pend=sit->mPhases.end(); pit!=pend; ++pit) {
+				std::vector<double>	ms(pit->mMs);
+				std::sort(ms.begin(), ms.end());
+				double			total = 0.0;
+				for (auto it=ms.begin(), end=ms.end(); it!=end; ++it) total += *it;
+				if (pit != sit->mPhases.begin()) out << ",";
+				out << "\"" << pit->mName << "\":{\"avg_ms\":" << (ms.empty() ? 0.0 : total / static_cast<double>(ms.size()))
+					<< ",\"min_ms\":" << (ms.empty() ? 0.0 : ms.front())
+					<< ",\"p50_ms\":" << percentile(ms, 0.5)
+					<< ",\"p95_ms\":" << percentile(ms, 0.95)
+					<< ",\"max_ms\":" << (ms.empty() ? 0.0 : ms.back()) << "}";
+			}
+			out << "}}";
+		}
+		out << std::endl << "]}" << std::endl;
+		out.close();
+		DS_LOG_INFO("Benchmark wrote " << path.toString());
+		return path.toString();
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING("Benchmark::write() error " << ex.what());
+	}
+	return "";
+}
+
+/**
+ * \class ds::Benchmark::Phase
+ */
+Benchmark::Phase::Phase(const char* name)
+		: mName(name) {
+}
+
+/**
+ * \class ds::Benchmark::Scene
+ */
+Benchmark::Scene::Scene(const std::string& name)
+		: mName(name)
+		, mSprites(0)
+		, mSerializedBytes(0)
+		, mPoolBytesPerSprite(0.0)
+		, mExtraSprites(0) {
+}
+
+} // namespace ds
@@ -0,0 +1,117 @@
+#pragma once
+#ifndef DS_DEBUG_BENCHMARK_H_
+#define DS_DEBUG_BENCHMARK_H_
+
+#include <string>
+#include <vector>
+
+namespace ds {
+class Engine;
+
+namespace cfg {
+class Settings;
+} // namespace cfg
+
+namespace ui {
+class Sprite;
+class SpriteEngine;
+} // namespace ui
+
+/**
+ * \class ds::Benchmark
+ * \brief Time the engine's sprite paths against synthetic scenes. Each scene
+ * is built under a parent sprite, run for N frames and torn down. Every frame
+ * moves all the sprites, then times each phase: updateServer(), re-sorting
+ * the children of draw-sorted sprites, writeTo(), reading that back in, and a
+ * grid of getHit() calls. Most scenes move sprites in z, so every sort is
+ * dirty; the static scene is the wide scene moving in x and y only, so its
+ * sorts are the clean case. Results are written as JSON. Nothing is drawn, so
+ * any SpriteEngine will do: the ds_benchmark console target (test/vs2013)
+ * runs it headless, with no window or GL. In an app, pair it with the null
+ * renderer. The touch scene also feeds the engine touch moves at a fixed
+ * rate, and times the engine dispatching them, so it only runs given a full
+ * ds::Engine. Each
+ * scene also reports the SpritePool bytes its sprites take, per sprite, and
+ * how many of them had to allocate their touch/idle/uniform side data.
+ * Settings are read from debug.xml, or the file given to ds_benchmark:
+ *	"benchmark:enabled" bool -- run the benchmark after app setup. DEFAULT=false
+ *	"benchmark:scenes" text -- any of deep, wide, static, text, image, touch. DEFAULT=deep,wide,static,text,image,touch
+ *	"benchmark:frames" int -- frames per scene. DEFAULT=120
+ *	"benchmark:sprites" int -- sprites per scene. DEFAULT=10000
+ *	"benchmark:depth" int -- nesting of the deep scene. DEFAULT=64
+ *	"benchmark:hits" int -- getHit() calls per frame. DEFAULT=100
+ *	"benchmark:touch_rate" int -- touch move samples per second, at 60 frames a second. DEFAULT=1000
+ *	"benchmark:fingers" int -- fingers down in the touch scene. DEFAULT=20
+ *	"benchmark:font" text -- font for the text scene, blank for the default.
+ *	"benchmark:image" text -- image file for the image scene, blank for none.
+ *	"benchmark:file" text -- results folder. DEFAULT=%LOCAL%/benchmarks/
+ *	"benchmark:quit" bool -- quit the app when finished. DEFAULT=true
+ */
+class Benchmark {
+public:
+	// Every scene, built under the root sprite
+	Benchmark(ds::Engine&, const ds::cfg::Settings&);
+	// Every scene but touch, built under parent
+	Benchmark(ds::ui::SpriteEngine&, ds::ui::Sprite& parent, const ds::cfg::Settings&);
+
+	bool						isEnabled() const;
+	bool						quitWhenDone() const;
+
+	// Run every scene and write the results. Answer the results filename, or empty on failure.
+	std::string					run();
+
+	class Phase {
+	public:
+		Phase(const char* name);
+		const char*				mName;
+		// One sample per frame, in milliseconds
+		std::vector<double>		mMs;
+	};
+
+	class Scene {
+	public:
+		Scene(const std::string& name);
+		std::string				mName;
+		size_t					mSprites;
+		// Bytes written by writeTo() in the last frame
+		size_t					mSerializedBytes;
+		// SpritePool bytes taken by building the scene, over mSprites. Only
+		// the sprite objects themselves; what they allocate on the heap
+		// (children, strings, side data) isn't counted.
+		double					mPoolBytesPerSprite;
+		// Sprites that allocated their side data
+		size_t					mExtraSprites;
+		std::vector<Phase>		mPhases;
+	};
+
+private:
+	bool						runScene(const std::string& name, Scene&);
+	// Queue this frame's touches for the touch scene, spread over the fingers.
+	// due carries the fraction of a sample between frames, sent counts every sample.
+	void						feedTouches(const int frame, const float extent, double& due, int& sent) const;
+	// Answer the scene root, and fill in every sprite and every parent.
+	ds::ui::Sprite*				build(const std::string& name, std::vector<ds::ui::Sprite*>& all,
+									  std::vector<ds::ui::Sprite*>& parents) const;
+	std::string					write(const std::vector<Scene>&) const;
+
+	ds::ui::SpriteEngine&		mEngine;
+	// Only set when there's a full engine to feed touches to
+	ds::Engine*					mTouchEngine;
+	ds::ui::Sprite&				mParent;
+	bool						mEnabled,
+								mQuit;
+	std::vector<std::string>	mScenes;
+	int							mFrames,
+								mSprites,
+								mDepth,
+								mHits,
+								mTouchRate,
+								mFingers;
+	std::string					mFont,
+								mImage,
+								mFolder;
+};
+
+} // namespace ds
+
+#endif // DS_DEBUG_BENCHMARK_H_
@@ -0,0 +1,398 @@
+#include "ds/debug/frame_profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include "ds/app/environment.h"
+#include "ds/cfg/settings.h"
+#include "ds/debug/logger.h"
+
+namespace ds {
+
+#if defined(_MSC_VER)
+#define DS_PROFILER_THREAD_LOCAL	__declspec(thread)
+#else
+#define DS_PROFILER_THREAD_LOCAL	__thread
+#endif
+
+namespace {
+// Read by every scope on every thread
+std::atomic<bool>	ENABLED(false);
+// Only assign during setup()
+size_t				HISTORY_SIZE = 120;
+int					TRACE_FRAMES = 60;
+std::string			TRACE_FOLDER("%LOCAL%/traces/");
+
+const double		MICROS_TO_MS = 1.0 / 1000.0;
+// About ten seconds of empty frames before a buffer goes to another thread
+const int			BUFFER_IDLE_FRAMES = 600;
+// A sample whose phase hasn't been looked up
+const size_t		NO_PHASE = static_cast<size_t>(-1);
+
+// The calling thread's sample buffer, owned by the profiler
+DS_PROFILER_THREAD_LOCAL void*	THREAD_BUFFER = nullptr;
+
+// JSON strings in a trace are phase names, which are code literals, but be safe.
+void				write_json_string(std::ostream& out, const std::string& str) {
+	out << "\"";
+	for (auto it=str.begin(), end=str.end(); it!=end; ++it) {
+		if (*it == '"' || *it == '\\') out << '\\';
+		out << *it;
+	}
+	out << "\"";
+}
+}
+
+/**
+ * \class ds::FrameProfiler static
+ */
+const double FrameProfiler::HISTOGRAM_BOUNDS[HISTOGRAM_SIZE-1] = { 0.25, 0.5, 1.0, 2.0, 4.0, 8.0, 16.7 };
+
+void FrameProfiler::setup(const ds::cfg::Settings& settings) {
+	ENABLED = settings.getBool("profiler:enabled", 0, false);
+	HISTORY_SIZE = static_cast<size_t>(std::max(1, settings.getInt("profiler:history", 0, static_cast<int>(HISTORY_SIZE))));
+	TRACE_FRAMES = std::max(1, settings.getInt("profiler:trace_frames", 0, TRACE_FRAMES));
+	TRACE_FOLDER = settings.getText("profiler:trace_file", 0, TRACE_FOLDER);
+}
+
+bool FrameProfiler::isEnabled() {
+	return ENABLED;
+}
+
+void FrameProfiler::setEnabled(const bool on) {
+	ENABLED = on;
+}
+
+/**
+ * \class ds::FrameProfiler
+ */
+FrameProfiler::FrameProfiler()
+		: mFrame(0)
+		, mFrameStart(Poco::Timestamp().epochMicroseconds())
+		, mTraceFramesLeft(0)
+		, mEnabledBeforeTrace(false) {
+	mPhases.reserve(32);
+}
+
+void FrameProfiler::beginFrame() {
+	if (!ENABLED && mTraceFramesLeft <= 0) return;
+
+	bool						write = false;
+	{
+		Poco::FastMutex::ScopedLock		l(mMutex);
+		for (auto it=mBuffers.begin(), end=mBuffers.end(); it!=end; ++it) {
+			collect(**it);
+		}
+		for (auto it=mPhases.begin(), end=mPhases.end(); it!=end; ++it) {
+			it->endFrame();
+		}
+		++mFrame;
+		mFrameStart = Poco::Timestamp().epochMicroseconds();
+
+		if (mTraceFramesLeft > 0) {
+			mTraceFrames.push_back(mFrameStart);
+			if (--mTraceFramesLeft <= 0) {
+				ENABLED = mEnabledBeforeTrace;
+				write = true;
+			}
+		}
+	}
+	if (write) writeTrace();
+}
+
+void FrameProfiler::addSample(const char* name, const Poco::Timestamp::TimeVal start, const Poco::Timestamp::TimeVal end) {
+	if (!name) return;
+
+	try {
+		const Poco::Thread::TID		tid = Poco::Thread::currentTid();
+		Sample						s;
+		s.mPhase = NO_PHASE;
+		s.mStart = start;
+		s.mEnd = end;
+		// A name this thread hasn't used needs the profiler lock, which beginFrame()
+		// takes before the buffer locks, so look it up with the buffer unlocked.
+		if (record(tid, name, s)) return;
+		s.mPhase = getPhaseId(name);
+		record(tid, name, s);
+	} catch (std::exception const&) {
+	}
+}
+
+void FrameProfiler::requestTrace(const int frames, const std::string& folder) {
+	Poco::FastMutex::ScopedLock		l(mMutex);
+	if (mTraceFramesLeft > 0) {
+		DS_LOG_WARNING("FrameProfiler::requestTrace() trace already in progress");
+		return;
+	}
+	// Tracing needs the scopes to be live.
+	mEnabledBeforeTrace = ENABLED;
+	ENABLED = true;
+	mTraceFramesLeft = (frames > 0 ? frames : TRACE_FRAMES);
+	mTraceFolder = (folder.empty() ? TRACE_FOLDER : folder);
+	mTrace.clear();
+	mTrace.reserve(mTraceFramesLeft * 64);
+	mTraceFrames.clear();
+	mTraceFrames.push_back(Poco::Timestamp().epochMicroseconds());
+	DS_LOG_INFO("FrameProfiler tracing " << mTraceFramesLeft << " frames");
+}
+
+bool FrameProfiler::isTracing() const {
+	Poco::FastMutex::ScopedLock		l(mMutex);
+	return mTraceFramesLeft > 0;
+}
+
+void FrameProfiler::getStats(std::vector<Stats>& out) const {
+	out.clear();
+	Poco::FastMutex::ScopedLock		l(mMutex);
+	for (auto it=mPhases.begin(), end=mPhases.end(); it!=end; ++it) {
+		const Phase&			p(*it);
+		if (p.mCount < 1) continue;
+
+		Stats					s;
+		s.mName = p.mName;
+		s.mFrames = static_cast<int>(p.mCount);
+		s.mLastCalls = p.mLastCalls;
+		s.mLastMs = p.mHistory[(p.mNext + p.mHistory.size() - 1) % p.mHistory.size()];
+		s.mMinMs = s.mLastMs;
+		s.mMaxMs = s.mLastMs;
+		double					total = 0.0;
+		for (size_t k=0; k<p.mCount; ++k) {
+			const double		v = p.mHistory[k];
+			total += v;
+			if (v < s.mMinMs) s.mMinMs = v;
+			if (v > s.mMaxMs) s.mMaxMs = v;
+			int					bucket = 0;
+			while (bucket < HISTOGRAM_SIZE-1 && v > HISTOGRAM_BOUNDS[bucket]) ++bucket;
+			++s.mHistogram[bucket];
+		}
+		s.mAverageMs = total / static_cast<double>(p.mCount);
+		out.push_back(s);
+	}
+}
+
+int64_t FrameProfiler::getFrameCount() const {
+	Poco::FastMutex::ScopedLock		l(mMutex);
+	return mFrame;
+}
+
+FrameProfiler::Buffer& FrameProfiler::getThreadBuffer(const Poco::Thread::TID tid) {
+	if (THREAD_BUFFER) return *static_cast<Buffer*>(THREAD_BUFFER);
+
+	// First sample from this thread. Threads that have ended can't say so, but
+	// their buffers stop filling, so take over one of those before making one.
+	Buffer*							b = nullptr;
+	{
+		Poco::FastMutex::ScopedLock	l(mMutex);
+		for (auto it=mBuffers.begin(), end=mBuffers.end(); it!=end && !b; ++it) {
+			Poco::FastMutex::ScopedLock	bl((*it)->mMutex);
+			if ((*it)->mIdleFrames < BUFFER_IDLE_FRAMES) continue;
+			b = *it;
+			b->mTid = tid;
+			b->mIdleFrames = 0;
+			// The old owner's name pointers may not be valid anymore
+			b->mPhaseIds.clear();
+		}
+		if (!b) {
+			b = new Buffer();
+			mBuffers.push_back(b);
+		}
+	}
+	THREAD_BUFFER = b;
+	return *b;
+}
+
+bool FrameProfiler::record(const Poco::Thread::TID tid, const char* name, Sample& s) {
+	Buffer&							b = getThreadBuffer(tid);
+	Poco::FastMutex::ScopedLock		l(b.mMutex);
+	// Went quiet long enough for another thread to take it
+	if (b.mTid != tid) {
+		THREAD_BUFFER = nullptr;
+		return false;
+	}
+	if (s.mPhase == NO_PHASE) {
+		auto						found = b.mPhaseIds.find(name);
+		if (found == b.mPhaseIds.end()) return false;
+		s.mPhase = found->second;
+	} else {
+		b.mPhaseIds[name] = s.mPhase;
+	}
+	b.mSamples.push_back(s);
+	return true;
+}
+
+size_t FrameProfiler::getPhaseId(const char* name) {
+	Poco::FastMutex::ScopedLock		l(mMutex);
+	const std::string				key(name);
+	auto							found = mPhaseIndex.find(key);
+	if (found != mPhaseIndex.end()) return found->second;
+
+	const size_t					id = mPhases.size();
+	mPhases.push_back(Phase(key, HISTORY_SIZE));
+	mPhaseIndex[key] = id;
+	return id;
+}
+
+void FrameProfiler::collect(Buffer& b) {
+	Poco::Thread::TID				tid;
+	{
+		// Swap, so the owning thread is held up as briefly as possible
+		Poco::FastMutex::ScopedLock	l(b.mMutex);
+		if (b.mSamples.empty()) {
+			if (b.mIdleFrames < BUFFER_IDLE_FRAMES) ++b.mIdleFrames;
+		} else {
+			b.mIdleFrames = 0;
+		}
+		mCollected.swap(b.mSamples);
+		tid = b.mTid;
+	}
+	for (auto it=mCollected.begin(), end=mCollected.end(); it!=end; ++it) {
+		if (it->mPhase >= mPhases.size()) continue;
+		Phase&						p(mPhases[it->mPhase]);
+		p.mCurrentMs += static_cast<double>(it->mEnd - it->mStart) * MICROS_TO_MS;
+		++p.mCurrentCalls;
+
+		if (mTraceFramesLeft > 0) {
+			mTrace.push_back(TraceEvent(it->mPhase, tid, it->mStart, it->mEnd - it->mStart));
+		}
+	}
+	mCollected.clear();
+}
+
+void FrameProfiler::writeTrace() {
+	// Swap the trace out so the file writing happens unlocked.
+	std::vector<TraceEvent>					events;
+	std::vector<Poco::Timestamp::TimeVal>	frames;
+	std::vector<std::string>				names;
+	std::string								folder;
+	{
+		Poco::FastMutex::ScopedLock		l(mMutex);
+		events.swap(mTrace);
+		frames.swap(mTraceFrames);
+		folder = mTraceFolder;
+		for (auto it=mPhases.begin(), end=mPhases.end(); it!=end; ++it) names.push_back(it->mName);
+	}
+	if (events.empty()) return;
+
+	try {
+		Poco::Path				path(ds::Environment::expand(folder));
+		path.makeDirectory();
+		Poco::File(path).createDirectories();
+		std::stringstream		fn;
+		fn << "ds_trace." << Poco::Timestamp().epochMicroseconds() << ".json";
+		path.setFileName(fn.str());
+
+		std::ofstream			out(path.toString().c_str(), std::ios_base::out | std::ios_base::trunc);
+		if (!out.is_open()) {
+			DS_LOG_WARNING("FrameProfiler::writeTrace() can't open " << path.toString());
+			return;
+		}
+		// Timestamps are relative to the start of the trace, which keeps the viewer sane.
+		const Poco::Timestamp::TimeVal	origin = (frames.empty() ? events.front().mStart : frames.front());
+		const Poco::Thread::TID			main_tid = Poco::Thread::currentTid();
+		out << "{\"traceEvents\":[" << std::endl;
+		bool					first = true;
+		for (size_t k=0; k<frames.size(); ++k) {
+			if (!first) out << "," << std::endl;
+			first = false;
+			out << "{\"name\":\"frame\",\"cat\":\"ds\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":" << main_tid
+				<< ",\"ts\":" << (frames[k] - origin) << "}";
+		}
+		for (auto it=events.begin(), end=events.end(); it!=end; ++it) {
+			if (!first) out << "," << std::endl;
+			first = false;
+			out << "{\"name\":";
+			write_json_string(out, (it->mPhase < names.size() ? names[it->mPhase] : std::string()));
+			out << ",\"cat\":\"ds\",\"ph\":\"X\",\"pid\":1,\"tid\":" << it->mTid
+				<< ",\"ts\":" << (it->mStart - origin) << ",\"dur\":" << it->mDuration << "}";
+		}
+		out << std::endl << "]}" << std::endl;
+		out.close();
+		DS_LOG_INFO("FrameProfiler wrote trace " << path.toString());
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING("FrameProfiler::writeTrace() error " << ex.what());
+	}
+}
+
+/**
+ * \class ds::FrameProfiler::Stats
+ */
+FrameProfiler::Stats::Stats()
+		: mFrames(0)
+		, mLastMs(0.0)
+		, mAverageMs(0.0)
+		, mMinMs(0.0)
+		, mMaxMs(0.0)
+		, mLastCalls(0) {
+	for (int k=0; k<HISTOGRAM_SIZE; ++k) mHistogram[k] = 0;
+}
+
+/**
+ * \class ds::FrameProfiler::Scope
+ */
+FrameProfiler::Scope::Scope(const char* name)
+		: mName(ENABLED ? name : nullptr)
+		, mStart(0) {
+	if (mName) mStart = Poco::Timestamp().epochMicroseconds();
+}
+
+FrameProfiler::Scope::~Scope() {
+	if (!mName) return;
+	getFrameProfiler().addSample(mName, mStart, Poco::Timestamp().epochMicroseconds());
+}
+
+/**
+ * \class ds::FrameProfiler::Buffer
+ */
+FrameProfiler::Buffer::Buffer()
+		: mTid(Poco::Thread::currentTid())
+		, mIdleFrames(0) {
+	mSamples.reserve(64);
+}
+
+/**
+ * \class ds::FrameProfiler::Phase
+ */
+FrameProfiler::Phase::Phase(const std::string& name, const size_t history)
+		: mName(name)
+		, mCurrentMs(0.0)
+		, mCurrentCalls(0)
+		, mLastCalls(0)
+		, mHistory(history, 0.0)
+		, mNext(0)
+		, mCount(0) {
+}
+
+void FrameProfiler::Phase::endFrame() {
+	mHistory[mNext] = mCurrentMs;
+	mNext = (mNext + 1) % mHistory.size();
+	if (mCount < mHistory.size()) ++mCount;
+	mLastCalls = mCurrentCalls;
+	mCurrentMs = 0.0;
+	mCurrentCalls = 0;
+}
+
+/**
+ * \class ds::FrameProfiler::TraceEvent
+ */
+FrameProfiler::TraceEvent::TraceEvent(	const size_t phase, const Poco::Thread::TID tid,
+										const Poco::Timestamp::TimeVal start, const Poco::Timestamp::TimeVal dur)
+		: mPhase(phase)
+		, mTid(tid)
+		, mStart(start)
+		, mDuration(dur) {
+}
+
+/* DS::FRAME-PROFILER singleton
+ ******************************************************************/
+namespace {
+// Built before main(), so no thread ever races its construction
+FrameProfiler				PROFILER;
+}
+
+FrameProfiler& getFrameProfiler() {
+	return PROFILER;
+}
+
+} // namespace ds
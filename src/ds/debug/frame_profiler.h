@@ -0,0 +1,192 @@
+#pragma once
+#ifndef DS_DEBUG_FRAMEPROFILER_H_
+#define DS_DEBUG_FRAMEPROFILER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <Poco/Mutex.h>
+#include <Poco/Thread.h>
+#include <Poco/Timestamp.h>
+
+namespace ds {
+
+namespace cfg {
+class Settings;
+} // namespace cfg
+
+/**
+ * \class ds::FrameProfiler
+ * \brief Lightweight per-frame phase timing. Code marks a phase with
+ * the DS_PROFILE_SCOPE() macro; every sample for a phase is summed into
+ * a per-frame total, and the last N frame totals are kept so you can get
+ * min/avg/max and a histogram. On request, the next N frames are also
+ * written out as a Chrome trace_event JSON file (open in chrome://tracing).
+ * Each thread records its samples into its own buffer, which beginFrame()
+ * collects, so timing a scope never contends with other threads. A buffer
+ * that has sat empty for a while is handed to the next new thread, since
+ * threads can't say when they end.
+ * Settings are read from debug.xml:
+ *	"profiler:enabled" bool -- DEFAULT=false
+ *	"profiler:history" int -- number of frames kept per phase. DEFAULT=120
+ *	"profiler:trace_frames" int -- frames captured per trace request. DEFAULT=60
+ *	"profiler:trace_file" text -- trace output folder. DEFAULT=%LOCAL%/traces/
+ */
+class FrameProfiler {
+public:
+	static void					setup(const ds::cfg::Settings&);
+	static bool					isEnabled();
+	static void					setEnabled(const bool);
+
+	// Histogram bucket upper bounds, in milliseconds. The final bucket catches everything else.
+	static const int			HISTOGRAM_SIZE = 8;
+	static const double			HISTOGRAM_BOUNDS[HISTOGRAM_SIZE-1];
+
+	class Stats {
+	public:
+		Stats();
+		std::string				mName;
+		int						mFrames;
+		double					mLastMs,
+								mAverageMs,
+								mMinMs,
+								mMaxMs;
+		// Calls in the last complete frame
+		int						mLastCalls;
+		int						mHistogram[HISTOGRAM_SIZE];
+	};
+
+public:
+	FrameProfiler();
+
+	// Called once per frame from the main thread. Closes out the previous frame.
+	void						beginFrame();
+	// Record a finished sample. Phases are keyed by the name's text, so the same
+	// name from anywhere is one phase. The name must outlive the calling thread.
+	void						addSample(const char* name, const Poco::Timestamp::TimeVal start, const Poco::Timestamp::TimeVal end);
+
+	// Capture the next frames into a trace file. An empty folder uses the settings.
+	// Profiling is turned on for the trace, and back to how it was after.
+	void						requestTrace(const int frames = 0, const std::string& folder = "");
+	bool						isTracing() const;
+
+	// Answer the stats for all phases, in order of first appearance.
+	void						getStats(std::vector<Stats>&) const;
+	int64_t						getFrameCount() const;
+
+	/**
+	 * \class ds::FrameProfiler::Scope
+	 * \brief Time from construction to destruction. Use via DS_PROFILE_SCOPE().
+	 */
+	class Scope {
+	public:
+		Scope(const char* name);
+		~Scope();
+
+	private:
+		Scope(const Scope&);
+		Scope&					operator=(const Scope&);
+
+		const char*				mName;
+		Poco::Timestamp::TimeVal
+								mStart;
+	};
+
+private:
+	class Phase {
+	public:
+		Phase(const std::string& name, const size_t history);
+		void					endFrame();
+
+		std::string				mName;
+		double					mCurrentMs;
+		int						mCurrentCalls;
+		int						mLastCalls;
+		// Ring of per-frame totals
+		std::vector<double>		mHistory;
+		size_t					mNext,
+								mCount;
+	};
+
+	class TraceEvent {
+	public:
+		TraceEvent(const size_t phase, const Poco::Thread::TID, const Poco::Timestamp::TimeVal start, const Poco::Timestamp::TimeVal dur);
+		size_t					mPhase;
+		Poco::Thread::TID		mTid;
+		Poco::Timestamp::TimeVal
+								mStart,
+								mDuration;
+	};
+
+	class Sample {
+	public:
+		size_t					mPhase;
+		Poco::Timestamp::TimeVal
+								mStart,
+								mEnd;
+	};
+
+	// One per thread that records samples. Only its owner adds to it, so its
+	// lock is only ever contended by beginFrame() collecting, or by a new
+	// thread taking it over once it's gone quiet.
+	class Buffer {
+	public:
+		Buffer();
+
+		Poco::FastMutex			mMutex;
+		Poco::Thread::TID		mTid;
+		std::vector<Sample>		mSamples;
+		// Names this thread has used, so only a new name touches the profiler lock
+		std::unordered_map<const char*, size_t>
+								mPhaseIds;
+		// Frames collected in a row with no samples
+		int						mIdleFrames;
+	};
+
+	// Answer the calling thread's buffer, taking over a quiet one or making one
+	// if it has none. Only mark it as the owner's under its lock.
+	Buffer&						getThreadBuffer(const Poco::Thread::TID);
+	// Add the sample to the thread's buffer. Answer false if its phase isn't
+	// known yet, or the buffer was given to another thread.
+	bool						record(const Poco::Thread::TID, const char* name, Sample&);
+	// Answer the phase for the name, adding it if needed. Takes mMutex, so
+	// never call it holding a buffer's lock.
+	size_t						getPhaseId(const char* name);
+	// mMutex must be held
+	void						collect(Buffer&);
+	void						writeTrace();
+
+	mutable Poco::FastMutex		mMutex;
+	std::vector<Phase>			mPhases;
+	std::unordered_map<std::string, size_t>
+								mPhaseIndex;
+	// Kept for the life of the app, since a thread can't tell me it's ended;
+	// a quiet one is reused instead
+	std::vector<Buffer*>		mBuffers;
+	std::vector<Sample>			mCollected;
+	int64_t						mFrame;
+	Poco::Timestamp::TimeVal	mFrameStart;
+
+	// Tracing
+	int							mTraceFramesLeft;
+	// What ENABLED was before the trace turned it on
+	bool						mEnabledBeforeTrace;
+	std::string					mTraceFolder;
+	std::vector<TraceEvent>		mTrace;
+	std::vector<Poco::Timestamp::TimeVal>
+								mTraceFrames;
+};
+
+// Singleton access
+FrameProfiler&					getFrameProfiler();
+
+} // namespace ds
+
+// example: DS_PROFILE_SCOPE("Engine::updateServer");
+#define DS_PROFILE_CONCAT_IMPL(a, b)	a##b
+#define DS_PROFILE_CONCAT(a, b)			DS_PROFILE_CONCAT_IMPL(a, b)
+#define DS_PROFILE_SCOPE(name)			ds::FrameProfiler::Scope DS_PROFILE_CONCAT(ds_profile_scope_, __LINE__)(name)
+
+#endif // DS_DEBUG_FRAMEPROFILER_H_
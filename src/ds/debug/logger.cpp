@@ -1,5 +1,7 @@
 #include "ds/debug/logger.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <Poco/DateTimeFormatter.h>
@@ -7,6 +9,7 @@
 #include <Poco/Path.h>
 #include <Poco/Semaphore.h>
 #include <Poco/String.h>
+#include <Poco/Timezone.h>
 #include "ds/app/environment.h"
 #include "ds/cfg/settings.h"
 #include "ds/util/string_util.h"
@@ -22,21 +25,35 @@ const ds::BitMask	ds::VIDEO_LOG = ds::Logger::newModule("video");
 namespace {
 const std::string	EMPTY_SZ("");
 
-// Special error codes for levels so we can communicate to the thread
-const int			LOG_LEVEL_ERROR_CODE = -1;
-const int			LOG_LEVEL_BLOCK_CODE = LOG_LEVEL_ERROR_CODE-1;
-
 const int			LEVEL_SIZE = 5;
 // Only assign during setup()
 bool				HAS_LEVEL[LEVEL_SIZE];
 ds::BitMask			HAS_MODULE = ds::BitMask::newFilled();
 bool				HAS_ASYNC = true;
 std::string			LOG_FILE;
+size_t				RING_SIZE = 512;
 
+// How long the consumer sleeps when nothing wakes it, and how often blockUntilReady() checks in
+const long			WAKE_POLL_MS = 100;
+// How long a slot goes unused before it's given back, in microseconds
+const int64_t		SLOT_IDLE_US = 5 * 1000 * 1000;
+const long			BLOCK_POLL_MS = 10;
 Poco::Semaphore		BLOCK_SEM(0, 1);
 
+std::atomic<int64_t>	STAT_LOGGED(0);
+std::atomic<int64_t>	STAT_DROPPED(0);
+std::atomic<int64_t>	STAT_WRITTEN(0);
+std::atomic<int64_t>	STAT_BATCHES(0);
+
 // Maintain the modules associated with names so I can let the user know what's available
 std::map<int, std::string>*  MODULE_MAP = nullptr;
+
+// Wake anyone in blockUntilReady(). Only the logger thread signals, so taking
+// any leftover signal first keeps the count from going past its maximum.
+void				signal_block() {
+	BLOCK_SEM.tryWait(0);
+	BLOCK_SEM.set();
+}
 }
 
 /* DS::LOGGER static
@@ -105,6 +122,9 @@ void ds::Logger::setup(const ds::cfg::Settings& settings)
 	Poco::toLowerInPlace(async);
 	if (async == "false") HAS_ASYNC = false;
 
+	// Only applies to threads that haven't logged yet
+	RING_SIZE = static_cast<size_t>(std::max(16, settings.getInt("logger:ring_size", 0, static_cast<int>(RING_SIZE))));
+
 	// If I wasn't supplied a filename, try and find a logs folder
 	if (file.empty()) {
 	file = ds::Environment::getAppFolder("logs");
@@ -172,6 +192,16 @@ void Logger::toggleModule(const ds::BitMask& module, const bool on)
 
 /* DS::LOGGER
  ******************************************************************/
+Logger::Stats Logger::getStats()
+{
+	Stats			s;
+	s.mLogged = STAT_LOGGED.load();
+	s.mDropped = STAT_DROPPED.load();
+	s.mWritten = STAT_WRITTEN.load();
+	s.mBatches = STAT_BATCHES.load();
+	return s;
+}
+
 Logger::Logger()
 {
 	if (HAS_ASYNC) {
@@ -200,21 +230,24 @@ void ds::Logger::log( const int level, const std::wstring& str)
 void Logger::blockUntilReady()
 {
 	// Only matters if I'm running async
-	if (!HAS_ASYNC) return;
+	if (!HAS_ASYNC || !mThread.isRunning()) {
+		mLoop.drainNow();
+		return;
+	}
 
-	mLoop.log(LOG_LEVEL_BLOCK_CODE, "");
-	BLOCK_SEM.wait();
+	const int64_t				request = ++mLoop.mFlushRequest;
+	mLoop.mWake.set();
+	while (mLoop.mFlushDone.load() < request) {
+		BLOCK_SEM.tryWait(BLOCK_POLL_MS);
+	}
 }
 
 void Logger::shutDown()
 {
 	if (!mThread.isRunning()) return;
 
-	{
-		Poco::Mutex::ScopedLock		l(mLoop.mMutex);
-		mLoop.mAbort = true;
-		mLoop.mCondition.signal();
-	}
+	mLoop.mAbort = true;
+	mLoop.mWake.set();
 
 	try {
 		mThread.join();
@@ -222,134 +255,447 @@ void Logger::shutDown()
 	}
 }
 
-/* DS::LOGGER::LOOP
+/* DS::LOGGER::STATS
  ******************************************************************/
-Logger::Loop::Loop()
-	: mAbort(false)
+Logger::Stats::Stats()
+	: mLogged(0)
+	, mDropped(0)
+	, mWritten(0)
+	, mBatches(0)
 {
-	mInput.reserve(128);
 }
 
-void Logger::Loop::log(const int level, const std::string& str)
-{
-	Poco::Mutex::ScopedLock		l(mMutex);
-	try {
-		mInput.push_back(entry());
-		entry&					e = mInput.back();
-		e.mMsg = str;
-		e.mLevel = level;
-		e.mTime = Poco::LocalDateTime().timestamp().epochMicroseconds();
-	} catch(std::exception&) {
-		return;
+/* DS::LOGGER::LINESTREAM
+ ******************************************************************/
+// Writes to a fixed buffer, and only moves to a string past the end of it.
+// One lives with each slot and is reset for every message.
+class Logger::LineStream : private std::streambuf, public std::ostream {
+public:
+	LineStream()
+		: std::ostream(static_cast<std::streambuf*>(this))
+		, mSpilled(false)
+	{
+		reset();
 	}
-	if (HAS_ASYNC) {
-		mCondition.signal();
+
+	void				reset()
+	{
+		setp(mFixed, mFixed + Line::FIXED_SIZE);
+		mSpill.clear();
+		mSpilled = false;
+		// Formatting state would otherwise carry over from the last message
+		clear();
+		flags(std::ios_base::dec | std::ios_base::skipws);
+		precision(6);
+		width(0);
+		fill(' ');
+	}
+
+	const char*			data() const	{ return mSpilled ? mSpill.data() : mFixed; }
+	size_t				size() const	{ return mSpilled ? mSpill.size() : static_cast<size_t>(pptr() - pbase()); }
+
+protected:
+	typedef std::streambuf::traits_type	traits;
+
+	virtual std::streambuf::int_type	overflow(std::streambuf::int_type c)
+	{
+		spill();
+		if (!traits::eq_int_type(c, traits::eof())) mSpill.push_back(traits::to_char_type(c));
+		return traits::not_eof(c);
+	}
+
+	virtual std::streamsize	xsputn(const char* s, std::streamsize n)
+	{
+		if (!mSpilled && n <= epptr() - pptr()) {
+			memcpy(pptr(), s, static_cast<size_t>(n));
+			pbump(static_cast<int>(n));
+			return n;
+		}
+		spill();
+		mSpill.append(s, static_cast<size_t>(n));
+		return n;
+	}
+
+private:
+	void				spill()
+	{
+		if (mSpilled) return;
+		mSpill.assign(pbase(), pptr());
+		mSpilled = true;
+		// Everything from here goes through overflow() and xsputn()
+		setp(mFixed, mFixed);
+	}
+
+	char				mFixed[Line::FIXED_SIZE];
+	std::string			mSpill;
+	bool				mSpilled;
+};
+
+/* DS::LOGGER::LINE
+ ******************************************************************/
+Logger::Line::Line(const int level)
+	: mLevel(level)
+	, mSlot(getLogger().mLoop.acquire())
+	, mFallback(nullptr)
+{
+	if (mSlot >= 0) getLogger().mLoop.getStream(mSlot).reset();
+	else mFallback = new std::ostringstream();
+}
+
+Logger::Line::~Line()
+{
+	Loop&						loop = getLogger().mLoop;
+	if (mSlot >= 0) {
+		const LineStream&		s = loop.getStream(mSlot);
+		loop.release(mSlot, mLevel, s.data(), s.size());
 	} else {
-		consume(mInput);
+		const std::string		str = mFallback->str();
+		loop.logShared(mLevel, str.data(), str.size());
+		delete mFallback;
 	}
 }
 
-void ds::Logger::Loop::log( const int level, const std::wstring& str)
+std::ostream& Logger::Line::stream()
 {
-	log(level, ds::utf8_from_wstr(str));
+	if (mFallback) return *mFallback;
+	return getLogger().mLoop.getStream(mSlot);
 }
 
-void Logger::Loop::run()
+/* DS::LOGGER::RING
+ ******************************************************************/
+Logger::Ring::Ring(const size_t size)
+	: mEntries(size)
+	, mHead(0)
+	, mTail(0)
 {
-	vector<entry>				ins;
-	ins.reserve(128);
+}
 
-	while (true) {
-		// Pop the inputs
-		{
-			Poco::Mutex::ScopedLock		l(mMutex);
-			mInput.swap(ins);
-		}
+bool Logger::Ring::push(const int level, const Poco::Timestamp::TimeVal time, const char* msg, const size_t length)
+{
+	const size_t				count = (length < 1 ? 1 : (length + entry::MSG_SIZE - 1) / entry::MSG_SIZE);
+	const size_t				head = mHead.load(std::memory_order_relaxed);
+	const size_t				tail = mTail.load(std::memory_order_acquire);
+	if (mEntries.size() - (head - tail) < count) return false;
+
+	size_t						offset = 0;
+	for (size_t k=0; k<count; ++k) {
+		entry&					e = mEntries[(head + k) % mEntries.size()];
+		const size_t			len = std::min(length - offset, static_cast<size_t>(entry::MSG_SIZE));
+		e.mTime = time;
+		e.mLevel = level;
+		e.mLength = static_cast<int>(len);
+		e.mContinued = (k + 1 < count);
+		if (len > 0) memcpy(e.mMsg, msg + offset, len);
+		offset += len;
+	}
+	mHead.store(head + count, std::memory_order_release);
+	return true;
+}
 
-		// Perform each input
-		consume(ins);
+const Logger::entry* Logger::Ring::front() const
+{
+	const size_t				tail = mTail.load(std::memory_order_relaxed);
+	if (tail == mHead.load(std::memory_order_acquire)) return nullptr;
+	return &mEntries[tail % mEntries.size()];
+}
 
-		{
-			Poco::Mutex::ScopedLock		l(mMutex);
-			if (mAbort) break;
-		}
+void Logger::Ring::pop()
+{
+	mTail.store(mTail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+bool Logger::Ring::empty() const
+{
+	return front() == nullptr;
+}
+
+/* DS::LOGGER::LOOP
+ ******************************************************************/
+Logger::Loop::Loop()
+	: mWake(true)
+	, mPending(false)
+	, mAbort(false)
+	, mFlushRequest(0)
+	, mFlushDone(0)
+	, mShared(nullptr)
+	, mFatal(false)
+	, mReportedDrops(0)
+{
+	for (int k=0; k<MAX_THREADS; ++k) {
+		mSlots[k].mOwner = 0;
+		mSlots[k].mBusy = false;
+		mSlots[k].mLastUsed = 0;
+		mSlots[k].mRing = nullptr;
+		mSlots[k].mStream = nullptr;
+	}
+	mMsg.reserve(entry::MSG_SIZE * 4);
+	mBatch.reserve(64 * 1024);
+}
 
-		// If more input came in during the time I've been
-		// processing keep going, otherwise wait.
-		mMutex.lock();
-		if (!mAbort && mInput.size() < 1) mCondition.wait(mMutex);
-		if (mAbort) break;
-		mMutex.unlock();
+Logger::Loop::~Loop()
+{
+	for (int k=0; k<MAX_THREADS; ++k) {
+		delete mSlots[k].mRing.load();
+		mSlots[k].mRing = nullptr;
+		delete mSlots[k].mStream;
+		mSlots[k].mStream = nullptr;
 	}
+	delete mShared;
 }
 
-void Logger::Loop::consume(vector<entry>& ins)
+void Logger::Loop::log(const int level, const std::string& str)
+{
+	const int					slot = acquire();
+	if (slot >= 0) release(slot, level, str.data(), str.size());
+	else logShared(level, str.data(), str.size());
+}
+
+int Logger::Loop::acquire()
+{
+	const size_t				owner = (size_t)Poco::Thread::currentTid();
+	for (int k=0; k<MAX_THREADS; ++k) {
+		Slot&					s = mSlots[k];
+		if (s.mOwner.load() != owner) continue;
+		// Busy means I'm logging from inside a DS_LOG expression, or the
+		// consumer is looking at the slot; either way use the shared ring.
+		if (s.mBusy.exchange(true)) return -1;
+		if (s.mOwner.load() == owner) return k;
+		// Given back between the check and taking it
+		s.mBusy = false;
+		break;
+	}
+	// No slot yet -- claim a free one. Making its ring and stream is the one
+	// allocation per slot; a slot that's been given back keeps them.
+	for (int k=0; k<MAX_THREADS; ++k) {
+		Slot&					s = mSlots[k];
+		size_t					expected = 0;
+		if (!s.mOwner.compare_exchange_strong(expected, owner)) continue;
+		// The consumer may still be letting go of it
+		while (s.mBusy.exchange(true)) Poco::Thread::yield();
+		try {
+			if (!s.mStream) s.mStream = new LineStream();
+			if (!s.mRing.load()) s.mRing = new Ring(RING_SIZE);
+		} catch (std::exception const&) {
+		}
+		if (s.mStream && s.mRing.load()) return k;
+		s.mOwner = 0;
+		s.mBusy = false;
+		return -1;
+	}
+	return -1;
+}
+
+Logger::LineStream& Logger::Loop::getStream(const int slot)
+{
+	return *mSlots[slot].mStream;
+}
+
+void Logger::Loop::release(const int slot, const int level, const char* msg, const size_t length)
+{
+	Slot&						s = mSlots[slot];
+	const Poco::Timestamp::TimeVal	time = Poco::Timestamp().epochMicroseconds();
+	const bool					ok = push(*s.mRing.load(), level, time, msg, length);
+	s.mLastUsed = time;
+	s.mBusy = false;
+	pushed(ok);
+}
+
+void Logger::Loop::logShared(const int level, const char* msg, const size_t length)
+{
+	const Poco::Timestamp::TimeVal	time = Poco::Timestamp().epochMicroseconds();
+	bool						ok = false;
+	{
+		Poco::FastMutex::ScopedLock	l(mSharedMutex);
+		if (!mShared) {
+			try {
+				mShared = new Ring(RING_SIZE);
+			} catch (std::exception const&) {
+			}
+		}
+		if (mShared) ok = push(*mShared, level, time, msg, length);
+	}
+	pushed(ok);
+}
+
+bool Logger::Loop::push(Ring& ring, const int level, const Poco::Timestamp::TimeVal time, const char* msg, const size_t length)
+{
+	bool						ok = ring.push(level, time, msg, length);
+	// Fatal errors are never dropped -- wait for the consumer to make room.
+	while (!ok && level == ds::Logger::LOG_FATAL && HAS_ASYNC && !mAbort) {
+		mWake.set();
+		Poco::Thread::yield();
+		ok = ring.push(level, time, msg, length);
+	}
+	return ok;
+}
+
+void Logger::Loop::pushed(const bool ok)
+{
+	if (!ok) {
+		++STAT_DROPPED;
+		if (!HAS_ASYNC) drainNow();
+		return;
+	}
+	++STAT_LOGGED;
+
+	if (HAS_ASYNC) {
+		if (!mPending.exchange(true)) mWake.set();
+	} else {
+		drainNow();
+	}
+}
+
+void Logger::Loop::drainNow()
 {
-	for (int k=0; k<ins.size(); k++) {
-		const entry&			e = ins[k];
-		if (e.mLevel == LOG_LEVEL_BLOCK_CODE) BLOCK_SEM.set();
-		if (e.mMsg.empty()) continue;
-
-		mBuf.str("");
-		// time stamp
-		static const std::string	DATE_FORMAT("%Y/%m/%d %H:%M:%s");
-		mBuf << Poco::DateTimeFormatter::format(Poco::Timestamp(e.mTime), DATE_FORMAT);
-		mBuf << " ";
-		// level
-		mBuf << level_name(e.mLevel);
-		mBuf << " ";
-		// message
-		mBuf << e.mMsg;
-		mBuf << endl;
-
-		logToConsole(e, mBuf.str());
-		logToFile(e, mBuf.str());
-
-		if (e.mLevel == ds::Logger::LOG_FATAL) {
-			std::string		msg = mBuf.str();
-			Poco::Thread::sleep(4*1000);
-			std::terminate();
+	drain();
+}
+
+void Logger::Loop::run()
+{
+	while (true) {
+		mWake.tryWait(WAKE_POLL_MS);
+		mPending = false;
+
+		const int64_t				request = mFlushRequest.load();
+		drain();
+		if (request > mFlushDone.load()) {
+			mFlushDone = request;
+			signal_block();
+		}
+
+		if (mAbort) {
+			// Pick up anything that came in while aborting.
+			drain();
+			mFlushDone = mFlushRequest.load();
+			signal_block();
+			break;
 		}
 	}
-	ins.clear();
 }
 
-void Logger::Loop::logToConsole(const entry& e, const std::string& formattedMsg)
+void Logger::Loop::releaseIdle()
+{
+	const int64_t				now = Poco::Timestamp().epochMicroseconds();
+	for (int k=0; k<MAX_THREADS; ++k) {
+		Slot&					s = mSlots[k];
+		if (s.mOwner.load() == 0 || now - s.mLastUsed.load() < SLOT_IDLE_US) continue;
+		if (s.mBusy.exchange(true)) continue;
+		// Anything still in the ring gets drained first, on a later pass
+		Ring*					ring = s.mRing.load();
+		if (now - s.mLastUsed.load() >= SLOT_IDLE_US && (!ring || ring->empty())) s.mOwner = 0;
+		s.mBusy = false;
+	}
+}
+
+void Logger::Loop::drainRing(Ring& ring, int64_t& written)
 {
-	cout << formattedMsg;
+	const entry*				e;
+	mMsg.clear();
+	while ((e = ring.front()) != nullptr) {
+		const int				level = e->mLevel;
+		const Poco::Timestamp::TimeVal	time = e->mTime;
+		const bool				continued = e->mContinued;
+		mMsg.append(e->mMsg, e->mLength);
+		ring.pop();
+		if (continued) continue;
+
+		write(level, time, mMsg);
+		mMsg.clear();
+		++written;
+	}
 }
 
-void Logger::Loop::logToFile(const entry& e, const std::string& formattedMsg)
+void Logger::Loop::drain()
 {
-	if (LOG_FILE.empty()) return;
+	Poco::Mutex::ScopedLock		l(mDrainMutex);
+	mBatch.clear();
+	int64_t						written = 0;
+	for (int k=0; k<MAX_THREADS; ++k) {
+		Ring*					ring = mSlots[k].mRing.load();
+		if (ring) drainRing(*ring, written);
+	}
+	releaseIdle();
+	{
+		// Only the pointer needs the lock; the ring is still single consumer.
+		Ring*					shared = nullptr;
+		{
+			Poco::FastMutex::ScopedLock	sl(mSharedMutex);
+			shared = mShared;
+		}
+		if (shared) drainRing(*shared, written);
+	}
+
+	// Let the user know if things are getting lost
+	const int64_t				dropped = STAT_DROPPED.load();
+	if (dropped > mReportedDrops) {
+		std::stringstream		buf;
+		buf << "Logger dropped " << (dropped - mReportedDrops) << " message(s), ring full";
+		write(ds::Logger::LOG_WARNING, Poco::Timestamp().epochMicroseconds(), buf.str());
+		mReportedDrops = dropped;
+	}
+
+	if (!mBatch.empty()) {
+		flush();
+		STAT_WRITTEN += written;
+		++STAT_BATCHES;
+	}
 
-	ofstream outFile;
-	outFile.open(LOG_FILE.c_str(), ios_base::app);
-	outFile << formattedMsg;
-	outFile.close();
+	if (mFatal) {
+		Poco::Thread::sleep(4*1000);
+		std::terminate();
+	}
 }
 
-void ds::Logger::Loop::logToConsole( const entry& e, const std::wstring& formattedMsg )
+void Logger::Loop::write(const int level, const Poco::Timestamp::TimeVal time, const std::string& msg)
 {
-	logToConsole(e, ds::utf8_from_wstr(formattedMsg));
+	if (msg.empty()) return;
+
+	// time stamp, stamped in UTC by the caller and made local here
+	static const std::string	DATE_FORMAT("%Y/%m/%d %H:%M:%s");
+	const Poco::Timestamp::TimeVal	local = time + Poco::Timestamp::TimeVal(Poco::Timezone::tzd()) * Poco::Timestamp::resolution();
+	Poco::DateTimeFormatter::append(mBatch, Poco::Timestamp(local), DATE_FORMAT);
+	mBatch.append(" ");
+	// level
+	mBatch.append(level_name(level));
+	mBatch.append(" ");
+	// message
+	mBatch.append(msg);
+	mBatch.append("\n");
+
+	if (level == ds::Logger::LOG_FATAL) mFatal = true;
 }
 
-void ds::Logger::Loop::logToFile( const entry& e, const std::wstring& formattedMsg )
+void Logger::Loop::flush()
 {
-	logToFile(e, ds::utf8_from_wstr(formattedMsg));
+	cout << mBatch;
+	cout.flush();
+
+	if (LOG_FILE.empty()) return;
+	if (!mFile.is_open()) {
+		mFile.open(LOG_FILE.c_str(), ios_base::app);
+		if (!mFile.is_open()) return;
+	}
+	mFile << mBatch;
+	mFile.flush();
 }
 
 /* DS::LOGGER singleton
  ******************************************************************/
 namespace {
 Poco::Mutex					LOGGER_MUTEX;
+std::atomic<Logger*>		LOGGER_INSTANCE;
 }
 
 extern Logger&				ds::getLogger()
 {
+	// Every DS_LOG comes through here, so only the first call locks.
+	Logger*					ans = LOGGER_INSTANCE.load();
+	if (ans) return *ans;
+
 	// The logger is in a multithreaded environment, so
 	// control access to the static construction.
 	Poco::Mutex::ScopedLock	l(LOGGER_MUTEX);
 	static Logger			LOGGER;
+	LOGGER_INSTANCE = &LOGGER;
 	return LOGGER;
 }
@@ -5,10 +5,13 @@
 // Unfortunately due to some weird include issue I need to make sure to
 // include cinder/ChanTraits.h before something in presumably the C++ libs.
 #include <cinder/Color.h>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
 #include <sstream>
 #include <string>
 #include <vector>
-#include <Poco/Condition.h>
+#include <Poco/Event.h>
 #include <Poco/Mutex.h>
 #include <Poco/Thread.h>
 #include <Poco/Timestamp.h>
@@ -34,6 +37,18 @@ extern const ds::BitMask	VIDEO_LOG;
  * The logger is initially configured from a settings file, and then at
  * runtime, modules can be turned on and off.  All logging ideally happens
  * through the DS_LOG_* convenience macros.
+ * Logging is safe from any thread. Each thread that logs takes a slot with
+ * its own ring of fixed-size records, and a single background thread drains
+ * all of them and writes in batches. The DS_LOG macros format into a stream
+ * kept with the slot, so once a thread has logged, a message under
+ * Line::FIXED_SIZE bytes costs no lock and no allocation. The timestamp is
+ * the system clock, made local time on the background thread.
+ * What does allocate or lock: a thread's first message (it makes the slot),
+ * longer messages, DS_LOGW and the std::string overloads of log(), logging
+ * from inside a DS_LOG expression, and threads that find every slot taken,
+ * which share one locked ring. Slots that go unused for a few seconds are
+ * given back, ring and stream kept, so threads that come and go reuse them.
+ * If a ring is full the message is dropped and counted (fatal messages wait).
  */
 class Logger {
 public:
@@ -43,6 +58,7 @@ public:
 	 *  "logger:module" string -- all,none, or numbers (i.e. "0,1,2,3").  applications map the numbers to specific modules DEFAULT=all
 	 *  "logger:file" string -- filename (and location).  a date stamp is appended.  DEFAULT=../logs/
 	 *  "logger:async" text -- (true,false) If this is false, then logging is synchronous.  DEFAULT=true
+	 *  "logger:ring_size" int -- number of records in each thread's ring.  DEFAULT=512
 	 */
 	static void						  setup(const ds::cfg::Settings&);
 
@@ -79,6 +95,40 @@ public:
 	* missing logging for a fraction of a second. */
 	static void             toggleModule(const ds::BitMask& module, const bool on);
 
+	/// Counters for the life of the app.
+	class Stats {
+	  public:
+		Stats();
+		int64_t             mLogged;	// Messages accepted
+		int64_t             mDropped;	// Messages lost because a ring was full
+		int64_t             mWritten;	// Messages written out
+		int64_t             mBatches;	// Number of batched writes
+	};
+	static Stats            getStats();
+
+	class LineStream;
+
+	/// What the DS_LOG macros format into. Holds the calling thread's slot
+	/// for as long as it's alive, and logs what was written when it goes.
+	class Line {
+	  public:
+		static const size_t	FIXED_SIZE = 1024;
+
+		Line(const int level);
+		~Line();
+
+		std::ostream&		stream();
+
+	  private:
+		Line(const Line&);
+		Line&				operator=(const Line&);
+
+		const int			mLevel;
+		// The slot I hold, or -1 if I'm formatting into mFallback
+		int					mSlot;
+		std::ostringstream*	mFallback;
+	};
+
   public:
 	Logger();
 	~Logger();
@@ -93,37 +143,101 @@ public:
 	void                    shutDown();
 
   private:
+	/// A single preformatted record. Messages longer than one record
+	/// span several consecutive records, all but the last flagged continued.
 	struct entry {
+	  static const int      MSG_SIZE = 472;
 	  Poco::Timestamp::TimeVal
 							mTime;
 	  int                   mLevel;
-	  std::string           mMsg;
+	  int                   mLength;
+	  bool                  mContinued;
+	  char                  mMsg[MSG_SIZE];
+	};
+
+	/// Single producer (the slot's owner), single consumer (the Loop).
+	class Ring {
+	  public:
+		Ring(const size_t size);
+
+		/// All or nothing -- answer false if there's no room for the whole message.
+		bool                push(const int level, const Poco::Timestamp::TimeVal, const char* msg, const size_t length);
+		/// Consumer side. Answer the next record, or nullptr if empty. Call pop() when done with it.
+		const entry*        front() const;
+		void                pop();
+		bool                empty() const;
+
+	  private:
+		std::vector<entry>  mEntries;
+		std::atomic<size_t> mHead;	// next write, owned by the producer
+		std::atomic<size_t> mTail;	// next read, owned by the consumer
 	};
 
   private:
 	class Loop : public Poco::Runnable {
 	  public:
-		Poco::Mutex         mMutex;
-		Poco::Condition     mCondition;
-		bool                mAbort;
-		std::vector<entry>  mInput;
+		static const int    MAX_THREADS = 64;
+
+		Poco::Event         mWake;
+		std::atomic<bool>   mPending;
+		std::atomic<bool>   mAbort;
+		std::atomic<int64_t>
+							mFlushRequest,
+							mFlushDone;
 
 	  public:
 		Loop();
+		~Loop();
 
 		void                log(const int level, const std::string&);
-		void                log(const int level, const std::wstring&);
+
+		/// Take the calling thread's slot, claiming a free one if it has none.
+		/// Answer -1 if every slot is taken, or the slot is already held.
+		int                 acquire();
+		LineStream&         getStream(const int slot);
+		/// Log through the slot's ring and give the slot back.
+		void                release(const int slot, const int level, const char* msg, const size_t length);
+		/// Log through the shared ring, for threads without a slot.
+		void                logShared(const int level, const char* msg, const size_t length);
+
+		/// Synchronous mode: write everything out in the caller's thread.
+		void                drainNow();
 
 		virtual void        run();
 
 	  private:
-		std::stringstream   mBuf;
+		/// One per logging thread. mBusy is held by the owner while it logs, and
+		/// by the consumer while it checks whether an idle slot can be given back.
+		/// The ring and stream are made on first claim and kept after that.
+		struct Slot {
+			std::atomic<size_t>		mOwner;
+			std::atomic<bool>		mBusy;
+			std::atomic<int64_t>	mLastUsed;
+			std::atomic<Ring*>		mRing;
+			LineStream*				mStream;
+		};
+
+		bool                push(Ring&, const int level, const Poco::Timestamp::TimeVal, const char* msg, const size_t length);
+		void                pushed(const bool ok);
+		/// Consumer side: give back slots that have been idle a while.
+		void                releaseIdle();
+		void                drainRing(Ring&, int64_t& written);
+		void                drain();
+		void                write(const int level, const Poco::Timestamp::TimeVal, const std::string& msg);
+		void                flush();
+
+		Slot                mSlots[MAX_THREADS];
+		// Overflow, for threads past MAX_THREADS. The lock makes its producers one at a time.
+		Poco::FastMutex     mSharedMutex;
+		Ring*               mShared;
 
-		void                consume(std::vector<entry>&);
-		void                logToConsole(const entry&, const std::string& formattedMsg);
-		void                logToFile(const entry&, const std::string& formattedMsg);
-		void                logToConsole(const entry&, const std::wstring& formattedMsg);
-		void                logToFile(const entry&, const std::wstring& formattedMsg);
+		// Consumer-only state
+		Poco::Mutex         mDrainMutex;
+		std::string         mMsg,
+							mBatch;
+		std::ofstream       mFile;
+		bool                mFatal;
+		int64_t             mReportedDrops;
 	};
 
   private:
@@ -138,7 +252,7 @@ Logger&                     getLogger();
 } // namespace ds
 
 // example: DS_LOG(ds::Logger::LOG_INFO, "I have " << numberArg << " info items to report" << endl, ds::BitMask::newFilled());
-#define DS_LOG(level, streamExp, module)	{ if (ds::Logger::hasLevel(level) && ds::Logger::hasModule(module)) { std::stringstream	buf;	buf << streamExp; 	ds::getLogger().log(level, buf.str()); } }
+#define DS_LOG(level, streamExp, module)	{ if (ds::Logger::hasLevel(level) && ds::Logger::hasModule(module)) { ds::Logger::Line	line(level);	line.stream() << streamExp; } }
 
 // example: DS_LOGW(ds::Logger::LOG_INFO, L"I have " << numberArg << L" info items to report" << endl, ds::BitMask::newFilled());
 #define DS_LOGW(level, streamExp, module)	{ if (ds::Logger::hasLevel(level) && ds::Logger::hasModule(module)) { std::wstringstream	buf;	buf << streamExp; 	ds::getLogger().log(level, buf.str()); } }
@@ -1,13 +1,22 @@
 #include "ds/network/http_client.h"
 
+#include <atomic>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <Poco/File.h>
+#include <Poco/Mutex.h>
 #include <Poco/Net/HTMLForm.h>
 #include <Poco/Net/HTTPClientSession.h>
 #include <Poco/Net/HTTPRequest.h>
 #include <Poco/Net/HTTPResponse.h>
 #include <Poco/Net/NetException.h>
 #include <Poco/Net/StringPartSource.h>
+#include <Poco/NullStream.h>
 #include <Poco/StreamCopier.h>
+#include <Poco/Timestamp.h>
 #include <Poco/URI.h>
 #include "ds/debug/debug_defines.h"
 #include "ds/debug/logger.h"
@@ -30,6 +39,212 @@ static const string			EMPTY_SZ("");
 static const wstring		EMPTY_WSZ(L"");
 
 const ds::BitMask			HTTP_LOG = ds::Logger::newModule("http");
+
+// Idle sessions are dropped after this, before most servers give up on them (Apache's default is 5)
+const int					KEEP_ALIVE_SECONDS = 3;
+const size_t				MAX_IDLE_PER_HOST = 4;
+const size_t				CHUNK_SIZE = 64 * 1024;
+
+/**
+ * \class SessionPool
+ * Idle keep-alive sessions, by host and port. Requests run on worker
+ * threads, so a session is owned by one request at a time.
+ */
+class SessionPool {
+public:
+	SessionPool() : mEnabled(true) { }
+
+	void					setEnabled(const bool on) {
+		Poco::Mutex::ScopedLock		l(mMutex);
+		mEnabled = on;
+		if (!on) mIdle.clear();
+	}
+
+	// Answer an idle session for the host, or a new one. reused is set if it was idle.
+	std::unique_ptr<Poco::Net::HTTPClientSession>
+							take(const std::string& host, const unsigned short port, bool& reused) {
+		reused = false;
+		{
+			Poco::Mutex::ScopedLock		l(mMutex);
+			auto						f = mIdle.find(key(host, port));
+			if (f != mIdle.end()) {
+				std::vector<holder>&	v = f->second;
+				while (!v.empty()) {
+					holder				h(std::move(v.back()));
+					v.pop_back();
+					if (h.mReturned.isElapsed(static_cast<Poco::Timestamp::TimeDiff>(KEEP_ALIVE_SECONDS) * 1000000)) continue;
+					reused = true;
+					return std::move(h.mSession);
+				}
+			}
+		}
+		return create(host, port);
+	}
+
+	std::unique_ptr<Poco::Net::HTTPClientSession>
+							create(const std::string& host, const unsigned short port) const {
+		std::unique_ptr<Poco::Net::HTTPClientSession>	s(new Poco::Net::HTTPClientSession());
+		// This seems insane, but some requests will complain unless we explicitly set the host name.
+		// What's going on -- seen in the google weather API -- is that the SocketAddress translates the
+		// domain name into an IP address, and then running the request redirects you back to the domain name.
+		// So always set the host and port this way, rather then going through a SocketAddress on the constructor.
+		s->setHost(host);
+		s->setPort(port);
+		s->setKeepAlive(isEnabled());
+		s->setKeepAliveTimeout(Poco::Timespan(KEEP_ALIVE_SECONDS, 0));
+		return s;
+	}
+
+	// Hand back a session whose response has been read completely.
+	void					give(std::unique_ptr<Poco::Net::HTTPClientSession>& s) {
+		if (!s || !s->connected()) return;
+		Poco::Mutex::ScopedLock		l(mMutex);
+		if (!mEnabled) return;
+		std::vector<holder>&		v = mIdle[key(s->getHost(), s->getPort())];
+		if (v.size() >= MAX_IDLE_PER_HOST) return;
+		v.push_back(holder());
+		v.back().mSession = std::move(s);
+	}
+
+	bool					isEnabled() const {
+		Poco::Mutex::ScopedLock		l(mMutex);
+		return mEnabled;
+	}
+
+private:
+	struct holder {
+		holder() { }
+		holder(holder&& o) : mSession(std::move(o.mSession)), mReturned(o.mReturned) { }
+		holder&				operator=(holder&& o) { mSession = std::move(o.mSession); mReturned = o.mReturned; return *this; }
+
+		std::unique_ptr<Poco::Net::HTTPClientSession>
+							mSession;
+		Poco::Timestamp		mReturned;
+	};
+
+	static std::string		key(const std::string& host, const unsigned short port) {
+		return host + ":" + std::to_string(static_cast<int>(port));
+	}
+
+	mutable Poco::Mutex		mMutex;
+	bool					mEnabled;
+	std::unordered_map<std::string, std::vector<holder>>
+							mIdle;
+};
+
+/**
+ * \class ResponseCache
+ * GET bodies that came with an ETag or Last-Modified, on disk. Each URL
+ * has one file: three lines of the URL, the ETag and the Last-Modified
+ * date, then the body. It's written beside and renamed over the old one,
+ * so a reader sees the old entry or the new one, never a mix of both.
+ */
+class ResponseCache {
+public:
+	ResponseCache() : mTmpId(0) { }
+
+	struct entry {
+		std::string			mETag,
+							mLastModified;
+	};
+
+	void					setFolder(const std::string& folder) {
+		std::string			path(folder);
+		if (!path.empty()) {
+			try {
+				Poco::File(path).createDirectories();
+			} catch (std::exception const& ex) {
+				DS_LOG_WARNING_M("HttpClient can't create cache folder " << folder << " ex=" << ex.what(), HTTP_LOG);
+				path.clear();
+			}
+			if (!path.empty() && path.back() != '/' && path.back() != '\\') path.append("/");
+		}
+		Poco::Mutex::ScopedLock		l(mMutex);
+		mFolder = path;
+	}
+
+	std::string				getStem(const std::string& url) const {
+		Poco::Mutex::ScopedLock		l(mMutex);
+		if (mFolder.empty()) return EMPTY_SZ;
+		std::ostringstream	name;
+		name << mFolder << std::hex << std::hash<std::string>()(url);
+		return name.str();
+	}
+
+	bool					find(const std::string& url, entry& e) const {
+		std::ifstream		in;
+		return open(url, in, e);
+	}
+
+	// Open the entry for url and leave in at the start of its body. Answer
+	// false if there's none, or it isn't the one that matched e.
+	bool					openBody(const std::string& url, const entry& e, std::ifstream& in) const {
+		entry				now;
+		if (!open(url, in, now)) return false;
+		return now.mETag == e.mETag && now.mLastModified == e.mLastModified;
+	}
+
+	// Answer a unique scratch file for a body that's about to arrive. The
+	// header goes in first, so the body can be streamed in after it.
+	std::string				startEntry(const std::string& url, const Poco::Net::HTTPResponse& response, std::ofstream& os) {
+		const std::string	stem(getStem(url));
+		if (stem.empty()) return EMPTY_SZ;
+		const std::string	tmp(stem + "." + std::to_string(++mTmpId) + ".tmp");
+		os.open(tmp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!os.is_open()) return EMPTY_SZ;
+		os << url << "\n" << response.get("ETag", EMPTY_SZ) << "\n" << response.get("Last-Modified", EMPTY_SZ) << "\n";
+		return tmp;
+	}
+
+	void					commit(const std::string& url, const std::string& tmp) {
+		const std::string	stem(getStem(url));
+		try {
+			if (!stem.empty()) {
+				// Replaces any old entry in one step
+				Poco::File(tmp).renameTo(stem + ".cache");
+				return;
+			}
+		} catch (std::exception const& ex) {
+			DS_LOG_WARNING_M("HttpClient can't cache " << url << " ex=" << ex.what(), HTTP_LOG);
+		}
+		discard(tmp);
+	}
+
+	static void				discard(const std::string& tmp) {
+		try {
+			Poco::File(tmp).remove();
+		} catch (std::exception const&) {
+		}
+	}
+
+private:
+	bool					open(const std::string& url, std::ifstream& in, entry& e) const {
+		const std::string	stem(getStem(url));
+		if (stem.empty()) return false;
+		in.open((stem + ".cache").c_str(), std::ios::in | std::ios::binary);
+		std::string			file_url;
+		if (!std::getline(in, file_url) || file_url != url) return false;
+		entry				ans;
+		std::getline(in, ans.mETag);
+		if (!std::getline(in, ans.mLastModified)) return false;
+		if (ans.mETag.empty() && ans.mLastModified.empty()) return false;
+		e = ans;
+		return true;
+	}
+
+	mutable Poco::Mutex		mMutex;
+	std::string				mFolder;
+	std::atomic<int>		mTmpId;
+};
+
+SessionPool					SESSIONS;
+ResponseCache				RESPONSE_CACHE;
+
+// Read whatever's left so the session can be reused.
+void						drain(std::istream& in) {
+	Poco::NullOutputStream	null;
+	Poco::StreamCopier::copyStream(in, null);
+}
 }
 
 /* HTTP-CLIENT static
@@ -38,6 +253,14 @@ bool HttpClient::httpGetAndReply(const std::wstring& url, ds::HttpReply* ans) {
 	return httpAndReply(HTTP_GET_OPT, url, EMPTY_SZ, nullptr, ans);
 }
 
+bool HttpClient::httpGetAndReply(const std::wstring& url, const std::function<void(const char*, const size_t)>& bodyFn, ds::HttpReply* ans) {
+	return httpAndReply(HTTP_GET_OPT, url, EMPTY_SZ, nullptr, ans, EMPTY_SZ, bodyFn);
+}
+
+bool HttpClient::httpGetToFileAndReply(const std::wstring& url, const std::string& filename, ds::HttpReply* ans) {
+	return httpAndReply(HTTP_GET_OPT, url, EMPTY_SZ, nullptr, ans, filename);
+}
+
 bool HttpClient::httpPostAndReply(const std::wstring& url, const std::string& body, ds::HttpReply* ans) {
 	return httpAndReply(HTTP_POST_OPT, url, body, nullptr, ans);
 }
@@ -47,6 +270,14 @@ bool HttpClient::httpPostAndReply(	const std::wstring& url, const std::function<
 	return httpAndReply(HTTP_POST_OPT, url, EMPTY_SZ, postFn, ans);
 }
 
+void HttpClient::setKeepAlive(const bool on) {
+	SESSIONS.setEnabled(on);
+}
+
+void HttpClient::setCacheFolder(const std::string& folder) {
+	RESPONSE_CACHE.setFolder(folder);
+}
+
 /* HTTP-CLIENT
  ******************************************************************/
 HttpClient::HttpClient(ui::SpriteEngine& e, const std::function<void(const HttpReply&)>& h)
@@ -66,6 +297,12 @@ bool HttpClient::httpGet(const std::wstring& url)
 	return sendHttp(HTTP_GET_OPT, EMPTY_SZ, url, EMPTY_SZ, nullptr);
 }
 
+bool HttpClient::httpGetToFile(const std::wstring& url, const std::string& filename)
+{
+	if (filename.empty()) return false;
+	return sendHttp(HTTP_GET_OPT, EMPTY_SZ, url, EMPTY_SZ, nullptr, nullptr, filename);
+}
+
 bool HttpClient::httpPost(const std::wstring& url, const std::string& body)
 {
 	return sendHttp(HTTP_POST_OPT, EMPTY_SZ, url, body, nullptr);
@@ -92,7 +329,8 @@ void HttpClient::handleResult(std::unique_ptr<WorkRequest>& wr)
 
 bool HttpClient::sendHttp(	const int opt, const std::string &verb, const std::wstring& url, const std::string& body,
 							const std::function<void(Poco::Net::HTMLForm&)>& postFn,
-							const std::function<void(Poco::Net::HTTPRequest&)>& requestFn)
+							const std::function<void(Poco::Net::HTTPRequest&)>& requestFn,
+							const std::string& outputFile)
 {
 	if (url.empty()) {
 		DS_DBG_CODE(std::cout << "ERROR ds::HttpClient() empty url" << std::endl);
@@ -108,19 +346,24 @@ bool HttpClient::sendHttp(	const int opt, const std::string &verb, const std::ws
 	r->mBody = body;
 	r->mPostFn = postFn;
 	r->mRequestFn = requestFn;
+	r->mOutputFile = outputFile;
+	r->mBodyFn = nullptr;
 	r->mReply.clear();
 	return mManager.sendRequest(ds::unique_dynamic_cast<WorkRequest, Request>(r));
 }
 
 bool HttpClient::httpAndReply(const int opt, const std::wstring& url, const std::string& body,
                               const std::function<void(Poco::Net::HTMLForm&)>& postFn,
-                              ds::HttpReply* ans)
+                              ds::HttpReply* ans, const std::string& outputFile,
+                              const std::function<void(const char*, const size_t)>& bodyFn)
 {
 	Request				r(nullptr);
 	r.mOpt = opt;
 	r.mUrl = url;
 	r.mBody = body;
 	r.mPostFn = postFn;
+	r.mOutputFile = outputFile;
+	r.mBodyFn = bodyFn;
 	r.run();
 	if (ans) (*ans) = r.mReply;
 	return true;
@@ -137,6 +380,7 @@ void ds::HttpReply::clear()
 {
 	mMsg.clear();
 	mStatus = REPLY_UNKNOWN_ERROR;
+	mNotModified = false;
 }
 
 /* HTTP-CLIENT::REQUEST
@@ -154,73 +398,56 @@ void HttpClient::Request::run() {
 
 	try {
 		Poco::URI						uri(url8);
-		Poco::Net::HTTPClientSession	s;
 		// I think POCO is a little tricky -- if the URL does NOT have a server part, then this will automatically
 		// URL encode the string.  If it does, it will leave it alone.  Groan!
 		std::string						path(uri.getPathAndQuery());
 		if (path.empty()) path = "/";
-		// This seems insane, but some requests will complain unless we explicitly set the host name.
-		// What's going on -- seen in the google weather API -- is that the SocketAddress translates the
-		// domain name into an IP address, and then running the request redirects you back to the domain name.
-		// So always set the host and port this way, rather then going through a SocketAddress on the constructor.
-		s.setHost(uri.getHost());
-		s.setPort(uri.getPort());
-
-		// NEW NEW NEW STYLE!
-		if (!mVerb.empty()) {
-			// Ignore having a form for now; seems like a big enough topic that
-			// I might require everyone to handle it in the callback.
-			Poco::Net::HTTPRequest		request(mVerb, path, Poco::Net::HTTPMessage::HTTP_1_1);
-			if (!mBody.empty()) request.setContentLength(mBody.size());
-			if (mRequestFn != nullptr) {
-				request.setKeepAlive(true);
-				s.setKeepAliveTimeout(Poco::Timespan(30, 0));
-				mRequestFn(request);
-			}
 
-			std::ostream&   ostr = s.sendRequest(request);
-			// Send the body
-			if (!mBody.empty()) {
-				std::istringstream		ifs(mBody);
-				Poco::StreamCopier::copyStream(ifs, ostr);
-			}
-#if 0
-std::cout << "REQUEST=";
-request.write(std::cout);
-std::cout << std::endl;
-if (!mBody.empty()) std::cout << mBody << std::endl;
-std::cout << "DONE" << std::endl;
-#endif
-		} else if ((mOpt&HTTP_POST_OPT) != 0) {
-			Poco::Net::HTTPRequest		request(Poco::Net::HTTPRequest::HTTP_POST, path, Poco::Net::HTTPMessage::HTTP_1_1);
-			Poco::Net::HTMLForm		    form(request);
-			form.setEncoding(Poco::Net::HTMLForm::ENCODING_MULTIPART);
-			if (!mBody.empty()) {
-				request.setKeepAlive(true);
-				// XXX Obviously we need to provide more parameters to use this properly.
-				// Clients should use the postFn... probably should obsolete this, or make it URL-encoded only.
-				Poco::Net::StringPartSource*  ps = new Poco::Net::StringPartSource(mBody, "binary/octet-stream", "unknown_file");
-				if (ps) form.addPart("file", ps);
-			} else if (mPostFn != nullptr) {
-				request.setKeepAlive(true);
-				mPostFn(form);
-			}
-			form.prepareSubmit(request);
+		// Plain GETs can be answered from the disk cache if the server says nothing changed
+		const bool						get = mVerb.empty() && (mOpt&HTTP_POST_OPT) == 0;
+		ResponseCache::entry			cached;
+		const bool						conditional = get && RESPONSE_CACHE.find(url8, cached);
 
-			std::ostream&   ostr = s.sendRequest(request); // << mBody;
-			form.write(ostr);
-		} else {
-			Poco::Net::HTTPRequest		request(Poco::Net::HTTPRequest::HTTP_GET, path, Poco::Net::HTTPMessage::HTTP_1_1);
-			s.sendRequest(request);
+		// Only GETs go out on an idle session. The server may have closed it
+		// under us, and a POST or custom verb mustn't be sent a second time.
+		bool							reused = false;
+		std::unique_ptr<Poco::Net::HTTPClientSession>
+										s(get ? SESSIONS.take(uri.getHost(), uri.getPort(), reused) : SESSIONS.create(uri.getHost(), uri.getPort()));
+		Poco::Net::HTTPResponse			response;
+		std::istream*					rs = nullptr;
+		try {
+			send(*s, path, cached.mETag, cached.mLastModified);
+			rs = &s->receiveResponse(response);
+		} catch (Poco::Exception&) {
+			// A closed idle session; GETs are safe to try again on a new one.
+			if (!reused) throw;
+			s = SESSIONS.create(uri.getHost(), uri.getPort());
+			response.clear();
+			send(*s, path, cached.mETag, cached.mLastModified);
+			rs = &s->receiveResponse(response);
 		}
 
-		Poco::Net::HTTPResponse			response;
-		std::istream&					rs = s.receiveResponse(response);
-		if (response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
-			std::string					str;
-			Poco::StreamCopier::copyToString(rs, str);
-			if (!str.empty()) mReply.mMsg = ds::wstr_from_utf8(str);
-			mReply.mStatus = ds::HttpReply::REPLY_OK;
+		bool							complete = true;
+		if (conditional && response.getStatus() == Poco::Net::HTTPResponse::HTTP_NOT_MODIFIED) {
+			drain(*rs);
+			std::ifstream				body;
+			if (RESPONSE_CACHE.openBody(url8, cached, body) && receive(body, nullptr, Poco::Net::HTTPMessage::UNKNOWN_CONTENT_LENGTH)) {
+				mReply.mStatus = ds::HttpReply::REPLY_OK;
+				mReply.mNotModified = true;
+			}
+		} else if (response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
+			// Keep a copy if the server gave me a way to ask whether it changed
+			std::ofstream				cache;
+			std::string					cache_file;
+			if (get && (response.has("ETag") || response.has("Last-Modified"))) cache_file = RESPONSE_CACHE.startEntry(url8, response, cache);
+
+			complete = receive(*rs, cache_file.empty() ? nullptr : &cache, response.getContentLength());
+			if (complete) mReply.mStatus = ds::HttpReply::REPLY_OK;
+			if (!cache_file.empty()) {
+				cache.close();
+				if (complete && cache.good()) RESPONSE_CACHE.commit(url8, cache_file);
+				else ResponseCache::discard(cache_file);
+			}
 #ifdef _DEBUG
 //			wcout << "DBG HttpClient response OK msg=" << mReply.mMsg << endl;
 #endif
@@ -228,10 +455,13 @@ std::cout << "DONE" << std::endl;
 #ifdef _DEBUG
 			std::cout << "DBG Http request failed on " << uri.toString() << " response=" << response.getStatus() << " reason=" << response.getReason() << std::endl;
 			std::string					str;
-			Poco::StreamCopier::copyToString(rs, str);
+			Poco::StreamCopier::copyToString(*rs, str);
 			if (!str.empty()) std::cout << "response=" << str << std::endl;
+#else
+			drain(*rs);
 #endif
 		}
+		if (complete && response.getKeepAlive()) SESSIONS.give(s);
 	} catch (Poco::Net::ConnectionRefusedException&) {
 		cout << "HttpClient connection refused" << endl;
 		mReply.mStatus = ds::HttpReply::REPLY_CONNECTION_ERROR;
@@ -240,4 +470,92 @@ std::cout << "DONE" << std::endl;
 	}
 }
 
+void HttpClient::Request::send(	Poco::Net::HTTPClientSession& s, const std::string& path,
+								const std::string& etag, const std::string& modified) {
+	const bool							keep_alive = SESSIONS.isEnabled();
+	// NEW NEW NEW STYLE!
+	if (!mVerb.empty()) {
+		// Ignore having a form for now; seems like a big enough topic that
+		// I might require everyone to handle it in the callback.
+		Poco::Net::HTTPRequest			request(mVerb, path, Poco::Net::HTTPMessage::HTTP_1_1);
+		request.setKeepAlive(keep_alive);
+		if (!mBody.empty()) request.setContentLength(mBody.size());
+		if (mRequestFn != nullptr) {
+			request.setKeepAlive(true);
+			mRequestFn(request);
+		}
+
+		std::ostream&   ostr = s.sendRequest(request);
+		// Send the body
+		if (!mBody.empty()) {
+			std::istringstream			ifs(mBody);
+			Poco::StreamCopier::copyStream(ifs, ostr);
+		}
+#if 0
+std::cout << "REQUEST=";
+request.write(std::cout);
+std::cout << std::endl;
+if (!mBody.empty()) std::cout << mBody << std::endl;
+std::cout << "DONE" << std::endl;
+#endif
+	} else if ((mOpt&HTTP_POST_OPT) != 0) {
+		Poco::Net::HTTPRequest			request(Poco::Net::HTTPRequest::HTTP_POST, path, Poco::Net::HTTPMessage::HTTP_1_1);
+		Poco::Net::HTMLForm				form(request);
+		form.setEncoding(Poco::Net::HTMLForm::ENCODING_MULTIPART);
+		request.setKeepAlive(keep_alive);
+		if (!mBody.empty()) {
+			// XXX Obviously we need to provide more parameters to use this properly.
+			// Clients should use the postFn... probably should obsolete this, or make it URL-encoded only.
+			Poco::Net::StringPartSource*  ps = new Poco::Net::StringPartSource(mBody, "binary/octet-stream", "unknown_file");
+			if (ps) form.addPart("file", ps);
+		} else if (mPostFn != nullptr) {
+			mPostFn(form);
+		}
+		form.prepareSubmit(request);
+
+		std::ostream&   ostr = s.sendRequest(request); // << mBody;
+		form.write(ostr);
+	} else {
+		Poco::Net::HTTPRequest			request(Poco::Net::HTTPRequest::HTTP_GET, path, Poco::Net::HTTPMessage::HTTP_1_1);
+		request.setKeepAlive(keep_alive);
+		if (!etag.empty()) request.set("If-None-Match", etag);
+		if (!modified.empty()) request.set("If-Modified-Since", modified);
+		s.sendRequest(request);
+	}
+}
+
+bool HttpClient::Request::receive(std::istream& in, std::ostream* copy, const std::streamsize expected) {
+	// The body goes to a file, a callback or the reply, a chunk at a time
+	std::ofstream						file;
+	if (!mOutputFile.empty()) {
+		file.open(mOutputFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			DS_LOG_WARNING_M("HttpClient can't write " << mOutputFile, HTTP_LOG);
+			drain(in);
+			return false;
+		}
+	}
+	std::string							str;
+	std::vector<char>					buf(CHUNK_SIZE);
+	std::streamsize						total = 0;
+	while (in.good()) {
+		in.read(buf.data(), buf.size());
+		const std::streamsize			n = in.gcount();
+		if (n <= 0) break;
+		total += n;
+		if (copy) copy->write(buf.data(), n);
+		if (file.is_open()) file.write(buf.data(), n);
+		else if (mBodyFn) mBodyFn(buf.data(), static_cast<size_t>(n));
+		else str.append(buf.data(), static_cast<size_t>(n));
+	}
+	if (in.bad()) return false;
+	if (expected != Poco::Net::HTTPMessage::UNKNOWN_CONTENT_LENGTH && total != expected) {
+		DS_LOG_WARNING_M("HttpClient body cut short, " << total << " of " << expected << " bytes", HTTP_LOG);
+		return false;
+	}
+	if (file.is_open() && !file.good()) return false;
+	if (!str.empty()) mReply.mMsg = ds::wstr_from_utf8(str);
+	return true;
+}
+
 } // namespace ds
\ No newline at end of file
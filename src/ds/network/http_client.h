@@ -3,6 +3,7 @@
 #define DS_NETWORK_HTTPCLIENT_H_
 
 #include <functional>
+#include <iosfwd>
 #include <string>
 #include "ds/thread/work_client.h"
 #include "ds/thread/work_request_list.h"
@@ -10,6 +11,7 @@
 namespace Poco {
 namespace Net {
 class HTMLForm;
+class HTTPClientSession;
 class HTTPRequest;
 }
 }
@@ -27,6 +29,8 @@ public:
 public:
 	std::wstring			mMsg;
 	int						mStatus;
+	// The server answered 304 Not Modified, and the body came from the disk cache
+	bool					mNotModified;
 
 	HttpReply();
 
@@ -38,11 +42,20 @@ public:
  * HTTPS is not supported -- getting SSL in place is a can
  * I don't want to open.  Also, currently don't support any
  * actual reply, this is a fire and forget for now.
+ * Sessions are kept alive per host, and GETs reuse them for up to
+ * 3 seconds; POSTs and custom verbs always go out on a new one, so
+ * they're never sent twice. If there's a cache folder, GET bodies
+ * that come with an ETag or Last-Modified are kept there, and asked
+ * for again with If-None-Match / If-Modified-Since.
  ******************************************************************/
 class HttpClient : public ds::WorkClient {
 public:
 	// If the URL contains a query part it needs to be URL encoded, that won't happen automatically.
 	static bool						httpGetAndReply(const std::wstring& url, ds::HttpReply*);
+	// Hand the body to bodyFn as it arrives, instead of filling in the reply message.
+	static bool						httpGetAndReply(const std::wstring& url, const std::function<void(const char*, const size_t)>& bodyFn, ds::HttpReply*);
+	// Stream the body into filename, instead of filling in the reply message.
+	static bool						httpGetToFileAndReply(const std::wstring& url, const std::string& filename, ds::HttpReply*);
 	static bool						httpPostAndReply(const std::wstring& url, const std::string& body, ds::HttpReply*);
 	// Do a post with complete control over what goes in the form. Poco supplies utilities for
 	// adding strings and files. An example of posting a file into the form would be this:
@@ -53,12 +66,18 @@ public:
 	// };
 	static bool						httpPostAndReply(const std::wstring& url, const std::function<void(Poco::Net::HTMLForm&)>&, ds::HttpReply*);
 
+	// Reuse sessions between requests to the same host. DEFAULT=true
+	static void						setKeepAlive(const bool);
+	// Folder for the conditional GET cache, blank to turn it off. DEFAULT=blank
+	static void						setCacheFolder(const std::string&);
+
 public:
 	HttpClient(ui::SpriteEngine&, const std::function<void(const HttpReply&)>& = nullptr);
 
 	void							setResultHandler(const std::function<void(const HttpReply&)>&);
 
 	bool							httpGet(const std::wstring& url);
+	bool							httpGetToFile(const std::wstring& url, const std::string& filename);
 	bool							httpPost(const std::wstring& url, const std::string& body);
 	bool							httpPost(const std::wstring& url, const std::function<void(Poco::Net::HTMLForm&)>& postFn);
 	bool							http(	const std::string &verb, const std::string& url, const std::string &body,
@@ -85,11 +104,24 @@ private:
 		// Utility to write to the message
 		std::function<void(Poco::Net::HTTPRequest&)>
 									mRequestFn;
+		// Where the body goes, if not the reply message
+		std::string					mOutputFile;
+		std::function<void(const char*, const size_t)>
+									mBodyFn;
 
         // output
 		ds::HttpReply				mReply;
 
 		virtual void				run();
+
+	private:
+		// etag and modified are the cached validators, if any
+		void						send(	Poco::Net::HTTPClientSession&, const std::string& path,
+											const std::string& etag, const std::string& modified);
+		// Answer false if the body didn't arrive whole. A dropped connection reads
+		// as a normal end, so the byte count is checked against expected when the
+		// server sent one. copy gets everything as well.
+		bool						receive(std::istream&, std::ostream* copy, const std::streamsize expected);
 	};
 
 	ds::WorkRequestList<Request>	mCache;
@@ -99,10 +131,12 @@ private:
 private:
 	bool							sendHttp(	const int opt, const std::string &verb, const std::wstring& url, const std::string& body,
 												const std::function<void(Poco::Net::HTMLForm&)>& postFn,
-												const std::function<void(Poco::Net::HTTPRequest&)>& requestFn = nullptr);
+												const std::function<void(Poco::Net::HTTPRequest&)>& requestFn = nullptr,
+												const std::string& outputFile = "");
 	static bool						httpAndReply(	const int opt, const std::wstring& url, const std::string& body,
 													const std::function<void(Poco::Net::HTMLForm&)>& postFn,
-													ds::HttpReply*);
+													ds::HttpReply*, const std::string& outputFile = "",
+													const std::function<void(const char*, const size_t)>& bodyFn = nullptr);
 };
 
 } // namespace ds
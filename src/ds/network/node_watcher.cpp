@@ -1,8 +1,10 @@
 #include "ds/network/node_watcher.h"
 
+#include <algorithm>
 #include <Poco/Net/DatagramSocket.h>
 #include <ds/cfg/settings.h>
 #include <ds/debug/debug_defines.h>
+#include <ds/debug/logger.h>
 #include <ds/ui/sprite/sprite_engine.h>
 
 namespace ds {
@@ -20,10 +22,8 @@ NodeWatcher::~NodeWatcher() {
 	{
 		Poco::Mutex::ScopedLock		l(mLoop.mMutex);
 		mLoop.mAbort = true;
-		// I don't know how one would "wakeup" the socket.  If I knew that,
-		// I could increase the timeout and make the whole thing more efficient.
-//		mLoop.mCondition.signal();
 	}
+	mLoop.wake();
 	try {
 		mThread.join();
 	} catch (std::exception&) {
@@ -39,24 +39,54 @@ void NodeWatcher::add(const std::function<void(const Message&)>& f) {
 	}
 }
 
+NodeWatcher::Stats NodeWatcher::getStats() const {
+	Poco::Mutex::ScopedLock		l(mLoop.mMutex);
+	return mLoop.mStats;
+}
+
 void NodeWatcher::update(const ds::UpdateParams &) {
 	mMsg.clear();
+	Poco::Timestamp::TimeVal	received = 0;
 	{
 		Poco::Mutex::ScopedLock	l(mLoop.mMutex);
+		if (mLoop.mMsg.empty()) return;
 		mMsg.swap(mLoop.mMsg);
+		received = mLoop.mFirstReceived;
 	}
-	if (mMsg.empty()) return;
 
 	for (auto it=mListener.begin(), end=mListener.end(); it != end; ++it) {
 		(*it)(mMsg);
 	}
+
+	// Latency is measured through the listeners, since that's when the app actually sees the change.
+	const double				ms = static_cast<double>(Poco::Timestamp().epochMicroseconds() - received) / 1000.0;
+	Poco::Mutex::ScopedLock		l(mLoop.mMutex);
+	Stats&						s(mLoop.mStats);
+	++s.mDispatched;
+	s.mLastLatencyMs = ms;
+	if (ms > s.mMaxLatencyMs) s.mMaxLatencyMs = ms;
+	s.mAverageLatencyMs += (ms - s.mAverageLatencyMs) / static_cast<double>(s.mDispatched);
+}
+
+/**
+ * \class ds::NodeWatcher::Stats
+ */
+NodeWatcher::Stats::Stats()
+		: mReceived(0)
+		, mCoalesced(0)
+		, mTruncated(0)
+		, mDispatched(0)
+		, mLastLatencyMs(0.0)
+		, mMaxLatencyMs(0.0)
+		, mAverageLatencyMs(0.0) {
 }
 
 /**
  * \class ds::NodeWatcher::Loop
  */
 static long get_refresh_rate(ds::ui::SpriteEngine& e) {
-	// Default to one second
+	// Default to one second. Receiving doesn't wait on this, it only bounds how
+	// long the thread goes without checking for an abort.
 	const ds::cfg::Settings&		settings = e.getSettings("engine");
 	float							rate = settings.getFloat("node:refresh_rate", 0, 1.0f);
 	long							ans = static_cast<long>(rate * 1000.0f);
@@ -65,11 +95,20 @@ static long get_refresh_rate(ds::ui::SpriteEngine& e) {
 	return ans;
 }
 
+static int get_buffer_size(ds::ui::SpriteEngine& e) {
+	// Max UDP payload is just under 64k
+	const ds::cfg::Settings&		settings = e.getSettings("engine");
+	const int						size = settings.getInt("node:buffer_size", 0, 64 * 1024);
+	return std::max(512, std::min(size, 64 * 1024));
+}
+
 NodeWatcher::Loop::Loop(ds::ui::SpriteEngine& e, const std::string& host, const int port)
 		: mAbort(false)
+		, mFirstReceived(0)
 		, mHost(host)
 		, mPort(port)
-		, mRefreshRateMs(get_refresh_rate(e)) {
+		, mRefreshRateMs(get_refresh_rate(e))
+		, mBufferSize(get_buffer_size(e)) {
 }
 
 // WARNING: this class can throw in constructor thanks to
@@ -86,55 +125,91 @@ struct ScopedDatagramSocket
 };
 
 void NodeWatcher::Loop::run() {
-	static const int			BUF_SIZE = 512;
-	char						buf[BUF_SIZE];
+	std::vector<char>			buf;
 
 	try
 	{
+		buf.resize(mBufferSize);
 		ScopedDatagramSocket so{ mHost, mPort };
-		
-		so.mCmsReceiver.setBlocking(false);
-		so.mCmsReceiver.setReceiveTimeout(0);
+
+		const Poco::Timespan	wait(mRefreshRateMs * 1000);
+		const Poco::Timespan	no_wait(0);
 
 		while (true)
 		{
-			int						length = 0;
-
-			try
 			{
-				length = so.mCmsReceiver.receiveBytes(buf, BUF_SIZE);
+				Poco::Mutex::ScopedLock	l(mMutex);
+				if (mAbort) break;
 			}
-			catch (const Poco::TimeoutException&)
+
+			bool					readable = false;
+			try
 			{
+				readable = so.mCmsReceiver.poll(wait, Poco::Net::Socket::SELECT_READ);
 			}
 			catch (const std::exception&)
 			{
 			}
+			if (!readable) continue;
 
-			if (length > 0)
+			// Drain everything that's waiting, not just the first datagram.
+			do
 			{
+				int					length = 0;
 				try
 				{
-					std::string		msg(buf, length);
-					Poco::Mutex::ScopedLock	l(mMutex);
-					mMsg.mData.push_back(msg);
+					length = so.mCmsReceiver.receiveBytes(buf.data(), mBufferSize);
+				}
+				catch (const Poco::TimeoutException&)
+				{
 				}
 				catch (const std::exception&)
 				{
 				}
-			}
-			Poco::Thread::sleep(mRefreshRateMs);
-			{
-				Poco::Mutex::ScopedLock	l(mMutex);
-				if (mAbort) break;
-			}
+				if (length <= 0) break;
+
+				add(buf.data(), length);
+			} while (so.mCmsReceiver.poll(no_wait, Poco::Net::Socket::SELECT_READ));
 		}
 	}
 	catch (...)
 	{
-		// WARNING: you must not use DS_LOG_XX here. We are in a thread and logger class
-		// is not thread-safe.
-		std::cerr << "Unable to construct the DatagramSocket to DS Node." << std::endl;
+		DS_LOG_WARNING("Unable to construct the DatagramSocket to DS Node.");
+	}
+}
+
+void NodeWatcher::Loop::wake() {
+	// Poke the socket with an empty datagram so the poll returns.
+	try {
+		Poco::Net::DatagramSocket	so;
+		so.sendTo("", 0, Poco::Net::SocketAddress(mHost, mPort));
+	} catch (std::exception const&) {
+	}
+}
+
+void NodeWatcher::Loop::add(const char* buf, const int length) {
+	try
+	{
+		Poco::Mutex::ScopedLock	l(mMutex);
+		++mStats.mReceived;
+		if (length >= mBufferSize) {
+			++mStats.mTruncated;
+			DS_LOG_WARNING("NodeWatcher message truncated to " << mBufferSize << " bytes (node:buffer_size)");
+		}
+
+		// The node sends the same notification for every row that changes,
+		// but listeners only need to hear it once per update.
+		for (auto it=mMsg.mData.begin(), end=mMsg.mData.end(); it!=end; ++it) {
+			if (it->size() == static_cast<size_t>(length) && it->compare(0, length, buf, length) == 0) {
+				++mStats.mCoalesced;
+				return;
+			}
+		}
+		if (mMsg.empty()) mFirstReceived = Poco::Timestamp().epochMicroseconds();
+		mMsg.mData.push_back(std::string(buf, length));
+	}
+	catch (const std::exception&)
+	{
 	}
 }
 
@@ -2,12 +2,14 @@
 #ifndef DS_NETWORK_NODEWATCHER_H_
 #define DS_NETWORK_NODEWATCHER_H_
 
+#include <cstdint>
 #include <functional>
 #include <vector>
 #include <Poco/Condition.h>
 #include <Poco/Mutex.h>
 #include <Poco/Runnable.h>
 #include <Poco/Thread.h>
+#include <Poco/Timestamp.h>
 #include "ds/app/auto_update.h"
 
 namespace ds {
@@ -15,6 +17,12 @@ namespace ds {
 /**
  * \class ds::NodeWatcher
  * \brief Feed clients information about changes in the node.
+ * The socket is read in a blocking poll, so notifications are picked up as
+ * soon as they arrive, and everything pending is drained on each wake.
+ * Identical notifications that arrive before the next update are collapsed.
+ * Settings are read from engine.xml:
+ *	"node:refresh_rate" float -- max seconds between checks for shutdown. DEFAULT=1.0
+ *	"node:buffer_size" int -- largest datagram, in bytes. DEFAULT=65536
  */
 class NodeWatcher : public ds::AutoUpdate {
 public:
@@ -31,6 +39,20 @@ public:
 		void						swap(Message&);
 	};
 
+	// Running totals, plus the time from receiving a notification to handing it to the listeners.
+	class Stats {
+	public:
+		Stats();
+
+		int64_t						mReceived,
+									mCoalesced,
+									mTruncated,
+									mDispatched;
+		double						mLastLatencyMs,
+									mMaxLatencyMs,
+									mAverageLatencyMs;
+	};
+
 public:
 	// Standard node location
 	NodeWatcher(ds::ui::SpriteEngine&, const std::string& host = "localhost", const int port = 7777);
@@ -38,25 +60,35 @@ public:
 
 	void							add(const std::function<void(const Message&)>&);
 
+	Stats							getStats() const;
+
 protected:
 	virtual void					update(const ds::UpdateParams &);
 
 private:
 	class Loop : public Poco::Runnable {
 	public:
-		Poco::Mutex					mMutex;
+		mutable Poco::Mutex			mMutex;
 		bool						mAbort;
 		Message						mMsg;
+		// When the oldest message in mMsg arrived
+		Poco::Timestamp::TimeVal	mFirstReceived;
+		Stats						mStats;
 
 	public:
 		Loop(ds::ui::SpriteEngine&, const std::string& host, const int port);
 
 		virtual void				run();
+		// Unblock the receive so run() sees the abort right away.
+		void						wake();
 
 	private:
+		void						add(const char* buf, const int length);
+
 		const std::string			mHost;
 		const int					mPort;
 		const long					mRefreshRateMs;	// in milliseconds
+		const int					mBufferSize;
 	};
 
 	Poco::Thread					mThread;
@@ -68,4 +100,4 @@ private:
 
 } // namespace ds
 
-#endif // DS_NETWORK_NODEWATCHER_H_
\ No newline at end of file
+#endif // DS_NETWORK_NODEWATCHER_H_
@@ -3,8 +3,30 @@
 namespace ds
 {
 
+/**
+ * \class ds::DrawStats
+ */
+DrawStats::DrawStats()
+  : mDrawn(0)
+  , mCulled(0)
+{
+
+}
+
+void DrawStats::clear()
+{
+  mDrawn = 0;
+  mCulled = 0;
+}
+
+/**
+ * \class ds::DrawParams
+ */
 DrawParams::DrawParams()
   : mParentOpacity(1.0f)
+  , mCull(false)
+  , mCullRect(0.0f, 0.0f, 0.0f, 0.0f)
+  , mStats(nullptr)
 {
 
 }
@@ -2,8 +2,26 @@
 #ifndef DS_DRAW_PARAMS_H
 #define DS_DRAW_PARAMS_H
 
+#include <cstddef>
+#include <cinder/Rect.h>
+
 namespace ds {
 
+/**
+ * \class ds::DrawStats
+ * \brief What the client draw did with the sprites it was handed in one frame.
+ */
+class DrawStats {
+public:
+	DrawStats();
+	void			clear();
+
+	// Sprites that went through drawClient()
+	size_t			mDrawn;
+	// Sprites skipped because their subtree was outside the cull rect
+	size_t			mCulled;
+};
+
 /**
  * \class ds::DrawParams
  * \brief Provided to sprites for draw()ing functions.
@@ -12,6 +30,14 @@ class DrawParams {
 public:
 	DrawParams();
 	float mParentOpacity;
+	// When on, drawClient() skips any subtree whose bounds, through the
+	// transform it's handed, miss mCullRect. Nothing is culled while the
+	// rect is empty. Ortho roots fill it in with the screen, or clip a rect
+	// a renderer has already narrowed it to.
+	bool mCull;
+	ci::Rectf mCullRect;
+	// Optional, counted into when set
+	DrawStats* mStats;
 };
 
 } // namespace ds
@@ -0,0 +1,270 @@
+#include "directory_watcher.h"
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <Poco/Timestamp.h>
+#include "ds/debug/logger.h"
+
+using namespace ds;
+
+namespace {
+// OK It's horrible placing this as a global, but there can only ever be a single
+// watcher thread going, and I don't want to clutter the API with platform references.
+Poco::Mutex			WAKEUP_LOCK;
+int					WAKEUP = -1;
+
+void				setWakeup(const int fd) {
+	Poco::Mutex::ScopedLock		l(WAKEUP_LOCK);
+	WAKEUP = fd;
+}
+
+void				signalWakeup() {
+	Poco::Mutex::ScopedLock		l(WAKEUP_LOCK);
+	if (WAKEUP >= 0) {
+		const uint64_t			one = 1;
+		if (write(WAKEUP, &one, sizeof(one)) < 0) { }
+	}
+}
+
+// A burst of changes (i.e. a CMS sync) is reported once it's been quiet this long,
+const int			QUIET_MS = 250;
+// but never later than this after the first change.
+const int			MAX_DELAY_MS = 2000;
+
+const uint32_t		WATCH_MASK = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB
+								 | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+/**
+ * Every directory under the roots gets its own watch; inotify isn't recursive.
+ */
+class Watches {
+public:
+	Watches(const int fd)
+			: mFd(fd)
+			, mFull(false) {
+	}
+
+	// Watch dir and everything under it, reporting to root.
+	void					addTree(const std::string& dir, const size_t root) {
+		if (mFull) return;
+
+		const int			wd = inotify_add_watch(mFd, dir.c_str(), WATCH_MASK);
+		if (wd < 0) {
+			if (errno == ENOSPC) {
+				// Out of watch descriptors. Keep what we have rather than failing outright.
+				mFull = true;
+				DS_LOG_WARNING("DirectoryWatcher out of inotify watches at " << dir << ", raise fs.inotify.max_user_watches to watch the whole tree");
+			} else if (errno != ENOENT && errno != ENOTDIR) {
+				DS_LOG_WARNING("DirectoryWatcher can't watch " << dir << " (" << strerror(errno) << ")");
+			}
+			return;
+		}
+		// Adding a watched inode again hands back its wd; it's been moved within the tree
+		if (mWatches.find(wd) != mWatches.end()) mReadded.insert(wd);
+		mWatches[wd] = entry(dir, root);
+
+		DIR*				d = opendir(dir.c_str());
+		if (!d) return;
+		while (struct dirent* e = readdir(d)) {
+			if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+			const std::string	child = dir + "/" + e->d_name;
+			if (isDirectory(e, child)) addTree(child, root);
+		}
+		closedir(d);
+	}
+
+	void					remove(const int wd) {
+		auto				found = mWatches.find(wd);
+		if (found == mWatches.end()) return;
+		mWatches.erase(found);
+		// Might have been the reason we ran out
+		mFull = false;
+	}
+
+	// Answer true if addTree() found wd already watched since the last clearReadded().
+	bool					wasReadded(const int wd) const {
+		return mReadded.find(wd) != mReadded.end();
+	}
+
+	void					clearReadded() {
+		mReadded.clear();
+	}
+
+	// The directory moved somewhere we can't follow, stop watching it.
+	void					detach(const int wd) {
+		if (mWatches.find(wd) == mWatches.end()) return;
+		inotify_rm_watch(mFd, wd);
+		remove(wd);
+	}
+
+	bool					find(const int wd, std::string& dir, size_t& root) const {
+		auto				found = mWatches.find(wd);
+		if (found == mWatches.end()) return false;
+		dir = found->second.first;
+		root = found->second.second;
+		return true;
+	}
+
+	bool					empty() const {
+		return mWatches.empty();
+	}
+
+private:
+	typedef std::pair<std::string, size_t>	entry;
+
+	static bool				isDirectory(const struct dirent* e, const std::string& path) {
+		if (e->d_type == DT_DIR) return true;
+		if (e->d_type != DT_UNKNOWN) return false;
+		// Don't follow links, they can loop
+		struct stat			st;
+		return lstat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+	}
+
+	const int				mFd;
+	bool					mFull;
+	std::unordered_map<int, entry>
+							mWatches;
+	std::unordered_set<int>	mReadded;
+};
+
+int					millis_since(const Poco::Timestamp& t) {
+	return static_cast<int>(t.elapsed() / 1000);
+}
+
+}
+
+/**
+ * \class ds::DirectoryWatcher
+ */
+void DirectoryWatcher::wakeup()
+{
+	signalWakeup();
+}
+
+/**
+ * \class ds::DirectoryWatcher::Waiter
+ */
+void DirectoryWatcher::Waiter::run()
+{
+	if (mPath.empty()) return;
+
+	const int			fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd < 0) {
+		DS_LOG_WARNING("DirectoryWatcher inotify_init1 failed (" << strerror(errno) << ")");
+		return;
+	}
+	const int			wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (wake < 0) {
+		close(fd);
+		return;
+	}
+	setWakeup(wake);
+
+	{
+		Watches			watches(fd);
+		for (size_t k=0; k<mPath.size(); ++k) {
+			std::string	root(mPath[k]);
+			while (root.size() > 1 && root.back() == '/') root.pop_back();
+			watches.addTree(root, k);
+		}
+		watches.clearReadded();
+
+		// Roots with changes waiting on the debounce
+		std::vector<bool>	pending(mPath.size(), false);
+		bool				has_pending = false;
+		Poco::Timestamp		first_change, last_change;
+		// inotify_event is variable length; align for the header
+		alignas(struct inotify_event) char	buf[16 * 1024];
+		// Directories that moved, held until every queued event has been read
+		std::vector<int>	moved;
+
+		while (!isStopped()) {
+			int				timeout = -1;
+			if (has_pending) {
+				timeout = std::max(0, std::min(QUIET_MS - millis_since(last_change), MAX_DELAY_MS - millis_since(first_change)));
+			}
+
+			struct pollfd	fds[2] = { { wake, POLLIN, 0 }, { fd, POLLIN, 0 } };
+			const int		ready = poll(fds, 2, timeout);
+			if (ready < 0 && errno != EINTR) break;
+			if (isStopped()) break;
+
+			if (ready > 0 && (fds[1].revents & POLLIN) != 0) {
+				while (true) {
+					const ssize_t	len = read(fd, buf, sizeof(buf));
+					if (len <= 0) break;
+					for (char* p = buf; p < buf + len; ) {
+						const struct inotify_event*	e = reinterpret_cast<const struct inotify_event*>(p);
+						p += sizeof(struct inotify_event) + e->len;
+
+						size_t			root = 0;
+						std::string		dir;
+						if ((e->mask & IN_Q_OVERFLOW) != 0) {
+							// Lost events, so everything might have changed
+							std::fill(pending.begin(), pending.end(), true);
+						} else if ((e->mask & IN_IGNORED) != 0) {
+							// Deleted directory, or its watch was removed
+							watches.remove(e->wd);
+							continue;
+						} else if (watches.find(e->wd, dir, root)) {
+							pending[root] = true;
+							if ((e->mask & IN_ISDIR) != 0 && (e->mask & (IN_CREATE | IN_MOVED_TO)) != 0 && e->len > 0) {
+								watches.addTree(dir + "/" + e->name, root);
+							} else if ((e->mask & IN_MOVE_SELF) != 0) {
+								// If it moved inside the tree, the parent's IN_MOVED_TO re-adds it under the
+								// new name, which can come before or after this. Decide once both are in.
+								moved.push_back(e->wd);
+							}
+						} else {
+							continue;
+						}
+
+						if (!has_pending) first_change.update();
+						has_pending = true;
+						last_change.update();
+					}
+				}
+				// A rename queues all its events at once, so the queue is empty now
+				for (auto it=moved.begin(), end=moved.end(); it!=end; ++it) {
+					if (!watches.wasReadded(*it)) watches.detach(*it);
+				}
+				moved.clear();
+				watches.clearReadded();
+			}
+			if ((fds[0].revents & POLLIN) != 0) {
+				uint64_t		v;
+				if (read(wake, &v, sizeof(v)) < 0) { }
+			}
+
+			if (has_pending && (millis_since(last_change) >= QUIET_MS || millis_since(first_change) >= MAX_DELAY_MS)) {
+				for (size_t k=0; k<pending.size(); ++k) {
+					if (pending[k] && !onChanged(mPath[k])) goto cleanup;
+					pending[k] = false;
+				}
+				has_pending = false;
+			}
+			if (watches.empty()) {
+				DS_LOG_WARNING("DirectoryWatcher nothing left to watch");
+				break;
+			}
+		}
+	}
+
+cleanup:
+	setWakeup(-1);
+	close(wake);
+	close(fd);
+}
+
+#endif // __linux__
@@ -2,6 +2,7 @@
 
 #include <Poco/Semaphore.h>
 #include "ds/debug/debug_defines.h"
+#include "ds/debug/frame_profiler.h"
 #include "ds/debug/logger.h"
 
 using namespace ds;
@@ -201,6 +202,8 @@ void GlThread::Loop::run()
 
 void GlThread::Loop::consume(std::vector<GlThreadCallback*>& ins) 
 {
+	if (ins.empty()) return;
+	DS_PROFILE_SCOPE("GlThread::consume");
 	// Perform each callback.  There's one special case:  Callbacks of matching runs
 	// are considered a batch, and only the final one will be performed.
 	const int				size = ins.size();
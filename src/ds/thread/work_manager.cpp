@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include "ds/debug/frame_profiler.h"
 #include "ds/thread/work_client.h"
 
 using namespace ds;
@@ -79,6 +80,7 @@ void WorkManager::stopManager()
 
 void WorkManager::update()
 {
+	DS_PROFILE_SCOPE("WorkManager::update");
 	// To control how much processing the client does, pop off a single result
 	// in an update cycle.
 	mOutputTmp.clear();
@@ -204,7 +206,10 @@ void WorkManager::Loop::handleInput(std::unique_ptr<WorkRequest>& upR) const
 	WorkRequest*			r = upR.get();
 	if (!r) return;
 
-	r->run();
+	{
+		DS_PROFILE_SCOPE("WorkRequest::run");
+		r->run();
+	}
 
   mManager.addOutput(upR);
 }
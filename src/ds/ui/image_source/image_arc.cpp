@@ -9,6 +9,7 @@
 #include "ds/data/data_buffer.h"
 #include "ds/debug/logger.h"
 #include "ds/ui/image_source/image_generator.h"
+#include "ds/ui/service/generated_image_service.h"
 #include "ds/ui/sprite/sprite_engine.h"
 
 namespace ds {
@@ -26,6 +27,9 @@ const int			STATUS_ERROR	= -1;
 const int			STATUS_EMPTY	= 0;
 const int			STATUS_OK		= 1;
 
+// Bump when the rendered output changes, to invalidate disk caches
+const int			ARC_VERSION		= 1;
+
 /**
  * \class ArcGenerator
  * This does all the work of generating and transporting settings across the network.
@@ -33,10 +37,13 @@ const int			STATUS_OK		= 1;
 class ArcGenerator : public ImageGenerator
 {
 public:
-	ArcGenerator(SpriteEngine&)
-		: ImageGenerator(BLOB_TYPE), mStatus(STATUS_EMPTY), mWidth(0), mHeight(0) { }
-	ArcGenerator(SpriteEngine&, const int width, const int height, const std::string& fn, const ds::arc::Input& input, const std::string& write_file)
-		: ImageGenerator(BLOB_TYPE), mStatus(STATUS_EMPTY), mWidth(width), mHeight(height), mFilename(fn), mInput(input), mWriteFile(write_file) { }
+	ArcGenerator(SpriteEngine& e)
+		: ImageGenerator(BLOB_TYPE), mImages(e.getService<GeneratedImageService>(GENERATED_IMAGE_SERVICE)), mStatus(STATUS_EMPTY), mWidth(0), mHeight(0), mKey(0) { }
+	ArcGenerator(SpriteEngine& e, const int width, const int height, const std::string& fn, const ds::arc::Input& input, const std::string& write_file)
+		: ImageGenerator(BLOB_TYPE), mImages(e.getService<GeneratedImageService>(GENERATED_IMAGE_SERVICE)), mStatus(STATUS_EMPTY), mWidth(width), mHeight(height), mFilename(fn), mInput(input), mWriteFile(write_file), mKey(0) { }
+	~ArcGenerator() {
+		if (mStatus == STATUS_OK) mImages.release(mKey);
+	}
 
 	bool						getMetaData(ImageMetaData& d) const {
 		d.mSize.x = static_cast<float>(mWidth);
@@ -89,22 +96,50 @@ public:
 	}
 
 private:
+	// Every arc with the same size, file and input shares one texture.
 	void											generate() {
 		mStatus = STATUS_ERROR;
 		if (mWidth < 1 || mHeight < 1) return;
+
+		mKey = makeKey();
+		mTexture = mImages.acquire(mKey, [this](ci::Surface8u& s)->bool { return renderTo(s); });
+		if (!mTexture) return;
+		if (mTexture.getWidth() != mWidth || mTexture.getHeight() != mHeight) {
+			mImages.release(mKey);
+			mTexture = ci::gl::Texture();
+			return;
+		}
+		mStatus = STATUS_OK;
+	}
+
+	bool											renderTo(ci::Surface8u& out) {
 		std::unique_ptr<ds::arc::Arc>		a = std::move(ds::arc::load(mFilename));
-		if (!a) return;
+		if (!a) return false;
 		ci::Surface8u		s(mWidth, mHeight, true, ci::SurfaceConstraintsDefault());
-		if (!s || s.getWidth() != mWidth || s.getHeight() != mHeight) return;
+		if (!s || s.getWidth() != mWidth || s.getHeight() != mHeight) return false;
 
 		ds::arc::RenderCircle		render;
-		if (!render.on(mInput, s, *(a.get()))) return;
+		if (!render.on(mInput, s, *(a.get()))) return false;
 
 		writeFile(s);
-		mTexture = ci::gl::Texture(s);
-		if (mTexture && mTexture.getWidth() == mWidth && mTexture.getHeight() == mHeight) {
-			mStatus = STATUS_OK;
-		}
+		out = s;
+		return true;
+	}
+
+	uint64_t				makeKey() const {
+		GeneratedImageKey	key("arc", ARC_VERSION);
+		key.add(&mWidth, sizeof(mWidth));
+		key.add(&mHeight, sizeof(mHeight));
+		key.addFile(mFilename);
+		DataBuffer			buf;
+		mInput.writeTo(buf);
+		std::string			input(buf.size(), 0);
+		buf.seekBegin();
+		if (!input.empty()) buf.readRaw(&input[0], static_cast<unsigned>(input.size()));
+		key.add(input);
+		// A debug write file only happens on a render, so don't share with anyone else
+		if (!mWriteFile.empty()) key.add(mWriteFile);
+		return key.getValue();
 	}
 
 	void					writeFile(const ci::Surface8u& s) {
@@ -118,12 +153,14 @@ private:
 		}
 	}
 
+	GeneratedImageService&	mImages;
 	int						mStatus;
 	int						mWidth,
 							mHeight;
 	std::string				mFilename;
 	ds::arc::Input			mInput;
 	std::string				mWriteFile;
+	uint64_t				mKey;
 	ci::gl::Texture			mTexture;
 };
 
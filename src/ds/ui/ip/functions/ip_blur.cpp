@@ -0,0 +1,57 @@
+#include <ds/ui/ip/functions/ip_blur.h>
+
+#include <algorithm>
+#include <vector>
+#include <ds/ui/ip/ip_kernels.h>
+#include <ds/util/string_util.h>
+
+namespace ds {
+namespace ui {
+namespace ip {
+
+namespace {
+const int				DEFAULT_RADIUS = 4;
+const int				MAX_RADIUS = 255;
+// Three box passes are within a few percent of a gaussian
+const int				PASSES = 3;
+}
+
+/**
+ * \class ds::ui::ip::Blur
+ */
+Blur::Blur() {
+}
+
+void Blur::on(const std::string& parameters, ci::Surface8u& s) const {
+	if (!s) return;
+	const int32_t			w = s.getWidth(), h = s.getHeight();
+	if (w < 1 || h < 1) return;
+
+	int						radius = DEFAULT_RADIUS;
+	if (!parameters.empty()) ds::string_to_value(parameters, radius);
+	radius = std::max(1, std::min(radius, MAX_RADIUS));
+	// The passes add up, so each only needs to cover part of the radius
+	const int				pass_radius = std::max(1, radius / 2);
+
+	uint8_t*				data = s.getData();
+	const int32_t			row_bytes = s.getRowBytes();
+	const int				pixel_inc = s.getPixelInc();
+	std::vector<uint8_t>	tmp(static_cast<size_t>(row_bytes) * h);
+	uint8_t*				buf = tmp.data();
+	for (int pass=0; pass<PASSES; ++pass) {
+		parallel_rows(h, [data, buf, row_bytes, pixel_inc, w, pass_radius](const int begin, const int end) {
+			for (int y=begin; y<end; ++y) {
+				box_row(data + y * row_bytes, buf + y * row_bytes, w, pixel_inc, pass_radius);
+			}
+		});
+		// Columns are split across threads, each walking the whole height
+		const int			bytes = w * pixel_inc;
+		parallel_rows(bytes, [data, buf, row_bytes, h, pass_radius](const int begin, const int end) {
+			box_columns(buf, data, h, row_bytes, begin, end, pass_radius);
+		}, 64);
+	}
+}
+
+} // namespace ip
+} // namespace ui
+} // namespace ds
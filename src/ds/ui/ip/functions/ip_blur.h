@@ -0,0 +1,27 @@
+#pragma once
+#ifndef DS_UI_IP_FUNCTIONS_IPBLUR_H_
+#define DS_UI_IP_FUNCTIONS_IPBLUR_H_
+
+#include <ds/ui/ip/ip_function.h>
+
+namespace ds {
+namespace ui {
+namespace ip {
+
+/**
+ * \class ds::ui::ip::Blur
+ * Blur every channel of the surface. The parameter is the radius in pixels
+ * (default 4); three box passes approximate a gaussian.
+ */
+class Blur : public Function {
+public:
+	Blur();
+		
+	virtual void				on(const std::string& parameters, ci::Surface8u&) const;
+};
+
+} // namespace ip
+} // namespace ui
+} // namespace ds
+
+#endif
\ No newline at end of file
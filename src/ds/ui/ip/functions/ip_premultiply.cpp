@@ -0,0 +1,34 @@
+#include <ds/ui/ip/functions/ip_premultiply.h>
+
+#include <ds/ui/ip/ip_kernels.h>
+
+namespace ds {
+namespace ui {
+namespace ip {
+
+/**
+ * \class ds::ui::ip::Premultiply
+ */
+Premultiply::Premultiply() {
+}
+
+void Premultiply::on(const std::string& parameters, ci::Surface8u& s) const {
+	if (!s || !s.hasAlpha() || s.isPremultiplied()) return;
+	const int32_t			w = s.getWidth(), h = s.getHeight();
+	if (w < 1 || h < 1) return;
+
+	uint8_t*				data = s.getData();
+	const int32_t			row_bytes = s.getRowBytes();
+	const int				pixel_inc = s.getPixelInc();
+	const int				alpha_offset = s.getAlphaOffset();
+	parallel_rows(h, [data, row_bytes, pixel_inc, alpha_offset, w](const int begin, const int end) {
+		for (int y=begin; y<end; ++y) {
+			premultiply_row(data + y * row_bytes, pixel_inc, w, alpha_offset);
+		}
+	});
+	s.setPremultiplied(true);
+}
+
+} // namespace ip
+} // namespace ui
+} // namespace ds
@@ -0,0 +1,27 @@
+#pragma once
+#ifndef DS_UI_IP_FUNCTIONS_IPPREMULTIPLY_H_
+#define DS_UI_IP_FUNCTIONS_IPPREMULTIPLY_H_
+
+#include <ds/ui/ip/ip_function.h>
+
+namespace ds {
+namespace ui {
+namespace ip {
+
+/**
+ * \class ds::ui::ip::Premultiply
+ * Multiply the colour channels by alpha, so the surface is ready for
+ * premultiplied blending. Surfaces that already are get left alone.
+ */
+class Premultiply : public Function {
+public:
+	Premultiply();
+		
+	virtual void				on(const std::string& parameters, ci::Surface8u&) const;
+};
+
+} // namespace ip
+} // namespace ui
+} // namespace ds
+
+#endif
\ No newline at end of file
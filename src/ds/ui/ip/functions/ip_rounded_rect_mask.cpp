@@ -0,0 +1,48 @@
+#include <ds/ui/ip/functions/ip_rounded_rect_mask.h>
+
+#include <algorithm>
+#include <cmath>
+#include <ds/ui/ip/ip_kernels.h>
+#include <ds/util/string_util.h>
+
+namespace ds {
+namespace ui {
+namespace ip {
+
+/**
+ * \class ds::ui::ip::RoundedRectMask
+ */
+RoundedRectMask::RoundedRectMask() {
+}
+
+void RoundedRectMask::on(const std::string& parameters, ci::Surface8u& s) const {
+	if (!s || !s.hasAlpha()) return;
+	const int32_t			w = s.getWidth(), h = s.getHeight();
+	if (w < 1 || h < 1) return;
+
+	const float				half = static_cast<float>(std::min(w, h)) / 2.0f;
+	float					radius = half / 4.0f;
+	if (!parameters.empty()) ds::string_to_value(parameters, radius);
+	radius = std::min(radius, half);
+	if (radius <= 0.0f) return;
+
+	uint8_t*				alpha = s.getData() + s.getAlphaOffset();
+	const int32_t			row_bytes = s.getRowBytes();
+	const int				pixel_inc = s.getPixelInc();
+	// Only the rows with corners in them
+	const int				corner_rows = std::min(h, static_cast<int>(std::ceil(radius)));
+	auto					rows = [alpha, row_bytes, pixel_inc, w, h, radius](const int y) {
+		rounded_rect_mask_row(alpha + y * row_bytes, pixel_inc, w, y, h, radius);
+	};
+	parallel_rows(corner_rows, [&rows, h, corner_rows](const int begin, const int end) {
+		for (int y=begin; y<end; ++y) {
+			rows(y);
+			const int		bottom = h - 1 - y;
+			if (bottom >= corner_rows) rows(bottom);
+		}
+	}, 8);
+}
+
+} // namespace ip
+} // namespace ui
+} // namespace ds
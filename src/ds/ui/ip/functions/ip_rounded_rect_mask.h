@@ -0,0 +1,27 @@
+#pragma once
+#ifndef DS_UI_IP_FUNCTIONS_IPROUNDEDRECTMASK_H_
+#define DS_UI_IP_FUNCTIONS_IPROUNDEDRECTMASK_H_
+
+#include <ds/ui/ip/ip_function.h>
+
+namespace ds {
+namespace ui {
+namespace ip {
+
+/**
+ * \class ds::ui::ip::RoundedRectMask
+ * Round off the corners of the surface by alphing-out anything outside them.
+ * The parameter is the corner radius in pixels, default an eighth of the smaller side.
+ */
+class RoundedRectMask : public Function {
+public:
+	RoundedRectMask();
+		
+	virtual void				on(const std::string& parameters, ci::Surface8u&) const;
+};
+
+} // namespace ip
+} // namespace ui
+} // namespace ds
+
+#endif
\ No newline at end of file
@@ -6,9 +6,15 @@ namespace ip {
 
 namespace {
 const std::string		_CIRCLE_MASK("ds:circle_mask");
+const std::string		_ROUNDED_RECT_MASK("ds:rounded_rect_mask");
+const std::string		_BLUR("ds:blur");
+const std::string		_PREMULTIPLY("ds:premultiply");
 }
 
 const std::string&		CIRCLE_MASK(_CIRCLE_MASK);
+const std::string&		ROUNDED_RECT_MASK(_ROUNDED_RECT_MASK);
+const std::string&		BLUR(_BLUR);
+const std::string&		PREMULTIPLY(_PREMULTIPLY);
 
 } // namespace ip
 } // namespace ui
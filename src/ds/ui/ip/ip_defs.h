@@ -12,6 +12,12 @@ namespace ip {
 
 // Make everything outside the largest possible circle transparent.
 extern const std::string&	CIRCLE_MASK;
+// Round the corners. Parameter is the radius in pixels.
+extern const std::string&	ROUNDED_RECT_MASK;
+// Blur all channels. Parameter is the radius in pixels.
+extern const std::string&	BLUR;
+// Multiply the colour channels by alpha.
+extern const std::string&	PREMULTIPLY;
 
 } // namespace ip
 } // namespace ui
@@ -0,0 +1,394 @@
+#include "ds/ui/ip/ip_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <vector>
+#include <Poco/Condition.h>
+#include <Poco/Environment.h>
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/ThreadPool.h>
+#include "ds/debug/logger.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define DS_IP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace ds {
+namespace ui {
+namespace ip {
+
+namespace {
+
+/**
+ * One range of a parallel_rows() call, run on the pool.
+ */
+class RowJob : public Poco::Runnable {
+public:
+	RowJob(const std::function<void(const int, const int)>& fn, const int begin, const int end,
+		   Poco::Mutex& m, Poco::Condition& c, int& remaining)
+			: mFn(fn), mBegin(begin), mEnd(end), mMutex(m), mCondition(c), mRemaining(remaining) {
+	}
+
+	virtual void		run() {
+		// Nothing can get past the count, or parallel_rows() waits forever
+		try {
+			mFn(mBegin, mEnd);
+		} catch (std::exception const& ex) {
+			DS_LOG_WARNING("ip::parallel_rows() job failed ex=" << ex.what());
+		} catch (...) {
+			DS_LOG_WARNING("ip::parallel_rows() job failed on an unknown exception");
+		}
+		Poco::Mutex::ScopedLock		l(mMutex);
+		--mRemaining;
+		mCondition.signal();
+	}
+
+private:
+	RowJob&				operator=(const RowJob&);
+
+	const std::function<void(const int, const int)>&
+						mFn;
+	const int			mBegin,
+						mEnd;
+	Poco::Mutex&		mMutex;
+	Poco::Condition&	mCondition;
+	int&				mRemaining;
+};
+
+// The circle mask coverage for a pixel d from the centre, written the same way in
+// the scalar and SSE2 code so they round identically.
+inline float circle_coverage(const float d, const float radius, const float inner) {
+	if (d > radius) return 0.0f;
+	if (d > inner) return 1.0f - (d - inner);
+	return 1.0f;
+}
+
+inline void scale_alpha(uint8_t& a, const float f) {
+	int32_t				v = static_cast<int32_t>(static_cast<float>(a) * f);
+	if (v < 0) v = 0;
+	else if (v > 255) v = 255;
+	a = static_cast<uint8_t>(v);
+}
+
+// c * a / 255, rounded to nearest, without a divide
+inline uint8_t mul_div255(const uint32_t c, const uint32_t a) {
+	const uint32_t		t = c * a + 128;
+	return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+}
+
+// The box filters divide by multiplying with a 24 bit fixed point 1/size, rounded
+// up. A sum of up to 255 * size times that still fits 32 bits, and it's close
+// enough that a flat image stays exactly flat.
+const int			BOX_SHIFT = 24;
+const uint32_t		BOX_ROUND = 1u << (BOX_SHIFT - 1);
+
+inline uint32_t box_multiplier(const uint32_t size) {
+	return ((1u << BOX_SHIFT) + size - 1) / size;
+}
+
+inline uint32_t box_divide(const uint32_t sum, const uint32_t mul) {
+	return std::min<uint32_t>(255, (sum * mul + BOX_ROUND) >> BOX_SHIFT);
+}
+
+#ifdef DS_IP_SSE2
+template <int A>
+void premultiply_sse2(uint8_t* p, const int count) {
+	const __m128i		zero = _mm_setzero_si128();
+	const __m128i		round = _mm_set1_epi16(128);
+	const __m128i		amask = _mm_set1_epi32(0xFF << (A * 8));
+	for (int k=0; k<count; k+=4, p+=16) {
+		const __m128i	px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		__m128i			lo = _mm_unpacklo_epi8(px, zero),
+						hi = _mm_unpackhi_epi8(px, zero);
+		const __m128i	alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(A, A, A, A)), _MM_SHUFFLE(A, A, A, A)),
+						ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(A, A, A, A)), _MM_SHUFFLE(A, A, A, A));
+		lo = _mm_add_epi16(_mm_mullo_epi16(lo, alo), round);
+		hi = _mm_add_epi16(_mm_mullo_epi16(hi, ahi), round);
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+		const __m128i	out = _mm_packus_epi16(lo, hi);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_or_si128(_mm_andnot_si128(amask, out), _mm_and_si128(amask, px)));
+	}
+}
+
+// The low 32 bits of a * b per lane, same as the scalar uint32_t multiply. SSE2 has no pmulld.
+inline __m128i mullo_epu32(const __m128i a, const __m128i b) {
+	const __m128i		even = _mm_mul_epu32(a, b);
+	const __m128i		odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// box_divide() per lane
+inline __m128i box_divide_sse2(const __m128i sum, const __m128i mul) {
+	return _mm_srli_epi32(_mm_add_epi32(mullo_epu32(sum, mul), _mm_set1_epi32(static_cast<int>(BOX_ROUND))), BOX_SHIFT);
+}
+
+// Four bytes widened to four 32 bit lanes
+inline __m128i widen4(const uint8_t* p) {
+	const __m128i		zero = _mm_setzero_si128();
+	const __m128i		v = _mm_cvtsi32_si128(*reinterpret_cast<const int*>(p));
+	return _mm_unpacklo_epi16(_mm_unpacklo_epi8(v, zero), zero);
+}
+
+// box_row() for 4 byte pixels, all four channels in one register
+void box_row_sse2(const uint8_t* src, uint8_t* dst, const int width, const int radius, const uint32_t mul) {
+	const int			last = width - 1;
+	const __m128i		v_mul = _mm_set1_epi32(static_cast<int>(mul));
+	__m128i				sum = mullo_epu32(widen4(src), _mm_set1_epi32(radius + 1));
+	for (int k=1; k<=radius; ++k) sum = _mm_add_epi32(sum, widen4(src + std::min(k, last) * 4));
+	for (int x=0; x<width; ++x) {
+		// Saturating packs are the scalar min(255)
+		const __m128i	out = box_divide_sse2(sum, v_mul);
+		const int		packed = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(out, out), _mm_setzero_si128()));
+		memcpy(dst + x * 4, &packed, 4);
+		sum = _mm_add_epi32(sum, widen4(src + std::min(x + radius + 1, last) * 4));
+		sum = _mm_sub_epi32(sum, widen4(src + std::max(x - radius, 0) * 4));
+	}
+}
+
+// One row of box_columns() for 16 byte columns: write out, then slide the sums down a row
+inline void box_columns_sse2(uint32_t* sums, uint8_t* out, const uint8_t* add, const uint8_t* sub, const __m128i mul) {
+	const __m128i		zero = _mm_setzero_si128();
+	__m128i				s[4];
+	for (int j=0; j<4; ++j) s[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + j * 4));
+	const __m128i		lo = _mm_packs_epi32(box_divide_sse2(s[0], mul), box_divide_sse2(s[1], mul)),
+						hi = _mm_packs_epi32(box_divide_sse2(s[2], mul), box_divide_sse2(s[3], mul));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(lo, hi));
+
+	const __m128i		a8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(add)),
+						b8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sub));
+	const __m128i		a16[2] = { _mm_unpacklo_epi8(a8, zero), _mm_unpackhi_epi8(a8, zero) },
+						b16[2] = { _mm_unpacklo_epi8(b8, zero), _mm_unpackhi_epi8(b8, zero) };
+	for (int j=0; j<4; ++j) {
+		const __m128i	a32 = ((j & 1) == 0 ? _mm_unpacklo_epi16(a16[j / 2], zero) : _mm_unpackhi_epi16(a16[j / 2], zero));
+		const __m128i	b32 = ((j & 1) == 0 ? _mm_unpacklo_epi16(b16[j / 2], zero) : _mm_unpackhi_epi16(b16[j / 2], zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(sums + j * 4), _mm_sub_epi32(_mm_add_epi32(s[j], a32), b32));
+	}
+}
+#endif
+
+}
+
+void parallel_rows(const int count, const std::function<void(const int begin, const int end)>& fn, const int min_per_job) {
+	if (count < 1 || !fn) return;
+
+	int						jobs = 1;
+	try {
+		jobs = std::max(1, std::min(static_cast<int>(Poco::Environment::processorCount()), count / std::max(1, min_per_job)));
+	} catch (std::exception const&) {
+	}
+	if (jobs < 2) {
+		fn(0, count);
+		return;
+	}
+
+	Poco::Mutex				mutex;
+	Poco::Condition			condition;
+	int						remaining = 0;
+	std::vector<RowJob>		pool_jobs;
+	pool_jobs.reserve(jobs - 1);
+	// The last range stays with me
+	for (int k=0; k<jobs - 1; ++k) {
+		pool_jobs.push_back(RowJob(fn, (count * k) / jobs, (count * (k + 1)) / jobs, mutex, condition, remaining));
+	}
+
+	for (auto it=pool_jobs.begin(), end=pool_jobs.end(); it!=end; ++it) {
+		{
+			Poco::Mutex::ScopedLock		l(mutex);
+			++remaining;
+		}
+		try {
+			Poco::ThreadPool::defaultPool().start(*it);
+		} catch (std::exception const&) {
+			// Pool's full, do it myself
+			it->run();
+		}
+	}
+	// The jobs hold my locals, so they finish before anything of mine is thrown
+	std::exception_ptr		failed;
+	try {
+		fn((count * (jobs - 1)) / jobs, count);
+	} catch (...) {
+		failed = std::current_exception();
+	}
+
+	{
+		Poco::Mutex::ScopedLock		l(mutex);
+		while (remaining > 0) condition.wait(mutex);
+	}
+	if (failed) std::rethrow_exception(failed);
+}
+
+void circle_mask_row(uint8_t* alpha, const int pixel_inc, const int width, const int y,
+					 const float cen_x, const float cen_y, const float radius) {
+	if (!alpha || width < 1) return;
+
+	const float				inner = radius - 1.0f;
+	const float				dy = cen_y - static_cast<float>(y);
+	const float				dy2 = dy * dy;
+
+	// Anything well inside the inner radius is untouched, so only visit the
+	// pixels either side of that span. Pull it in a pixel to stay clear of rounding.
+	int						skip_begin = 0, skip_end = 0;
+	if (inner > 0.0f && dy2 < inner * inner) {
+		const float			half = std::sqrt(inner * inner - dy2) - 1.0f;
+		if (half > 0.0f) {
+			skip_begin = std::max(0, static_cast<int>(std::ceil(cen_x - half)));
+			skip_end = std::min(width, static_cast<int>(std::floor(cen_x + half)) + 1);
+			if (skip_end < skip_begin) skip_end = skip_begin;
+		}
+	}
+
+	int						x = 0;
+	while (x < width) {
+		if (x == skip_begin && skip_end > skip_begin) {
+			x = skip_end;
+			continue;
+		}
+		const int			end = (x < skip_begin ? skip_begin : width);
+
+#ifdef DS_IP_SSE2
+		const __m128		v_dy2 = _mm_set1_ps(dy2);
+		const __m128		v_cen_x = _mm_set1_ps(cen_x);
+		const __m128		v_radius = _mm_set1_ps(radius);
+		const __m128		v_inner = _mm_set1_ps(inner);
+		const __m128		v_one = _mm_set1_ps(1.0f);
+		float				f[4];
+		for (; x + 4 <= end; x += 4) {
+			const __m128	px = _mm_set_ps(static_cast<float>(x + 3), static_cast<float>(x + 2), static_cast<float>(x + 1), static_cast<float>(x));
+			const __m128	dx = _mm_sub_ps(v_cen_x, px);
+			const __m128	d = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), v_dy2));
+			const __m128	edge = _mm_sub_ps(v_one, _mm_sub_ps(d, v_inner));
+			const __m128	is_edge = _mm_cmpgt_ps(d, v_inner);
+			const __m128	is_out = _mm_cmpgt_ps(d, v_radius);
+			// out ? 0 : (edge ? 1-(d-inner) : 1)
+			const __m128	cov = _mm_andnot_ps(is_out, _mm_or_ps(_mm_and_ps(is_edge, edge), _mm_andnot_ps(is_edge, v_one)));
+			_mm_storeu_ps(f, cov);
+			for (int k=0; k<4; ++k) scale_alpha(alpha[(x + k) * pixel_inc], f[k]);
+		}
+#endif
+		for (; x < end; ++x) {
+			const float		dx = cen_x - static_cast<float>(x);
+			const float		d = std::sqrt(dx * dx + dy2);
+			scale_alpha(alpha[x * pixel_inc], circle_coverage(d, radius, inner));
+		}
+	}
+}
+
+void rounded_rect_mask_row(uint8_t* alpha, const int pixel_inc, const int width, const int y,
+						   const int height, const float radius) {
+	if (!alpha || width < 1 || radius <= 0.0f) return;
+
+	// Measured from pixel centres
+	const float				py = static_cast<float>(y) + 0.5f;
+	float					cen_y;
+	if (py < radius) cen_y = radius;
+	else if (py > static_cast<float>(height) - radius) cen_y = static_cast<float>(height) - radius;
+	else return;
+
+	const float				inner = radius - 1.0f;
+	const float				dy = cen_y - py;
+	const int				span = std::min(width, static_cast<int>(std::ceil(radius)));
+	for (int x=0; x<span; ++x) {
+		const float			dx = radius - (static_cast<float>(x) + 0.5f);
+		if (dx > 0.0f) scale_alpha(alpha[x * pixel_inc], circle_coverage(std::sqrt(dx * dx + dy * dy), radius, inner));
+	}
+	for (int x=std::max(span, width - span); x<width; ++x) {
+		const float			dx = (static_cast<float>(x) + 0.5f) - (static_cast<float>(width) - radius);
+		if (dx > 0.0f) scale_alpha(alpha[x * pixel_inc], circle_coverage(std::sqrt(dx * dx + dy * dy), radius, inner));
+	}
+}
+
+void premultiply_row(uint8_t* pixels, const int pixel_inc, const int width, const int alpha_offset) {
+	if (!pixels || width < 1 || alpha_offset < 0 || alpha_offset >= pixel_inc) return;
+
+	int						x = 0;
+#ifdef DS_IP_SSE2
+	if (pixel_inc == 4) {
+		const int			count = width & ~3;
+		switch (alpha_offset) {
+		case 0: premultiply_sse2<0>(pixels, count); break;
+		case 1: premultiply_sse2<1>(pixels, count); break;
+		case 2: premultiply_sse2<2>(pixels, count); break;
+		case 3: premultiply_sse2<3>(pixels, count); break;
+		}
+		x = count;
+	}
+#endif
+	for (uint8_t* p = pixels + x * pixel_inc; x < width; ++x, p += pixel_inc) {
+		const uint32_t		a = p[alpha_offset];
+		for (int c=0; c<pixel_inc; ++c) {
+			if (c != alpha_offset) p[c] = mul_div255(p[c], a);
+		}
+	}
+}
+
+void box_row(const uint8_t* src, uint8_t* dst, const int width, const int pixel_inc, const int radius) {
+	if (!src || !dst || width < 1) return;
+
+	const int				last = width - 1;
+	const uint32_t			size = static_cast<uint32_t>(radius * 2 + 1);
+	const uint32_t			mul = box_multiplier(size);
+#ifdef DS_IP_SSE2
+	if (pixel_inc == 4) {
+		box_row_sse2(src, dst, width, radius, mul);
+		return;
+	}
+#endif
+	for (int c=0; c<pixel_inc; ++c) {
+		const uint8_t*		s = src + c;
+		uint8_t*			d = dst + c;
+		uint32_t			sum = s[0] * static_cast<uint32_t>(radius + 1);
+		for (int k=1; k<=radius; ++k) sum += s[std::min(k, last) * pixel_inc];
+		for (int x=0; x<width; ++x) {
+			d[x * pixel_inc] = static_cast<uint8_t>(box_divide(sum, mul));
+			sum += s[std::min(x + radius + 1, last) * pixel_inc];
+			sum -= s[std::max(x - radius, 0) * pixel_inc];
+		}
+	}
+}
+
+void box_columns(const uint8_t* src, uint8_t* dst, const int height, const int row_bytes,
+				 const int begin, const int end, const int radius) {
+	if (!src || !dst || height < 1 || end <= begin) return;
+
+	const int				last = height - 1;
+	const int				n = end - begin;
+	const uint32_t			size = static_cast<uint32_t>(radius * 2 + 1);
+	const uint32_t			mul = box_multiplier(size);
+	// A running sum per byte column, walked down a row at a time so every access is sequential
+	std::vector<uint32_t>	sums(n);
+	const uint8_t*			first = src + begin;
+	for (int k=0; k<n; ++k) sums[k] = first[k] * static_cast<uint32_t>(radius + 1);
+	for (int y=1; y<=radius; ++y) {
+		const uint8_t*		row = src + std::min(y, last) * row_bytes + begin;
+		for (int k=0; k<n; ++k) sums[k] += row[k];
+	}
+#ifdef DS_IP_SSE2
+	const __m128i			v_mul = _mm_set1_epi32(static_cast<int>(mul));
+	const int				wide = n & ~15;
+#else
+	const int				wide = 0;
+#endif
+	for (int y=0; y<height; ++y) {
+		uint8_t*			out = dst + y * row_bytes + begin;
+		const uint8_t*		add = src + std::min(y + radius + 1, last) * row_bytes + begin;
+		const uint8_t*		sub = src + std::max(y - radius, 0) * row_bytes + begin;
+#ifdef DS_IP_SSE2
+		for (int k=0; k<wide; k+=16) box_columns_sse2(&sums[k], out + k, add + k, sub + k, v_mul);
+#endif
+		for (int k=wide; k<n; ++k) {
+			out[k] = static_cast<uint8_t>(box_divide(sums[k], mul));
+			sums[k] += add[k];
+			sums[k] -= sub[k];
+		}
+	}
+}
+
+} // namespace ip
+} // namespace ui
+} // namespace ds
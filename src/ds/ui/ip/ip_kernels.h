@@ -0,0 +1,48 @@
+#pragma once
+#ifndef DS_UI_IP_IPKERNELS_H_
+#define DS_UI_IP_IPKERNELS_H_
+
+#include <cstdint>
+#include <functional>
+
+namespace ds {
+namespace ui {
+namespace ip {
+
+/* Pixel kernels shared by the ip functions. Each works on a run of 8 bit
+ * pixels described by the pixel stride and channel offsets, so any slice of
+ * a surface can be handed to any thread. Where SSE2 is available it's used,
+ * and it gives exactly the same results as the scalar code.
+ */
+
+// Split [0, count) into contiguous ranges and run fn(begin, end) on each, in parallel
+// when there's enough work. The calling thread takes a share and waits for the rest.
+// fn must be safe to run concurrently on disjoint ranges.
+void			parallel_rows(const int count, const std::function<void(const int begin, const int end)>& fn,
+							  const int min_per_job = 32);
+
+// Scale a row of alpha values by their coverage of the circle at cen with radius,
+// antialiased over the last pixel. alpha points at the first pixel's alpha byte.
+void			circle_mask_row(uint8_t* alpha, const int pixel_inc, const int width, const int y,
+								const float cen_x, const float cen_y, const float radius);
+
+// Scale a row of alpha values by their coverage of a width x height rectangle with
+// corners rounded to radius, antialiased over the last pixel. Only corner pixels are touched.
+void			rounded_rect_mask_row(uint8_t* alpha, const int pixel_inc, const int width, const int y,
+									  const int height, const float radius);
+
+// Multiply the colour channels by alpha, rounded. The alpha channel is left alone.
+void			premultiply_row(uint8_t* pixels, const int pixel_inc, const int width, const int alpha_offset);
+
+// A box filter of the given radius along a row of pixels, every channel, clamped at the edges.
+// src and dst can't overlap.
+void			box_row(const uint8_t* src, uint8_t* dst, const int width, const int pixel_inc, const int radius);
+// The same down the byte columns [begin, end) of an image.
+void			box_columns(const uint8_t* src, uint8_t* dst, const int height, const int row_bytes,
+							const int begin, const int end, const int radius);
+
+} // namespace ip
+} // namespace ui
+} // namespace ds
+
+#endif
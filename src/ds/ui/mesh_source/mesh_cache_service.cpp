@@ -1,9 +1,39 @@
 #include "mesh_cache_service.h"
 
+#include <algorithm>
+#include <Poco/File.h>
+#include "ds/cfg/settings.h"
+#include "ds/debug/logger.h"
+#include "ds/ui/sprite/sprite_engine.h"
+
 namespace ds {
 
 namespace {
 const std::string	_MESH_CACHE_SERVICE_NAME("ds:meshcache");
+
+const size_t		BYTES_PER_MB = 1024 * 1024;
+// How often a failed file is checked for changes
+const Poco::Timestamp::TimeDiff	FAILED_CHECK_MICROS = 2 * 1000 * 1000;
+
+// Generated meshes have no MeshData to ask, so assume positions, normals and one set of tex coords.
+size_t				vbo_bytes(const ci::gl::VboMesh& m) {
+	return m.getNumVertices() * (sizeof(ci::Vec3f) * 2 + sizeof(ci::Vec2f)) + m.getNumIndices() * sizeof(uint32_t);
+}
+
+// The epoch if the file is missing, which still changes when it shows up
+Poco::Timestamp		last_modified(const std::string& filename) {
+	try {
+		Poco::File	f(filename);
+		if (f.exists()) return f.getLastModified();
+	} catch (std::exception const&) {
+	}
+	return Poco::Timestamp(0);
+}
+
+// File meshes share the cache with generated ones
+std::string			file_key(const std::string& filename) {
+	return "file;" + filename;
+}
 }
 
 const std::string&	MESH_CACHE_SERVICE_NAME(_MESH_CACHE_SERVICE_NAME);
@@ -11,10 +41,23 @@ const std::string&	MESH_CACHE_SERVICE_NAME(_MESH_CACHE_SERVICE_NAME);
 /**
  * \class ds::MeshCacheService
  */
-MeshCacheService::MeshCacheService() {
+MeshCacheService::MeshCacheService(ds::ui::SpriteEngine& e)
+		: mEngine(e)
+		, mBudgetBytes(128 * BYTES_PER_MB)
+		, mResidentBytes(0)
+		, mUseClock(0)
+		, mLoader(e, [this](std::unique_ptr<Poco::Runnable>& r) { onLoaded(r); }) {
 }
 
 void MeshCacheService::start() {
+	const float		mb = mEngine.getSettings("engine").getFloat("mesh:cache_budget_mb", 0, static_cast<float>(mBudgetBytes / BYTES_PER_MB));
+	setBudget(mb > 0.0f ? static_cast<size_t>(mb * static_cast<float>(BYTES_PER_MB)) : 0);
+}
+
+void MeshCacheService::setBudget(const size_t bytes) {
+	std::unique_lock<std::mutex>	lock(mMutex);
+	mBudgetBytes = bytes;
+	evict();
 }
 
 ci::gl::VboMesh MeshCacheService::get(	const std::string& key,
@@ -22,12 +65,133 @@ ci::gl::VboMesh MeshCacheService::get(	const std::string& key,
 	std::unique_lock<std::mutex>	lock(mMutex);
 	if (!mCache.empty()) {
 		auto f = mCache.find(key);
-		if (f != mCache.end()) return f->second;
+		if (f != mCache.end()) {
+			f->second.mLastUsed = ++mUseClock;
+			return f->second.mMesh;
+		}
 	}
 	if (!generate_fn) return ci::gl::VboMesh();
 	ci::gl::VboMesh		vbo(generate_fn());
-	mCache[key] = vbo;
+	insert(key, vbo, vbo_bytes(vbo));
 	return vbo;
 }
 
-} // namespace ds
+ci::gl::VboMesh MeshCacheService::getFile(const std::string& filename, bool* error) {
+	if (error) *error = false;
+	{
+		std::unique_lock<std::mutex>	lock(mMutex);
+		auto f = mCache.find(file_key(filename));
+		if (f != mCache.end()) {
+			f->second.mLastUsed = ++mUseClock;
+			return f->second.mMesh;
+		}
+		if (stillFailed(filename)) {
+			if (error) *error = true;
+			return ci::gl::VboMesh();
+		}
+		if (mLoading.find(filename) != mLoading.end()) return ci::gl::VboMesh();
+		mLoading.insert(filename);
+	}
+
+	std::unique_ptr<LoadOp>				op(new LoadOp());
+	op->mFilename = filename;
+	std::unique_ptr<Poco::Runnable>		r(std::move(op));
+	if (!mLoader.run(r)) {
+		DS_LOG_WARNING("MeshCacheService can't start load for " << filename);
+		std::unique_lock<std::mutex>	lock(mMutex);
+		mLoading.erase(filename);
+	}
+	return ci::gl::VboMesh();
+}
+
+void MeshCacheService::insert(const std::string& key, const ci::gl::VboMesh& vbo, const size_t bytes) {
+	holder&				h = mCache[key];
+	mResidentBytes -= std::min(mResidentBytes, h.mBytes);
+	h.mMesh = vbo;
+	h.mBytes = bytes;
+	h.mLastUsed = ++mUseClock;
+	mResidentBytes += bytes;
+	evict();
+}
+
+void MeshCacheService::evict() {
+	if (mBudgetBytes < 1 || mResidentBytes <= mBudgetBytes) return;
+
+	std::vector<std::pair<int64_t, const std::string*>>	lru;
+	lru.reserve(mCache.size());
+	for (auto it=mCache.begin(), end=mCache.end(); it!=end; ++it) {
+		// Whatever was just used stays, even if it alone is over budget
+		if (it->second.mLastUsed < mUseClock) lru.push_back(std::make_pair(it->second.mLastUsed, &it->first));
+	}
+	std::sort(lru.begin(), lru.end(), [](const std::pair<int64_t, const std::string*>& a, const std::pair<int64_t, const std::string*>& b)->bool { return a.first < b.first; });
+
+	for (auto it=lru.begin(), end=lru.end(); it!=end && mResidentBytes > mBudgetBytes; ++it) {
+		auto			found = mCache.find(*(it->second));
+		if (found == mCache.end()) continue;
+		mResidentBytes -= std::min(mResidentBytes, found->second.mBytes);
+		mCache.erase(found);
+	}
+}
+
+void MeshCacheService::onLoaded(std::unique_ptr<Poco::Runnable>& r) {
+	LoadOp*				op = dynamic_cast<LoadOp*>(r.get());
+	if (!op) return;
+
+	// The GPU upload is all that's left for the main thread
+	ci::gl::VboMesh		vbo;
+	if (op->mOk) {
+		try {
+			vbo = op->mData.createVbo();
+		} catch (std::exception const& ex) {
+			DS_LOG_WARNING("MeshCacheService can't create mesh for " << op->mFilename << " ex=" << ex.what());
+		}
+	}
+
+	std::unique_lock<std::mutex>	lock(mMutex);
+	mLoading.erase(op->mFilename);
+	if (!vbo) {
+		mFailed[op->mFilename].mModified = op->mModified;
+		return;
+	}
+	insert(file_key(op->mFilename), vbo, op->mData.getVboBytes());
+}
+
+bool MeshCacheService::stillFailed(const std::string& filename) {
+	auto				found = mFailed.find(filename);
+	if (found == mFailed.end()) return false;
+	// Don't touch the disk every frame
+	if (found->second.mChecked.elapsed() < FAILED_CHECK_MICROS) return true;
+	found->second.mChecked.update();
+	if (last_modified(filename) == found->second.mModified) return true;
+	mFailed.erase(found);
+	return false;
+}
+
+/**
+ * \class ds::MeshCacheService::holder
+ */
+MeshCacheService::holder::holder()
+		: mBytes(0)
+		, mLastUsed(0) {
+}
+
+/**
+ * \class ds::MeshCacheService::failure
+ */
+MeshCacheService::failure::failure() {
+}
+
+/**
+ * \class ds::MeshCacheService::LoadOp
+ */
+MeshCacheService::LoadOp::LoadOp()
+		: mOk(false) {
+}
+
+void MeshCacheService::LoadOp::run() {
+	mModified = last_modified(mFilename);
+	mOk = mData.load(mFilename) && !mData.empty();
+	if (!mOk) DS_LOG_WARNING("MeshCacheService can't load " << mFilename);
+}
+
+} // namespace ds
\ No newline at end of file
@@ -3,35 +3,103 @@
 #define DS_UI_MESHSOURCE_MESHCACHESERVICE_H_
 
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <cinder/gl/Vbo.h>
 #include <cinder/Thread.h>
 #include <cinder/TriMesh.h>
+#include <Poco/Runnable.h>
+#include <Poco/Timestamp.h>
 #include <ds/app/engine/engine_service.h>
+#include <ds/thread/runnable_client.h>
+#include <ds/ui/mesh_source/mesh_data.h>
 
 namespace ds {
+namespace ui {
+class SpriteEngine;
+}
 
 extern const std::string&	MESH_CACHE_SERVICE_NAME;
 
 /**
  * \class ds::MeshCacheService
- * \brief Utility to cache mesh geometry.
+ * \brief Utility to cache mesh geometry. Mesh files are parsed on a worker
+ * and only uploaded in the main thread. Meshes stay cached while the total
+ * stays under budget; past that the least recently used are dropped (sprites
+ * holding one keep it, and it's rebuilt the next time it's asked for).
+ * A file that fails to load isn't retried until it changes on disk.
+ * Settings are read from engine.xml:
+ *	"mesh:cache_budget_mb" float -- 0 for no limit. DEFAULT=128
  */
 class MeshCacheService : public ds::EngineService {
 public:
-	MeshCacheService();
+	MeshCacheService(ds::ui::SpriteEngine&);
 
 	virtual void			start();
 
+	// In bytes. 0 turns off eviction.
+	void					setBudget(const size_t);
+
 	ci::gl::VboMesh			get(const std::string& key,
 								const std::function<ci::TriMesh(void)>& generate_fn);
+	// Answer the mesh in filename, starting a background load if it's not
+	// cached. The answer is empty until the load is done. error is set if
+	// the file can't be loaded. Main thread only.
+	ci::gl::VboMesh			getFile(const std::string& filename, bool* error = nullptr);
 
 private:
+	struct holder {
+		holder();
+
+		ci::gl::VboMesh		mMesh;
+		size_t				mBytes;
+		int64_t				mLastUsed;
+	};
+
+	// A file that failed to load, and when it was last looked at
+	struct failure {
+		failure();
+
+		Poco::Timestamp		mModified,
+							mChecked;
+	};
+
+	class LoadOp : public Poco::Runnable {
+	public:
+		LoadOp();
+
+		virtual void		run();
+
+		std::string			mFilename;
+		ds::ui::MeshData	mData;
+		// The file's modified time from before the load
+		Poco::Timestamp		mModified;
+		bool				mOk;
+	};
+
+	// Must be called with the lock held
+	void					insert(const std::string& key, const ci::gl::VboMesh&, const size_t bytes);
+	void					evict();
+	void					onLoaded(std::unique_ptr<Poco::Runnable>&);
+	// Answer true if filename failed and hasn't changed since.
+	bool					stillFailed(const std::string& filename);
+
+	ds::ui::SpriteEngine&	mEngine;
 	std::mutex				mMutex;
-	std::unordered_map<std::string, ci::gl::VboMesh>
+	std::unordered_map<std::string, holder>
 							mCache;
+	size_t					mBudgetBytes,
+							mResidentBytes;
+	int64_t					mUseClock;
+
+	RunnableClient			mLoader;
+	// Files being loaded, and those that failed
+	std::unordered_set<std::string>
+							mLoading;
+	std::unordered_map<std::string, failure>
+							mFailed;
 };
 
 } // namespace ds
 
-#endif
+#endif
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "ds/ui/mesh_source/mesh_data.h"
+
+#include <cstring>
+#include <fstream>
+#include <Poco/File.h>
+#include <Poco/SharedMemory.h>
+#include "ds/debug/logger.h"
+#include "ds/ui/mesh_source/mesh_file_loader.h"
+
+namespace ds {
+namespace ui {
+
+namespace {
+// 'DSMH', little endian
+const uint32_t			MAGIC = 0x484d5344;
+const uint32_t			LEGACY_MAGIC = 0x1ee7ed;
+const uint32_t			ALIGN = 16;
+
+enum { POSITIONS, NORMALS, INDICES, TEXCOORDS, SECTION_COUNT };
+
+struct section {
+	uint32_t			mCount,
+						mOffset;
+};
+
+// Everything is little endian uint32, so the header is plain old data.
+struct file_header {
+	uint32_t			mMagic,
+						mVersion,
+						mHeaderSize,
+						mFileSize;
+	section				mSection[SECTION_COUNT];
+	uint32_t			mReserved[4];
+};
+static_assert(sizeof(file_header) == 64, "MeshData header must be 64 bytes");
+static_assert(sizeof(ci::Vec3f) == 12 && sizeof(ci::Vec2f) == 8, "MeshData expects packed vectors");
+
+const uint32_t			STRIDE[SECTION_COUNT] = { sizeof(ci::Vec3f), sizeof(ci::Vec3f), sizeof(uint32_t), sizeof(ci::Vec2f) };
+
+uint64_t				align_up(const uint64_t v) {
+	return (v + (ALIGN - 1)) & ~static_cast<uint64_t>(ALIGN - 1);
+}
+
+bool					valid_section(const section& s, const uint32_t stride, const uint64_t file_size) {
+	if (s.mCount == 0) return true;
+	if (s.mOffset % ALIGN != 0 || s.mOffset < sizeof(file_header)) return false;
+	return static_cast<uint64_t>(s.mOffset) + static_cast<uint64_t>(s.mCount) * stride <= file_size;
+}
+
+template <typename T>
+void					copy_section(const char* base, const section& s, std::vector<T>& out) {
+	out.resize(s.mCount);
+	if (s.mCount > 0) memcpy(out.data(), base + s.mOffset, static_cast<size_t>(s.mCount) * sizeof(T));
+}
+
+template <typename T>
+bool					write_section(std::ostream& os, const std::vector<T>& v, uint64_t& pos) {
+	static const char	PAD[ALIGN] = { 0 };
+	const uint64_t		start = align_up(pos);
+	if (start > pos) os.write(PAD, static_cast<std::streamsize>(start - pos));
+	if (!v.empty()) os.write(reinterpret_cast<const char*>(v.data()), static_cast<std::streamsize>(v.size() * sizeof(T)));
+	pos = start + v.size() * sizeof(T);
+	return os.good();
+}
+}
+
+/**
+ * \class ds::ui::MeshData
+ */
+MeshData::MeshData() {
+}
+
+bool MeshData::empty() const {
+	return mPositions.empty() || mIndices.empty();
+}
+
+void MeshData::clear() {
+	mPositions.clear();
+	mNormals.clear();
+	mIndices.clear();
+	mTexCoords.clear();
+}
+
+bool MeshData::load(const std::string& filename) {
+	clear();
+	uint32_t				magic = 0;
+	{
+		std::ifstream		is(filename.c_str(), std::ios::in | std::ios::binary);
+		if (!is.is_open()) return false;
+		is.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+		if (!is.good()) return false;
+	}
+	bool					ok = false;
+	if (magic == MAGIC) ok = loadMapped(filename);
+	else if (magic == LEGACY_MAGIC) ok = loadLegacy(filename);
+	else DS_LOG_WARNING("MeshData::load() unknown format " << filename);
+	if (!ok) clear();
+	return ok;
+}
+
+bool MeshData::loadMapped(const std::string& filename) {
+	try {
+		Poco::File				file(filename);
+		const uint64_t			file_size = file.getSize();
+		if (file_size < sizeof(file_header)) return false;
+
+		Poco::SharedMemory		map(file, Poco::SharedMemory::AM_READ);
+		const char*				base = map.begin();
+		if (!base) return false;
+
+		file_header				h;
+		memcpy(&h, base, sizeof(h));
+		if (h.mMagic != MAGIC || h.mVersion != FORMAT_VERSION || h.mHeaderSize != sizeof(file_header) || h.mFileSize != file_size) {
+			DS_LOG_WARNING("MeshData::load() bad header " << filename << " version=" << h.mVersion);
+			return false;
+		}
+		for (int k=0; k<SECTION_COUNT; ++k) {
+			if (!valid_section(h.mSection[k], STRIDE[k], file_size)) {
+				DS_LOG_WARNING("MeshData::load() bad section " << k << " in " << filename);
+				return false;
+			}
+		}
+
+		copy_section(base, h.mSection[POSITIONS], mPositions);
+		copy_section(base, h.mSection[NORMALS], mNormals);
+		copy_section(base, h.mSection[INDICES], mIndices);
+		copy_section(base, h.mSection[TEXCOORDS], mTexCoords);
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING("MeshData::load() failed on " << filename << " exception=" << ex.what());
+		return false;
+	}
+
+	// Don't hand the GPU an index past the end
+	const uint32_t				n = static_cast<uint32_t>(mPositions.size());
+	for (auto it=mIndices.begin(), end=mIndices.end(); it!=end; ++it) {
+		if (*it >= n) {
+			DS_LOG_WARNING("MeshData::load() index out of range in " << filename);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool MeshData::loadLegacy(const std::string& filename) {
+	ds::ui::util::MeshFileLoader	loader;
+	if (!loader.Load(filename)) return false;
+
+	mPositions.assign(loader.mVert, loader.mVert + loader.mNumVert);
+	mNormals.assign(loader.mNorm, loader.mNorm + loader.mNumNorm);
+	mIndices.assign(loader.mIndices, loader.mIndices + loader.mNumIndices);
+	mTexCoords.assign(loader.mTex, loader.mTex + loader.mNumTex);
+	return true;
+}
+
+bool MeshData::write(const std::string& filename) const {
+	try {
+		file_header				h;
+		memset(&h, 0, sizeof(h));
+		h.mMagic = MAGIC;
+		h.mVersion = FORMAT_VERSION;
+		h.mHeaderSize = sizeof(file_header);
+
+		// Lay out the sections first so the header is complete before anything is written
+		uint64_t				pos = sizeof(file_header);
+		const size_t			counts[SECTION_COUNT] = { mPositions.size(), mNormals.size(), mIndices.size(), mTexCoords.size() };
+		for (int k=0; k<SECTION_COUNT; ++k) {
+			pos = align_up(pos);
+			h.mSection[k].mCount = static_cast<uint32_t>(counts[k]);
+			h.mSection[k].mOffset = (counts[k] > 0 ? static_cast<uint32_t>(pos) : 0);
+			pos += static_cast<uint64_t>(counts[k]) * STRIDE[k];
+		}
+		if (pos > 0xffffffffULL) {
+			DS_LOG_WARNING("MeshData::write() mesh too large for " << filename);
+			return false;
+		}
+		h.mFileSize = static_cast<uint32_t>(pos);
+
+		// Write beside and rename, so a reader never sees a partial file
+		const std::string		tmp(filename + ".tmp");
+		{
+			std::ofstream		os(tmp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!os.is_open()) return false;
+			os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+			uint64_t			written = sizeof(file_header);
+			if (!write_section(os, mPositions, written) || !write_section(os, mNormals, written)
+					|| !write_section(os, mIndices, written) || !write_section(os, mTexCoords, written)) {
+				return false;
+			}
+		}
+		Poco::File				dst(filename);
+		if (dst.exists()) dst.remove();
+		Poco::File(tmp).renameTo(filename);
+		return true;
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING("MeshData::write() failed on " << filename << " exception=" << ex.what());
+	}
+	return false;
+}
+
+bool MeshData::convert(const std::string& src, const std::string& dst) {
+	MeshData				data;
+	if (!data.load(src)) return false;
+	return data.write(dst);
+}
+
+ci::gl::VboMesh MeshData::createVbo() const {
+	if (empty()) return ci::gl::VboMesh();
+
+	const bool				normals = (mNormals.size() == mPositions.size()),
+							tex = (mTexCoords.size() == mPositions.size());
+	ci::gl::VboMesh::Layout	layout;
+	layout.setStaticIndices();
+	layout.setStaticPositions();
+	if (normals) layout.setStaticNormals();
+	if (tex) layout.setStaticTexCoords2d();
+
+	ci::gl::VboMesh			vbo(mPositions.size(), mIndices.size(), layout, GL_TRIANGLES);
+	vbo.bufferIndices(mIndices);
+	vbo.bufferPositions(mPositions);
+	if (normals) vbo.bufferNormals(mNormals);
+	if (tex) vbo.bufferTexCoords2d(0, mTexCoords);
+	return vbo;
+}
+
+size_t MeshData::getVboBytes() const {
+	size_t					bytes = mPositions.size() * sizeof(ci::Vec3f) + mIndices.size() * sizeof(uint32_t);
+	if (mNormals.size() == mPositions.size()) bytes += mNormals.size() * sizeof(ci::Vec3f);
+	if (mTexCoords.size() == mPositions.size()) bytes += mTexCoords.size() * sizeof(ci::Vec2f);
+	return bytes;
+}
+
+} // namespace ui
+} // namespace ds
@@ -0,0 +1,59 @@
+#pragma once
+#ifndef DS_UI_MESHSOURCE_MESHDATA_H_
+#define DS_UI_MESHSOURCE_MESHDATA_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <cinder/gl/Vbo.h>
+#include <cinder/Vector.h>
+
+namespace ds {
+namespace ui {
+
+/**
+ * \class ds::ui::MeshData
+ * \brief The CPU side of a mesh file. Loading is safe from any thread,
+ * so it can be done by a worker; only createVbo() needs the GL context.
+ *
+ * Files in the current format (.ds3d by convention) are a 64 byte header
+ * followed by the positions, normals, indices and texture coordinates, each
+ * 16 byte aligned, so they're mapped and copied out in one pass. Files in
+ * the old 0x1ee7ed format still load, and convert() rewrites them; the
+ * mesh_converter utility does the same from the command line.
+ */
+class MeshData {
+public:
+	static const uint32_t		FORMAT_VERSION = 1;
+
+	MeshData();
+
+	bool						empty() const;
+	void						clear();
+
+	// Answer false, and leave me empty, if the file is missing or malformed.
+	bool						load(const std::string& filename);
+	bool						write(const std::string& filename) const;
+	// Rewrite a mesh file, in either format, in the current format.
+	static bool					convert(const std::string& src, const std::string& dst);
+
+	// Must be called in the GL thread. Normals and texture coordinates are
+	// only used if there's one per vertex.
+	ci::gl::VboMesh				createVbo() const;
+	// Estimated video memory for the VBO.
+	size_t						getVboBytes() const;
+
+	std::vector<ci::Vec3f>		mPositions,
+								mNormals;
+	std::vector<uint32_t>		mIndices;
+	std::vector<ci::Vec2f>		mTexCoords;
+
+private:
+	bool						loadMapped(const std::string& filename);
+	bool						loadLegacy(const std::string& filename);
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_MESHSOURCE_MESHDATA_H_
@@ -1,5 +1,7 @@
 #include "mesh_file.h"
-#include "ds/ui/mesh_source/mesh_file_loader.h"
+#include "ds/ui/mesh_source/mesh_cache_service.h"
+#include "ds/ui/mesh_source/mesh_data.h"
+#include "ds/ui/sprite/sprite_engine.h"
 
 namespace ds {
 namespace ui {
@@ -20,7 +22,7 @@ public:
 
 	virtual const ci::gl::VboMesh*	getMesh() {
 		if (!mMeshBuilt) buildMesh();
-		if (mMesh.getNumIndices() < 1) return nullptr;
+		if (!mMesh || mMesh.getNumIndices() < 1) return nullptr;
 		return &mMesh;
 	}
 
@@ -30,58 +32,19 @@ public:
 
 private:
 	void						buildMesh() {
-		mMeshBuilt = true;
-		mMesh = ci::gl::VboMesh();
-		
-		ci::TriMesh							mesh;
-	
-		ds::ui::util::MeshFileLoader		loader;
-
-		// TODO: This should be cached somewhere, or maybe just discard it? 
-		// Eric, want to implement a caching layer?
-		loader.Load(mFilename);
-
-		// Convert ds::ui::util::MeshFile data into cinder::TriMesh data...
-		std::vector<uint32_t> indices;
-		std::vector<ci::Vec3f> normals;
-		std::vector<ci::Vec3f> vertices;
-		std::vector<ci::Vec2f> texCoords;
-
-		// Indices
-		for (size_t i=0; i<loader.mNumIndices; i++ ) {
-			indices.push_back( loader.mIndices[i] );
-		}
-		// Normals
-		for (size_t i=0; i<loader.mNumNorm; i++ ) {
-			normals.push_back(loader.mNorm[i]);
-		}
-		// Vertices
-		for (size_t i=0; i<loader.mNumVert; i++ ) {
-			vertices.push_back(loader.mVert[i]);
-		}
-		// Texture Coordinates
-		for (size_t i=0; i<loader.mNumTex; i++ ) {
-			texCoords.push_back(loader.mTex[i]);
+		if (mEngine) {
+			// Loads in the background; keep asking until it's there. A failed
+			// file keeps asking too -- the service decides when to retry it.
+			MeshCacheService&	s(mEngine->getService<ds::MeshCacheService>(ds::MESH_CACHE_SERVICE_NAME));
+			mMesh = s.getFile(mFilename);
+			mMeshBuilt = (mMesh ? true : false);
+			return;
 		}
 
-		// Populate the TriMesh
-		if ( indices.size() > 0 ) {
-			mesh.appendIndices( &indices[ 0 ], indices.size() );
-		}
-		if ( normals.size() > 0 ) {
-			for ( auto iter = normals.begin(); iter != normals.end(); ++iter ) {
-				mesh.appendNormal( *iter );
-			}
-		}
-		if ( vertices.size() > 0 ) {
-			mesh.appendVertices( &vertices[ 0 ], vertices.size() );
-		}
-		if ( texCoords.size() > 0 ) {
-			for ( auto iter = texCoords.begin(); iter != texCoords.end(); ++iter ) {
-				mesh.appendTexCoord( *iter );
-			}
-		}
-		mMesh = ci::gl::VboMesh(mesh);
+		// No engine, so no cache or worker. Load it here.
+		mMeshBuilt = true;
+		MeshData				data;
+		if (data.load(mFilename)) mMesh = data.createVbo();
 	}
 
 	ds::ui::SpriteEngine*	mEngine;
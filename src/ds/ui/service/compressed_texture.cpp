@@ -0,0 +1,521 @@
+#include "ds/ui/service/compressed_texture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <cinder/gl/gl.h>
+#include <Poco/DigestEngine.h>
+#include <Poco/File.h>
+#include <Poco/MD5Engine.h>
+#include <Poco/Path.h>
+#include "ds/app/environment.h"
+#include "ds/cfg/settings.h"
+#include "ds/debug/logger.h"
+#include "ds/util/string_util.h"
+
+namespace {
+const ds::BitMask	TEXTURE_CACHE_LOG_M = ds::Logger::newModule("texture_cache");
+
+// File layout: magic, version, format, width, height, level count, then
+// the byte size of each level, then each level's blocks back to back.
+const char			MAGIC[4] = { 'D', 'S', 'T', 'X' };
+const uint32_t		VERSION = 1;
+const uint32_t		FORMAT_DXT1 = 1;
+const uint32_t		FORMAT_DXT5 = 5;
+const size_t		HEADER_SIZE = 4 + 5 * 4;
+const std::string	EXTENSION("dstx");
+const int			DEFAULT_MAX_JOBS = 4;
+const int			DEFAULT_MAX_MB = 2048;
+
+// A tightly packed RGBA level of the mip chain
+struct rgba_image {
+	rgba_image() : mW(0), mH(0) { }
+	int						mW,
+							mH;
+	std::vector<uint8_t>	mPixels;
+};
+
+void				to_rgba(const ci::Surface8u& s, rgba_image& out) {
+	ci::Surface8u			src(s);
+	out.mW = src.getWidth();
+	out.mH = src.getHeight();
+	out.mPixels.resize(static_cast<size_t>(out.mW) * out.mH * 4);
+	const int				inc = src.getPixelInc();
+	const int				r = src.getRedOffset(), g = src.getGreenOffset(), b = src.getBlueOffset();
+	const int				a = (src.hasAlpha() ? src.getAlphaOffset() : -1);
+	for (int y=0; y<out.mH; ++y) {
+		const uint8_t*		sp = src.getData() + y * src.getRowBytes();
+		uint8_t*			dp = &out.mPixels[static_cast<size_t>(y) * out.mW * 4];
+		for (int x=0; x<out.mW; ++x) {
+			dp[0] = sp[r];
+			dp[1] = sp[g];
+			dp[2] = sp[b];
+			dp[3] = (a >= 0 ? sp[a] : 255);
+			sp += inc;
+			dp += 4;
+		}
+	}
+}
+
+bool				has_alpha(const rgba_image& img) {
+	for (size_t k=3; k<img.mPixels.size(); k+=4) {
+		if (img.mPixels[k] < 255) return true;
+	}
+	return false;
+}
+
+// Box filter down one level. Odd edges repeat the last row/column.
+void				half(const rgba_image& src, rgba_image& dst) {
+	dst.mW = std::max(1, src.mW / 2);
+	dst.mH = std::max(1, src.mH / 2);
+	dst.mPixels.resize(static_cast<size_t>(dst.mW) * dst.mH * 4);
+	for (int y=0; y<dst.mH; ++y) {
+		const int			y0 = std::min(y * 2, src.mH - 1), y1 = std::min(y * 2 + 1, src.mH - 1);
+		for (int x=0; x<dst.mW; ++x) {
+			const int		x0 = std::min(x * 2, src.mW - 1), x1 = std::min(x * 2 + 1, src.mW - 1);
+			const uint8_t*	p00 = &src.mPixels[(static_cast<size_t>(y0) * src.mW + x0) * 4];
+			const uint8_t*	p01 = &src.mPixels[(static_cast<size_t>(y0) * src.mW + x1) * 4];
+			const uint8_t*	p10 = &src.mPixels[(static_cast<size_t>(y1) * src.mW + x0) * 4];
+			const uint8_t*	p11 = &src.mPixels[(static_cast<size_t>(y1) * src.mW + x1) * 4];
+			uint8_t*		dp = &dst.mPixels[(static_cast<size_t>(y) * dst.mW + x) * 4];
+			for (int c=0; c<4; ++c) {
+				dp[c] = static_cast<uint8_t>((p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+			}
+		}
+	}
+}
+
+// Gather a 4x4 block, clamping at the image edge
+void				get_block(const rgba_image& img, const int bx, const int by, uint8_t* block) {
+	for (int y=0; y<4; ++y) {
+		const int			sy = std::min(by + y, img.mH - 1);
+		for (int x=0; x<4; ++x) {
+			const int		sx = std::min(bx + x, img.mW - 1);
+			memcpy(block + (y * 4 + x) * 4, &img.mPixels[(static_cast<size_t>(sy) * img.mW + sx) * 4], 4);
+		}
+	}
+}
+
+uint16_t			to_565(const int r, const int g, const int b) {
+	return static_cast<uint16_t>((((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) | ((b * 31 + 127) / 255));
+}
+
+void				from_565(const uint16_t c, int* out) {
+	const int				r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+	out[0] = (r << 3) | (r >> 2);
+	out[1] = (g << 2) | (g >> 4);
+	out[2] = (b << 3) | (b >> 2);
+}
+
+void				put_u16(uint8_t* out, const uint16_t v) {
+	out[0] = static_cast<uint8_t>(v & 0xff);
+	out[1] = static_cast<uint8_t>(v >> 8);
+}
+
+// DXT1 color block: endpoints from the inset bounding box, nearest palette entry per pixel.
+void				encode_color(const uint8_t* block, uint8_t* out) {
+	int						mn[3] = { 255, 255, 255 }, mx[3] = { 0, 0, 0 };
+	for (int k=0; k<16; ++k) {
+		for (int c=0; c<3; ++c) {
+			mn[c] = std::min(mn[c], static_cast<int>(block[k * 4 + c]));
+			mx[c] = std::max(mx[c], static_cast<int>(block[k * 4 + c]));
+		}
+	}
+	for (int c=0; c<3; ++c) {
+		const int			inset = (mx[c] - mn[c]) >> 4;
+		mn[c] += inset;
+		mx[c] -= inset;
+	}
+	uint16_t				c0 = to_565(mx[0], mx[1], mx[2]), c1 = to_565(mn[0], mn[1], mn[2]);
+	// c0 > c1 selects the four color (no transparency) mode
+	if (c0 < c1) std::swap(c0, c1);
+
+	uint32_t				indices = 0;
+	if (c0 != c1) {
+		int					pal[4][3];
+		from_565(c0, pal[0]);
+		from_565(c1, pal[1]);
+		for (int c=0; c<3; ++c) {
+			pal[2][c] = (2 * pal[0][c] + pal[1][c]) / 3;
+			pal[3][c] = (pal[0][c] + 2 * pal[1][c]) / 3;
+		}
+		for (int k=0; k<16; ++k) {
+			int				best = 0, best_d = 0x7fffffff;
+			for (int p=0; p<4; ++p) {
+				int			d = 0;
+				for (int c=0; c<3; ++c) {
+					const int	e = block[k * 4 + c] - pal[p][c];
+					d += e * e;
+				}
+				if (d < best_d) {
+					best_d = d;
+					best = p;
+				}
+			}
+			indices |= static_cast<uint32_t>(best) << (2 * k);
+		}
+	}
+	put_u16(out, c0);
+	put_u16(out + 2, c1);
+	put_u16(out + 4, static_cast<uint16_t>(indices & 0xffff));
+	put_u16(out + 6, static_cast<uint16_t>(indices >> 16));
+}
+
+// DXT5 alpha block, eight value mode with a0 = max, a1 = min
+void				encode_alpha(const uint8_t* block, uint8_t* out) {
+	int						mn = 255, mx = 0;
+	for (int k=0; k<16; ++k) {
+		mn = std::min(mn, static_cast<int>(block[k * 4 + 3]));
+		mx = std::max(mx, static_cast<int>(block[k * 4 + 3]));
+	}
+	out[0] = static_cast<uint8_t>(mx);
+	out[1] = static_cast<uint8_t>(mn);
+	uint64_t				bits = 0;
+	if (mx > mn) {
+		for (int k=0; k<16; ++k) {
+			// Steps down from the max; 0 and 7 are the endpoints, the rest interpolate
+			const int		t = ((mx - block[k * 4 + 3]) * 7 + (mx - mn) / 2) / (mx - mn);
+			const int		index = (t == 0 ? 0 : (t == 7 ? 1 : t + 1));
+			bits |= static_cast<uint64_t>(index) << (3 * k);
+		}
+	}
+	for (int k=0; k<6; ++k) out[2 + k] = static_cast<uint8_t>((bits >> (8 * k)) & 0xff);
+}
+
+void				encode(const rgba_image& img, const bool alpha, std::vector<uint8_t>& out) {
+	const int				bw = (img.mW + 3) / 4, bh = (img.mH + 3) / 4;
+	const size_t			block_size = (alpha ? 16 : 8);
+	out.resize(static_cast<size_t>(bw) * bh * block_size);
+	uint8_t					block[64];
+	uint8_t*				dp = out.data();
+	for (int by=0; by<bh; ++by) {
+		for (int bx=0; bx<bw; ++bx) {
+			get_block(img, bx * 4, by * 4, block);
+			if (alpha) {
+				encode_alpha(block, dp);
+				encode_color(block, dp + 8);
+			} else {
+				encode_color(block, dp);
+			}
+			dp += block_size;
+		}
+	}
+}
+
+void				write_u32(std::ostream& out, const uint32_t v) {
+	const char				b[4] = { static_cast<char>(v & 0xff), static_cast<char>((v >> 8) & 0xff),
+									 static_cast<char>((v >> 16) & 0xff), static_cast<char>((v >> 24) & 0xff) };
+	out.write(b, 4);
+}
+
+uint32_t			read_u32(const char* in) {
+	const unsigned char*	b = reinterpret_cast<const unsigned char*>(in);
+	return b[0] | (b[1] << 8) | (b[2] << 16) | (static_cast<uint32_t>(b[3]) << 24);
+}
+}
+
+namespace ds {
+namespace ui {
+
+/**
+ * \class ds::ui::CompressedTexture
+ */
+CompressedTexture::CompressedTexture()
+		: mFormat(0)
+		, mWidth(0)
+		, mHeight(0) {
+}
+
+bool CompressedTexture::empty() const {
+	return mLevels.empty();
+}
+
+void CompressedTexture::clear() {
+	Poco::SharedMemory().swap(mMemory);
+	mFormat = 0;
+	mWidth = 0;
+	mHeight = 0;
+	mLevels.clear();
+}
+
+size_t CompressedTexture::getBytes(const bool mipmap) const {
+	if (mLevels.empty()) return 0;
+	if (!mipmap) return mLevels.front().mSize;
+	size_t					bytes = 0;
+	for (auto it=mLevels.begin(), end=mLevels.end(); it!=end; ++it) bytes += it->mSize;
+	return bytes;
+}
+
+bool CompressedTexture::load(const std::string& path) {
+	clear();
+	try {
+		const Poco::File	file(path);
+		if (!file.exists() || file.getSize() < HEADER_SIZE) return false;
+
+		Poco::SharedMemory	mem(file, Poco::SharedMemory::AM_READ);
+		const char*			data = mem.begin();
+		const size_t		size = static_cast<size_t>(mem.end() - mem.begin());
+		if (memcmp(data, MAGIC, 4) != 0 || read_u32(data + 4) != VERSION) return false;
+
+		const uint32_t		format = read_u32(data + 8);
+		const int			w = static_cast<int>(read_u32(data + 12)), h = static_cast<int>(read_u32(data + 16));
+		const uint32_t		count = read_u32(data + 20);
+		if ((format != FORMAT_DXT1 && format != FORMAT_DXT5) || w < 1 || h < 1 || count < 1 || count > 32) return false;
+		if (size < HEADER_SIZE + count * 4) return false;
+
+		std::vector<level>	levels(count);
+		size_t				offset = HEADER_SIZE + count * 4;
+		for (uint32_t k=0; k<count; ++k) {
+			levels[k].mOffset = offset;
+			levels[k].mSize = read_u32(data + HEADER_SIZE + k * 4);
+			offset += levels[k].mSize;
+		}
+		// Truncated write
+		if (offset > size) return false;
+
+		mMemory.swap(mem);
+		mFormat = format;
+		mWidth = w;
+		mHeight = h;
+		mLevels.swap(levels);
+		return true;
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING_M("CompressedTexture::load() failed ex=" << ex.what() << " (file=" << path << ")", TEXTURE_CACHE_LOG_M);
+	}
+	clear();
+	return false;
+}
+
+ci::gl::Texture CompressedTexture::upload(const bool mipmap) const {
+	if (mLevels.empty()) return ci::gl::Texture();
+
+	GLuint					id = 0;
+	glGenTextures(1, &id);
+	if (id == 0) return ci::gl::Texture();
+
+	const GLenum			internal_format = (mFormat == FORMAT_DXT5 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT);
+	const int				count = (mipmap ? static_cast<int>(mLevels.size()) : 1);
+	const char*				data = mMemory.begin();
+	int						w = mWidth, h = mHeight;
+	glBindTexture(GL_TEXTURE_2D, id);
+	for (int k=0; k<count; ++k) {
+		const level&		l = mLevels[k];
+		glCompressedTexImage2D(GL_TEXTURE_2D, k, internal_format, w, h, 0, static_cast<GLsizei>(l.mSize), data + l.mOffset);
+		w = std::max(1, w / 2);
+		h = std::max(1, h / 2);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, count - 1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// The texture takes ownership of the id
+	return ci::gl::Texture(GL_TEXTURE_2D, id, mWidth, mHeight, false);
+}
+
+bool CompressedTexture::save(const std::string& path, const ci::Surface8u& s) {
+	if (!s || s.getWidth() < 1 || s.getHeight() < 1) return false;
+
+	const std::string		tmp_path(path + ".tmp");
+	try {
+		rgba_image			img;
+		to_rgba(s, img);
+		const bool			alpha = has_alpha(img);
+
+		std::vector<std::vector<uint8_t>>	levels;
+		while (true) {
+			levels.push_back(std::vector<uint8_t>());
+			encode(img, alpha, levels.back());
+			if (img.mW == 1 && img.mH == 1) break;
+			rgba_image		next;
+			half(img, next);
+			img.mPixels.swap(next.mPixels);
+			img.mW = next.mW;
+			img.mH = next.mH;
+		}
+
+		// Write to a temp file and move it into place, so a reader never sees a partial file.
+		{
+			std::ofstream	out(tmp_path.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+			if (!out.is_open()) return false;
+			out.write(MAGIC, 4);
+			write_u32(out, VERSION);
+			write_u32(out, (alpha ? FORMAT_DXT5 : FORMAT_DXT1));
+			write_u32(out, static_cast<uint32_t>(s.getWidth()));
+			write_u32(out, static_cast<uint32_t>(s.getHeight()));
+			write_u32(out, static_cast<uint32_t>(levels.size()));
+			for (auto it=levels.begin(), end=levels.end(); it!=end; ++it) write_u32(out, static_cast<uint32_t>(it->size()));
+			for (auto it=levels.begin(), end=levels.end(); it!=end; ++it) out.write(reinterpret_cast<const char*>(it->data()), it->size());
+			if (!out.good()) return false;
+		}
+		Poco::File(tmp_path).renameTo(path);
+		return true;
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING_M("CompressedTexture::save() failed ex=" << ex.what() << " (file=" << path << ")", TEXTURE_CACHE_LOG_M);
+	}
+	try {
+		Poco::File			tmp(tmp_path);
+		if (tmp.exists()) tmp.remove();
+	} catch (std::exception const&) {
+	}
+	return false;
+}
+
+/**
+ * \class ds::ui::CompressedTextureCache
+ */
+CompressedTextureCache::CompressedTextureCache()
+		: mEnabled(false)
+		, mFolder("%LOCAL%/cache/textures/") {
+}
+
+CompressedTextureCache::~CompressedTextureCache() {
+	{
+		Poco::Mutex::ScopedLock		l(mLoop.mMutex);
+		mLoop.mAbort = true;
+		mLoop.mCondition.signal();
+	}
+	try {
+		if (mThread.isRunning()) mThread.join();
+	} catch (std::exception&) {
+	}
+}
+
+void CompressedTextureCache::setup(const ds::cfg::Settings& settings) {
+	mEnabled = settings.getBool("image:compressed_cache", 0, false);
+	mFolder = settings.getText("image:compressed_cache_folder", 0, mFolder);
+	if (!mEnabled) return;
+
+	try {
+		Poco::Path					path(ds::Environment::expand(mFolder));
+		path.makeDirectory();
+		Poco::File(path).createDirectories();
+		mFolder = path.toString();
+		{
+			Poco::Mutex::ScopedLock	l(mLoop.mMutex);
+			mLoop.mMaxJobs = static_cast<size_t>(std::max(1, settings.getInt("image:compressed_cache_queue", 0, DEFAULT_MAX_JOBS)));
+			mLoop.mMaxBytes = static_cast<uint64_t>(std::max(0, settings.getInt("image:compressed_cache_mb", 0, DEFAULT_MAX_MB))) * 1024 * 1024;
+			mLoop.mFolder = mFolder;
+		}
+		if (!mThread.isRunning()) mThread.start(mLoop);
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING_M("CompressedTextureCache::setup() disabled, ex=" << ex.what(), TEXTURE_CACHE_LOG_M);
+		mEnabled = false;
+	}
+}
+
+std::string CompressedTextureCache::getPath(const std::string& filename, const std::string& ip_key, const std::string& ip_params) const {
+	if (!mEnabled) return "";
+
+	try {
+		const Poco::File			file(filename);
+		if (!file.exists()) return "";
+
+		Poco::MD5Engine				md5;
+		md5.update(filename);
+		md5.update("|");
+		md5.update(ds::value_to_string(file.getLastModified().epochMicroseconds()));
+		md5.update("|");
+		md5.update(ip_key);
+		md5.update("|");
+		md5.update(ip_params);
+
+		Poco::Path					path(mFolder);
+		path.setFileName(Poco::DigestEngine::digestToHex(md5.digest()) + "." + EXTENSION);
+		return path.toString();
+	} catch (std::exception const&) {
+	}
+	return "";
+}
+
+void CompressedTextureCache::transcode(const std::string& path, const ci::Surface8u& s) {
+	if (!mEnabled || path.empty() || !s) return;
+
+	try {
+		Poco::Mutex::ScopedLock		l(mLoop.mMutex);
+		for (auto it=mLoop.mJobs.begin(), end=mLoop.mJobs.end(); it!=end; ++it) {
+			if (it->first == path) return;
+		}
+		// Every job holds a decoded image, so don't let them pile up
+		if (mLoop.mJobs.size() >= mLoop.mMaxJobs) {
+			DS_LOG_INFO_M("CompressedTextureCache::transcode() queue full, skipped " << path, TEXTURE_CACHE_LOG_M);
+			return;
+		}
+		mLoop.mJobs.push_back(std::make_pair(path, s));
+		mLoop.mCondition.signal();
+	} catch (std::exception const&) {
+	}
+}
+
+/**
+ * \class ds::ui::CompressedTextureCache::Loop
+ */
+CompressedTextureCache::Loop::Loop()
+		: mAbort(false)
+		, mMaxJobs(DEFAULT_MAX_JOBS)
+		, mMaxBytes(0) {
+}
+
+void CompressedTextureCache::Loop::run() {
+	while (true) {
+		std::pair<std::string, ci::Surface8u>	job;
+		{
+			Poco::Mutex::ScopedLock	l(mMutex);
+			while (mJobs.empty() && !mAbort) mCondition.wait(mMutex);
+			if (mAbort) break;
+			job = mJobs.front();
+			mJobs.pop_front();
+		}
+
+		try {
+			if (Poco::File(job.first).exists()) continue;
+		} catch (std::exception const&) {
+			continue;
+		}
+		// Let the image go before the slow part of trimming
+		const std::string			path(job.first);
+		const bool					saved = CompressedTexture::save(path, job.second);
+		job.second = ci::Surface8u();
+		if (saved) {
+			DS_LOG_INFO_M("CompressedTextureCache wrote " << path, TEXTURE_CACHE_LOG_M);
+			trim();
+		}
+	}
+}
+
+void CompressedTextureCache::Loop::trim() {
+	if (mMaxBytes < 1) return;
+
+	try {
+		// A rescan is nothing next to a transcode, and it picks up files other apps wrote
+		std::vector<Poco::File>		files;
+		Poco::File(mFolder).list(files);
+		std::vector<std::pair<Poco::Timestamp, Poco::File>>
+									entries;
+		uint64_t					total = 0;
+		for (auto it=files.begin(), end=files.end(); it!=end; ++it) {
+			if (Poco::Path(it->path()).getExtension() != EXTENSION || !it->isFile()) continue;
+			total += static_cast<uint64_t>(it->getSize());
+			entries.push_back(std::make_pair(it->getLastModified(), *it));
+		}
+		if (total <= mMaxBytes) return;
+
+		std::sort(entries.begin(), entries.end(), [](const std::pair<Poco::Timestamp, Poco::File>& a, const std::pair<Poco::Timestamp, Poco::File>& b) { return a.first < b.first; });
+		for (auto it=entries.begin(), end=entries.end(); it!=end && total > mMaxBytes; ++it) {
+			try {
+				const uint64_t		size = static_cast<uint64_t>(it->second.getSize());
+				it->second.remove();
+				total -= size;
+			} catch (std::exception const&) {
+				// Most likely mapped by a loaded texture; try the next one
+			}
+		}
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING_M("CompressedTextureCache::trim() failed ex=" << ex.what(), TEXTURE_CACHE_LOG_M);
+	}
+}
+
+} // namespace ui
+} // namespace ds
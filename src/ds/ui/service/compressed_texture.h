@@ -0,0 +1,123 @@
+#pragma once
+#ifndef DS_UI_SERVICE_COMPRESSEDTEXTURE_H_
+#define DS_UI_SERVICE_COMPRESSEDTEXTURE_H_
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include <cinder/Surface.h>
+#include <cinder/gl/Texture.h>
+#include <Poco/Condition.h>
+#include <Poco/Mutex.h>
+#include <Poco/Runnable.h>
+#include <Poco/SharedMemory.h>
+#include <Poco/Thread.h>
+
+namespace ds {
+namespace cfg {
+class Settings;
+}
+namespace ui {
+
+/**
+ * \class ds::ui::CompressedTexture
+ * \brief A block compressed (DXT1 or DXT5) image with its full mip chain,
+ * as stored in the texture cache. Loading memory maps the file, and upload
+ * hands the mapped blocks straight to GL, so there's no decode or copy.
+ */
+class CompressedTexture {
+public:
+	CompressedTexture();
+
+	bool						empty() const;
+	void						clear();
+
+	int							getWidth() const	{ return mWidth; }
+	int							getHeight() const	{ return mHeight; }
+	// Bytes of texture memory for the levels that would be uploaded
+	size_t						getBytes(const bool mipmap) const;
+
+	// Map a cache file. Answer false if it's missing or not a valid file.
+	bool						load(const std::string& path);
+	// Must be called from the GL thread. Only uploads the top level unless mipmap is on.
+	ci::gl::Texture				upload(const bool mipmap) const;
+
+	// Build the mip chain, compress it and write it to path. Slow, call from a worker.
+	static bool					save(const std::string& path, const ci::Surface8u&);
+
+private:
+	struct level {
+		level() : mOffset(0), mSize(0) { }
+		size_t					mOffset,
+								mSize;
+	};
+
+	Poco::SharedMemory			mMemory;
+	uint32_t					mFormat;
+	int							mWidth,
+								mHeight;
+	std::vector<level>			mLevels;
+};
+
+/**
+ * \class ds::ui::CompressedTextureCache
+ * \brief Find and generate cached compressed textures. Files are keyed by
+ * the source path, its modification time and the image processing applied,
+ * so a changed file or a different ip function gets a fresh entry. Missing
+ * entries are queued to a background transcoder thread. Each queued job holds
+ * a full decoded image, so the queue is bounded; when it's full the transcode
+ * is skipped, and happens the next time the image is loaded. The folder is
+ * trimmed to its size limit after each write, oldest written first.
+ * Settings are read from engine.xml:
+ *	"image:compressed_cache" bool -- DEFAULT=false
+ *	"image:compressed_cache_folder" text -- DEFAULT=%LOCAL%/cache/textures/
+ *	"image:compressed_cache_queue" int -- most images waiting to transcode. DEFAULT=4
+ *	"image:compressed_cache_mb" int -- most megabytes kept on disk, 0 for no limit. DEFAULT=2048
+ */
+class CompressedTextureCache {
+public:
+	CompressedTextureCache();
+	~CompressedTextureCache();
+
+	void						setup(const ds::cfg::Settings&);
+	bool						isEnabled() const	{ return mEnabled; }
+
+	// Answer the cache file for the (expanded) filename, or an empty string if the source doesn't exist.
+	std::string					getPath(const std::string& filename, const std::string& ip_key, const std::string& ip_params) const;
+	// Queue a decoded image to be written to path, unless the queue is full. Safe from any thread.
+	void						transcode(const std::string& path, const ci::Surface8u&);
+
+private:
+	class Loop : public Poco::Runnable {
+	public:
+		Poco::Mutex				mMutex;
+		Poco::Condition			mCondition;
+		bool					mAbort;
+		std::deque<std::pair<std::string, ci::Surface8u>>
+								mJobs;
+		size_t					mMaxJobs;
+		// Only read on the loop thread once it's started
+		std::string				mFolder;
+		uint64_t				mMaxBytes;
+
+	public:
+		Loop();
+
+		virtual void			run();
+
+	private:
+		// Remove the oldest files until the folder fits mMaxBytes
+		void					trim();
+	};
+
+	bool						mEnabled;
+	std::string					mFolder;
+	Loop						mLoop;
+	Poco::Thread				mThread;
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_SERVICE_COMPRESSEDTEXTURE_H_
@@ -0,0 +1,218 @@
+#include "ds/ui/service/generated_image_service.h"
+
+#include <cstdio>
+#include <fstream>
+#include <Poco/File.h>
+#include "ds/app/environment.h"
+#include "ds/cfg/settings.h"
+#include "ds/debug/logger.h"
+#include "ds/ui/sprite/sprite_engine.h"
+#include "ds/util/string_util.h"
+
+#if defined( CINDER_MSW )
+#include <windows.h>
+#endif
+
+namespace ds {
+namespace ui {
+
+namespace {
+const std::string	_GENERATED_IMAGE_SERVICE("ds:generatedimg");
+
+// FNV-1a
+const uint64_t		HASH_BASIS = 14695981039346656037ULL;
+const uint64_t		HASH_PRIME = 1099511628211ULL;
+
+const std::string	RESOURCE_("resource:");
+
+// The file a "resource:" name is compiled into
+std::string			resource_file() {
+#if defined( CINDER_MSW )
+	wchar_t				buf[MAX_PATH];
+	const DWORD			len = GetModuleFileNameW(NULL, buf, MAX_PATH);
+	if (len > 0 && len < MAX_PATH) return ds::utf8_from_wstr(std::wstring(buf, len));
+#endif
+	return "";
+}
+
+// 'DSGI', little endian. Followed by the version, width and height, then RGBA rows.
+const uint32_t		MAGIC = 0x49475344;
+const uint32_t		FORMAT_VERSION = 1;
+}
+
+const std::string&	GENERATED_IMAGE_SERVICE(_GENERATED_IMAGE_SERVICE);
+
+/**
+ * \class ds::ui::GeneratedImageKey
+ */
+GeneratedImageKey::GeneratedImageKey(const std::string& type, const int version)
+		: mValue(HASH_BASIS) {
+	add(type);
+	add(&version, sizeof(version));
+}
+
+void GeneratedImageKey::add(const void* data, const size_t size) {
+	const unsigned char*	p = static_cast<const unsigned char*>(data);
+	for (size_t k=0; k<size; ++k) {
+		mValue ^= p[k];
+		mValue *= HASH_PRIME;
+	}
+}
+
+void GeneratedImageKey::add(const std::string& s) {
+	// Include the size so consecutive strings can't run together
+	const uint64_t			size = s.size();
+	add(&size, sizeof(size));
+	add(s.data(), s.size());
+}
+
+void GeneratedImageKey::addFile(const std::string& filename) {
+	add(filename);
+	const bool				resource = (filename.compare(0, RESOURCE_.length(), RESOURCE_) == 0);
+	try {
+		const std::string	path = (resource ? resource_file() : filename);
+		if (path.empty()) return;
+		Poco::File			f(path);
+		if (!f.exists()) return;
+		const int64_t		size = static_cast<int64_t>(f.getSize()),
+							modified = static_cast<int64_t>(f.getLastModified().epochMicroseconds());
+		add(&size, sizeof(size));
+		add(&modified, sizeof(modified));
+	} catch (std::exception const&) {
+	}
+}
+
+uint64_t GeneratedImageKey::getValue() const {
+	return mValue;
+}
+
+/**
+ * \class ds::ui::GeneratedImageService
+ */
+GeneratedImageService::GeneratedImageService(ds::ui::SpriteEngine& e)
+		: mEngine(e) {
+}
+
+void GeneratedImageService::start() {
+	setDiskCache(mEngine.getSettings("engine").getText("image:generated_cache", 0, ""));
+}
+
+void GeneratedImageService::setDiskCache(const std::string& folder) {
+	mFolder.clear();
+	if (folder.empty()) return;
+	try {
+		const std::string	path = ds::Environment::expand(folder);
+		Poco::File(path).createDirectories();
+		mFolder = path;
+		if (mFolder.back() != '/' && mFolder.back() != '\\') mFolder.append("/");
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING("GeneratedImageService can't create cache folder " << folder << " ex=" << ex.what());
+	}
+}
+
+ci::gl::Texture GeneratedImageService::acquire(const uint64_t key, const std::function<bool(ci::Surface8u&)>& generate_fn) {
+	auto f = mCache.find(key);
+	if (f != mCache.end()) {
+		f->second.mRefs++;
+		return f->second.mImg;
+	}
+	if (mFailed.find(key) != mFailed.end()) return ci::gl::Texture();
+
+	ci::gl::Texture			img;
+	try {
+		ci::Surface8u		s;
+		if (readDisk(key, s)) {
+			img = ci::gl::Texture(s);
+		} else if (generate_fn && generate_fn(s) && s) {
+			img = ci::gl::Texture(s);
+			if (img) writeDisk(key, s);
+		}
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING("GeneratedImageService::acquire() failed ex=" << ex.what());
+		img = ci::gl::Texture();
+	}
+	if (!img) {
+		mFailed.insert(key);
+		return img;
+	}
+
+	holder&					h = mCache[key];
+	h.mImg = img;
+	h.mRefs = 1;
+	return img;
+}
+
+void GeneratedImageService::release(const uint64_t key) {
+	auto f = mCache.find(key);
+	if (f == mCache.end()) return;
+	if (--(f->second.mRefs) <= 0) mCache.erase(f);
+}
+
+void GeneratedImageService::clear() {
+	mCache.clear();
+	mFailed.clear();
+}
+
+std::string GeneratedImageService::getDiskFile(const uint64_t key) const {
+	char					buf[32];
+	std::snprintf(buf, sizeof(buf), "%016llx.img", static_cast<unsigned long long>(key));
+	return mFolder + buf;
+}
+
+bool GeneratedImageService::readDisk(const uint64_t key, ci::Surface8u& s) const {
+	if (mFolder.empty()) return false;
+	std::ifstream			is(getDiskFile(key).c_str(), std::ios::in | std::ios::binary);
+	if (!is.is_open()) return false;
+
+	uint32_t				header[4] = { 0, 0, 0, 0 };
+	is.read(reinterpret_cast<char*>(header), sizeof(header));
+	if (!is.good() || header[0] != MAGIC || header[1] != FORMAT_VERSION) return false;
+	const int32_t			w = static_cast<int32_t>(header[2]),
+							h = static_cast<int32_t>(header[3]);
+	if (w < 1 || h < 1 || w > 16384 || h > 16384) return false;
+
+	ci::Surface8u			ans(w, h, true, ci::SurfaceConstraintsDefault());
+	if (!ans || ans.getWidth() != w || ans.getHeight() != h) return false;
+	const std::streamsize	row_bytes = static_cast<std::streamsize>(w) * 4;
+	for (int32_t y=0; y<h; ++y) {
+		is.read(reinterpret_cast<char*>(ans.getData() + y * ans.getRowBytes()), row_bytes);
+	}
+	if (!is.good()) return false;
+	s = ans;
+	return true;
+}
+
+void GeneratedImageService::writeDisk(const uint64_t key, const ci::Surface8u& s) const {
+	if (mFolder.empty() || !s.hasAlpha() || s.getPixelInc() != 4) return;
+	const std::string		fn(getDiskFile(key)),
+							tmp(fn + ".tmp");
+	try {
+		{
+			std::ofstream	os(tmp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!os.is_open()) return;
+			const uint32_t	header[4] = { MAGIC, FORMAT_VERSION, static_cast<uint32_t>(s.getWidth()), static_cast<uint32_t>(s.getHeight()) };
+			os.write(reinterpret_cast<const char*>(header), sizeof(header));
+			const std::streamsize	row_bytes = static_cast<std::streamsize>(s.getWidth()) * 4;
+			for (int32_t y=0; y<s.getHeight(); ++y) {
+				os.write(reinterpret_cast<const char*>(s.getData() + y * s.getRowBytes()), row_bytes);
+			}
+			if (!os.good()) return;
+		}
+		// Write beside and rename, so a reader never sees a partial file
+		Poco::File			dst(fn);
+		if (dst.exists()) dst.remove();
+		Poco::File(tmp).renameTo(fn);
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING("GeneratedImageService can't write " << fn << " ex=" << ex.what());
+	}
+}
+
+/**
+ * \class ds::ui::GeneratedImageService::holder
+ */
+GeneratedImageService::holder::holder()
+		: mRefs(0) {
+}
+
+} // namespace ui
+} // namespace ds
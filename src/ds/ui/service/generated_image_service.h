@@ -0,0 +1,92 @@
+#pragma once
+#ifndef DS_UI_SERVICE_GENERATEDIMAGESERVICE_H_
+#define DS_UI_SERVICE_GENERATEDIMAGESERVICE_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <cinder/Surface.h>
+#include <cinder/gl/Texture.h>
+#include "ds/app/engine/engine_service.h"
+
+namespace ds {
+namespace ui {
+class SpriteEngine;
+
+extern const std::string&	GENERATED_IMAGE_SERVICE;
+
+/**
+ * \class ds::ui::GeneratedImageKey
+ * \brief A content hash for a generated image: the generator type, every
+ * parameter that affects the pixels, and the state of any input files.
+ */
+class GeneratedImageKey {
+public:
+	// The version should be bumped whenever the generator's output changes.
+	GeneratedImageKey(const std::string& type, const int version);
+
+	void					add(const void* data, const size_t size);
+	void					add(const std::string&);
+	// Add the size and modified time of the file, so an edit changes the key.
+	// Compiled-in resources ("resource:name") add the executable they're
+	// compiled into, so a rebuild changes the key.
+	void					addFile(const std::string& filename);
+
+	uint64_t				getValue() const;
+
+private:
+	uint64_t				mValue;
+};
+
+/**
+ * \class ds::ui::GeneratedImageService
+ * \brief Share generated images between every source that asks for the same
+ * key. Each image is generated once and reference counted; it's freed when the
+ * last holder releases it. Optionally the generated pixels are also written
+ * to a disk cache, so later runs load them instead of generating.
+ * Settings are read from engine.xml:
+ *	"image:generated_cache" text -- disk cache folder, blank for none. DEFAULT=blank
+ */
+class GeneratedImageService : public ds::EngineService {
+public:
+	GeneratedImageService(ds::ui::SpriteEngine&);
+
+	virtual void			start();
+
+	// Blank turns off the disk cache.
+	void					setDiskCache(const std::string& folder);
+
+	// Answer the image for key, generating it into the surface if it's neither
+	// held nor on disk. Call release() for every non-empty answer. Main thread only.
+	ci::gl::Texture			acquire(const uint64_t key, const std::function<bool(ci::Surface8u&)>& generate_fn);
+	void					release(const uint64_t key);
+
+	void					clear();
+
+private:
+	struct holder {
+		holder();
+
+		ci::gl::Texture		mImg;
+		int					mRefs;
+	};
+
+	std::string				getDiskFile(const uint64_t key) const;
+	bool					readDisk(const uint64_t key, ci::Surface8u&) const;
+	void					writeDisk(const uint64_t key, const ci::Surface8u&) const;
+
+	ds::ui::SpriteEngine&	mEngine;
+	std::unordered_map<uint64_t, holder>
+							mCache;
+	// Keys that failed to generate, so they aren't tried for every instance
+	std::unordered_set<uint64_t>
+							mFailed;
+	std::string				mFolder;
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_SERVICE_GENERATEDIMAGESERVICE_H_
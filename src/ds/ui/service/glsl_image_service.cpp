@@ -64,6 +64,18 @@ void ImageKey::clear() {
 	mFlags = 0;
 }
 
+/* \class ds::glsl::ImageKeyHash
+ */
+size_t ImageKeyHash::operator()(const ImageKey& key) const {
+	std::hash<std::string>			str_hash;
+	size_t							h = str_hash(key.getVertex());
+	h = h * 31 + str_hash(key.getFragment());
+	h = h * 31 + static_cast<size_t>(key.getWidth());
+	h = h * 31 + static_cast<size_t>(key.getHeight());
+	h = h * 31 + static_cast<size_t>(key.getFlags());
+	return h;
+}
+
 /* \class ds::glsl::ImageToken
  */
 ImageToken::ImageToken(ImageService& srv)
@@ -129,8 +141,7 @@ bool ImageService::acquire(const ImageKey& key) {
 	// If there's no holder, then create one and get the process started.
 	if (!h) {
 		try {
-			mCache.push_back(holder(key));
-			h = &(mCache.back());
+			h = &(mCache[key] = holder(key));
 			{
 				Poco::Mutex::ScopedLock		l(mMutex);
 				mInput.push_back(op(key));
@@ -148,13 +159,12 @@ bool ImageService::acquire(const ImageKey& key) {
 }
 
 void ImageService::release(const ImageKey& key) {
-	int				index;
-	holder*			h = find(key, &index);
-	if (!h) return;
+	auto			f = mCache.find(key);
+	if (f == mCache.end()) return;
 	
-	h->mRefs--;
-	if (h->mRefs <= 0) {
-		mCache.erase(mCache.begin()+index);
+	f->second.mRefs--;
+	if (f->second.mRefs <= 0) {
+		mCache.erase(f);
 	}
 }
 
@@ -185,15 +195,10 @@ void ImageService::clear() {
 	mCache.clear();
 }
 
-ImageService::holder* ImageService::find(const ImageKey& key, int* index) {
-	for (int k=0; k<mCache.size(); ++k) {
-		holder&				h(mCache[k]);
-		if (h.mKey == key) {
-			if (index) *index = k;
-			return &h;
-		}
-	}
-	return nullptr;
+ImageService::holder* ImageService::find(const ImageKey& key) {
+	auto			f = mCache.find(key);
+	if (f == mCache.end()) return nullptr;
+	return &(f->second);
 }
 
 void ImageService::renderInput() {
@@ -32,6 +32,7 @@ public:
 	const std::string&		getFragment() const		{ return mFragment; }
 	int						getWidth() const		{ return mW; }
 	int						getHeight() const		{ return mH; }
+	int						getFlags() const		{ return mFlags; }
 	const gl::Uniform&		getUnifom() const		{ return mUniform; }
 
 	/**
@@ -56,6 +57,14 @@ private:
 	int						mFlags;
 };
 
+/* \class ds::glsl::ImageKeyHash
+ * \brief Hash the shaders, size and flags. Keys that only differ in their
+ * uniforms land in the same bucket and are told apart by operator==.
+ */
+struct ImageKeyHash {
+	size_t					operator()(const ImageKey&) const;
+};
+
 /* \class ds::glsl::ImageToken
  */
 class ImageToken {
@@ -127,14 +136,15 @@ public:
 	};
 
 private:
-	holder*					find(const ImageKey&, int* index = nullptr);
+	holder*					find(const ImageKey&);
 
 	// NOTE:  This is running in the main thread.  I think it has to.
 	void					renderInput();
 	void					renderInput(op&);
 
 	ds::ui::SpriteEngine&	mEngine;
-	std::vector<holder>		mCache;
+	std::unordered_map<ImageKey, holder, ImageKeyHash>
+							mCache;
 
 	Poco::Mutex				mMutex;
 	// Input and output stacks for thread processing
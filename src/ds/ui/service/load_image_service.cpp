@@ -1,8 +1,11 @@
 ﻿#include "ds/ui/service/load_image_service.h"
 
+#include <algorithm>
 #include <cinder/ImageIo.h>
 #include "ds/app/environment.h"
+#include "ds/cfg/settings.h"
 #include "ds/debug/debug_defines.h"
+#include "ds/debug/frame_profiler.h"
 #include "ds/debug/logger.h"
 #include "ds/ui/sprite/image.h"
 #include "Poco/File.h"
@@ -11,6 +14,14 @@ namespace {
 const ds::BitMask	LOAD_IMAGE_LOG_M = ds::Logger::newModule("load_image");
 // A mask of all the image flags that impact the key.
 const int			IMAGE_FLAGS_KEY_MASK(ds::ui::Image::IMG_CACHE_F);
+
+const size_t		BYTES_PER_MB = 1024 * 1024;
+
+// Drivers pad RGB out to 4 bytes a pixel, and a mip chain adds a third.
+size_t				texture_bytes(const ci::Surface8u& s, const bool mipmap) {
+	const size_t	bytes = static_cast<size_t>(s.getWidth()) * static_cast<size_t>(s.getHeight()) * 4;
+	return (mipmap ? bytes + bytes / 3 : bytes);
+}
 }
 
 namespace ds {
@@ -109,7 +120,11 @@ void ImageToken::init() {
  ******************************************************************/
 LoadImageService::LoadImageService(GlThread& t, ds::ui::ip::FunctionList& list)
 		: GlThreadClient<LoadImageService>(t)
-		, mFunctions(list) {
+		, mFunctions(list)
+		, mBudgetBytes(512 * BYTES_PER_MB)
+		, mResidentBytes(0)
+		, mUseClock(0)
+		, mEvictions(0) {
 	mInput.reserve(64);
 	mOutput.reserve(64);
 	mTmp.reserve(64);
@@ -121,8 +136,20 @@ LoadImageService::~LoadImageService()
 	clear();
 }
 
+void LoadImageService::setup(const ds::cfg::Settings& settings) {
+	const float	mb = settings.getFloat("image:texture_budget_mb", 0, static_cast<float>(mBudgetBytes / BYTES_PER_MB));
+	setTextureBudget(mb > 0.0f ? static_cast<size_t>(mb * static_cast<float>(BYTES_PER_MB)) : 0);
+	mTextureCache.setup(settings);
+}
+
+void LoadImageService::setTextureBudget(const size_t bytes) {
+	mBudgetBytes = bytes;
+	evict();
+}
+
 bool LoadImageService::acquire(const ImageKey& key, const int flags) {
 	holder&		h = mImageResource[key];
+	h.mLastUsed = ++mUseClock;
 	// We have to test multiple conditions here -- if our refs fall below 1 AND we have no
 	// current image, then we need to load one in.  But if the refs are > 0, then there's
 	// either an image or one's being loaded.  And if there's an image but the refs are < 1,
@@ -155,9 +182,11 @@ void LoadImageService::release(const ImageKey& key) {
 	if (it != mImageResource.end()) {
 		holder&		h = it->second;
 		h.mRefs--;
-		// If I'm caching this image, never release it
+		// If I'm caching this image, keep it until the budget needs the space
 		if ((h.mFlags&Image::IMG_CACHE_F) == 0 && h.mRefs <= 0) {
-			mImageResource.erase(key);
+			erase(it);
+		} else if (h.mRefs <= 0) {
+			evict();
 		}
 	} else {
 		DS_LOG_WARNING_M("LoadImageService::release() called on filename that doesn't exist (" << key.mFilename << ")", LOAD_IMAGE_LOG_M);
@@ -170,6 +199,7 @@ ci::gl::Texture LoadImageService::getImage(const ImageKey& key, float& fade) {
 
 	if (mImageResource.empty()) return ci::gl::Texture();
 	holder& h = mImageResource[key];
+	h.mLastUsed = ++mUseClock;
 	fade = 1;
 	return h.mTexture;
 }
@@ -197,35 +227,108 @@ bool LoadImageService::peekToken(const ImageKey& key, int* flags) const {
 
 void LoadImageService::update() {
 	Poco::Mutex::ScopedLock			l(mMutex);
+	if (mOutput.empty()) return;
+
+	DS_PROFILE_SCOPE("LoadImageService::update");
 	for (int k=0; k<mOutput.size(); k++) {
 		op&							out = mOutput[k];
-		holder&						h = mImageResource[out.mKey];
+		auto						found = mImageResource.find(out.mKey);
+		// Released before the load finished, nobody wants it anymore.
+		if (found == mImageResource.end()) {
+			out.clear();
+			continue;
+		}
+		holder&						h = found->second;
 		if(h.mTexture) {
 			DS_LOG_WARNING_M("Duplicate images for id=" << out.mKey.mFilename << " refs=" << h.mRefs, LOAD_IMAGE_LOG_M);
 		} else {
-			ci::gl::Texture::Format	fmt;
-			if ((h.mFlags&ds::ui::Image::IMG_ENABLE_MIPMAP_F) != 0) {
-				fmt.enableMipmapping(true);
-				fmt.setMinFilter(GL_LINEAR_MIPMAP_LINEAR);
+			const bool				mipmap = (h.mFlags&ds::ui::Image::IMG_ENABLE_MIPMAP_F) != 0;
+			size_t					bytes = 0;
+			if (!out.mCompressed.empty()) {
+				h.mTexture = out.mCompressed.upload(mipmap);
+				bytes = out.mCompressed.getBytes(mipmap);
+			} else {
+				ci::gl::Texture::Format	fmt;
+				if (mipmap) {
+					fmt.enableMipmapping(true);
+					fmt.setMinFilter(GL_LINEAR_MIPMAP_LINEAR);
+				}
+				h.mTexture = ci::gl::Texture(out.mSurface, fmt);
+				bytes = texture_bytes(out.mSurface, mipmap);
 			}
-			h.mTexture = ci::gl::Texture(out.mSurface, fmt);
 			if (glGetError() == GL_OUT_OF_MEMORY) {
 				DS_LOG_ERROR_M("LoadImageService::update() called on filename: " << out.mKey.mFilename << " received an out of memory error. Image may be too big.", LOAD_IMAGE_LOG_M);
 			}
 			DS_REPORT_GL_ERRORS();
+			if (h.mTexture) {
+				h.mBytes = bytes;
+				mResidentBytes += h.mBytes;
+			}
 		}
 		out.clear();
 	}
 	mOutput.clear();
+	evict();
 }
 
 void LoadImageService::clear()
 {
 	mImageResource.clear();
+	mResidentBytes = 0;
+}
+
+void LoadImageService::getStats(Stats& out) const {
+	out.mBudgetBytes = mBudgetBytes;
+	out.mResidentBytes = mResidentBytes;
+	out.mEvictions = mEvictions;
+	out.mImages.clear();
+	try {
+		out.mImages.reserve(mImageResource.size());
+		for (auto it=mImageResource.begin(), end=mImageResource.end(); it!=end; ++it) {
+			if (!it->second.mTexture) continue;
+			Stats::Image		img;
+			img.mFilename = it->first.mFilename;
+			img.mBytes = it->second.mBytes;
+			img.mRefs = it->second.mRefs;
+			img.mCached = (it->second.mFlags&Image::IMG_CACHE_F) != 0;
+			out.mImages.push_back(img);
+		}
+		std::sort(out.mImages.begin(), out.mImages.end(), [](const Stats::Image& a, const Stats::Image& b)->bool { return a.mBytes > b.mBytes; });
+	} catch (std::exception const&) {
+	}
+}
+
+void LoadImageService::evict() {
+	if (mBudgetBytes < 1 || mResidentBytes <= mBudgetBytes) return;
+
+	try {
+		std::vector<std::pair<int64_t, const ImageKey*>>	lru;
+		for (auto it=mImageResource.begin(), end=mImageResource.end(); it!=end; ++it) {
+			const holder&	h = it->second;
+			if (h.mRefs <= 0 && h.mTexture) lru.push_back(std::make_pair(h.mLastUsed, &it->first));
+		}
+		std::sort(lru.begin(), lru.end(), [](const std::pair<int64_t, const ImageKey*>& a, const std::pair<int64_t, const ImageKey*>& b)->bool { return a.first < b.first; });
+
+		for (auto it=lru.begin(), end=lru.end(); it!=end && mResidentBytes > mBudgetBytes; ++it) {
+			auto			found = mImageResource.find(*(it->second));
+			if (found == mImageResource.end()) continue;
+			DS_LOG_INFO_M("LoadImageService evicting " << found->first.mFilename << " (" << found->second.mBytes << " bytes)", LOAD_IMAGE_LOG_M);
+			erase(found);
+			++mEvictions;
+		}
+	} catch (std::exception const& ex) {
+		DS_LOG_WARNING_M("LoadImageService::evict() failed ex=" << ex.what(), LOAD_IMAGE_LOG_M);
+	}
+}
+
+void LoadImageService::erase(std::unordered_map<ImageKey, holder>::iterator it) {
+	mResidentBytes -= std::min(mResidentBytes, it->second.mBytes);
+	mImageResource.erase(it);
 }
 
 void LoadImageService::_load()
 {
+	DS_PROFILE_SCOPE("LoadImageService::_load");
 	// Pop off the items I need
 	mTmp.clear();
 	{
@@ -245,13 +348,21 @@ void LoadImageService::_load()
 			const std::string				fn = ds::Environment::expand(top.mKey.mFilename);
 			const Poco::File file(fn);
 			if (file.exists()) {
-				top.mSurface = ci::Surface8u(ci::loadImage(fn), ci::SurfaceConstraintsDefault(), alpha);
-				DS_REPORT_GL_ERRORS();
-				if (top.mSurface) {
-					top.mIpFunction.on(top.mKey.mIpParams, top.mSurface);
-					// This is to immediately place operations on the output...
+				// A hit in the compressed cache skips the decode entirely.
+				const std::string			cache_path = mTextureCache.getPath(fn, top.mKey.mIpKey, top.mKey.mIpParams);
+				if (!cache_path.empty() && top.mCompressed.load(cache_path)) {
 					Poco::Mutex::ScopedLock		l(mMutex);
 					mOutput.push_back(op(top));
+				} else {
+					top.mSurface = ci::Surface8u(ci::loadImage(fn), ci::SurfaceConstraintsDefault(), alpha);
+					DS_REPORT_GL_ERRORS();
+					if (top.mSurface) {
+						top.mIpFunction.on(top.mKey.mIpParams, top.mSurface);
+						if (!cache_path.empty()) mTextureCache.transcode(cache_path, top.mSurface);
+						// This is to immediately place operations on the output...
+						Poco::Mutex::ScopedLock		l(mMutex);
+						mOutput.push_back(op(top));
+					}
 				}
 			} else {
 				DS_LOG_WARNING_M("LoadImageService::_load() failed. File does not exist: " << top.mKey.mFilename, LOAD_IMAGE_LOG_M);
@@ -271,7 +382,24 @@ void LoadImageService::_load()
 LoadImageService::holder::holder()
 		: mRefs(0)
 		, mError(false)
-		, mFlags(0) {
+		, mFlags(0)
+		, mBytes(0)
+		, mLastUsed(0) {
+}
+
+/**
+ * \class ds::ui::LoadImageService::Stats
+ */
+LoadImageService::Stats::Stats()
+		: mBudgetBytes(0)
+		, mResidentBytes(0)
+		, mEvictions(0) {
+}
+
+LoadImageService::Stats::Image::Image()
+		: mBytes(0)
+		, mRefs(0)
+		, mCached(false) {
 }
 
 /**
@@ -294,6 +422,7 @@ LoadImageService::op::op(const ImageKey& key, const int flags, const ds::ui::ip:
 void LoadImageService::op::clear() {
 	mKey.clear();
 	mSurface.reset();
+	mCompressed.clear();
 	mFlags = 0;
 	mIpFunction.clear();
 }
@@ -2,6 +2,7 @@
 #ifndef DS_UI_SERVICE_LOADIMAGESERVICE_H_
 #define DS_UI_SERVICE_LOADIMAGESERVICE_H_
 
+#include <cstdint>
 #include <unordered_map>
 #include <vector>
 #include <cinder/Surface.h>
@@ -9,8 +10,12 @@
 #include "ds/app/engine/engine_service.h"
 #include "ds/thread/gl_thread.h"
 #include "ds/ui/ip/ip_function_list.h"
+#include "ds/ui/service/compressed_texture.h"
 
 namespace ds {
+namespace cfg {
+class Settings;
+}
 namespace ui {
 class LoadImageService;
 
@@ -97,12 +102,45 @@ private:
 /**
  * \class ds::ui::LoadImageService
  * \brief Manage and load images.
+ * Cached images (IMG_CACHE_F) are kept after their last release, but only
+ * while the texture memory stays under budget. Past that, the least recently
+ * used cached images with no references are dropped (they reload on demand).
+ * Optionally, images are also kept in an on-disk cache of compressed
+ * textures (see ds::ui::CompressedTextureCache), which skips the decode
+ * and uses a fraction of the memory on later loads.
+ * Settings are read from engine.xml:
+ *	"image:texture_budget_mb" float -- 0 for no limit. DEFAULT=512
  */
 class LoadImageService : public ds::GlThreadClient<LoadImageService> {
+public:
+	// A snapshot of texture memory use
+	class Stats {
+	public:
+		class Image {
+		public:
+			Image();
+			std::string			mFilename;
+			size_t				mBytes;
+			int					mRefs;
+			bool				mCached;
+		};
+
+		Stats();
+		size_t					mBudgetBytes,
+								mResidentBytes;
+		int64_t					mEvictions;
+		// Resident images, largest first
+		std::vector<Image>		mImages;
+	};
+
 public:
 	LoadImageService(GlThread&, ds::ui::ip::FunctionList&);
 	~LoadImageService();
 
+	void						setup(const ds::cfg::Settings&);
+	// In bytes. 0 turns off eviction.
+	void						setTextureBudget(const size_t);
+
 	// Clients should call release() for every successful acquire
 	bool						acquire(const ImageKey& key, const int flags);
 	void						release(const ImageKey& key);
@@ -116,6 +154,8 @@ public:
 	void						update();
 	void						clear();
 
+	void						getStats(Stats&) const;
+
 private:
 	// store a single image slot
 	struct holder {
@@ -125,6 +165,9 @@ private:
 		ci::gl::Texture			mTexture;
 		bool					mError;
 		int						mFlags;
+		// Estimated texture memory, and the last time it was asked for (in mUseClock ticks)
+		size_t					mBytes;
+		int64_t					mLastUsed;
 	};
 
 	// an op for loading images
@@ -139,18 +182,28 @@ private:
 // This seems to cause problems with garbled images
 //		ci::gl::Texture			mTexture;
 		ci::Surface8u			mSurface;
+		// Set instead of mSurface when the image came from the compressed cache
+		CompressedTexture		mCompressed;
 		int						mFlags;
 		ds::ui::ip::FunctionRef	mIpFunction;
 	};
 
 private:
 	void						_load();
+	// Drop unreferenced cached images, oldest first, until under budget
+	void						evict();
+	void						erase(std::unordered_map<ImageKey, holder>::iterator);
 
 	ds::ui::ip::FunctionList&	mFunctions;
 	// Hmm, had problems getting the hashing implemented for ImageKey
 //	std::unordered_map<ImageKey, holder>
 	std::unordered_map<ImageKey, holder>
 								mImageResource;
+	size_t						mBudgetBytes,
+								mResidentBytes;
+	int64_t						mUseClock,
+								mEvictions;
+	CompressedTextureCache		mTextureCache;
 
 	Poco::Mutex					mMutex;
 	// Input and output stacks for thread processing
@@ -2,6 +2,7 @@
 
 #include <cinder/ImageIo.h>
 #include "ds/debug/debug_defines.h"
+#include "ds/debug/frame_profiler.h"
 #include "ds/debug/logger.h"
 #include "ds/ui/sprite/image.h"
 #include "ds/ui/sprite/fbo/fbo.h"
@@ -127,6 +128,7 @@ void RenderTextService::start(std::unique_ptr<RenderTextWorker>& worker)
 
 void RenderTextService::update()
 {
+	DS_PROFILE_SCOPE("RenderTextService::update");
 	mMainThreadTmp.clear();
 	{
 		std::lock_guard<std::mutex> lock(mLock);
@@ -152,6 +154,7 @@ void RenderTextService::update()
 
 void RenderTextService::_run()
 {
+	DS_PROFILE_SCOPE("RenderTextService::_run");
 	// Pop off the items I need
 	mWorkerThreadTmp.clear();
 	{
@@ -0,0 +1,126 @@
+#include "ds/ui/sprite/idle_tracker.h"
+
+#include "ds/app/event_notifier.h"
+#include "ds/ui/sprite/sprite_engine.h"
+
+namespace ds {
+namespace ui {
+
+/**
+ * \class ds::ui::IdleEvent
+ */
+IdleEvent::IdleEvent(Sprite& s)
+		: mSprite(s) {
+}
+
+/**
+ * \class ds::ui::IdleTracker
+ */
+IdleTracker::IdleTracker(SpriteEngine& e)
+		: mEngine(e)
+		, mNextGeneration(0) {
+}
+
+void IdleTracker::set(Sprite& s, const double seconds) {
+	Entry&					e = mEntries[&s];
+	e.mIdleTime = seconds;
+	e.mStart = mEngine.getElapsedTimeSeconds();
+	e.mIdling = false;
+	// The new deadline might be earlier than the one in the heap, so retire that one
+	e.mGeneration = ++mNextGeneration;
+	schedule(&s, e);
+}
+
+void IdleTracker::remove(const Sprite& s) {
+	mEntries.erase(&s);
+}
+
+double IdleTracker::secondsToIdle(const Sprite& s) const {
+	auto					found = mEntries.find(&s);
+	if (found == mEntries.end()) return 0.0;
+	return found->second.mIdleTime - (mEngine.getElapsedTimeSeconds() - found->second.mStart);
+}
+
+bool IdleTracker::isIdling(const Sprite& s) const {
+	auto					found = mEntries.find(&s);
+	return found != mEntries.end() && found->second.mIdling;
+}
+
+void IdleTracker::startIdling(Sprite& s) {
+	auto					found = mEntries.find(&s);
+	if (found == mEntries.end() || found->second.mIdling) return;
+	found->second.mIdling = true;
+	mEngine.getNotifier().notify(IdleEvent(s));
+}
+
+void IdleTracker::reset(const Sprite& s) {
+	auto					found = mEntries.find(&s);
+	if (found == mEntries.end()) return;
+	Entry&					e = found->second;
+	e.mIdling = false;
+	e.mStart = mEngine.getElapsedTimeSeconds();
+	// An entry already in the heap is no later than the new expiry; update() pushes it back
+	if (!e.mScheduled) schedule(const_cast<Sprite*>(&s), e);
+}
+
+void IdleTracker::update() {
+	if (mDeadlines.empty()) return;
+	const double			now = mEngine.getElapsedTimeSeconds();
+	// One at a time, since a listener is free to reset, remove or delete sprites
+	while (!mDeadlines.empty() && mDeadlines.top().mExpiry < now) {
+		const Deadline		d = mDeadlines.top();
+		mDeadlines.pop();
+
+		auto				found = mEntries.find(d.mSprite);
+		if (found == mEntries.end() || found->second.mGeneration != d.mGeneration) continue;
+		Entry&				e = found->second;
+		e.mScheduled = false;
+		if (e.mIdling) continue;
+		if (e.mStart + e.mIdleTime >= now) {
+			schedule(d.mSprite, e);
+			continue;
+		}
+		e.mIdling = true;
+		mEngine.getNotifier().notify(IdleEvent(*d.mSprite));
+	}
+}
+
+size_t IdleTracker::size() const {
+	return mEntries.size();
+}
+
+size_t IdleTracker::pending() const {
+	return mDeadlines.size();
+}
+
+void IdleTracker::schedule(Sprite* s, Entry& e) {
+	mDeadlines.push(Deadline(e.mStart + e.mIdleTime, s, e.mGeneration));
+	e.mScheduled = true;
+}
+
+/**
+ * \class ds::ui::IdleTracker::Entry
+ */
+IdleTracker::Entry::Entry()
+		: mIdleTime(0.0)
+		, mStart(0.0)
+		, mIdling(false)
+		, mScheduled(false)
+		, mGeneration(0) {
+}
+
+/**
+ * \class ds::ui::IdleTracker::Deadline
+ */
+IdleTracker::Deadline::Deadline(const double expiry, Sprite* s, const uint32_t generation)
+		: mExpiry(expiry)
+		, mSprite(s)
+		, mGeneration(generation) {
+}
+
+bool IdleTracker::Deadline::operator>(const Deadline& o) const {
+	return mExpiry > o.mExpiry;
+}
+
+} // namespace ui
+} // namespace ds
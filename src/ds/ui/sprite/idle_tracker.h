@@ -0,0 +1,98 @@
+#pragma once
+#ifndef DS_UI_SPRITE_IDLETRACKER_H_
+#define DS_UI_SPRITE_IDLETRACKER_H_
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+#include "ds/app/event.h"
+
+namespace ds {
+namespace ui {
+class Sprite;
+class SpriteEngine;
+
+/**
+ * \class ds::ui::IdleEvent
+ * \brief Sent on the engine notifier when a sprite goes idle, either because
+ * its time ran out or because startIdling() was called.
+ */
+class IdleEvent : public ds::RegisteredEvent<IdleEvent> {
+public:
+	IdleEvent(Sprite&);
+
+	Sprite&						mSprite;
+};
+
+/**
+ * \class ds::ui::IdleTracker
+ * \brief Idle timing for the sprites that ask for it with setSecondBeforeIdle().
+ * Deadlines sit in a min-heap ordered by expiry, so a frame only looks at the
+ * earliest one, and sprites that never asked cost nothing. Resetting doesn't
+ * touch the heap: a reset only moves the deadline later, so when the old entry
+ * comes due it's pushed back to the real expiry. Anything that makes an entry
+ * wrong (a new idle time, clearing, the sprite going away) gives the sprite a
+ * new generation, and stale entries are dropped as they come off the heap.
+ */
+class IdleTracker {
+public:
+	IdleTracker(SpriteEngine&);
+
+	// Start tracking the sprite, or restart it with a new time.
+	void						set(Sprite&, const double seconds);
+	// Stop tracking the sprite. Safe for sprites that aren't tracked.
+	void						remove(const Sprite&);
+
+	// These all answer the untracked defaults (0, false, nothing) for sprites I don't know.
+	double						secondsToIdle(const Sprite&) const;
+	bool						isIdling(const Sprite&) const;
+	void						startIdling(Sprite&);
+	void						reset(const Sprite&);
+
+	// Send an IdleEvent for every sprite that's come due. The engine calls this once a frame.
+	void						update();
+
+	size_t						size() const;
+	// Deadlines in the heap, stale ones included
+	size_t						pending() const;
+
+private:
+	IdleTracker(const IdleTracker&);
+	IdleTracker&				operator=(const IdleTracker&);
+
+	class Entry {
+	public:
+		Entry();
+		double					mIdleTime,
+								mStart;
+		bool					mIdling;
+		// Whether a current-generation deadline is in the heap
+		bool					mScheduled;
+		uint32_t				mGeneration;
+	};
+
+	class Deadline {
+	public:
+		Deadline(const double expiry, Sprite*, const uint32_t generation);
+		bool					operator>(const Deadline&) const;
+		double					mExpiry;
+		Sprite*					mSprite;
+		uint32_t				mGeneration;
+	};
+
+	void						schedule(Sprite*, Entry&);
+
+	SpriteEngine&				mEngine;
+	std::unordered_map<const Sprite*, Entry>
+								mEntries;
+	std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>>
+								mDeadlines;
+	uint32_t					mNextGeneration;
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_SPRITE_IDLETRACKER_H_
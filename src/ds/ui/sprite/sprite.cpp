@@ -11,7 +11,9 @@
 #include "ds/math/math_defs.h"
 #include "ds/math/math_func.h"
 #include "ds/math/random.h"
+#include "ds/ui/sprite/idle_tracker.h"
 #include "ds/ui/sprite/sprite_engine.h"
+#include "ds/ui/sprite/util/sprite_pool.h"
 #include "ds/ui/tween/tweenline.h"
 #include "ds/util/string_util.h"
 #include "util/clip_plane.h"
@@ -68,6 +70,29 @@ const int           NO_REPLICATION_F	= (1<<6);
 const int           ROTATE_TOUCHES_F	= (1<<7);
 
 const ds::BitMask   SPRITE_LOG        = ds::Logger::newModule("sprite");
+
+// What getClippingBounds() answers for a sprite that has never clipped
+const ci::Rectf		EMPTY_CLIPPING_BOUNDS(0.0f, 0.0f, 0.0f, 0.0f);
+
+// The app folder is fixed once the app is running, so only build the path
+// the first time. Sprites are only made on the main thread.
+const std::string&	default_shader_folder() {
+	static const std::string	FOLDER(Environment::getAppFolder("data/shaders"));
+	return FOLDER;
+}
+
+// The axis-aligned box around a rect once it goes through m.
+ci::Rectf			transform_rect(const ci::Matrix44f& m, const ci::Rectf& r) {
+	const ci::Vec3f	a = m.transformPoint(ci::Vec3f(r.x1, r.y1, 0.0f)),
+					b = m.transformPoint(ci::Vec3f(r.x2, r.y1, 0.0f)),
+					c = m.transformPoint(ci::Vec3f(r.x2, r.y2, 0.0f)),
+					d = m.transformPoint(ci::Vec3f(r.x1, r.y2, 0.0f));
+	ci::Rectf		ans(a.x, a.y, a.x, a.y);
+	ans.include(b.xy());
+	ans.include(c.xy());
+	ans.include(d.xy());
+	return ans;
+}
 }
 
 void Sprite::installAsServer(ds::BlobRegistry& registry) {
@@ -86,15 +111,50 @@ void Sprite::handleBlobFromClient(ds::BlobReader& r) {
 	if(s) s->readFrom(r);
 }
 
+/**
+ * \class ds::ui::Sprite::Extra
+ */
+struct Sprite::Extra {
+	Extra(SpriteEngine& engine, Sprite& sprite)
+			: mTouchProcess(engine, sprite)
+			, mIdleTracked(false)
+			, mClippingBounds(0.0f, 0.0f, 0.0f, 0.0f)
+			, mClippingBoundsDirty(true) {
+	}
+
+	std::function<void(Sprite *, const TouchInfo &)> mProcessTouchInfoCallback;
+	std::function<void(Sprite *, const ci::Vec3f &)> mSwipeCallback;
+	std::function<bool(Sprite *, const TapInfo &)> mTapInfoCallback;
+	std::function<void(Sprite *, const ci::Vec3f &)> mTapCallback;
+	std::function<void(Sprite *, const ci::Vec3f &)> mDoubleTapCallback;
+	std::function<void(Sprite *, const DragDestinationInfo &)> mDragDestinationCallback;
+
+	// All touch processing happens in the process touch class
+	TouchProcess		mTouchProcess;
+	// Whether the engine's IdleTracker knows about me
+	bool				mIdleTracked;
+	// Transport uniform data to the shader
+	ds::gl::Uniform		mUniform;
+	// Only a clipping sprite, or a client that was sent bounds, has these
+	ci::Rectf			mClippingBounds;
+	bool				mClippingBoundsDirty;
+};
+
+void* Sprite::operator new(std::size_t size) {
+	return SpritePool::get().allocate(size);
+}
+
+void Sprite::operator delete(void* p, std::size_t size) {
+	SpritePool::get().deallocate(p, size);
+}
+
 Sprite::Sprite(SpriteEngine& engine, float width /*= 0.0f*/, float height /*= 0.0f*/)
 	: SpriteAnimatable(*this, engine)
 	, mEngine(engine)
 	, mId(ds::EMPTY_SPRITE_ID)
 	, mWidth(width)
 	, mHeight(height)
-	, mTouchProcess(engine, *this)
-	, mSpriteShader(Environment::getAppFolder("data/shaders"), "base")
-	, mIdleTimer(engine)
+	, mSpriteShader(default_shader_folder(), "base")
 	, mLastWidth(width)
 	, mLastHeight(height)
 	, mPerspective(false)
@@ -108,9 +168,7 @@ Sprite::Sprite(SpriteEngine& engine, const ds::sprite_id_t id, const bool perspe
 	: SpriteAnimatable(*this, engine)
 	, mEngine(engine)
 	, mId(ds::EMPTY_SPRITE_ID)
-	, mTouchProcess(engine, *this)
-	, mSpriteShader(Environment::getAppFolder("data/shaders"), "base")
-	, mIdleTimer(engine)
+	, mSpriteShader(default_shader_folder(), "base")
 	, mLastWidth(0)
 	, mLastHeight(0)
 	, mPerspective(perspective)
@@ -129,6 +187,7 @@ void Sprite::init(const ds::sprite_id_t id) {
 	mScale = ci::Vec3f(1.0f, 1.0f, 1.0f);
 	mUpdateTransform = true;
 	mParent = nullptr;
+	mSortedDirty = true;
 	mOpacity = 1.0f;
 	mColor = ci::Color(1.0f, 1.0f, 1.0f);
 	mMultiTouchEnabled = false;
@@ -146,6 +205,11 @@ void Sprite::init(const ds::sprite_id_t id) {
 	mDrawOpacity = 1.0f;
 	mDelayedCallCueRef = nullptr;
 	mHasDrawLocalClientPost = false;
+	mCullBounds.set(0.0f, 0.0f, 0.0f, 0.0f);
+	mCullSprites = 1;
+	mCullEmpty = true;
+	mCullUnbounded = false;
+	mCullBoundsDirty = true;
 
 	if(mEngine.getRotateTouchesDefault()){
 		setRotateTouches(true);
@@ -157,12 +221,11 @@ void Sprite::init(const ds::sprite_id_t id) {
 							  static_cast<float>(math::random()*0.5 + 0.5),
 							  static_cast<float>(math::random()*0.5 + 0.5),
 							  0.4f);
-	mClippingBounds.set(0.0f, 0.0f, 0.0f, 0.0f);
-	mClippingBoundsDirty = false;
 	dimensionalStateChanged();
 }
 
 Sprite::~Sprite() {
+	clearIdleTimer();
 	animStop();
 	cancelDelayedCall();
 
@@ -186,8 +249,6 @@ Sprite::~Sprite() {
 }
 
 void Sprite::updateClient(const UpdateParams &p) {
-	mIdleTimer.update();
-
 	if(mCheckBounds) {
 		updateCheckBounds();
 	}
@@ -198,9 +259,7 @@ void Sprite::updateClient(const UpdateParams &p) {
 }
 
 void Sprite::updateServer(const UpdateParams &p) {
-	mTouchProcess.update(p);
-
-	mIdleTimer.update();
+	if(mExtra) mExtra->mTouchProcess.update(p);
 
 	if(mCheckBounds) {
 		updateCheckBounds();
@@ -216,6 +275,17 @@ void Sprite::drawClient(const ci::Matrix44f &trans, const DrawParams &drawParams
 		return;
 	}
 
+	// Bounds from the last draw still hold if nothing under me has changed
+	const bool			cull = drawParams.mCull && drawParams.mCullRect.x2 > drawParams.mCullRect.x1
+								&& drawParams.mCullRect.y2 > drawParams.mCullRect.y1;
+	if(cull && !mCullBoundsDirty && !mCullUnbounded) {
+		if(mCullEmpty || !transform_rect(trans, mCullBounds).intersects(drawParams.mCullRect)) {
+			if(drawParams.mStats) drawParams.mStats->mCulled += mCullSprites;
+			return;
+		}
+	}
+	if(drawParams.mStats) ++drawParams.mStats->mDrawn;
+
 	if(!mSpriteShader.isValid()) {
 		mSpriteShader.loadShaders();
 	}
@@ -235,7 +305,7 @@ void Sprite::drawClient(const ci::Matrix44f &trans, const DrawParams &drawParams
 			shaderBase.uniform("tex0", 0);
 			shaderBase.uniform("useTexture", mUseShaderTexture);
 			shaderBase.uniform("preMultiply", premultiplyAlpha(mBlendMode));
-			mUniform.applyTo(shaderBase);
+			if(mExtra) mExtra->mUniform.applyTo(shaderBase);
 		}
 
 		mDrawOpacity = mOpacity*drawParams.mParentOpacity;
@@ -271,7 +341,7 @@ void Sprite::drawClient(const ci::Matrix44f &trans, const DrawParams &drawParams
 		}
 	} else {
 		makeSortedChildren();
-		for(auto it = mSortedTmp.begin(), it2 = mSortedTmp.end(); it != it2; ++it) {
+		for(auto it = mSortedChildren.begin(), it2 = mSortedChildren.end(); it != it2; ++it) {
 			(*it)->drawClient(totalTransformation, dParams);
 		}
 	}
@@ -293,7 +363,7 @@ void Sprite::drawClient(const ci::Matrix44f &trans, const DrawParams &drawParams
 			shaderBase.uniform("tex0", 0);
 			shaderBase.uniform("useTexture", mUseShaderTexture);
 			shaderBase.uniform("preMultiply", premultiplyAlpha(mBlendMode));
-			mUniform.applyTo(shaderBase);
+			if(mExtra) mExtra->mUniform.applyTo(shaderBase);
 		}
 
 		ci::gl::color(mColor.r, mColor.g, mColor.b, mDrawOpacity);
@@ -312,6 +382,10 @@ void Sprite::drawClient(const ci::Matrix44f &trans, const DrawParams &drawParams
 		}
 		ci::gl::popModelView();
 	}
+
+	if(cull && mCullBoundsDirty) {
+		updateCullBounds();
+	}
 }
 
 void Sprite::drawServer(const ci::Matrix44f &trans, const DrawParams &drawParams) {
@@ -353,7 +427,7 @@ void Sprite::drawServer(const ci::Matrix44f &trans, const DrawParams &drawParams
 		}
 	} else {
 		makeSortedChildren();
-		for(auto it = mSortedTmp.begin(), it2 = mSortedTmp.end(); it != it2; ++it) {
+		for(auto it = mSortedChildren.begin(), it2 = mSortedChildren.end(); it != it2; ++it) {
 			(*it)->drawServer(totalTransformation, drawParams);
 		}
 	}
@@ -378,6 +452,7 @@ bool Sprite::getInnerHit(const ci::Vec3f&) const {
 void Sprite::doSetPosition(const ci::Vec3f& pos) {
 	if (mPosition == pos) return;
 
+	if (mPosition.z != pos.z && mParent) mParent->markSortedDirty();
 	mPosition = pos;
 	mUpdateTransform = true;
 	mBoundsNeedChecking = true;
@@ -531,6 +606,8 @@ void Sprite::addChild(Sprite &child){
 	}
 
 	mChildren.push_back(&child);
+	markSortedDirty();
+	markCullDirty();
 	child.setParent(this);
 	child.setPerspective(mPerspective);
 	child.setDrawSorted(getDrawSorted());
@@ -547,6 +624,8 @@ void Sprite::removeChild(Sprite &child){
 
 	auto found = std::find(mChildren.begin(), mChildren.end(), &child);
 	if(found != mChildren.end()) mChildren.erase(found);
+	markSortedDirty();
+	markCullDirty();
 	if(child.getParent() == this) {
 		child.setParent(nullptr);
 		child.setPerspective(false);
@@ -592,6 +671,8 @@ void Sprite::clearChildren(){
 	if(mChildren.empty()) return;
 	auto tempList = mChildren;
 	mChildren.clear();
+	markSortedDirty();
+	markCullDirty();
 
 	for(auto it = tempList.begin(), it2 = tempList.end(); it != it2; ++it){
 		if(!(*it) || (*it)->getParent() != this)
@@ -782,7 +863,7 @@ float Sprite::getHeight() const {
 }
 
 void Sprite::enable(bool flag) {
-	mTouchProcess.clearTouches();
+	if(mExtra) mExtra->mTouchProcess.clearTouches();
 	setFlag(ENABLED_F, flag, FLAGS_DIRTY, mSpriteFlags);
 }
 
@@ -895,7 +976,7 @@ Sprite* Sprite::getHit(const ci::Vec3f &point) {
 	} else {
 		makeSortedChildren();
 		// picks happen in reverse sorted order (front to back)
-		for(auto it = mSortedTmp.rbegin(), it2 = mSortedTmp.rend(); it != it2; ++it)
+		for(auto it = mSortedChildren.rbegin(), it2 = mSortedChildren.rend(); it != it2; ++it)
 		{
 			Sprite *child = *it;
 			
@@ -921,7 +1002,7 @@ Sprite* Sprite::getPerspectiveHit(CameraPick& pick){
 
 	std::vector<ds::ui::Sprite*> candidates;
 
-	for(auto it = mSortedTmp.rbegin(), it2 = mSortedTmp.rend(); it != it2; ++it) {
+	for(auto it = mSortedChildren.rbegin(), it2 = mSortedChildren.rend(); it != it2; ++it) {
 		Sprite*		hit = (*it)->getPerspectiveHit(pick);
 		if(hit) {
 			candidates.push_back(hit);
@@ -1005,11 +1086,11 @@ Sprite* Sprite::getPerspectiveHit(CameraPick& pick){
 }
 
 void Sprite::setProcessTouchCallback(const std::function<void(Sprite *, const TouchInfo &)> &func){
-	mProcessTouchInfoCallback = func;
+	getExtra().mProcessTouchInfoCallback = func;
 }
 
 void Sprite::processTouchInfo(const TouchInfo &touchInfo) {
-	mTouchProcess.processTouchInfo(touchInfo);
+	getExtra().mTouchProcess.processTouchInfo(touchInfo);
 }
 
 void Sprite::move(const ci::Vec3f &delta) {
@@ -1060,61 +1141,61 @@ bool Sprite::hasMultiTouchConstraint( const BitMask &constraint ) const {
 }
 
 void Sprite::swipe(const ci::Vec3f &swipeVector){
-	if(mSwipeCallback)
-		mSwipeCallback(this, swipeVector);
+	if(mExtra && mExtra->mSwipeCallback)
+		mExtra->mSwipeCallback(this, swipeVector);
 }
 
 bool Sprite::hasDoubleTap() const{
-	if(mDoubleTapCallback){
+	if(mExtra && mExtra->mDoubleTapCallback){
 		return true;
 	}
 	return false;
 }
 
 bool Sprite::tapInfo(const TapInfo& ti){
-	if(mTapInfoCallback){
-		return mTapInfoCallback(this, ti);
+	if(mExtra && mExtra->mTapInfoCallback){
+		return mExtra->mTapInfoCallback(this, ti);
 	}
 	return false;
 }
 
 void Sprite::tap(const ci::Vec3f &tapPos){
-	if(mTapCallback){
-		mTapCallback(this, tapPos);
+	if(mExtra && mExtra->mTapCallback){
+		mExtra->mTapCallback(this, tapPos);
 	}
 }
 
 void Sprite::doubleTap(const ci::Vec3f &tapPos){
-	if(mDoubleTapCallback)
-		mDoubleTapCallback(this, tapPos);
+	if(mExtra && mExtra->mDoubleTapCallback)
+		mExtra->mDoubleTapCallback(this, tapPos);
 }
 
 bool Sprite::hasTap() const {
-	if(mTapCallback){
+	if(mExtra && mExtra->mTapCallback){
 		return true;
 	}
 	return false;
 }
 
 bool Sprite::hasTapInfo() const {
-	return mTapInfoCallback != nullptr;
+	return mExtra && mExtra->mTapInfoCallback != nullptr;
 }
 
 void Sprite::processTouchInfoCallback(const TouchInfo &touchInfo){
-	if(mProcessTouchInfoCallback)
-		mProcessTouchInfoCallback(this, touchInfo);
+	if(mExtra && mExtra->mProcessTouchInfoCallback)
+		mExtra->mProcessTouchInfoCallback(this, touchInfo);
 }
 
 void Sprite::setTapInfoCallback(const std::function<bool(Sprite *, const TapInfo &)> &func){
-	mTapInfoCallback = func;
+	getExtra().mTapInfoCallback = func;
 }
 
 void Sprite::setTapCallback(const std::function<void(Sprite *, const ci::Vec3f &)> &func){
-	mTapCallback = func;
+	getExtra().mTapCallback = func;
 }
 
 void Sprite::setDoubleTapCallback(const std::function<void(Sprite *, const ci::Vec3f &)> &func){
-	mDoubleTapCallback = func;
+	getExtra().mDoubleTapCallback = func;
 }
 
 void Sprite::enableMultiTouch(const BitMask &constraints){
@@ -1277,12 +1358,12 @@ Sprite *Sprite::getDragDestination() const{
 }
 
 void Sprite::setDragDestinationCallback(const std::function<void(Sprite *, const DragDestinationInfo &)> &func){
-	mDragDestinationCallback = func;
+	getExtra().mDragDestinationCallback = func;
 }
 
 void Sprite::dragDestination(Sprite *sprite, const DragDestinationInfo &dragInfo) {
-	if(mDragDestinationCallback)
-		mDragDestinationCallback(sprite, dragInfo);
+	if(mExtra && mExtra->mDragDestinationCallback)
+		mExtra->mDragDestinationCallback(sprite, dragInfo);
 }
 
 bool Sprite::isDirty() const {
@@ -1379,11 +1460,12 @@ void Sprite::writeAttributesTo(ds::DataBuffer &buf) {
 		buf.add(mBlendMode);
 	}
 	if (mDirty.has(CLIPPING_BOUNDS)) {
+		const ci::Rectf&	clip = (mExtra ? mExtra->mClippingBounds : EMPTY_CLIPPING_BOUNDS);
 		buf.add(CLIP_BOUNDS_ATT);
-		buf.add(mClippingBounds.getX1());
-		buf.add(mClippingBounds.getY1());
-		buf.add(mClippingBounds.getX2());
-		buf.add(mClippingBounds.getY2());
+		buf.add(clip.getX1());
+		buf.add(clip.getY1());
+		buf.add(clip.getX2());
+		buf.add(clip.getY2());
 	}
 	if (mDirty.has(SORTORDER_DIRTY)) {
 		// A flat list of ints, the first value is the number of ints
@@ -1420,6 +1502,7 @@ void Sprite::readAttributesFrom(ds::DataBuffer& buf) {
 			transformChanged = true;
 		} else if (id == FLAGS_ATT) {
 			mSpriteFlags = buf.read<int>();
+			markCullDirty();
 			// This is being read here because I do not want to introduce a
 			// new dirty state and the previous code already sets flag to false.
 			// This is a no-op if it's the same shader.
@@ -1430,9 +1513,11 @@ void Sprite::readAttributesFrom(ds::DataBuffer& buf) {
 			auto name = buf.read<std::string>();
 			mSpriteShader.setShaders(loc, name);
 		} else if (id == POSITION_ATT) {
+			const float		z = mPosition.z;
 			mPosition.x = buf.read<float>();
 			mPosition.y = buf.read<float>();
 			mPosition.z = buf.read<float>();
+			if (mPosition.z != z && mParent) mParent->markSortedDirty();
 			transformChanged = true;
 		} else if (id == CENTER_ATT) {
 			mCenter.x = buf.read<float>();
@@ -1457,7 +1542,7 @@ void Sprite::readAttributesFrom(ds::DataBuffer& buf) {
 			float y1 = buf.read<float>();
 			float x2 = buf.read<float>();
 			float y2 = buf.read<float>();
-			mClippingBounds.set(x1, y1, x2, y2);
+			getExtra().mClippingBounds.set(x1, y1, x2, y2);
 			markClippingDirty();
 		} else if (id == SORTORDER_ATT) {
 			int32_t						size = buf.read<int32_t>();
@@ -1498,6 +1583,9 @@ void Sprite::setFlag(const int newBit, const bool on, const DirtyState& dirty, i
 	else newFlags &= ~newBit;
 	if(newFlags == oldFlags) return;
 
+	if(&oldFlags == &mSpriteFlags && ((newFlags^oldFlags)&(VISIBLE_F|TRANSPARENT_F)) != 0) {
+		markCullDirty();
+	}
 	oldFlags = newFlags;
 	markAsDirty(dirty);
 }
@@ -1577,11 +1665,13 @@ bool Sprite::getClipping() const {
 
 const ci::Rectf& Sprite::getClippingBounds()
 {
-	if(mClippingBoundsDirty) {
-		mClippingBoundsDirty = false;
+	if(!mExtra && !getClipping()) return EMPTY_CLIPPING_BOUNDS;
+	Extra&			extra = getExtra();
+	if(extra.mClippingBoundsDirty) {
+		extra.mClippingBoundsDirty = false;
 		computeClippingBounds();
 	}
-	return mClippingBounds;
+	return extra.mClippingBounds;
 }
 
 void Sprite::computeClippingBounds(){
@@ -1600,10 +1690,11 @@ void Sprite::computeClippingBounds(){
 			curSprite = curSprite->mParent;
 		}
 
-		float old_l = mClippingBounds.getX1();
-		float old_r = mClippingBounds.getX2();
-		float old_t = mClippingBounds.getY1();
-		float old_b = mClippingBounds.getY2();
+		ci::Rectf& clippingBounds = getExtra().mClippingBounds;
+		float old_l = clippingBounds.getX1();
+		float old_r = clippingBounds.getX2();
+		float old_t = clippingBounds.getY1();
+		float old_b = clippingBounds.getY2();
 
 		if(outerClippedSprite) {
 			curSprite = mParent;
@@ -1639,7 +1730,7 @@ void Sprite::computeClippingBounds(){
 		}
 
 		if(!math::isEqual(old_l, l) || !math::isEqual(old_r, r) || !math::isEqual(old_t, t) || !math::isEqual(old_b, b)) {
-			mClippingBounds.set(l, t, r, b);
+			clippingBounds.set(l, t, r, b);
 			markAsDirty(CLIPPING_BOUNDS);
 		}
 	}
@@ -1647,6 +1738,7 @@ void Sprite::computeClippingBounds(){
 
 void Sprite::dimensionalStateChanged(){
 	markClippingDirty();
+	markCullDirty();
 	if(mLastWidth != mWidth || mLastHeight != mHeight) {
 		mLastWidth = mWidth;
 		mLastHeight = mHeight;
@@ -1654,8 +1746,51 @@ void Sprite::dimensionalStateChanged(){
 	}
 }
 
+void Sprite::markCullDirty(){
+	mCullBoundsDirty = true;
+	// A dirty ancestor already has dirty ancestors, unless it's hidden, and
+	// showing it marks upwards again.
+	for(Sprite* s = mParent; s && !s->mCullBoundsDirty; s = s->mParent) {
+		s->mCullBoundsDirty = true;
+	}
+}
+
+void Sprite::updateCullBounds(){
+	mCullBoundsDirty = false;
+	mCullUnbounded = false;
+	mCullEmpty = true;
+	mCullSprites = 1;
+
+	// Gather in my space, then take it to my parent's
+	ci::Rectf			local(0.0f, 0.0f, 0.0f, 0.0f);
+	if((mSpriteFlags&TRANSPARENT_F) == 0) {
+		// Whatever draws with no size could be drawing anywhere
+		if(mWidth <= 0.0f || mHeight <= 0.0f) mCullUnbounded = true;
+		else {
+			local.set(0.0f, 0.0f, mWidth, mHeight);
+			mCullEmpty = false;
+		}
+	}
+	for(auto it = mChildren.begin(), end = mChildren.end(); it != end; ++it) {
+		const Sprite*	child = *it;
+		if(!child || !child->visible()) continue;
+		// A child that wasn't drawn through here (or can't be bounded) leaves me unbounded
+		if(child->mCullBoundsDirty || child->mCullUnbounded) {
+			mCullUnbounded = true;
+			continue;
+		}
+		mCullSprites += child->mCullSprites;
+		if(child->mCullEmpty) continue;
+		if(mCullEmpty) local = child->mCullBounds;
+		else local.include(child->mCullBounds);
+		mCullEmpty = false;
+	}
+	if(!mCullEmpty) mCullBounds = transform_rect(mTransformation, local);
+}
+
 void Sprite::markClippingDirty(){
-	mClippingBoundsDirty = true;
+	// Sprites without bounds start out dirty when they get them
+	if(mExtra) mExtra->mClippingBoundsDirty = true;
 	for(auto it = mChildren.begin(), end = mChildren.end(); it != end; ++it) {
 		Sprite*     s = *it;
 		if(s) s->markClippingDirty();
@@ -1663,34 +1798,47 @@ void Sprite::markClippingDirty(){
 }
 
 void Sprite::makeSortedChildren() {
-	mSortedTmp = mChildren;
-	std::sort( mSortedTmp.begin(), mSortedTmp.end(), [](Sprite *i, Sprite *j) {
+	if (!mSortedDirty) return;
+
+	mSortedChildren.assign(mChildren.begin(), mChildren.end());
+	std::stable_sort( mSortedChildren.begin(), mSortedChildren.end(), [](Sprite *i, Sprite *j) {
 		return i->getPosition().z < j->getPosition().z;
 	});
+	mSortedDirty = false;
+}
+
+void Sprite::markSortedDirty() {
+	mSortedDirty = true;
 }
 
 void Sprite::setSecondBeforeIdle( const double idleTime ) {
-	mIdleTimer.setSecondBeforeIdle(idleTime);
+	getExtra().mIdleTracked = true;
+	mEngine.getIdleTracker().set(*this, idleTime);
 }
 
 double Sprite::secondsToIdle() const {
-	return mIdleTimer.secondsToIdle();
+	// A timer that was never set up answers 0 and never idles
+	if(!mExtra || !mExtra->mIdleTracked) return 0.0;
+	return mEngine.getIdleTracker().secondsToIdle(*this);
 }
 
 bool Sprite::isIdling() const {
-	return mIdleTimer.isIdling();
+	if(!mExtra || !mExtra->mIdleTracked) return false;
+	return mEngine.getIdleTracker().isIdling(*this);
 }
 
 void Sprite::startIdling() {
-	mIdleTimer.startIdling();
+	if(mExtra && mExtra->mIdleTracked) mEngine.getIdleTracker().startIdling(*this);
 }
 
 void Sprite::resetIdleTimer() {
-	mIdleTimer.resetIdleTimer();
+	if(mExtra && mExtra->mIdleTracked) mEngine.getIdleTracker().reset(*this);
 }
 
 void Sprite::clearIdleTimer() {
-	mIdleTimer.clear();
+	if(!mExtra || !mExtra->mIdleTracked) return;
+	mExtra->mIdleTracked = false;
+	mEngine.getIdleTracker().remove(*this);
 }
 
 void Sprite::setNoReplicationOptimization(const bool on) {
@@ -1728,6 +1876,7 @@ void Sprite::sendSpriteToFront(Sprite &sprite) {
 
 	mChildren.erase(found);
 	mChildren.push_back(&sprite);
+	markSortedDirty();
 
 	markAsDirty(SORTORDER_DIRTY);
 }
@@ -1739,6 +1888,7 @@ void Sprite::sendSpriteToBack(Sprite &sprite) {
 
 	mChildren.erase(found);
 	mChildren.insert(mChildren.begin(), &sprite);
+	markSortedDirty();
 
 	markAsDirty(SORTORDER_DIRTY);
 }
@@ -1765,6 +1915,7 @@ void Sprite::setSpriteOrder(const std::vector<sprite_id_t> &order) {
 			mChildren.push_back(s);
 		}
 	}
+	markSortedDirty();
 }
 
 ds::ui::SpriteShader &Sprite::getBaseShader() {
@@ -1784,11 +1935,11 @@ float Sprite::getScaleDepth() const {
 }
 
 void Sprite::setSwipeCallback( const std::function<void (Sprite *, const ci::Vec3f &)> &func ) {
-	mSwipeCallback = func;
+	getExtra().mSwipeCallback = func;
 }
 
 bool Sprite::hasTouches() const {
-	return mTouchProcess.hasTouches();
+	return mExtra && mExtra->mTouchProcess.hasTouches();
 }
 
 void Sprite::passTouchToSprite( Sprite *destinationSprite, const TouchInfo &touchInfo ) {
@@ -1869,7 +2020,12 @@ void Sprite::readClientFrom(ds::DataBuffer& buf){
 
 
 ds::gl::Uniform& Sprite::getUniform(){
-	return mUniform;
+	return getExtra().mUniform;
+}
+
+Sprite::Extra& Sprite::getExtra() {
+	if(!mExtra) mExtra.reset(new Extra(mEngine, *this));
+	return *mExtra;
 }
 
 #ifdef _DEBUG
@@ -1895,11 +2051,11 @@ void			write_matrix44f(const ci::Matrix44f &m, std::ostream &s) {
 
 void Sprite::writeState(std::ostream &s, const size_t tab) const {
 	for (size_t k=0; k<tab; ++k) s << "\t";
-	s << "ID=" << mId << " flags=" << mSpriteFlags << " pos=" << mPosition << " size=[" << mWidth << "x" << mHeight << "x" << mDepth << "] scale=" << mScale << " cen=" << mCenter << " rot=" << mRotation << " clip=" << mClippingBounds << std::endl;
+	s << "ID=" << mId << " flags=" << mSpriteFlags << " pos=" << mPosition << " size=[" << mWidth << "x" << mHeight << "x" << mDepth << "] scale=" << mScale << " cen=" << mCenter << " rot=" << mRotation << " clip=" << (mExtra ? mExtra->mClippingBounds : EMPTY_CLIPPING_BOUNDS) << std::endl;
 	for (size_t k=0; k<tab+2; ++k) s << "\t";
 	s << "STATE opacity=" << mOpacity << " use_shader=" << mUseShaderTexture << " use_depthbuffer=" << mUseDepthBuffer << " last_w=" << mLastWidth << " last_h=" << mLastHeight << std::endl;
 	for (size_t k=0; k<tab+2; ++k) s << "\t";
-	s << "STATE need_bounds_check=" << mBoundsNeedChecking << " in_bounds=" << mInBounds << " check_bounds=" << mCheckBounds << " clip_dirty=" << mClippingBoundsDirty << " update_transform=" << mUpdateTransform << std::endl;
+	s << "STATE need_bounds_check=" << mBoundsNeedChecking << " in_bounds=" << mInBounds << " check_bounds=" << mCheckBounds << " clip_dirty=" << (mExtra && mExtra->mClippingBoundsDirty) << " update_transform=" << mUpdateTransform << std::endl;
 	// Transform
 	for (size_t k=0; k<tab+2; ++k) s << "\t";
 	s << "STATE transform=";
@@ -10,6 +10,7 @@
 // STL includes
 #include <list>
 #include <exception>
+#include <memory>
 // DS includes
 #include "ds/app/app_defs.h"
 #include "ds/data/user_data.h"
@@ -21,10 +22,10 @@
 #include "ds/ui/tween/sprite_anim.h"
 #include "ds/ui/sprite/shader/sprite_shader.h"
 #include "ds/ui/sprite/util/blend.h"
-#include "ds/util/idle_timer.h"
 #include "ds/debug/debug_defines.h"
 
 namespace ds {
+class Benchmark;
 class BlobReader;
 class BlobRegistry;
 class CameraPick;
@@ -33,8 +34,13 @@ class DrawParams;
 class Engine;
 class EngineRoot;
 class Event;
+class GeometricPicking;
 class UpdateParams;
 
+namespace test {
+class SpriteAccess;
+} // namespace test
+
 namespace ui {
 	class SpriteEngine;
 	struct DragDestinationInfo;
@@ -83,6 +89,11 @@ namespace ui {
 		Sprite(SpriteEngine& engine, float width = 0.0f, float height = 0.0f);
 		virtual ~Sprite();
 
+		/** Sprites (and subclasses) come from the SpritePool, not the general heap.
+			The size passed to delete is the size of the most derived class, since the destructor is virtual.		*/
+		static void*			operator new(std::size_t);
+		static void				operator delete(void*, std::size_t);
+
 		/** Update function for when this app is set to be a client.
 			Sprite behaviour can vary whether this is running on the server or client, and you can hook into that here.
 			\param updateParams UpdateParams containing some conveniences such as delta time.		*/
@@ -560,6 +571,8 @@ namespace ui {
 		bool					getClipping() const;
 
 		virtual void			userInputReceived();
+		/** Idle timing is opt-in: nothing is tracked until setSecondBeforeIdle() is called.
+			The engine's IdleTracker sends an ds::ui::IdleEvent when the time runs out.		*/
 		void					setSecondBeforeIdle(const double);
 		double					secondsToIdle() const;
 		bool					isIdling() const;
@@ -699,6 +712,8 @@ namespace ui {
 			mHeight,
 			mDepth;
 
+		// The transforms stay here rather than in Extra: every sprite needs them
+		// to draw, pick and cull, so moving them out would only add a lookup.
 		mutable ci::Matrix44f	mTransformation;
 		mutable ci::Matrix44f	mInverseTransform;
 		mutable bool			mUpdateTransform;
@@ -711,8 +726,7 @@ namespace ui {
 		float				mZLevel;
 		float				mOpacity;
 		ci::Color			mColor;
-		ci::Rectf			mClippingBounds;
-		bool				mClippingBoundsDirty;
+		// Bound on every draw, so every sprite that draws has one.
 		SpriteShader		mSpriteShader;
 
 		mutable ci::Matrix44f	mGlobalTransform;
@@ -722,9 +736,11 @@ namespace ui {
 
 		Sprite*					mParent;
 		std::vector<Sprite *>	mChildren;
-		// A cache for when I need to sort my children. This could be
-		// a lot more efficient, only running the sort when Z changes.
-		std::vector<Sprite*>	mSortedTmp;
+		// My children in z order (ties keep child order). Only rebuilt when
+		// mSortedDirty is set, by a child being added, removed, reordered or
+		// changing its z.
+		std::vector<Sprite*>	mSortedChildren;
+		bool					mSortedDirty;
 
 		bool					mHasDrawLocalClientPost;
 
@@ -732,23 +748,12 @@ namespace ui {
 		char				mBlobType;
 		DirtyState			mDirty;
 
-		std::function<void(Sprite *, const TouchInfo &)> mProcessTouchInfoCallback;
-		std::function<void(Sprite *, const ci::Vec3f &)> mSwipeCallback;
-		std::function<bool(Sprite *, const TapInfo &)> mTapInfoCallback;
-		std::function<void(Sprite *, const ci::Vec3f &)> mTapCallback;
-		std::function<void(Sprite *, const ci::Vec3f &)> mDoubleTapCallback;
-		std::function<void(Sprite *, const DragDestinationInfo &)> mDragDestinationCallback;
-
 		bool				mMultiTouchEnabled;
 		BitMask				mMultiTouchConstraints;
 		bool				mTouchScaleSizeMode;
 
-		// All touch processing happens in the process touch class
-		TouchProcess		mTouchProcess;
-
 		bool				mCheckBounds;
 		Sprite*				mDragDestination;
-		IdleTimer			mIdleTimer;
 		bool				mUseDepthBuffer;
 		float				mCornerRadius;
 		// For clients that do their own drawing -- this is the current parent * me opacity.
@@ -756,15 +761,39 @@ namespace ui {
 		// \see Sprite::getDrawOpacity()
 		float				mDrawOpacity;
 
-		// Transport uniform data to the shader
-		ds::gl::Uniform		mUniform;
-
 	private:
+		// State most sprites never touch: the touch callbacks and touch
+		// processing, idle tracking, the shader uniforms and the clipping
+		// bounds. Made the first time something asks for it, so a plain
+		// layout sprite doesn't carry it.
+		struct Extra;
+		Extra&					getExtra();
+		std::unique_ptr<Extra>	mExtra;
+
+		// My bounds and everything drawn under me, in my parent's space, as
+		// of the last culled draw, and how many sprites that covers. Dirty
+		// when anything in the subtree moves, resizes, shows, hides or gains or
+		// loses a child. Unbounded when something opaque has no size, so
+		// there's no telling where it draws.
+		ci::Rectf				mCullBounds;
+		size_t					mCullSprites;
+		bool					mCullEmpty,
+								mCullUnbounded,
+								mCullBoundsDirty;
+		// Mark me and my ancestors for new cull bounds.
+		void					markCullDirty();
+		// Rebuild my cull bounds from my size and my children's. Called after I draw.
+		void					updateCullBounds();
+
 		// Utility to reorder the sprites
 		void				setSpriteOrder(const std::vector<sprite_id_t>&);
 
-		friend class Engine;
-		friend class EngineRoot;
+		friend class ds::Benchmark;
+		friend class ds::Engine;
+		friend class ds::EngineRoot;
+		friend class ds::GeometricPicking;
+		// ds_tests, for the cull bounds
+		friend class ds::test::SpriteAccess;
 		// Disable copy constructor; sprites are managed by their parent and
 		// must be allocated
 		Sprite(const Sprite&);
@@ -778,9 +807,9 @@ namespace ui {
 		void				dimensionalStateChanged();
 		// Applies to all children, too.
 		void				markClippingDirty();
-		// Store all children in mSortedTmp by z order.
-		// XXX Need to optimize this so only built when needed.
+		// Bring mSortedChildren up to date, if anything changed.
 		void				makeSortedChildren();
+		void				markSortedDirty();
 		// calls removeParent then addChild to parent.
 		// setParent was previously public, but calling it by itself can cause an infinite loop
 		// Use addChild() from outside sprite.cpp
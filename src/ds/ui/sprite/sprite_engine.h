@@ -28,9 +28,11 @@ class Settings;
 }
 
 namespace ui {
+class IdleTracker;
 class LoadImageService;
 class RenderTextService;
 class Sprite;
+class TextLayoutCache;
 class Tweenline;
 
 /**
@@ -56,6 +58,10 @@ public:
 	virtual RenderTextService&		getRenderTextService() = 0;
 	virtual ds::ImageRegistry&		getImageRegistry() = 0;
 	virtual Tweenline&				getTweenline() = 0;
+	// Idle timing for the sprites that ask for it
+	virtual IdleTracker&			getIdleTracker() = 0;
+	// Text layouts shared between the Text sprites
+	virtual TextLayoutCache&		getTextLayoutCache() = 0;
 	virtual const ds::cfg::Settings&
 									getDebugSettings() = 0;
 	virtual ci::app::WindowRef		getWindow() = 0;
@@ -121,7 +127,8 @@ public:
 	void							removeFromDragDestinationList(Sprite *sprite);
 	Sprite*							getDragDestinationSprite(const ci::Vec3f &globalPoint, Sprite *draggingSprite);
 
-	double							getElapsedTimeSeconds() const;
+	// The app clock. Virtual so an engine without an app can supply its own.
+	virtual double					getElapsedTimeSeconds() const;
 
 	int								getIdleTimeout() const;
 	void							setIdleTimeout(int idleTimeout);
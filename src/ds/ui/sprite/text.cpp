@@ -82,6 +82,9 @@ Text::Text(SpriteEngine& engine)
 	, mNeedsLayout(false)
 	, mNeedRedrawing(false)
 	, mLayoutFunc(TextLayout::SINGLE_LINE())
+	, mSingleLineLayout(true)
+	, mVerticalLayout(nullptr)
+	, mAsyncLayout(false)
 	, mResizeLimitWidth(0)
 	, mResizeLimitHeight(0)
 	, mHasSplitLine(false)
@@ -183,13 +186,14 @@ void Text::updateServer(const UpdateParams& p)
 {
 	inherited::updateServer(p);
 
-	makeLayout();
+	makeLayout(false);
 	// NOTE: Needs to be here. If this is called in drawLocalClient(),
 	// then the font won't render.
 	// ALSO, this really shouldn't be here. Need to work out a way for
 	// the texture to be created only in client or clientserver mode;
 	// this also drags in server mode.
-	if (mNeedRedrawing) {
+	// Wait for an async layout before redrawing.
+	if (mNeedRedrawing && !mNeedsLayout) {
 		drawIntoFbo();
 	}
 }
@@ -360,14 +364,22 @@ Text& Text::setBorder(const ci::Rectf& r)
 	return *this;
 }
 
-Text& Text::setLayoutFunction(const TextLayout::MAKE_FUNC& f)
+Text& Text::setLayoutFunction(const TextLayout::MAKE_FUNC& f, const TextLayoutVertical* vertical)
 {
 	mLayoutFunc = f;
+	mSingleLineLayout = false;
+	mVerticalLayout = vertical;
 	mNeedsLayout = true;
 	mNeedRedrawing = true;
 	return *this;
 }
 
+Text& Text::setAsyncLayout(const bool on)
+{
+	mAsyncLayout = on;
+	return *this;
+}
+
 float Text::getFontAscent() const
 {
 	if (!mFont) return 0;
@@ -483,11 +495,9 @@ void Text::readAttributeFrom(const char attributeId, ds::DataBuffer& buf)
 	mNeedsLayout = false;
 }
 
-void Text::makeLayout()
+void Text::makeLayout(const bool wait)
 {
 	if (mNeedsLayout) {
-		mNeedsLayout = false;
-		mLayout.clear();
 		if (mLayoutFunc && mFont) {
 			ci::Vec2f	size(mWidth-mBorder.x1-mBorder.x2, mHeight-mBorder.y1-mBorder.y2);
 			// If we're auto resizing, then the area to perform the layout should be unlimited.
@@ -499,10 +509,29 @@ void Text::makeLayout()
 				size.y = 100000;
 				if (mResizeLimitHeight > 0) size.y = mResizeLimitHeight;
 			}
-			TextLayout::Input	in(*this, mFont, size, mTextString);
-			mLayoutFunc(in, mLayout);
-			mHasSplitLine = in.mLineWasSplit;
+			TextLayoutCache&			cache = mEngine.getTextLayoutCache();
+			TextLayoutCache::Key		key;
+			if (cache.isEnabled() && getLayoutCacheKey(size, key)) {
+				TextLayoutCache::EntryRef	entry;
+				if (mAsyncLayout && !wait) {
+					entry = cache.prefetch(key, mFont);
+					if (!entry) return;
+				} else {
+					entry = cache.get(key, mFont);
+				}
+				mLayout.setLines(std::shared_ptr<const std::vector<TextLayout::Line>>(entry, &entry->mLines));
+				mHasSplitLine = entry->mLineWasSplit;
+			} else {
+				mLayout.clear();
+				TextLayout::Input	in(*this, mFont, size, mTextString);
+				mLayoutFunc(in, mLayout);
+				mLayout.measure(mFont);
+				mHasSplitLine = in.mLineWasSplit;
+			}
+		} else {
+			mLayout.clear();
 		}
+		mNeedsLayout = false;
 		markAsDirty(LAYOUT_DIRTY);
 
 		if (mResizeToTextF) {
@@ -511,6 +540,24 @@ void Text::makeLayout()
 	}
 }
 
+bool Text::getLayoutCacheKey(const ci::Vec2f& size, TextLayoutCache::Key& key) const
+{
+	if (!mSingleLineLayout && !mVerticalLayout) return false;
+
+	key.mText = mTextString;
+	key.mFont = mEngine.getFonts().getFileNameFromName(mFontFileName);
+	key.mFontSize = mFontSize;
+	// A single line ignores the layout area, so leave it out and share more
+	if (mVerticalLayout) {
+		key.mKind = TextLayoutCache::VERTICAL;
+		key.mWidth = size.x;
+		key.mHeight = size.y;
+		key.mLeading = mVerticalLayout->mLeading;
+		key.mAlignment = mVerticalLayout->mAlignment;
+	}
+	return true;
+}
+
 void Text::calculateFrame(const int flags)
 {
 	if(!mFont) return;
@@ -523,13 +570,14 @@ void Text::calculateFrame(const int flags)
 
 	for(auto it = lines.begin(), end = lines.end(); it != end; ++it) {
 		const TextLayout::Line&		line(*it);
-		const ci::Vec2f				size = getSizeFromString(mFont, line.mText);//mFont->measureRaw(line.mText.c_str());
+		// Lines are measured when they're laid out
+		const OGLFT::BBox			box = (line.mMeasured ? line.mBox : mFont->measureRaw(line.mText));
+		const ci::Vec2f				size(box.x_max_ - box.x_min_, box.y_max_ - box.y_min_);
 		const float					lineW = line.mPos.x + size.x;
 		float						lineH = line.mPos.y + height;
 		if(it + 1 != lines.end()) {
 			lineH += lineHeight;
 		} else {
-			OGLFT::BBox box = mFont->measureRaw(line.mText.c_str());
 			lineH += -box.y_min_;
 		}
 		if(lineW > w) w = lineW;
@@ -611,7 +659,7 @@ std::cout << "START=" << ds::utf8_from_wstr(mTextString) << std::endl;
 			for (auto it=lines.begin(), end=lines.end(); it!=end; ++it) {
 				const TextLayout::Line&		line(*it);
 				//mTextureFont->drawString(line.mText, ci::Vec2f(line.mPos.x+mBorder.x1, line.mPos.y+mBorder.y1), mDrawOptions);
-				OGLFT::BBox box = mFont->measureRaw(line.mText);
+				const OGLFT::BBox box = (line.mMeasured ? line.mBox : mFont->measureRaw(line.mText));
 
 				// Make sure textures are disabled, or else I can end up not
 				// drawing and it can be very difficult to know why.
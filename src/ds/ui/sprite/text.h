@@ -8,6 +8,7 @@
 #include "ds/ui/service/render_text_service.h"
 #include "ds/ui/sprite/sprite.h"
 #include "ds/ui/sprite/text_layout.h"
+#include "ds/ui/sprite/text_layout_cache.h"
 #include "cinder/gl/Fbo.h"
 
 //#define TEXT_RENDER_ASYNC		(1)
@@ -23,7 +24,9 @@ void clearFontCache();
  * Note that some functions require additional properties not on the sprite
  * (for example, spacing between lines, for multi-line layouts), in which
  * case the function is typically generated by an additional object responsible
- * for storing the info.
+ * for storing the info. The default single line and TextLayoutVertical
+ * layouts are shared with every other sprite showing the same text through
+ * the engine's TextLayoutCache.
  */
 class Text : public Sprite
 {
@@ -74,8 +77,12 @@ public:
 	std::wstring				getText() const;
 	bool						hasText() const;
 
-	// Set a function for translating a string into a layout object.
-	Text&						setLayoutFunction(const TextLayout::MAKE_FUNC&);
+	// Set a function for translating a string into a layout object. Pass the
+	// vertical layout that made the function, if one did, so it can be cached.
+	Text&						setLayoutFunction(const TextLayout::MAKE_FUNC&, const TextLayoutVertical* = nullptr);
+	// When a layout isn't cached, leave it for the cache to do on a later frame instead of
+	// waiting for it. The old text shows until it's ready, unless something asks for the size first.
+	Text&						setAsyncLayout(const bool = true);
 
 	// Font metrics, this is probably temporary
 	float						getFontAscent() const;
@@ -107,7 +114,10 @@ protected:
 private:
 	typedef Sprite inherited;
 
-	void						makeLayout();
+	// When wait is false and layout is async, a cache miss leaves mNeedsLayout on
+	void						makeLayout(const bool wait = true);
+	// Answer false if my layout function can't be shared
+	bool						getLayoutCacheKey(const ci::Vec2f& size, TextLayoutCache::Key&) const;
 	void						drawIntoFbo();
 	// Only used when ResizeToText is on
 	void						calculateFrame(const int flags);
@@ -127,6 +137,10 @@ private:
 	// will be set to the layout bounds.
 	TextLayout					mLayout;
 	TextLayout::MAKE_FUNC		mLayoutFunc;
+	// Which cacheable layout mLayoutFunc is, if any
+	bool						mSingleLineLayout;
+	const TextLayoutVertical*	mVerticalLayout;
+	bool						mAsyncLayout;
 	float						mResizeLimitWidth,
 								mResizeLimitHeight;
 	bool						mHasSplitLine;
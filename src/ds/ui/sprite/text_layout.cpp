@@ -46,12 +46,30 @@ float getFontHeight( const FontPtr &font, const float leading )
 
 namespace {
   
+const std::vector<TextLayout::Line>		EMPTY_LINES;
+
+// Word breaks for the vertical layout
+std::vector<std::wstring> make_partitioners()
+{
+	std::vector<std::wstring>	ans;
+	ans.push_back(L" ");
+	ans.push_back(L"-");
+	ans.push_back(L"|");
+	//ans.push_back(L"_");
+	ans.push_back(L"\n");
+	ans.push_back(L"\r");
+	ans.push_back(L"\t");
+	//ans.push_back(L",");
+	return ans;
+}
+// Built up front, rather than on every layout
+const std::vector<std::wstring>	PARTITIONERS = make_partitioners();
+
 class LimitCheck {
 public:
-	LimitCheck(const TextLayout::Input& in)
-		: mLimitToHeight(!(in.mSprite.autoResizeHeight()))
-		, mDescent(getFontDescender(in.mFont))
-		, mMaxY(in.mSize.y)
+	LimitCheck(const FontPtr& font, const float maxY)
+		: mDescent(getFontDescender(font))
+		, mMaxY(maxY)
 	{
 	}
 
@@ -65,7 +83,6 @@ public:
 	}
 
 private:
-	const bool    mLimitToHeight;
 	const float   mDescent;
 	const float   mMaxY;
 };
@@ -76,6 +93,7 @@ private:
  * \class ds::ui::TextLayout::Line
  */
 TextLayout::Line::Line()
+	: mMeasured(false)
 {
 }
 
@@ -103,22 +121,63 @@ TextLayout::TextLayout()
 
 void TextLayout::clear()
 {
-	mLines.clear();
+	mLines.reset();
 }
 
 void TextLayout::addLine(const ci::Vec2f& pos, const std::wstring& text)
 {
-	mLines.push_back(Line());
-	Line& l = mLines.back();
+	std::vector<Line>& lines = editLines();
+	lines.push_back(Line());
+	Line& l = lines.back();
 	l.mPos = pos;
 	l.mText = text;
 }
 
+void TextLayout::setLines(const std::shared_ptr<const std::vector<Line>>& lines)
+{
+	mLines = lines;
+}
+
+void TextLayout::measure(const FontPtr& font)
+{
+	if(!font || !mLines) return;
+	bool				measured = true;
+	for(auto it = mLines->begin(), end = mLines->end(); it != end; ++it) {
+		if(!it->mMeasured) measured = false;
+	}
+	if(measured) return;
+
+	std::vector<Line>&	lines = editLines();
+	for(auto it = lines.begin(), end = lines.end(); it != end; ++it) {
+		if(it->mMeasured) continue;
+		it->mBox = font->measureRaw(it->mText);
+		it->mMeasured = true;
+	}
+}
+
+const std::vector<TextLayout::Line>& TextLayout::getLines() const
+{
+	if(!mLines) return EMPTY_LINES;
+	return *mLines;
+}
+
+std::vector<TextLayout::Line>& TextLayout::editLines()
+{
+	// Copy anything shared, so the other holders never see the change
+	if(!mLines) {
+		mLines = std::make_shared<std::vector<Line>>();
+	} else if(mLines.use_count() > 1) {
+		mLines = std::make_shared<std::vector<Line>>(*mLines);
+	}
+	return const_cast<std::vector<Line>&>(*mLines);
+}
+
 void TextLayout::writeTo(ds::DataBuffer& buf) const
 {
-	buf.add(mLines.size());
+	const std::vector<Line>& lines = getLines();
+	buf.add(lines.size());
 	int k = 0;
-	for(auto it = mLines.begin(), end = mLines.end(); it != end; ++it) {
+	for(auto it = lines.begin(), end = lines.end(); it != end; ++it) {
 		const Line& line(*it);
 		buf.add(k);
 		buf.add(line.mPos.x);
@@ -138,8 +197,9 @@ bool TextLayout::readFrom(ds::DataBuffer& buf)
 		if(!buf.canRead<int>()) return false;
 		if(buf.read<int>() != k) return false;
 
-		mLines.push_back(Line());
-		Line& l = mLines.back();
+		std::vector<Line>& lines = editLines();
+		lines.push_back(Line());
+		Line& l = lines.back();
 
 		if(!buf.canRead<float>()) return false;
 		l.mPos.x = buf.read<float>();
@@ -153,7 +213,8 @@ bool TextLayout::readFrom(ds::DataBuffer& buf)
 void TextLayout::debugPrint() const
 {
 	int					k = 0;
-	for(auto it = mLines.begin(), end = mLines.end(); it != end; ++it) {
+	const std::vector<Line>& lines = getLines();
+	for(auto it = lines.begin(), end = lines.end(); it != end; ++it) {
 		const Line&		line(*it);
 		std::wcout << L"\t" << k << L" (" << line.mPos.x << L", " << line.mPos.y << L") " << line.mText << std::endl;
 	}
@@ -161,10 +222,15 @@ void TextLayout::debugPrint() const
 
 const TextLayout::MAKE_FUNC& TextLayout::SINGLE_LINE()
 {
-	static const MAKE_FUNC ANS = [](TextLayout::Input& i, TextLayout& l) { l.addLine(ci::Vec2f(0, ceilf((1.0f - getFontAscender(i.mFont)) * i.mFont->pointSize())), i.mText); };
+	static const MAKE_FUNC ANS = [](TextLayout::Input& i, TextLayout& l) { makeSingleLine(i.mFont, i.mText, l); };
 	return ANS;
 }
 
+void TextLayout::makeSingleLine(const FontPtr& font, const std::wstring& text, TextLayout& l)
+{
+	l.addLine(ci::Vec2f(0, ceilf((1.0f - getFontAscender(font)) * font->pointSize())), text);
+}
+
 /**
  * \class ds::ui::TextLayoutVertical
  */
@@ -181,7 +247,7 @@ TextLayoutVertical::TextLayoutVertical(Text& t)
 
 void TextLayoutVertical::installOn(Text& t) {
 	auto f = [this](TextLayout::Input& in, TextLayout& out) { this->run(in, out); };
-	t.setLayoutFunction(f);
+	t.setLayoutFunction(f, this);
 }
 
 ci::Vec2f getSizeFromString(const FontPtr &font, const std::string &str) {
@@ -209,29 +275,23 @@ float getDifference(const FontPtr &font, const std::wstring &str, float lineH, f
 
 void TextLayoutVertical::run(TextLayout::Input& in, TextLayout& out)
 {
-	if(in.mText.empty())
+	layout(in.mFont, in.mSize, in.mText, mLeading, mAlignment, out, in.mLineWasSplit);
+}
+
+void TextLayoutVertical::layout(const FontPtr& font, const ci::Vec2f& size_limit, const std::wstring& text, const float leading,
+								const Alignment::Enum alignment, TextLayout& out, bool& lineWasSplit)
+{
+	if(text.empty())
 		return;
 	// Per line, find the word breaks, then create a line.
 	std::vector<std::wstring>			tokens;
-	//tokenize(in.mText, tokens);
-	static std::vector<std::wstring>	partitioners;
-	if(partitioners.empty()) {
-		partitioners.push_back(L" ");
-		partitioners.push_back(L"-");
-		partitioners.push_back(L"|");
-		//partitioners.push_back(L"_");
-		partitioners.push_back(L"\n");
-		partitioners.push_back(L"\r");
-		partitioners.push_back(L"\t");
-		//partitioners.push_back(L",");
-	}
-
-	tokens = ds::partition(in.mText, partitioners);
+	//tokenize(text, tokens);
+	tokens = ds::partition(text, PARTITIONERS);
 
-	LimitCheck			check(in);
-	float				y = ceilf((1.0f - getFontAscender(in.mFont)) * in.mFont->pointSize());
+	LimitCheck			check(font, size_limit.y);
+	float				y = ceilf((1.0f - getFontAscender(font)) * font->pointSize());
 	//address this
-	const float			lineH = in.mFont->pointSize()*mLeading + in.mFont->pointSize();//in.mFont->ascender() + in.mFont->descender() + (in.mFont->getFont().getLeading()*mLeading);
+	const float			lineH = font->pointSize()*leading + font->pointSize();//in.mFont->ascender() + in.mFont->descender() + (in.mFont->getFont().getLeading()*mLeading);
 	std::wstring		lineText;
 
 	// Before we do anything, make sure we have room for the first line,
@@ -240,7 +300,7 @@ void TextLayoutVertical::run(TextLayout::Input& in, TextLayout& out)
 
 	float maxWidth = 0.0f;
 	// spaces don't have a size so we make something up
-	const ci::Vec2f		spaceSize = getSizeFromString(in.mFont, L"o");
+	const ci::Vec2f		spaceSize = getSizeFromString(font, L"o");
 	//const ci::Vec2f	spaceSize = in.mFont->measureString("o", in.mOptions);
 	const ci::Vec2f		tabSize(spaceSize.x*3.0f, spaceSize.y);
 	//for (auto it=tokens.begin(), end=tokens.end(); it != end; ++it) {
@@ -259,7 +319,7 @@ void TextLayoutVertical::run(TextLayout::Input& in, TextLayout& out)
 		} else if(token == L"\n") {
 			// Flush the current line
 			if(!lineText.empty()) {
-				float inSize = getSizeFromString(in.mFont, lineText).x;
+				float inSize = getSizeFromString(font, lineText).x;
 				if(inSize > maxWidth)
 					maxWidth = inSize;
 				linesToWrite.push_back(outPair(y, lineText));
@@ -296,11 +356,11 @@ void TextLayoutVertical::run(TextLayout::Input& in, TextLayout& out)
 		}
 
 		newLine.append(token);
-		ci::Vec2f size = getSizeFromString(in.mFont, newLine);//in.mFont->measureString(newLine, in.mOptions);
-		if(size.x > in.mSize.x) {
+		ci::Vec2f size = getSizeFromString(font, newLine);//in.mFont->measureString(newLine, in.mOptions);
+		if(size.x > size_limit.x) {
 			// Flush the current line
 			if(!lineText.empty()) {
-				float inSize = getSizeFromString(in.mFont, lineText).x;
+				float inSize = getSizeFromString(font, lineText).x;
 				if(inSize > maxWidth)
 					maxWidth = inSize;
 				linesToWrite.push_back(outPair(y, lineText));
@@ -321,19 +381,19 @@ void TextLayoutVertical::run(TextLayout::Input& in, TextLayout& out)
 
 			lineText = token;
 
-			size = getSizeFromString(in.mFont, lineText);//in.mFont->measureString(lineText, in.mOptions);
-			while(size.x > in.mSize.x) {
+			size = getSizeFromString(font, lineText);//in.mFont->measureString(lineText, in.mOptions);
+			while(size.x > size_limit.x) {
 				for(unsigned i = 1; i <= lineText.size(); ++i) {
-					float cSize = getSizeFromString(in.mFont, lineText.substr(0, i)).x;//in.mFont->measureString(lineText.substr(0, i), in.mOptions).x;
-					if(cSize > in.mSize.x && i > 0) {
+					float cSize = getSizeFromString(font, lineText.substr(0, i)).x;//in.mFont->measureString(lineText.substr(0, i), in.mOptions).x;
+					if(cSize > size_limit.x && i > 0) {
 						// Eric, you said there was an infinite loop here with the code like this. The way you changed it wasn't the correct
 						// split and would cause lettings out of bounds. If you get the infinite loop again let me know how to reproduce it.
 						std::wstring sub = lineText.substr(0, i - 1);
 						lineText = lineText.substr(i - 1, lineText.size() - i + 1);
 						if(!sub.empty()) {
-							in.mLineWasSplit = true;
+							lineWasSplit = true;
 
-							float inSize = getSizeFromString(in.mFont, sub).x;
+							float inSize = getSizeFromString(font, sub).x;
 							if(inSize > maxWidth)
 								maxWidth = inSize;
 							linesToWrite.push_back(outPair(y, sub));
@@ -359,7 +419,7 @@ void TextLayoutVertical::run(TextLayout::Input& in, TextLayout& out)
 
 				if(check.outOfBounds(y)) return;
 
-				size = getSizeFromString(in.mFont, lineText);//in.mFont->measureString(lineText, in.mOptions);
+				size = getSizeFromString(font, lineText);//in.mFont->measureString(lineText, in.mOptions);
 			}
 
 			//lineText.append(" ");
@@ -374,7 +434,7 @@ void TextLayoutVertical::run(TextLayout::Input& in, TextLayout& out)
 	}
 
 	if(!lineText.empty() && !check.outOfBounds(y)) {
-		float inSize = getSizeFromString(in.mFont, lineText).x;
+		float inSize = getSizeFromString(font, lineText).x;
 		if(inSize > maxWidth)
 			maxWidth = inSize;
 		linesToWrite.push_back(outPair(y, lineText));
@@ -391,22 +451,22 @@ void TextLayoutVertical::run(TextLayout::Input& in, TextLayout& out)
 		//}
 	}
 
-	if(maxWidth > in.mSize.x)
-		maxWidth = in.mSize.x;
+	if(maxWidth > size_limit.x)
+		maxWidth = size_limit.x;
 
 	for(auto it = linesToWrite.begin(), it2 = linesToWrite.end(); it != it2; ++it)
 	{
 		float y = it->first;
 		std::wstring &str = it->second;
 
-		if(mAlignment == Alignment::kLeft) {
+		if(alignment == Alignment::kLeft) {
 			out.addLine(ci::Vec2f(0, y), str);
-		} else if(mAlignment == Alignment::kRight) {
-			float size = getSizeFromString(in.mFont, str).x;//in.mFont->measureString(lineText, in.mOptions).x;
+		} else if(alignment == Alignment::kRight) {
+			float size = getSizeFromString(font, str).x;//in.mFont->measureString(lineText, in.mOptions).x;
 			float x = maxWidth - size;
 			out.addLine(ci::Vec2f(x, y), str);
 		} else {
-			float size = getSizeFromString(in.mFont, str).x;//in.mFont->measureString(lineText, in.mOptions).x;
+			float size = getSizeFromString(font, str).x;//in.mFont->measureString(lineText, in.mOptions).x;
 			float x = (maxWidth - size) / 2.0f;
 			out.addLine(ci::Vec2f(x, y), str);
 		}
@@ -3,6 +3,7 @@
 #define DS_UI_SPRITE_TEXTLAYOUT_H
 
 #include <functional>
+#include <memory>
 #include <vector>
 #include <cinder/Vector.h>
 #include <cinder/gl/TextureFont.h>
@@ -38,6 +39,9 @@ public:
 		Line();
 		ci::Vec2f			mPos;
 		std::wstring		mText;
+		// measureRaw() of the text, once mMeasured is set
+		OGLFT::BBox			mBox;
+		bool				mMeasured;
 	};
 	// A bundle of all data necessary to create a layout
 	class Input {
@@ -59,8 +63,13 @@ public:
 	void					clear();
 
 	void					addLine(const ci::Vec2f&, const std::wstring&);
+	// Share an immutable set of lines, such as a TextLayoutCache entry.
+	// Editing afterwards works on a copy.
+	void					setLines(const std::shared_ptr<const std::vector<Line>>&);
+	// Measure any lines that haven't been.
+	void					measure(const FontPtr&);
 
-	const std::vector<Line> getLines() const	{ return mLines; }
+	const std::vector<Line>& getLines() const;
 
 	void					writeTo(ds::DataBuffer&) const;
 	bool					readFrom(ds::DataBuffer&);
@@ -69,7 +78,10 @@ public:
 	void					debugPrint() const;
 
 private:
-	std::vector<Line>		mLines;
+	std::vector<Line>&		editLines();
+
+	std::shared_ptr<const std::vector<Line>>
+							mLines;
 
 public:
 	// Predefined layout functions. A layout function needs to install
@@ -78,6 +90,8 @@ public:
 	typedef std::function<void(TextLayout::Input&, TextLayout&)> MAKE_FUNC;
 
 	static const MAKE_FUNC&	SINGLE_LINE();
+	// What SINGLE_LINE() does, without a sprite.
+	static void				makeSingleLine(const FontPtr&, const std::wstring&, TextLayout&);
 
 	// Any layout function that needs additional information is supplied
 	// as a separate class, below.
@@ -101,6 +115,11 @@ public:
 	// and 1 = the default leading.
 	float					mLeading;
 	Alignment::Enum			mAlignment;
+
+	// Lay out without a sprite, as the TextLayoutCache does.
+	static void				layout(const FontPtr&, const ci::Vec2f& size, const std::wstring& text, const float leading,
+								   const Alignment::Enum, TextLayout&, bool& lineWasSplit);
+
 private:
 	void					run(TextLayout::Input&, TextLayout&);
 };
@@ -0,0 +1,190 @@
+#include "ds/ui/sprite/text_layout_cache.h"
+
+#include <algorithm>
+#include <functional>
+#include <Poco/Timestamp.h>
+#include "ds/cfg/settings.h"
+#include "ds/debug/logger.h"
+
+namespace ds {
+namespace ui {
+
+namespace {
+const size_t			DEFAULT_MAX_ENTRIES = 4096;
+// How long update() spends on queued layouts each frame, in microseconds
+const Poco::Timestamp::TimeDiff	UPDATE_BUDGET = 2000;
+
+inline void				hash_combine(size_t& seed, const size_t v) {
+	seed ^= v + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+}
+
+/**
+ * \class ds::ui::TextLayoutCache::Key
+ */
+TextLayoutCache::Key::Key()
+		: mKind(SINGLE_LINE)
+		, mFontSize(0.0f)
+		, mWidth(0.0f)
+		, mHeight(0.0f)
+		, mLeading(0.0f)
+		, mAlignment(Alignment::kLeft) {
+}
+
+bool TextLayoutCache::Key::operator==(const Key& o) const {
+	return mKind == o.mKind && mFontSize == o.mFontSize && mWidth == o.mWidth && mHeight == o.mHeight
+			&& mLeading == o.mLeading && mAlignment == o.mAlignment && mFont == o.mFont && mText == o.mText;
+}
+
+size_t TextLayoutCache::KeyHash::operator()(const Key& k) const {
+	size_t					seed = std::hash<std::wstring>()(k.mText);
+	hash_combine(seed, std::hash<std::string>()(k.mFont));
+	hash_combine(seed, std::hash<float>()(k.mFontSize));
+	hash_combine(seed, std::hash<float>()(k.mWidth));
+	hash_combine(seed, std::hash<float>()(k.mHeight));
+	hash_combine(seed, std::hash<float>()(k.mLeading));
+	hash_combine(seed, static_cast<size_t>(k.mAlignment) * 4 + static_cast<size_t>(k.mKind));
+	return seed;
+}
+
+/**
+ * \class ds::ui::TextLayoutCache::Entry
+ */
+TextLayoutCache::Entry::Entry()
+		: mLineWasSplit(false) {
+}
+
+/**
+ * \class ds::ui::TextLayoutCache
+ */
+TextLayoutCache::TextLayoutCache()
+		: mMaxEntries(DEFAULT_MAX_ENTRIES)
+		, mHits(0)
+		, mMisses(0) {
+}
+
+void TextLayoutCache::setup(const ds::cfg::Settings& settings) {
+	const int					max_entries = settings.getInt("text:layout_cache", 0, static_cast<int>(DEFAULT_MAX_ENTRIES));
+	Poco::Mutex::ScopedLock		l(mMutex);
+	mMaxEntries = static_cast<size_t>(std::max(0, max_entries));
+	while (mEntries.size() > mMaxEntries) {
+		mEntries.erase(mOrder.back());
+		mOrder.pop_back();
+	}
+}
+
+TextLayoutCache::EntryRef TextLayoutCache::get(const Key& key, const FontPtr& font) {
+	{
+		Poco::Mutex::ScopedLock	l(mMutex);
+		EntryRef				found = lookup(key);
+		if (found) {
+			++mHits;
+			return found;
+		}
+		++mMisses;
+	}
+
+	// Lay out outside the lock
+	EntryRef					entry = layout(key, font);
+	Poco::Mutex::ScopedLock		l(mMutex);
+	insert(key, entry);
+	return entry;
+}
+
+TextLayoutCache::EntryRef TextLayoutCache::prefetch(const Key& key, const FontPtr& font) {
+	Poco::Mutex::ScopedLock		l(mMutex);
+	EntryRef					found = lookup(key);
+	if (found) {
+		++mHits;
+		return found;
+	}
+	// Asking again while it's queued isn't another miss
+	if (!mQueued.insert(key).second) return nullptr;
+
+	++mMisses;
+	Job							job;
+	job.mKey = key;
+	job.mFont = font;
+	mJobs.push_back(job);
+	return nullptr;
+}
+
+void TextLayoutCache::update() {
+	const Poco::Timestamp		start;
+	Poco::Mutex::ScopedLock		l(mMutex);
+	while (!mJobs.empty() && start.elapsed() < UPDATE_BUDGET) {
+		const Job				job = mJobs.front();
+		mJobs.pop_front();
+		mQueued.erase(job.mKey);
+		try {
+			insert(job.mKey, layout(job.mKey, job.mFont));
+		} catch (std::exception const& ex) {
+			DS_LOG_WARNING("TextLayoutCache can't lay out text in " << job.mKey.mFont << ", ex=" << ex.what());
+		}
+	}
+}
+
+void TextLayoutCache::clear() {
+	Poco::Mutex::ScopedLock		l(mMutex);
+	mEntries.clear();
+	mOrder.clear();
+	mJobs.clear();
+	mQueued.clear();
+}
+
+size_t TextLayoutCache::size() const {
+	Poco::Mutex::ScopedLock		l(mMutex);
+	return mEntries.size();
+}
+
+size_t TextLayoutCache::getHits() const {
+	Poco::Mutex::ScopedLock		l(mMutex);
+	return mHits;
+}
+
+size_t TextLayoutCache::getMisses() const {
+	Poco::Mutex::ScopedLock		l(mMutex);
+	return mMisses;
+}
+
+TextLayoutCache::EntryRef TextLayoutCache::layout(const Key& key, const FontPtr& font) {
+	std::shared_ptr<Entry>		entry(new Entry());
+	if (!font) return entry;
+
+	TextLayout					out;
+	if (key.mKind == VERTICAL) {
+		TextLayoutVertical::layout(font, ci::Vec2f(key.mWidth, key.mHeight), key.mText, key.mLeading, key.mAlignment, out, entry->mLineWasSplit);
+	} else {
+		TextLayout::makeSingleLine(font, key.mText, out);
+	}
+	out.measure(font);
+	entry->mLines = out.getLines();
+	return entry;
+}
+
+TextLayoutCache::EntryRef TextLayoutCache::lookup(const Key& key) {
+	auto						found = mEntries.find(key);
+	if (found == mEntries.end()) return nullptr;
+	// Most recently used moves to the front
+	mOrder.splice(mOrder.begin(), mOrder, found->second.mOrder);
+	return found->second.mEntry;
+}
+
+void TextLayoutCache::insert(const Key& key, const EntryRef& entry) {
+	if (mMaxEntries < 1 || !entry) return;
+	auto						found = mEntries.find(key);
+	if (found != mEntries.end()) return;
+
+	mOrder.push_front(key);
+	Slot						slot;
+	slot.mEntry = entry;
+	slot.mOrder = mOrder.begin();
+	mEntries[key] = slot;
+	while (mEntries.size() > mMaxEntries) {
+		mEntries.erase(mOrder.back());
+		mOrder.pop_back();
+	}
+}
+
+} // namespace ui
+} // namespace ds
@@ -0,0 +1,123 @@
+#pragma once
+#ifndef DS_UI_SPRITE_TEXTLAYOUTCACHE_H_
+#define DS_UI_SPRITE_TEXTLAYOUTCACHE_H_
+
+#include <deque>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <Poco/Mutex.h>
+#include "ds/ui/sprite/text_layout.h"
+
+namespace ds {
+namespace cfg {
+class Settings;
+}
+
+namespace ui {
+
+/**
+ * \class ds::ui::TextLayoutCache
+ * \brief Share text layouts between every Text sprite showing the same
+ * string in the same font, size and layout. Entries are immutable line sets
+ * with each line already measured, dropped least recently used first. Misses
+ * can be deferred and laid out a few per frame by update(). They stay on the
+ * main thread: OGLFT shares one FreeType library across every face, and
+ * FreeType only allows one thread per library.
+ * Only the single line and TextLayoutVertical layouts can be keyed; Text
+ * sprites with any other layout function lay themselves out.
+ * Settings are read from engine.xml:
+ *	"text:layout_cache" int -- most layouts kept, 0 to turn the cache off. DEFAULT=4096
+ */
+class TextLayoutCache {
+public:
+	enum Kind { SINGLE_LINE, VERTICAL };
+
+	class Key {
+	public:
+		Key();
+		bool					operator==(const Key&) const;
+
+		Kind					mKind;
+		std::wstring			mText;
+		// The font file, not its short name
+		std::string				mFont;
+		float					mFontSize;
+		// The layout area, and for VERTICAL its leading and alignment
+		float					mWidth,
+								mHeight;
+		float					mLeading;
+		Alignment::Enum			mAlignment;
+	};
+
+	class Entry {
+	public:
+		Entry();
+		std::vector<TextLayout::Line>
+								mLines;
+		bool					mLineWasSplit;
+	};
+	typedef std::shared_ptr<const Entry> EntryRef;
+
+	TextLayoutCache();
+
+	void						setup(const ds::cfg::Settings&);
+	bool						isEnabled() const	{ return mMaxEntries > 0; }
+
+	// Answer the layout, laying it out here with the font on a miss.
+	EntryRef					get(const Key&, const FontPtr&);
+	// Answer the layout if it's cached. Otherwise queue it for update() and
+	// answer nothing; ask again on a later update.
+	EntryRef					prefetch(const Key&, const FontPtr&);
+	// Lay out queued misses until this frame's budget is spent. A layout
+	// that fails is dropped, not cached, so asking again retries it.
+	void						update();
+	void						clear();
+
+	size_t						size() const;
+	size_t						getHits() const;
+	size_t						getMisses() const;
+
+	// Lay out without a sprite.
+	static EntryRef				layout(const Key&, const FontPtr&);
+
+private:
+	class KeyHash {
+	public:
+		size_t					operator()(const Key&) const;
+	};
+	typedef std::list<Key>		Order;
+	class Slot {
+	public:
+		EntryRef				mEntry;
+		Order::iterator			mOrder;
+	};
+
+	// Mutex must be held
+	EntryRef					lookup(const Key&);
+	void						insert(const Key&, const EntryRef&);
+
+	class Job {
+	public:
+		Key						mKey;
+		FontPtr					mFont;
+	};
+
+	mutable Poco::Mutex			mMutex;
+	size_t						mMaxEntries;
+	std::unordered_map<Key, Slot, KeyHash>
+								mEntries;
+	// Most recently used at the front
+	Order						mOrder;
+	std::deque<Job>				mJobs;
+	std::unordered_set<Key, KeyHash>
+								mQueued;
+	size_t						mHits,
+								mMisses;
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_SPRITE_TEXTLAYOUTCACHE_H_
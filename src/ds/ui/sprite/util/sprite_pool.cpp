@@ -0,0 +1,91 @@
+#include "ds/ui/sprite/util/sprite_pool.h"
+
+#include <cstring>
+#include <new>
+
+namespace ds {
+namespace ui {
+
+namespace {
+// Never deleted: sprites can outlive any static destructor
+SpritePool*				POOL = nullptr;
+}
+
+/**
+ * \class ds::ui::SpritePool
+ */
+SpritePool& SpritePool::get() {
+	if (!POOL) POOL = new SpritePool();
+	return *POOL;
+}
+
+SpritePool::SpritePool()
+		: mBytesInUse(0)
+		, mBytesReserved(0)
+		, mBlocksInUse(0) {
+	memset(mFree, 0, sizeof(mFree));
+}
+
+void* SpritePool::allocate(const size_t size) {
+	if (size < 1 || size > MAX_SIZE) return ::operator new(size);
+
+	const size_t			size_class = (size - 1) / GRANULE;
+	std::lock_guard<std::mutex>	lock(mMutex);
+	if (!mFree[size_class] && !refill(size_class)) throw std::bad_alloc();
+	Node*					n = mFree[size_class];
+	mFree[size_class] = n->mNext;
+	mBytesInUse += (size_class + 1) * GRANULE;
+	++mBlocksInUse;
+	return n;
+}
+
+void SpritePool::deallocate(void* p, const size_t size) {
+	if (!p) return;
+	if (size < 1 || size > MAX_SIZE) {
+		::operator delete(p);
+		return;
+	}
+
+	const size_t			size_class = (size - 1) / GRANULE;
+	std::lock_guard<std::mutex>	lock(mMutex);
+	Node*					n = static_cast<Node*>(p);
+	n->mNext = mFree[size_class];
+	mFree[size_class] = n;
+	mBytesInUse -= (size_class + 1) * GRANULE;
+	--mBlocksInUse;
+}
+
+size_t SpritePool::getBytesInUse() const {
+	std::lock_guard<std::mutex>	lock(mMutex);
+	return mBytesInUse;
+}
+
+size_t SpritePool::getBytesReserved() const {
+	std::lock_guard<std::mutex>	lock(mMutex);
+	return mBytesReserved;
+}
+
+size_t SpritePool::getBlocksInUse() const {
+	std::lock_guard<std::mutex>	lock(mMutex);
+	return mBlocksInUse;
+}
+
+bool SpritePool::refill(const size_t size_class) {
+	const size_t			block = (size_class + 1) * GRANULE;
+	char*					chunk = static_cast<char*>(::operator new(block * BLOCKS_PER_CHUNK, std::nothrow));
+	if (!chunk) return false;
+	mBytesReserved += block * BLOCKS_PER_CHUNK;
+
+	// Thread the blocks so they come out in address order
+	Node*					head = mFree[size_class];
+	for (size_t k=BLOCKS_PER_CHUNK; k>0; --k) {
+		Node*				n = reinterpret_cast<Node*>(chunk + (k - 1) * block);
+		n->mNext = head;
+		head = n;
+	}
+	mFree[size_class] = head;
+	return true;
+}
+
+} // namespace ui
+} // namespace ds
@@ -0,0 +1,60 @@
+#pragma once
+#ifndef DS_UI_SPRITE_UTIL_SPRITEPOOL_H_
+#define DS_UI_SPRITE_UTIL_SPRITEPOOL_H_
+
+#include <cstddef>
+#include <mutex>
+
+namespace ds {
+namespace ui {
+
+/**
+ * \class ds::ui::SpritePool
+ * \brief Fixed size blocks for sprites. Sizes are rounded up to 16 bytes and
+ * each size gets its own free list, refilled a chunk of blocks at a time, so
+ * building and tearing down thousands of sprites doesn't go through the heap
+ * and sprites of one class end up packed together. Anything bigger than
+ * MAX_SIZE goes straight to the heap. Blocks are recycled, never returned to
+ * the heap; the pool lives as long as the process.
+ */
+class SpritePool {
+public:
+	static const size_t			GRANULE = 16;
+	static const size_t			MAX_SIZE = 4096;
+	static const size_t			BLOCKS_PER_CHUNK = 64;
+
+	static SpritePool&			get();
+
+	void*						allocate(const size_t);
+	void						deallocate(void*, const size_t);
+
+	// Bytes in blocks that are handed out, including the rounding
+	size_t						getBytesInUse() const;
+	// Bytes taken from the heap for chunks
+	size_t						getBytesReserved() const;
+	size_t						getBlocksInUse() const;
+
+private:
+	SpritePool();
+	SpritePool(const SpritePool&);
+	SpritePool&					operator=(const SpritePool&);
+
+	struct Node {
+		Node*					mNext;
+	};
+	static const size_t			CLASS_COUNT = MAX_SIZE / GRANULE;
+
+	// Carve a new chunk into blocks for the size class. Answer false if the heap is out.
+	bool						refill(const size_t size_class);
+
+	mutable std::mutex			mMutex;
+	Node*						mFree[CLASS_COUNT];
+	size_t						mBytesInUse,
+								mBytesReserved,
+								mBlocksInUse;
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_SPRITE_UTIL_SPRITEPOOL_H_
@@ -4,7 +4,6 @@
 
 #include <ds/ui/sprite/sprite.h>
 #include <ds/ui/sprite/sprite_engine.h>
-#include <ds/ui/tween/tweenline.h>
 
 namespace ds {
 
@@ -58,9 +57,10 @@ void ButtonBehaviour::disable() {
 
 
 namespace {
+// Through the sprite's tweens, so it replaces any scale tween already running
+// there as well as stopping a timeline one.
 void			anim_scale_to(ds::ui::Sprite& s, const float scale, const float duration) {
-	s.mAnimScale.stop();
-	s.getEngine().getTweenline().apply(s, s.ANIM_SCALE(), ci::Vec3f(scale, scale, 1.0f), duration, ci::easeInOutQuad);
+	s.tweenScale(ci::Vec3f(scale, scale, 1.0f), duration, 0.0f, ci::easeInOutQuad);
 }
 
 }
@@ -0,0 +1,100 @@
+#include "geometric_picking.h"
+
+#include <cmath>
+
+namespace ds {
+
+namespace {
+// Hits closer than this, as a fraction of the near to far distance, are a tie
+const float				TIE_T = 0.000001f;
+}
+
+/**
+ * \class ds::GeometricPicking
+ */
+GeometricPicking::GeometricPicking(const ci::Camera& c)
+		: mCamera(&c)
+		, mHit(nullptr)
+		, mHitT(0.0f) {
+}
+
+void GeometricPicking::setCamera(const ci::Camera& c) {
+	mCamera = &c;
+}
+
+ds::ui::Sprite* GeometricPicking::pickAt(const ci::Vec2f& pt, ds::ui::Sprite& root) {
+	const float				w = (mWorldSize.x > 0.0f ? mWorldSize.x : root.getWidth()),
+							h = (mWorldSize.y > 0.0f ? mWorldSize.y : root.getHeight());
+	if (w <= 0.0f || h <= 0.0f) return nullptr;
+
+	// Unproject the point at the near and far planes. This is the inverse of Camera::worldToScreen().
+	const ci::Matrix44f		inv = (mCamera->getProjectionMatrix() * mCamera->getModelViewMatrix()).inverted();
+	const float				x = pt.x / w * 2.0f - 1.0f,
+							y = 1.0f - pt.y / h * 2.0f;
+	mNear = inv.transformPoint(ci::Vec3f(x, y, -1.0f));
+	mFar = inv.transformPoint(ci::Vec3f(x, y, 1.0f));
+
+	mClipping.clear();
+	mHit = nullptr;
+	mHitT = 2.0f;
+	pick(root, root);
+	return mHit;
+}
+
+void GeometricPicking::pick(ds::ui::Sprite& s, const ds::ui::Sprite& root) {
+	if (!s.visible()) return;
+	// Nothing under a flat scale can be drawn, and it has no inverse
+	const ci::Vec3f&		scale = s.getScale();
+	if (scale.x == 0.0f || scale.y == 0.0f || scale.z == 0.0f) return;
+
+	s.buildGlobalTransform();
+
+	// Like SelectPicking, only drawn sprites can be hit, and the root never is
+	if (&s != &root && !s.getTransparent() && s.isEnabled()
+			&& s.getWidth() >= 0.001f && s.getHeight() >= 0.001f) {
+		// The ray in my space. Transforms are affine, so t is the same in world space.
+		const ci::Matrix44f&	inv = s.getInverseGlobalTransform();
+		const ci::Vec3f			a = inv.transformPointAffine(mNear),
+								b = inv.transformPointAffine(mFar);
+		const float				dz = b.z - a.z;
+		if (std::abs(dz) > 0.000001f) {
+			const float			t = -a.z / dz;
+			const ci::Vec3f		p = a + (b - a) * t;
+			if (t >= 0.0f && t <= 1.0f && t <= mHitT + TIE_T
+					&& p.x >= 0.0f && p.y >= 0.0f && p.x <= s.getWidth() && p.y <= s.getHeight()) {
+				const ci::Vec3f	world = mNear + (mFar - mNear) * t;
+				if (insideClipping(world) && s.getInnerHit(world)) {
+					mHit = &s;
+					mHitT = t;
+				}
+			}
+		}
+	}
+
+	// Children are visited in draw order, so later ones win ties
+	const bool				clip = s.getClipping();
+	if (clip) mClipping.push_back(&s);
+	if (!s.getDrawSorted()) {
+		for (auto it=s.mChildren.begin(), end=s.mChildren.end(); it!=end; ++it) {
+			pick(**it, root);
+		}
+	} else {
+		s.makeSortedChildren();
+		for (auto it=s.mSortedChildren.begin(), end=s.mSortedChildren.end(); it!=end; ++it) {
+			pick(**it, root);
+		}
+	}
+	if (clip) mClipping.pop_back();
+}
+
+bool GeometricPicking::insideClipping(const ci::Vec3f& world) const {
+	// Clip planes bound x and y in the clipping sprite's space, but not z
+	for (auto it=mClipping.begin(), end=mClipping.end(); it!=end; ++it) {
+		const ds::ui::Sprite*	c = *it;
+		const ci::Vec3f			p = c->getInverseGlobalTransform().transformPointAffine(world);
+		if (p.x < 0.0f || p.y < 0.0f || p.x > c->getWidth() || p.y > c->getHeight()) return false;
+	}
+	return true;
+}
+
+} // namespace ds
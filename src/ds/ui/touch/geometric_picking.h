@@ -0,0 +1,48 @@
+#pragma once
+#ifndef DS_UI_TOUCH_GEOMETRICPICKING_H_
+#define DS_UI_TOUCH_GEOMETRICPICKING_H_
+
+#include <vector>
+#include <cinder/Camera.h>
+#include "picking.h"
+
+namespace ds {
+
+/**
+ * \class ds::GeometricPicking
+ * \brief Perform picking on the CPU. A ray is cast from the camera through
+ * the pick point and tested against the quad of every sprite, in its world
+ * transform. It follows the same rules as SelectPicking: invisible sprites
+ * and their children are skipped, transparent and disabled sprites are passed
+ * through, clipping sprites clip their children, and the nearest hit wins,
+ * with the last drawn winning a tie. Meshes are tested against their sprite
+ * bounds; use getInnerHit() for anything finer.
+ */
+class GeometricPicking : public Picking {
+public:
+	GeometricPicking(const ci::Camera&);
+
+	// Slaved roots pick through their master's camera.
+	void					setCamera(const ci::Camera&);
+
+	virtual ds::ui::Sprite*	pickAt(const ci::Vec2f&, ds::ui::Sprite& root);
+
+private:
+	void					pick(ds::ui::Sprite&, const ds::ui::Sprite& root);
+	// Answer true if the world point is inside every clipping sprite above the current one.
+	bool					insideClipping(const ci::Vec3f&) const;
+
+	const ci::Camera*		mCamera;
+	// The pick ray, from the near to the far plane, in world space
+	ci::Vec3f				mNear,
+							mFar;
+	std::vector<ds::ui::Sprite*>
+							mClipping;
+	ds::ui::Sprite*			mHit;
+	// Distance along the ray to the hit, 0 at the near plane and 1 at the far
+	float					mHitT;
+};
+
+} // namespace ds
+
+#endif
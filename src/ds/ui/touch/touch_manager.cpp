@@ -105,7 +105,8 @@ void TouchManager::touchesMoved(const TouchEvent &event) {
 
 		int fingerId = touchIt->getId() + MOUSE_RESERVED_IDS;
 
-		if(mDiscardTouchMap[fingerId]){
+		auto discard = mDiscardTouchMap.find(fingerId);
+		if(discard != mDiscardTouchMap.end() && discard->second){
 			continue;
 		}
 
@@ -117,23 +118,27 @@ void TouchManager::touchesMoved(const TouchEvent &event) {
 		//if (shouldDiscardTouch(touchPos))
 		//	return;
 
+		// One lookup per map. Processing the touch can clear fingers, so nothing is held past it.
+		const ci::Vec3f& previousPoint = mTouchPreviousPoint[fingerId];
+		Sprite* dispatcher = mFingerDispatcher[fingerId];
+
 		TouchInfo touchInfo;
 		touchInfo.mCurrentGlobalPoint = Vec3f(touchPos, 0.0f);
 		touchInfo.mFingerId = fingerId;
 		touchInfo.mStartPoint = mTouchStartPoint[touchInfo.mFingerId];
-		touchInfo.mDeltaPoint = touchInfo.mCurrentGlobalPoint - mTouchPreviousPoint[touchInfo.mFingerId];
+		touchInfo.mDeltaPoint = touchInfo.mCurrentGlobalPoint - previousPoint;
 		touchInfo.mPhase = TouchInfo::Moved;
 		touchInfo.mPassedTouch = false;
-		touchInfo.mPickedSprite = mFingerDispatcher[touchInfo.mFingerId];
+		touchInfo.mPickedSprite = dispatcher;
 
 		if(mCapture){
 			mCapture->touchMoved(touchInfo);
 		}
 
-		mRotationTranslator.move(touchInfo, mTouchPreviousPoint[touchInfo.mFingerId]);
+		mRotationTranslator.move(touchInfo, previousPoint);
 
-		if (mFingerDispatcher[touchInfo.mFingerId]) {
-			mFingerDispatcher[touchInfo.mFingerId]->processTouchInfo( touchInfo );
+		if (dispatcher) {
+			dispatcher->processTouchInfo( touchInfo );
 		}
 
 		mTouchPreviousPoint[touchInfo.mFingerId] = touchInfo.mCurrentGlobalPoint;
@@ -13,9 +13,16 @@ namespace ui {
 SpriteAnimatable::SpriteAnimatable(Sprite& s, SpriteEngine& e)
 		: mOwner(s)
 		, mEngine(e) {
+	for (int k=0; k<SpriteTweens::PROPERTY_COUNT; ++k) mTweenIndex[k] = -1;
 }
 
 SpriteAnimatable::~SpriteAnimatable() {
+	for (int k=0; k<SpriteTweens::PROPERTY_COUNT; ++k) {
+		if (mTweenIndex[k] >= 0) {
+			getSpriteTweens().stop(mOwner);
+			break;
+		}
+	}
 }
 
 const SpriteAnim<ci::Color>& SpriteAnimatable::ANIM_COLOR() {
@@ -69,37 +76,37 @@ const SpriteAnim<ci::Vec3f>& SpriteAnimatable::ANIM_ROTATION() {
 void SpriteAnimatable::tweenColor(	const ci::Color& c, const float duration, const float delay,
 									const ci::EaseFn& ease, const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn) {
 	mAnimColor.stop();
-	mEngine.getTweenline().apply(mOwner, ANIM_COLOR(), c, duration, ease, finishFn, delay, updateFn);
+	getSpriteTweens().tweenColor(mOwner, c, duration, delay, ease, finishFn, updateFn);
 }
 
 void SpriteAnimatable::tweenOpacity(const float opacity, const float duration, const float delay,
 									const ci::EaseFn& ease, const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn) {
 	mAnimOpacity.stop();
-	mEngine.getTweenline().apply(mOwner, ANIM_OPACITY(), opacity, duration, ease, finishFn, delay, updateFn);
+	getSpriteTweens().tweenOpacity(mOwner, opacity, duration, delay, ease, finishFn, updateFn);
 }
 
 void SpriteAnimatable::tweenPosition(const ci::Vec3f& pos, const float duration, const float delay,
 									 const ci::EaseFn& ease, const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn) {
 	mAnimPosition.stop();
-	mEngine.getTweenline().apply(mOwner, ANIM_POSITION(), pos, duration, ease, finishFn, delay, updateFn);
+	getSpriteTweens().tweenPosition(mOwner, pos, duration, delay, ease, finishFn, updateFn);
 }
 
 void SpriteAnimatable::tweenRotation(const ci::Vec3f& rot, const float duration, const float delay,
 									 const ci::EaseFn& ease, const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn) {
 	mAnimRotation.stop();
-	mEngine.getTweenline().apply(mOwner, ANIM_ROTATION(), rot, duration, ease, finishFn, delay, updateFn);
+	getSpriteTweens().tweenRotation(mOwner, rot, duration, delay, ease, finishFn, updateFn);
 }
 
 void SpriteAnimatable::tweenScale(	const ci::Vec3f& scale, const float duration, const float delay,
 									const ci::EaseFn& ease, const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn) {
 	mAnimScale.stop();
-	mEngine.getTweenline().apply(mOwner, ANIM_SCALE(), scale, duration, ease, finishFn, delay, updateFn);
+	getSpriteTweens().tweenScale(mOwner, scale, duration, delay, ease, finishFn, updateFn);
 }
 
 void SpriteAnimatable::tweenSize(	const ci::Vec3f& size, const float duration, const float delay,
 									const ci::EaseFn& ease, const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn) {
 	mAnimSize.stop();
-	mEngine.getTweenline().apply(mOwner, ANIM_SIZE(), size, duration, ease, finishFn, delay, updateFn);
+	getSpriteTweens().tweenSize(mOwner, size, duration, delay, ease, finishFn, updateFn);
 }
 
 void SpriteAnimatable::animStop() {
@@ -108,6 +115,11 @@ void SpriteAnimatable::animStop() {
 	mAnimPosition.stop();
 	mAnimScale.stop();
 	mAnimSize.stop();
+	getSpriteTweens().stop(mOwner);
+}
+
+SpriteTweens& SpriteAnimatable::getSpriteTweens() {
+	return mEngine.getTweenline().getSpriteTweens();
 }
 
 } // namespace ui
@@ -6,6 +6,7 @@
 #include <cinder/Easing.h>
 #include <cinder/Tween.h>
 #include <cinder/Vector.h>
+#include "ds/ui/tween/sprite_tweens.h"
 
 namespace ds {
 namespace ui {
@@ -53,7 +54,9 @@ class SpriteAnim {
 /**
  * \class ds::ui::SpriteAnimatable
  * Provide conveniences for the common properties that can
- * be animated on a sprite.
+ * be animated on a sprite. The tween functions run on the
+ * engine's SpriteTweens; the Anim<> members are still there
+ * for anything applied directly to the timeline.
  */
 class SpriteAnimatable {
 public:
@@ -102,8 +105,13 @@ public:
 	ci::Anim<ci::Vec3f>						mAnimRotation;
 
 private:
+	friend class SpriteTweens;
+	SpriteTweens&							getSpriteTweens();
+
 	Sprite&									mOwner;
 	SpriteEngine&							mEngine;
+	// Slot of my active tween for each SpriteTweens::Property, or -1
+	int										mTweenIndex[SpriteTweens::PROPERTY_COUNT];
 };
 
 } // namespace ui
@@ -0,0 +1,342 @@
+#include "ds/ui/tween/sprite_tweens.h"
+
+#include "ds/debug/frame_profiler.h"
+#include "ds/ui/sprite/sprite.h"
+
+namespace ds {
+namespace ui {
+
+namespace {
+ci::Vec3f		get_position(Sprite& s)							{ return s.getPosition(); }
+void			set_position(Sprite& s, const ci::Vec3f& v)		{ s.setPosition(v); }
+ci::Vec3f		get_scale(Sprite& s)							{ return s.getScale(); }
+void			set_scale(Sprite& s, const ci::Vec3f& v)		{ s.setScale(v); }
+ci::Vec3f		get_size(Sprite& s)								{ return ci::Vec3f(s.getWidth(), s.getHeight(), s.getDepth()); }
+void			set_size(Sprite& s, const ci::Vec3f& v)			{ s.setSizeAll(v.x, v.y, v.z); }
+ci::Vec3f		get_rotation(Sprite& s)							{ return s.getRotation(); }
+void			set_rotation(Sprite& s, const ci::Vec3f& v)		{ s.setRotation(v); }
+float			get_opacity(Sprite& s)							{ return s.getOpacity(); }
+void			set_opacity(Sprite& s, const float& v)			{ s.setOpacity(v); }
+ci::Color		get_color(Sprite& s)							{ return s.getColor(); }
+void			set_color(Sprite& s, const ci::Color& v)		{ s.setColor(v); }
+
+template <typename T>
+T				tween_value(const T& from, const T& to, const float t)	{ return from + (to - from) * t; }
+
+// Keeps the depth right even if a function throws
+class DepthGuard {
+public:
+	DepthGuard(int& depth) : mDepth(depth) { ++mDepth; }
+	~DepthGuard() { --mDepth; }
+private:
+	DepthGuard&	operator=(const DepthGuard&);
+	int&		mDepth;
+};
+}
+
+/**
+ * \class ds::ui::SpriteTweens
+ */
+SpriteTweens::SpriteTweens(const ci::Timeline& t)
+		: mTimeline(t)
+		, mPosition(POSITION, get_position, set_position)
+		, mScale(SCALE, get_scale, set_scale)
+		, mSize(SIZE, get_size, set_size)
+		, mRotation(ROTATION, get_rotation, set_rotation)
+		, mOpacity(OPACITY, get_opacity, set_opacity)
+		, mColor(COLOR, get_color, set_color)
+		, mDepth(0) {
+}
+
+SpriteTweens::~SpriteTweens() {
+	// Sprites can outlive me, so make sure they forget about their tweens
+	clear();
+}
+
+void SpriteTweens::tweenPosition(	Sprite& s, const ci::Vec3f& v, const float duration, const float delay, const ci::EaseFn& ease,
+									const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn) {
+	mPosition.add(*this, s, v, mTimeline.getCurrentTime() + delay, duration, ease, addCallbacks(finishFn, updateFn));
+}
+
+void SpriteTweens::tweenScale(		Sprite& s, const ci::Vec3f& v, const float duration, const float delay, const ci::EaseFn& ease,
+									const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn) {
+	mScale.add(*this, s, v, mTimeline.getCurrentTime() + delay, duration, ease, addCallbacks(finishFn, updateFn));
+}
+
+void SpriteTweens::tweenSize(		Sprite& s, const ci::Vec3f& v, const float duration, const float delay, const ci::EaseFn& ease,
+									const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn) {
+	mSize.add(*this, s, v, mTimeline.getCurrentTime() + delay, duration, ease, addCallbacks(finishFn, updateFn));
+}
+
+void SpriteTweens::tweenRotation(	Sprite& s, const ci::Vec3f& v, const float duration, const float delay, const ci::EaseFn& ease,
+									const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn) {
+	mRotation.add(*this, s, v, mTimeline.getCurrentTime() + delay, duration, ease, addCallbacks(finishFn, updateFn));
+}
+
+void SpriteTweens::tweenOpacity(	Sprite& s, const float v, const float duration, const float delay, const ci::EaseFn& ease,
+									const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn) {
+	mOpacity.add(*this, s, v, mTimeline.getCurrentTime() + delay, duration, ease, addCallbacks(finishFn, updateFn));
+}
+
+void SpriteTweens::tweenColor(		Sprite& s, const ci::Color& v, const float duration, const float delay, const ci::EaseFn& ease,
+									const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn) {
+	mColor.add(*this, s, v, mTimeline.getCurrentTime() + delay, duration, ease, addCallbacks(finishFn, updateFn));
+}
+
+void SpriteTweens::stop(Sprite& s, const Property p) {
+	switch (p) {
+	case POSITION:	mPosition.remove(*this, s); break;
+	case SCALE:		mScale.remove(*this, s); break;
+	case SIZE:		mSize.remove(*this, s); break;
+	case ROTATION:	mRotation.remove(*this, s); break;
+	case OPACITY:	mOpacity.remove(*this, s); break;
+	case COLOR:		mColor.remove(*this, s); break;
+	default:		break;
+	}
+}
+
+void SpriteTweens::stop(Sprite& s) {
+	for (int k=0; k<PROPERTY_COUNT; ++k) stop(s, static_cast<Property>(k));
+}
+
+bool SpriteTweens::isTweening(const Sprite& s, const Property p) const {
+	if (p < 0 || p >= PROPERTY_COUNT) return false;
+	return indexOf(s, p) >= 0;
+}
+
+void SpriteTweens::clear() {
+	mPosition.clear(*this);
+	mScale.clear(*this);
+	mSize.clear(*this);
+	mRotation.clear(*this);
+	mOpacity.clear(*this);
+	mColor.clear(*this);
+}
+
+size_t SpriteTweens::size() const {
+	return mPosition.size() + mScale.size() + mSize.size() + mRotation.size() + mOpacity.size() + mColor.size();
+}
+
+void SpriteTweens::update() {
+	DS_PROFILE_SCOPE("SpriteTweens::update");
+	// Not reentrant; an update or finish function can't drive the tweens.
+	if (mDepth > 0) return;
+
+	const double		now = mTimeline.getCurrentTime();
+	// Only left over if a function threw last time
+	mUpdateQueue.clear();
+	mFinishQueue.clear();
+	{
+		DepthGuard		g(mDepth);
+		mPosition.update(*this, now);
+		mScale.update(*this, now);
+		mSize.update(*this, now);
+		mRotation.update(*this, now);
+		mOpacity.update(*this, now);
+		mColor.update(*this, now);
+		deliver();
+	}
+
+	if (!mReleasedCallbacks.empty()) {
+		mFreeCallbacks.insert(mFreeCallbacks.end(), mReleasedCallbacks.begin(), mReleasedCallbacks.end());
+		mReleasedCallbacks.clear();
+	}
+}
+
+int& SpriteTweens::indexOf(Sprite& s, const Property p) {
+	return static_cast<SpriteAnimatable&>(s).mTweenIndex[p];
+}
+
+int SpriteTweens::indexOf(const Sprite& s, const Property p) {
+	return static_cast<const SpriteAnimatable&>(s).mTweenIndex[p];
+}
+
+int SpriteTweens::addCallbacks(const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn) {
+	if (!finishFn && !updateFn) return -1;
+
+	int					index;
+	if (mFreeCallbacks.empty()) {
+		index = static_cast<int>(mCallbacks.size());
+		mCallbacks.push_back(callbacks());
+	} else {
+		index = mFreeCallbacks.back();
+		mFreeCallbacks.pop_back();
+	}
+	callbacks&			cb = mCallbacks[index];
+	cb.mFinishFn = finishFn;
+	cb.mUpdateFn = updateFn;
+	cb.mLive = true;
+	return index;
+}
+
+void SpriteTweens::releaseCallbacks(const int index) {
+	if (index < 0 || index >= static_cast<int>(mCallbacks.size())) return;
+	callbacks&			cb = mCallbacks[index];
+	if (!cb.mLive) return;
+	cb.mLive = false;
+	// A function might be running or queued, so only let go of them once the update is over.
+	if (mDepth > 0) {
+		mReleasedCallbacks.push_back(index);
+	} else {
+		cb.mFinishFn = nullptr;
+		cb.mUpdateFn = nullptr;
+		mFreeCallbacks.push_back(index);
+	}
+}
+
+void SpriteTweens::deliver() {
+	// Indexes, not references: anything can be stopped or started from inside a function.
+	for (size_t k=0; k<mUpdateQueue.size(); ++k) {
+		const int		index = mUpdateQueue[k];
+		if (mCallbacks[index].mLive && mCallbacks[index].mUpdateFn) mCallbacks[index].mUpdateFn();
+	}
+	mUpdateQueue.clear();
+
+	for (size_t k=0; k<mFinishQueue.size(); ++k) {
+		const int		index = mFinishQueue[k];
+		if (mCallbacks[index].mLive && mCallbacks[index].mFinishFn) mCallbacks[index].mFinishFn();
+		releaseCallbacks(index);
+	}
+	mFinishQueue.clear();
+
+	// Functions that were released are held until the update is over, so they're safe to drop now.
+	for (auto it=mReleasedCallbacks.begin(), end=mReleasedCallbacks.end(); it!=end; ++it) {
+		mCallbacks[*it].mFinishFn = nullptr;
+		mCallbacks[*it].mUpdateFn = nullptr;
+	}
+}
+
+/**
+ * \class ds::ui::SpriteTweens::Channel
+ */
+template <typename T>
+SpriteTweens::Channel<T>::Channel(const Property p, const GetFn get, const AssignFn assign)
+		: mProperty(p)
+		, mGet(get)
+		, mAssign(assign) {
+}
+
+template <typename T>
+void SpriteTweens::Channel<T>::add(	SpriteTweens& owner, Sprite& s, const T& end, const double start, const float duration,
+									const ci::EaseFn& ease, const int callbacks) {
+	remove(owner, s);
+
+	entry				e;
+	e.mSprite = &s;
+	// Same as the timeline, the start value is taken now, not when a delay runs out.
+	e.mFrom = mGet(s);
+	e.mTo = end;
+	e.mStart = start;
+	e.mDuration = duration;
+	e.mEase = ease;
+	e.mCallbacks = callbacks;
+	mEntries.push_back(e);
+	indexOf(s, mProperty) = static_cast<int>(mEntries.size() - 1);
+}
+
+template <typename T>
+void SpriteTweens::Channel<T>::remove(SpriteTweens& owner, Sprite& s) {
+	int&				index = indexOf(s, mProperty);
+	if (index < 0) return;
+
+	const size_t		k = static_cast<size_t>(index);
+	index = -1;
+	if (k >= mEntries.size()) return;
+
+	owner.releaseCallbacks(mEntries[k].mCallbacks);
+	mEntries[k].mSprite = nullptr;
+	mEntries[k].mCallbacks = -1;
+	// Mid update, the pass compacts it. Otherwise fill the hole with the last one.
+	if (owner.mDepth > 0) return;
+	if (k + 1 < mEntries.size()) {
+		mEntries[k] = mEntries.back();
+		place(k);
+	}
+	mEntries.pop_back();
+}
+
+template <typename T>
+void SpriteTweens::Channel<T>::clear(SpriteTweens& owner) {
+	for (auto it=mEntries.begin(), end=mEntries.end(); it!=end; ++it) {
+		if (!it->mSprite) continue;
+		indexOf(*it->mSprite, mProperty) = -1;
+		owner.releaseCallbacks(it->mCallbacks);
+		it->mSprite = nullptr;
+		it->mCallbacks = -1;
+	}
+	if (owner.mDepth < 1) mEntries.clear();
+}
+
+template <typename T>
+size_t SpriteTweens::Channel<T>::size() const {
+	size_t				ans = 0;
+	for (auto it=mEntries.begin(), end=mEntries.end(); it!=end; ++it) {
+		if (it->mSprite) ++ans;
+	}
+	return ans;
+}
+
+template <typename T>
+void SpriteTweens::Channel<T>::update(SpriteTweens& owner, const double now) {
+	if (mEntries.empty()) return;
+
+	// Assigning a value runs sprite code, which can stop or start tweens. Stopped ones
+	// are nulled in place, new ones are appended, so always go through an index.
+	const size_t		count = mEntries.size();
+	size_t				w = 0;
+	for (size_t r=0; r<count; ++r) {
+		if (!mEntries[r].mSprite) continue;
+		if (r != w) {
+			mEntries[w] = mEntries[r];
+			mEntries[r].mSprite = nullptr;
+			place(w);
+		}
+
+		const entry&	e = mEntries[w];
+		if (now < e.mStart) {
+			++w;
+			continue;
+		}
+
+		Sprite*			s = e.mSprite;
+		const int		cb = e.mCallbacks;
+		const float		t = (e.mDuration > 0.0f ? static_cast<float>((now - e.mStart) / e.mDuration) : 1.0f);
+		if (t >= 1.0f) {
+			// Finished. Leave it behind, it's overwritten or trimmed below.
+			const T		v(e.mTo);
+			indexOf(*s, mProperty) = -1;
+			mEntries[w].mSprite = nullptr;
+			mAssign(*s, v);
+			if (cb >= 0) {
+				owner.mUpdateQueue.push_back(cb);
+				owner.mFinishQueue.push_back(cb);
+			}
+			continue;
+		}
+
+		const T			v(tween_value(e.mFrom, e.mTo, e.mEase ? e.mEase(t) : t));
+		const size_t	index = w++;
+		mAssign(*s, v);
+		if (cb >= 0 && mEntries[index].mSprite == s) owner.mUpdateQueue.push_back(cb);
+	}
+
+	// Keep anything started during the pass
+	for (size_t r=count; r<mEntries.size(); ++r) {
+		if (!mEntries[r].mSprite) continue;
+		if (r != w) {
+			mEntries[w] = mEntries[r];
+			mEntries[r].mSprite = nullptr;
+			place(w);
+		}
+		++w;
+	}
+	mEntries.resize(w);
+}
+
+template <typename T>
+void SpriteTweens::Channel<T>::place(const size_t index) {
+	if (mEntries[index].mSprite) indexOf(*mEntries[index].mSprite, mProperty) = static_cast<int>(index);
+}
+
+} // namespace ui
+} // namespace ds
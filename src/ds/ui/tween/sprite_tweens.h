@@ -0,0 +1,134 @@
+#pragma once
+#ifndef DS_UI_TWEEN_SPRITETWEENS_H_
+#define DS_UI_TWEEN_SPRITETWEENS_H_
+
+#include <deque>
+#include <functional>
+#include <vector>
+#include <cinder/Color.h>
+#include <cinder/Timeline.h>
+#include <cinder/Tween.h>
+#include <cinder/Vector.h>
+
+namespace ds {
+namespace ui {
+class Sprite;
+
+/**
+ * \class ds::ui::SpriteTweens
+ * Run the common sprite property tweens without the cinder timeline. Active
+ * tweens for each property live in one contiguous array that's advanced in a
+ * single pass, and the finish and update functions are only stored for the
+ * tweens that supply them, then all called in a batch once the pass is done.
+ * A sprite can have one tween per property; starting another replaces it.
+ * Time comes from the supplied timeline, so delays line up with everything else.
+ */
+class SpriteTweens {
+public:
+	enum Property { POSITION, SCALE, SIZE, ROTATION, OPACITY, COLOR, PROPERTY_COUNT };
+
+	SpriteTweens(const ci::Timeline&);
+	~SpriteTweens();
+
+	void					tweenPosition(	Sprite&, const ci::Vec3f&, const float duration, const float delay, const ci::EaseFn&,
+											const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn);
+	void					tweenScale(		Sprite&, const ci::Vec3f&, const float duration, const float delay, const ci::EaseFn&,
+											const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn);
+	void					tweenSize(		Sprite&, const ci::Vec3f&, const float duration, const float delay, const ci::EaseFn&,
+											const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn);
+	void					tweenRotation(	Sprite&, const ci::Vec3f&, const float duration, const float delay, const ci::EaseFn&,
+											const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn);
+	void					tweenOpacity(	Sprite&, const float, const float duration, const float delay, const ci::EaseFn&,
+											const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn);
+	void					tweenColor(		Sprite&, const ci::Color&, const float duration, const float delay, const ci::EaseFn&,
+											const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn);
+
+	// Stopped tweens leave the property where it is, and don't call their finish function.
+	void					stop(Sprite&, const Property);
+	void					stop(Sprite&);
+	bool					isTweening(const Sprite&, const Property) const;
+	// Stop everything. Sprites are left alone.
+	void					clear();
+	// Number of active tweens
+	size_t					size() const;
+
+	// Advance every tween to the timeline's current time, then call the update and finish functions.
+	void					update();
+
+private:
+	SpriteTweens(const SpriteTweens&);
+	SpriteTweens&			operator=(const SpriteTweens&);
+
+	template <typename T>
+	class Channel {
+	public:
+		typedef void		(*AssignFn)(Sprite&, const T&);
+		typedef T			(*GetFn)(Sprite&);
+
+		Channel(const Property, const GetFn, const AssignFn);
+
+		void				add(SpriteTweens&, Sprite&, const T& end, const double start, const float duration,
+								const ci::EaseFn&, const int callbacks);
+		void				remove(SpriteTweens&, Sprite&);
+		void				clear(SpriteTweens&);
+		size_t				size() const;
+		void				update(SpriteTweens&, const double now);
+
+	private:
+		struct entry {
+			entry() : mSprite(nullptr), mStart(0.0), mDuration(0.0f), mCallbacks(-1) { }
+			// Null once the tween has been stopped
+			Sprite*			mSprite;
+			T				mFrom,
+							mTo;
+			double			mStart;
+			float			mDuration;
+			ci::EaseFn		mEase;
+			int				mCallbacks;
+		};
+
+		void				place(const size_t index);
+
+		const Property		mProperty;
+		const GetFn			mGet;
+		const AssignFn		mAssign;
+		std::vector<entry>	mEntries;
+	};
+
+	struct callbacks {
+		callbacks() : mLive(false) { }
+		std::function<void(void)>	mFinishFn,
+									mUpdateFn;
+		bool				mLive;
+	};
+
+	// Where the sprite's tween is in its channel, or -1
+	static int&				indexOf(Sprite&, const Property);
+	static int				indexOf(const Sprite&, const Property);
+
+	int						addCallbacks(const std::function<void(void)>& finishFn, const std::function<void(void)>& updateFn);
+	void					releaseCallbacks(const int);
+	void					deliver();
+
+	const ci::Timeline&		mTimeline;
+	Channel<ci::Vec3f>		mPosition,
+							mScale,
+							mSize,
+							mRotation;
+	Channel<float>			mOpacity;
+	Channel<ci::Color>		mColor;
+
+	// A deque so a function being called stays put when more are added
+	std::deque<callbacks>	mCallbacks;
+	std::vector<int>		mFreeCallbacks;
+	// Slots released while updating, freed once nothing can be holding them
+	std::vector<int>		mReleasedCallbacks;
+	std::vector<int>		mUpdateQueue,
+							mFinishQueue;
+	int						mDepth;
+};
+
+} // namespace ui
+} // namespace ds
+
+#endif // DS_UI_TWEEN_SPRITETWEENS_H_
@@ -11,6 +11,7 @@ namespace ui {
  */
 Tweenline::Tweenline(cinder::Timeline& tl)
   : mTimeline(tl)
+  , mSpriteTweens(tl)
 {
 }
 
@@ -19,5 +20,15 @@ cinder::Timeline& Tweenline::getTimeline()
   return mTimeline;
 }
 
+SpriteTweens& Tweenline::getSpriteTweens()
+{
+  return mSpriteTweens;
+}
+
+void Tweenline::update()
+{
+  mSpriteTweens.update();
+}
+
 } // namespace ui
 } // namespace ds
@@ -4,6 +4,7 @@
 
 #include <cinder/Timeline.h>
 #include "ds/ui/tween/sprite_anim.h"
+#include "ds/ui/tween/sprite_tweens.h"
 
 namespace ds {
 namespace ui {
@@ -11,6 +12,7 @@ namespace ui {
 /**
  * \class ds::ui::Tweenline
  * A wrapper around the Cinder timeline that provides some sprite-based management.
+ * The SpriteAnimatable tweens run on the SpriteTweens, which shares the timeline's clock.
  */
 class Tweenline {
   public:
@@ -25,10 +27,15 @@ class Tweenline {
 
     // Clients can go nuts with full access to the cinder timeline
     cinder::Timeline&     getTimeline();
+    SpriteTweens&         getSpriteTweens();
+
+    // Advance the sprite tweens. The engine calls this once a frame.
+    void                  update();
 
   private:
     Tweenline();
     cinder::Timeline&     mTimeline;
+    SpriteTweens          mSpriteTweens;
 };
 
 template <typename T>
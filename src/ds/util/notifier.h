@@ -5,8 +5,10 @@
 /* A much more useful version of the notifier.
  */
 
-#include <map>
+#include <algorithm>
 #include <functional>
+#include <unordered_map>
+#include <vector>
 
 namespace ds
 {
@@ -15,6 +17,10 @@ namespace ds
  * There are two types of messages: Notifications, where the client
  * will get no response (fire and forget) and requests, where the
  * point is to get a response.
+ * Listeners can either hear everything, or subscribe to a single
+ * message type (T::mWhat), in which case they're only called for it.
+ * It's safe to add and remove listeners while a message is being delivered;
+ * additions start hearing with the next message.
  */
 template <typename T>
 class Notifier
@@ -29,6 +35,9 @@ class Notifier
     /* Notification mechanism where no response is expected
      */
     void addListener(void *id, const std::function<void(const T *)> &func);
+    // Only called for messages where mWhat == what.
+    void addListener(void *id, const int what, const std::function<void(const T *)> &func);
+    // Removes the id from everything it's listening to.
     void removeListener(void *id);
 
     void notify( const T *v = nullptr );
@@ -36,6 +45,7 @@ class Notifier
     /* Request mechanism for requesting data.
      */
     void addRequestListener(void *id, const std::function<void(T&)> &func);
+    void addRequestListener(void *id, const int what, const std::function<void(T&)> &func);
     void removeRequestListener(void *id);
 
     void request(T&);
@@ -47,8 +57,52 @@ class Notifier
 	void setOnAddListenerFn(const std::function<T*(void)> &fn);
 
   private:
-    std::map<void *, std::function<void(const T *)>> mFunctions;
-    std::map<void *, std::function<void(T&)>> mRequestFn;
+	// A list of callbacks that can be modified while it's being called.
+	template <typename Fn>
+	class List {
+	  public:
+		List() : mDepth(0), mDirty(false) { }
+
+		bool	empty() const { return mEntries.empty() && mAdded.empty(); }
+		void	add(void *id, const Fn&);
+		void	remove(void *id);
+		void	clear();
+		template <typename Arg>
+		void	call(Arg);
+
+	  private:
+		struct entry {
+			entry(void *id, const Fn &fn) : mId(id), mFn(fn), mRemoved(false) { }
+			void*	mId;
+			Fn		mFn;
+			bool	mRemoved;
+		};
+		// Keeps the depth right even if a listener throws
+		class Guard {
+		  public:
+			Guard(List &l) : mList(l) { ++mList.mDepth; }
+			~Guard() { if (--mList.mDepth == 0) mList.settle(); }
+		  private:
+			Guard &operator=(const Guard&);
+			List	&mList;
+		};
+
+		void	settle();
+
+		std::vector<entry>	mEntries;
+		// Added during a call, merged in once it's finished
+		std::vector<entry>	mAdded;
+		int					mDepth;
+		bool				mDirty;
+	};
+
+	typedef std::function<void(const T *)>	NotifyFn;
+	typedef std::function<void(T&)>			RequestFn;
+
+    List<NotifyFn>							mFunctions;
+    std::unordered_map<int, List<NotifyFn>>	mWhatFunctions;
+    List<RequestFn>							mRequestFn;
+    std::unordered_map<int, List<RequestFn>>	mWhatRequestFn;
 	std::function<T*(void)>	mOnAddListenerFn;
 };
 
@@ -62,6 +116,8 @@ void Notifier<T>::clear()
 {
 	mFunctions.clear();
 	mRequestFn.clear();
+	for (auto it=mWhatFunctions.begin(), end=mWhatFunctions.end(); it!=end; ++it) it->second.clear();
+	for (auto it=mWhatRequestFn.begin(), end=mWhatRequestFn.end(); it!=end; ++it) it->second.clear();
 }
 
 template <typename T>
@@ -75,7 +131,7 @@ void Notifier<T>::addListener( void *id, const std::function<void(const T *)> &f
 	if (!func) return;
     try
     {
-        mFunctions[id] = func;
+        mFunctions.add(id, func);
 		if (mOnAddListenerFn) {
 			T*	t = mOnAddListenerFn();
 			if (t) func(t);
@@ -86,65 +142,81 @@ void Notifier<T>::addListener( void *id, const std::function<void(const T *)> &f
     }
 }
 
+template <typename T>
+void Notifier<T>::addListener( void *id, const int what, const std::function<void(const T *)> &func ) {
+	if (!func) return;
+    try
+    {
+        mWhatFunctions[what].add(id, func);
+		if (mOnAddListenerFn) {
+			T*	t = mOnAddListenerFn();
+			if (t && t->mWhat == what) func(t);
+		}
+    }
+    catch (std::exception const&)
+    {
+    }
+}
 
 template <typename T>
 void Notifier<T>::removeListener( void *id )
 {
-  // This is required, otherwise the app can hit an exception during shutdown
-  // if the map is empty but clients still exist.
-  if (mFunctions.empty()) return;
-  auto found = mFunctions.find(id);
-  if ( found != mFunctions.end() )
-  {
-      mFunctions.erase(found);
-  }
+	mFunctions.remove(id);
+	for (auto it=mWhatFunctions.begin(), end=mWhatFunctions.end(); it!=end; ++it) it->second.remove(id);
 }
 
 template <typename T>
 void Notifier<T>::notify( const T *v /*= nullptr */ )
 {
-    for ( auto it = mFunctions.begin(), it2 = mFunctions.end(); it != it2; ++it )
-    {
-        if ( it->second )
-            (it->second)(v);
-    }
+	if (v && !mWhatFunctions.empty()) {
+		auto found = mWhatFunctions.find(v->mWhat);
+		if (found != mWhatFunctions.end()) found->second.call(v);
+	}
+	mFunctions.call(v);
 }
 
 
 template <typename T>
 void Notifier<T>::addRequestListener( void *id, const std::function<void(T&)> &func )
 {
+	if (!func) return;
     try
     {
-        mRequestFn[id] = func;
+        mRequestFn.add(id, func);
     }
     catch (std::exception &)
     {
     }
 }
 
+template <typename T>
+void Notifier<T>::addRequestListener( void *id, const int what, const std::function<void(T&)> &func )
+{
+	if (!func) return;
+    try
+    {
+        mWhatRequestFn[what].add(id, func);
+    }
+    catch (std::exception &)
+    {
+    }
+}
 
 template <typename T>
 void Notifier<T>::removeRequestListener( void *id )
 {
-  // This is required, otherwise the app can hit an exception during shutdown
-  // if the map is empty but clients still exist.
-  if (mRequestFn.empty()) return;
-  auto found = mRequestFn.find(id);
-  if ( found != mRequestFn.end() )
-  {
-      mRequestFn.erase(found);
-  }
+	mRequestFn.remove(id);
+	for (auto it=mWhatRequestFn.begin(), end=mWhatRequestFn.end(); it!=end; ++it) it->second.remove(id);
 }
 
 template <typename T>
 void Notifier<T>::request( T& v )
 {
-    for ( auto it = mRequestFn.begin(), it2 = mRequestFn.end(); it != it2; ++it )
-    {
-        if ( it->second )
-            (it->second)(v);
-    }
+	if (!mWhatRequestFn.empty()) {
+		auto found = mWhatRequestFn.find(v.mWhat);
+		if (found != mWhatRequestFn.end()) found->second.template call<T&>(v);
+	}
+	mRequestFn.template call<T&>(v);
 }
 
 template <typename T>
@@ -152,6 +224,79 @@ void Notifier<T>::setOnAddListenerFn(const std::function<T*(void)> &fn) {
 	mOnAddListenerFn = fn;
 }
 
+/* Notifier::List
+ */
+template <typename T>
+template <typename Fn>
+void Notifier<T>::List<Fn>::add( void *id, const Fn &fn )
+{
+	// One callback per id, same as it's always been
+	remove(id);
+	if (mDepth > 0) mAdded.push_back(entry(id, fn));
+	else mEntries.push_back(entry(id, fn));
+}
+
+template <typename T>
+template <typename Fn>
+void Notifier<T>::List<Fn>::remove( void *id )
+{
+	if (empty()) return;
+	// Never destroy a callback while it might be running, just flag it.
+	if (mDepth > 0) {
+		for (auto it=mEntries.begin(), end=mEntries.end(); it!=end; ++it) {
+			if (it->mId == id && !it->mRemoved) {
+				it->mRemoved = true;
+				mDirty = true;
+			}
+		}
+		mAdded.erase(std::remove_if(mAdded.begin(), mAdded.end(), [id](const entry &e)->bool { return e.mId == id; }), mAdded.end());
+		return;
+	}
+	mEntries.erase(std::remove_if(mEntries.begin(), mEntries.end(), [id](const entry &e)->bool { return e.mId == id; }), mEntries.end());
+}
+
+template <typename T>
+template <typename Fn>
+void Notifier<T>::List<Fn>::clear()
+{
+	if (mDepth > 0) {
+		for (auto it=mEntries.begin(), end=mEntries.end(); it!=end; ++it) it->mRemoved = true;
+		mDirty = true;
+		mAdded.clear();
+		return;
+	}
+	mEntries.clear();
+	mAdded.clear();
+}
+
+template <typename T>
+template <typename Fn>
+template <typename Arg>
+void Notifier<T>::List<Fn>::call( Arg v )
+{
+	if (mEntries.empty()) return;
+
+	Guard		g(*this);
+	// Size is fixed for the duration, anything added lands in mAdded
+	for (size_t k=0, size=mEntries.size(); k<size; ++k) {
+		if (!mEntries[k].mRemoved) mEntries[k].mFn(v);
+	}
+}
+
+template <typename T>
+template <typename Fn>
+void Notifier<T>::List<Fn>::settle()
+{
+	if (mDirty) {
+		mEntries.erase(std::remove_if(mEntries.begin(), mEntries.end(), [](const entry &e)->bool { return e.mRemoved; }), mEntries.end());
+		mDirty = false;
+	}
+	if (!mAdded.empty()) {
+		mEntries.insert(mEntries.end(), mAdded.begin(), mAdded.end());
+		mAdded.clear();
+	}
+}
+
 } // ds2
 
 #endif
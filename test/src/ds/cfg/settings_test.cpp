@@ -0,0 +1,158 @@
+#include "ds_test.h"
+
+#include <new>
+#include <type_traits>
+#include <Poco/File.h>
+#include "ds/cfg/settings.h"
+
+using ds::cfg::Settings;
+
+namespace {
+// One of most of the types, with a couple of repeats
+void						fill(Settings& s) {
+	Settings::Editor		ed(s);
+	ed.setFloat("menu:speed", 2.5f);
+	ed.setInt("menu:count", 3);
+	ed.addInt("menu:count", 4);
+	ed.setRect("menu:area", ci::Rectf(10.0f, 20.0f, 110.0f, 220.0f));
+	ed.setColorA("menu:tint", ci::ColorA(0.25f, 0.5f, 0.75f, 0.5f));
+	ed.setSize("menu:size", ci::Vec2f(640.0f, 480.0f));
+	ed.setText("menu:title", "Welcome");
+	ed.setText("menu:on", "true");
+	ed.addTextW("menu:label", L"caf\x00e9");
+	ed.setPoint("menu:origin", ci::Vec3f(1.0f, 2.0f, 3.0f));
+}
+
+bool						same_as_filled(const Settings& s) {
+	return s.getFloat("menu:speed") == 2.5f
+		&& s.getIntSize("menu:count") == 2 && s.getInt("menu:count", 0) == 3 && s.getInt("menu:count", 1) == 4
+		&& s.getRect("menu:area").x1 == 10.0f && s.getRect("menu:area").y2 == 220.0f
+		&& s.getColorA("menu:tint").g == 0.5f && s.getColorA("menu:tint").a == 0.5f
+		&& s.getSize("menu:size").x == 640.0f && s.getSize("menu:size").y == 480.0f
+		&& s.getText("menu:title") == "Welcome"
+		&& s.getBool("menu:on")
+		&& s.getTextW("menu:label") == L"caf\x00e9"
+		&& s.getPoint("menu:origin").z == 3.0f;
+}
+}
+
+DS_TEST(settings_handle_reads_and_defaults) {
+	Settings				s;
+	fill(s);
+	const Settings::Handle<float>		speed("menu:speed", 1.0f);
+	const Settings::Handle<int>			count("menu:count", -1);
+	const Settings::Handle<std::string>	title("menu:title", "none");
+	const Settings::Handle<float>		missing("menu:missing", 7.0f);
+	DS_CHECK_EQUAL(speed.get(s), 2.5f);
+	DS_CHECK_EQUAL(count.getSize(s), 2);
+	DS_CHECK_EQUAL(count.get(s, 1), 4);
+	DS_CHECK_EQUAL(count.get(s, 2), -1);
+	DS_CHECK_EQUAL(title.get(s), "Welcome");
+	DS_CHECK_EQUAL(missing.get(s), 7.0f);
+	DS_CHECK_EQUAL(missing.getSize(s), 0);
+
+	// Same as getBool(): t or f, anything else is the default
+	const Settings::Handle<bool>		on("menu:on", false),
+										odd("menu:title", true);
+	DS_CHECK(on.get(s));
+	DS_CHECK(odd.get(s));
+	Settings::Editor(s).setText("menu:on", "False");
+	DS_CHECK(!on.get(s));
+}
+
+DS_TEST(settings_handle_resolves_again_on_a_new_stamp) {
+	Settings				s;
+	fill(s);
+	const Settings::Handle<float>	speed("menu:speed", 1.0f);
+	DS_CHECK_EQUAL(speed.get(s), 2.5f);
+
+	// Deleting frees the slot the handle found; the new stamp keeps it from being read
+	Settings::Editor(s).deleteFloat("menu:speed");
+	DS_CHECK_EQUAL(speed.get(s), 1.0f);
+	Settings::Editor(s).setFloat("menu:speed", 4.0f);
+	DS_CHECK_EQUAL(speed.get(s), 4.0f);
+	s.clear();
+	DS_CHECK_EQUAL(speed.get(s), 1.0f);
+
+	// Assigning over settings is a new load too
+	Settings				other;
+	Settings::Editor(other).setFloat("menu:speed", 6.0f);
+	s = other;
+	DS_CHECK_EQUAL(speed.get(s), 6.0f);
+
+	// New settings in the same memory don't answer the old slot
+	std::aligned_storage<sizeof(Settings), std::alignment_of<Settings>::value>::type	memory;
+	Settings*				first = new (&memory) Settings();
+	Settings::Editor(*first).setFloat("menu:speed", 8.0f);
+	DS_CHECK_EQUAL(speed.get(*first), 8.0f);
+	first->~Settings();
+	Settings*				second = new (&memory) Settings();
+	DS_CHECK(first == second);
+	DS_CHECK_EQUAL(speed.get(*second), 1.0f);
+	second->~Settings();
+}
+
+DS_TEST(settings_handle_on_copies) {
+	Settings				s;
+	fill(s);
+	const Settings::Handle<float>	speed("menu:speed", 1.0f);
+	DS_CHECK_EQUAL(speed.get(s), 2.5f);
+
+	// A copy has its own slots, and editing it leaves the original alone
+	Settings				copy(s);
+	Settings::Editor(copy).setFloat("menu:speed", 5.0f);
+	DS_CHECK_EQUAL(speed.get(copy), 5.0f);
+	DS_CHECK_EQUAL(speed.get(s), 2.5f);
+	DS_CHECK_EQUAL(speed.get(copy), 5.0f);
+
+	// A copied handle finds its own slot rather than sharing the original's
+	const Settings::Handle<float>	copied(speed);
+	DS_CHECK_EQUAL(copied.getName(), "menu:speed");
+	DS_CHECK_EQUAL(copied.get(copy), 5.0f);
+	DS_CHECK_EQUAL(speed.get(s), 2.5f);
+	Settings::Handle<float>	assigned("other", 0.0f);
+	assigned = speed;
+	DS_CHECK_EQUAL(assigned.get(s), 2.5f);
+	DS_CHECK_EQUAL(assigned.get(copy), 5.0f);
+}
+
+DS_TEST(settings_binary_round_trip) {
+	const ds::test::TempFile	file("settings.dss");
+	Settings				src;
+	fill(src);
+	DS_CHECK(same_as_filled(src));
+	DS_CHECK(src.writeBinaryTo(file.getPath(), "sources-1"));
+
+	// The wrong key leaves me alone
+	Settings				dst;
+	Settings::Editor(dst).setInt("kept", 1);
+	const Settings::Handle<int>	kept("kept", 0);
+	DS_CHECK_EQUAL(kept.get(dst), 1);
+	DS_CHECK(!dst.readBinaryFrom(file.getPath(), "sources-2"));
+	DS_CHECK_EQUAL(dst.getInt("kept", 0, 0), 1);
+
+	// The right one replaces everything, and handles see it
+	DS_CHECK(dst.readBinaryFrom(file.getPath(), "sources-1"));
+	DS_CHECK(same_as_filled(dst));
+	DS_CHECK(!dst.isChanged());
+	DS_CHECK_EQUAL(kept.get(dst), 0);
+	DS_CHECK_EQUAL(dst.getIntSize("kept"), 0);
+}
+
+DS_TEST(settings_binary_rejects_bad_files) {
+	const ds::test::TempFile	file("bad_settings.dss");
+	Settings				dst;
+	DS_CHECK(!dst.readBinaryFrom(file.getPath(), "sources-1"));
+
+	Settings				src;
+	fill(src);
+	DS_CHECK(src.writeBinaryTo(file.getPath(), "sources-1"));
+
+	// Cut short, nothing is loaded
+	const Poco::File::FileSize	size = Poco::File(file.getPath()).getSize();
+	Poco::File(file.getPath()).setSize(size - 4);
+	Settings::Editor(dst).setText("kept", "yes");
+	DS_CHECK(!dst.readBinaryFrom(file.getPath(), "sources-1"));
+	DS_CHECK_EQUAL(dst.getText("kept", 0, ""), "yes");
+	DS_CHECK_EQUAL(dst.getFloatSize("menu:speed"), 0);
+}
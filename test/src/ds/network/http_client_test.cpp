@@ -0,0 +1,227 @@
+#include "ds_test.h"
+
+#include <chrono>
+#include <istream>
+#include <thread>
+#include <vector>
+#include <Poco/File.h>
+#include <Poco/Mutex.h>
+#include <Poco/Net/HTTPRequestHandler.h>
+#include <Poco/Net/HTTPRequestHandlerFactory.h>
+#include <Poco/Net/HTTPServer.h>
+#include <Poco/Net/HTTPServerParams.h>
+#include <Poco/Net/HTTPServerRequest.h>
+#include <Poco/Net/HTTPServerResponse.h>
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/StreamCopier.h>
+#include "ds/network/http_client.h"
+
+namespace {
+// What the server saw, one entry per request
+struct Seen {
+	std::string				mMethod,
+							mPath,
+							mBody;
+	unsigned short			mClientPort;
+};
+
+struct ServerState {
+	ServerState() : mVersion(1) { }
+
+	std::vector<Seen>		getSeen() {
+		Poco::Mutex::ScopedLock		l(mMutex);
+		return mSeen;
+	}
+
+	Poco::Mutex				mMutex;
+	std::vector<Seen>		mSeen;
+	int						mVersion;
+};
+
+/* /etag answers a body with an ETag, and 304 when asked with it.
+ * /plain answers a body. /short promises more body than it sends, then
+ * hangs up. Anything else echoes the method and body.
+ */
+class Handler : public Poco::Net::HTTPRequestHandler {
+public:
+	Handler(ServerState& s) : mState(s) { }
+
+	void					handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response) {
+		Seen				seen;
+		seen.mMethod = request.getMethod();
+		seen.mPath = request.getURI();
+		seen.mClientPort = request.clientAddress().port();
+		Poco::StreamCopier::copyToString(request.stream(), seen.mBody);
+		int					version = 0;
+		{
+			Poco::Mutex::ScopedLock		l(mState.mMutex);
+			mState.mSeen.push_back(seen);
+			version = mState.mVersion;
+		}
+
+		if (seen.mPath == "/etag") {
+			const std::string	etag("\"v" + std::to_string(version) + "\"");
+			if (request.get("If-None-Match", "") == etag) {
+				response.setStatus(Poco::Net::HTTPResponse::HTTP_NOT_MODIFIED);
+				response.setContentLength(0);
+				response.send();
+				return;
+			}
+			response.set("ETag", etag);
+			reply(response, "hello " + std::to_string(version));
+		} else if (seen.mPath == "/plain") {
+			reply(response, "plain");
+		} else if (seen.mPath == "/short") {
+			response.set("ETag", "\"short\"");
+			response.setKeepAlive(false);
+			response.setContentType("text/plain");
+			response.setContentLength(100);
+			response.send() << "cut";
+		} else {
+			reply(response, seen.mMethod + " " + seen.mBody);
+		}
+	}
+
+private:
+	static void				reply(Poco::Net::HTTPServerResponse& response, const std::string& body) {
+		response.setContentType("text/plain");
+		response.setContentLength(static_cast<std::streamsize>(body.size()));
+		response.send() << body;
+	}
+
+	ServerState&			mState;
+};
+
+class Factory : public Poco::Net::HTTPRequestHandlerFactory {
+public:
+	Factory(ServerState& s) : mState(s) { }
+
+	Poco::Net::HTTPRequestHandler*	createRequestHandler(const Poco::Net::HTTPServerRequest&) {
+		return new Handler(mState);
+	}
+
+private:
+	ServerState&			mState;
+};
+
+// A local server on a free port, for as long as I'm around
+class Server {
+public:
+	Server(const int keep_alive_ms = 10000)
+			: mSocket(Poco::Net::SocketAddress("127.0.0.1", 0))
+			, mServer(new Factory(mState), mSocket, params(keep_alive_ms)) {
+		mServer.start();
+	}
+	~Server() {
+		mServer.stopAll(true);
+	}
+
+	std::wstring			url(const std::string& path) const {
+		return L"http://127.0.0.1:" + std::to_wstring(static_cast<int>(mSocket.address().port())) + std::wstring(path.begin(), path.end());
+	}
+
+	ServerState				mState;
+
+private:
+	static Poco::Net::HTTPServerParams*	params(const int keep_alive_ms) {
+		Poco::Net::HTTPServerParams*	p = new Poco::Net::HTTPServerParams();
+		p->setKeepAlive(true);
+		p->setKeepAliveTimeout(Poco::Timespan(0, keep_alive_ms * 1000));
+		return p;
+	}
+
+	Poco::Net::ServerSocket	mSocket;
+	Poco::Net::HTTPServer	mServer;
+};
+
+// Sets the client's cache folder, and turns it off again when I go away
+class CacheFolder {
+public:
+	CacheFolder(const std::string& path)	{ ds::HttpClient::setCacheFolder(path); }
+	~CacheFolder()							{ ds::HttpClient::setCacheFolder(""); }
+};
+
+ds::HttpReply				get(const std::wstring& url) {
+	ds::HttpReply			reply;
+	ds::HttpClient::httpGetAndReply(url, &reply);
+	return reply;
+}
+}
+
+DS_TEST(http_gets_share_a_session) {
+	Server					server;
+	DS_CHECK(get(server.url("/plain")).mMsg == L"plain");
+	DS_CHECK(get(server.url("/plain")).mMsg == L"plain");
+	const std::vector<Seen>	seen = server.mState.getSeen();
+	DS_CHECK_EQUAL(seen.size(), 2u);
+	DS_CHECK_EQUAL(seen[0].mClientPort, seen[1].mClientPort);
+}
+
+DS_TEST(http_get_retries_a_closed_session) {
+	// The server drops idle connections well inside the client's reuse window
+	Server					server(200);
+	DS_CHECK(get(server.url("/plain")).mStatus == ds::HttpReply::REPLY_OK);
+	std::this_thread::sleep_for(std::chrono::milliseconds(600));
+	const ds::HttpReply		reply = get(server.url("/plain"));
+	DS_CHECK(reply.mStatus == ds::HttpReply::REPLY_OK);
+	DS_CHECK(reply.mMsg == L"plain");
+}
+
+DS_TEST(http_posts_never_reuse_a_session) {
+	Server					server;
+	DS_CHECK(get(server.url("/plain")).mStatus == ds::HttpReply::REPLY_OK);
+	ds::HttpReply			reply;
+	ds::HttpClient::httpPostAndReply(server.url("/post"), std::string("abc"), &reply);
+	DS_CHECK(reply.mStatus == ds::HttpReply::REPLY_OK);
+
+	// The POST went out once, on its own connection
+	const std::vector<Seen>	seen = server.mState.getSeen();
+	DS_CHECK_EQUAL(seen.size(), 2u);
+	DS_CHECK_EQUAL(seen[1].mMethod, std::string("POST"));
+	DS_CHECK(seen[0].mClientPort != seen[1].mClientPort);
+}
+
+DS_TEST(http_conditional_get_uses_the_cache) {
+	Server					server;
+	ds::test::TempFile		folder("http_cache");
+	const CacheFolder		cache(folder.getPath());
+
+	const ds::HttpReply		first = get(server.url("/etag"));
+	DS_CHECK(first.mStatus == ds::HttpReply::REPLY_OK && !first.mNotModified);
+	DS_CHECK(first.mMsg == L"hello 1");
+	const ds::HttpReply		second = get(server.url("/etag"));
+	DS_CHECK(second.mStatus == ds::HttpReply::REPLY_OK && second.mNotModified);
+	DS_CHECK(second.mMsg == L"hello 1");
+
+	// A change on the server replaces the entry
+	{
+		Poco::Mutex::ScopedLock		l(server.mState.mMutex);
+		server.mState.mVersion = 2;
+	}
+	const ds::HttpReply		third = get(server.url("/etag"));
+	DS_CHECK(third.mStatus == ds::HttpReply::REPLY_OK && !third.mNotModified);
+	DS_CHECK(third.mMsg == L"hello 2");
+	DS_CHECK(get(server.url("/etag")).mNotModified);
+
+	// One file per URL, and no scratch files left behind
+	std::vector<std::string>	files;
+	Poco::File(folder.getPath()).list(files);
+	DS_CHECK_EQUAL(files.size(), 1u);
+	DS_CHECK(files[0].find(".cache") != std::string::npos);
+}
+
+DS_TEST(http_truncated_body_is_an_error) {
+	Server					server;
+	ds::test::TempFile		folder("http_cache_short");
+	const CacheFolder		cache(folder.getPath());
+
+	const ds::HttpReply		reply = get(server.url("/short"));
+	DS_CHECK(reply.mStatus != ds::HttpReply::REPLY_OK);
+	// Nothing was cached, so the next GET isn't conditional
+	std::vector<std::string>	files;
+	if (Poco::File(folder.getPath()).exists()) Poco::File(folder.getPath()).list(files);
+	DS_CHECK(files.empty());
+	DS_CHECK(get(server.url("/short")).mStatus != ds::HttpReply::REPLY_OK);
+	const std::vector<Seen>	seen = server.mState.getSeen();
+	DS_CHECK_EQUAL(seen.size(), 2u);
+}
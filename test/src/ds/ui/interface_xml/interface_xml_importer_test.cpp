@@ -0,0 +1,177 @@
+#include "ds_test.h"
+
+#include <fstream>
+#include <sstream>
+#include <Poco/File.h>
+#include <Poco/Timestamp.h>
+#include "ds/app/engine/engine_data.h"
+#include "ds/cfg/settings.h"
+#include "ds/ui/interface_xml/interface_xml_importer.h"
+#include "ds/ui/interface_xml/stylesheet_parser.h"
+#include "ds/ui/sprite/sprite.h"
+#include "ds/util/string_util.h"
+#include "headless_engine.h"
+
+using namespace ds::ui;
+
+namespace {
+// Explicit times, so a change never lands in the same clock tick
+const Poco::Timestamp::TimeVal	FIRST_TIME = 1000000000000000LL,
+								SECOND_TIME = FIRST_TIME + 60 * 1000000LL;
+
+void						write_file(const std::string& path, const std::string& text, const Poco::Timestamp::TimeVal time) {
+	{
+		std::ofstream		os(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		os << text;
+	}
+	Poco::File(path).setLastModified(Poco::Timestamp(time));
+}
+
+Stylesheet					parse(const std::string& text) {
+	Stylesheet				s;
+	DS_CHECK(stylesheets::parse_stylesheet(text.begin(), text.end(), s.mRules));
+	s.buildIndex();
+	return s;
+}
+
+// The matching rule indices, space separated
+std::string					match(const Stylesheet& s, const std::string& name, const std::string& classes) {
+	std::vector<size_t>		rules;
+	s.matchRules(name, ds::split(classes, " ", true), rules);
+	std::stringstream		out;
+	for (auto it=rules.begin(), end=rules.end(); it!=end; ++it) out << (it == rules.begin() ? "" : " ") << *it;
+	return out.str();
+}
+
+// A panel styled by a class, with a named child, linking one stylesheet
+struct Files {
+	Files()
+			: mXml("template.xml")
+			, mCss("template.css") {
+		write_file(mCss.getPath(), ".big { width: 200; height: 50 }\n#label { opacity: 0.5 }\n", FIRST_TIME);
+		writeXml("60", FIRST_TIME);
+	}
+
+	void					writeXml(const std::string& height, const Poco::Timestamp::TimeVal time) {
+		write_file(mXml.getPath(), "<link rel=\"stylesheet\" href=\"ds_tests_template.css\" />\n"
+								   "<interface>\n"
+								   "	<sprite name=\"panel\" class=\"big\" height=\"" + height + "\">\n"
+								   "		<sprite name=\"label\" />\n"
+								   "	</sprite>\n"
+								   "</interface>\n", time);
+	}
+
+	const ds::test::TempFile	mXml,
+								mCss;
+};
+
+void						check_panel(const XmlImporter::Template& t) {
+	DS_CHECK_EQUAL(t.mNodes.size(), 1u);
+	if (t.mNodes.size() != 1) return;
+	const XmlImporter::Template::Node&	panel = t.mNodes.front();
+	DS_CHECK_EQUAL(panel.mType, "sprite");
+	DS_CHECK_EQUAL(panel.mName, "panel");
+	DS_CHECK(panel.mCreate);
+	// Stylesheet rules first, then the attributes that overwrite them
+	DS_CHECK_EQUAL(panel.mProperties.size(), 3u);
+	if (panel.mProperties.size() == 3) {
+		DS_CHECK_EQUAL(panel.mProperties[0].mName, "width");
+		DS_CHECK_EQUAL(panel.mProperties[1].mName, "height");
+		DS_CHECK_EQUAL(panel.mProperties[2].mName, "height");
+		DS_CHECK_EQUAL(panel.mProperties[2].mValue, "60");
+		for (size_t k=0; k<3; ++k) DS_CHECK(panel.mProperties[k].mApply);
+	}
+	DS_CHECK_EQUAL(panel.mChildren.size(), 1u);
+	if (panel.mChildren.size() == 1) {
+		DS_CHECK_EQUAL(panel.mChildren.front().mName, "label");
+		DS_CHECK_EQUAL(panel.mChildren.front().mProperties.size(), 1u);
+	}
+}
+}
+
+DS_TEST(stylesheet_matches_rules_in_stylesheet_order) {
+	const Stylesheet		s = parse(".b { opacity: 0.5 }\n"
+									  "#title { color: #ff0000 }\n"
+									  ".a.b { width: 10 }\n"
+									  ".c, .a { height: 20 }\n"
+									  ".a { width: 30 }\n");
+	DS_CHECK_EQUAL(s.mRules.size(), 5u);
+
+	// Found through the id and both classes, but answered in file order, once each
+	DS_CHECK_EQUAL(match(s, "title", "b a"), "0 1 2 3 4");
+	DS_CHECK_EQUAL(match(s, "title", "a b"), "0 1 2 3 4");
+	// Every selector in a matcher has to match
+	DS_CHECK_EQUAL(match(s, "", "a"), "3 4");
+	DS_CHECK_EQUAL(match(s, "", "b"), "0");
+	// Any matcher in a rule will do
+	DS_CHECK_EQUAL(match(s, "other", "c"), "3");
+	DS_CHECK_EQUAL(match(s, "title", ""), "1");
+	DS_CHECK_EQUAL(match(s, "", ""), "");
+}
+
+DS_TEST(xml_template_round_trip) {
+	const Files				files;
+	const ds::test::TempFile	cache("template.dsxt");
+	XmlImporter::Template	src;
+	DS_CHECK(XmlImporter::compileXml(files.mXml.getPath(), src));
+	check_panel(src);
+	DS_CHECK_EQUAL(src.mSources.size(), 2u);
+	DS_CHECK(src.write(cache.getPath()));
+
+	XmlImporter::Template	dst;
+	DS_CHECK(dst.read(cache.getPath()));
+	DS_CHECK_EQUAL(dst.mFilename, src.mFilename);
+	DS_CHECK(dst.mSources == src.mSources);
+	check_panel(dst);
+}
+
+DS_TEST(xml_template_read_rejects_stale_and_bad_files) {
+	const Files				files;
+	const ds::test::TempFile	cache("stale.dsxt");
+	XmlImporter::Template	src;
+	DS_CHECK(XmlImporter::compileXml(files.mXml.getPath(), src));
+	DS_CHECK(src.write(cache.getPath()));
+
+	// A stylesheet changing is enough
+	XmlImporter::Template	dst;
+	Poco::File(files.mCss.getPath()).setLastModified(Poco::Timestamp(SECOND_TIME));
+	DS_CHECK(!dst.read(cache.getPath()));
+	DS_CHECK(dst.empty());
+	Poco::File(files.mCss.getPath()).setLastModified(Poco::Timestamp(FIRST_TIME));
+	DS_CHECK(dst.read(cache.getPath()));
+
+	// Cut short
+	const Poco::File::FileSize	size = Poco::File(cache.getPath()).getSize();
+	Poco::File(cache.getPath()).setSize(size / 2);
+	XmlImporter::Template	cut;
+	DS_CHECK(!cut.read(cache.getPath()));
+	DS_CHECK(cut.empty());
+
+	// Custom types can't be written
+	src.mNodes.front().mChildren.front().mCreate = nullptr;
+	DS_CHECK(!src.write(cache.getPath()));
+}
+
+DS_TEST(xml_load_reuses_the_compiled_file_until_it_changes) {
+	Files					files;
+	ds::cfg::Settings		settings;
+	ds::EngineData			data(settings);
+	ds::test::HeadlessEngine	engine(data);
+	Sprite&					root = engine.getRootSprite();
+
+	XmlImporter::NamedSpriteMap	map;
+	DS_CHECK(XmlImporter::loadXMLto(&root, files.mXml.getPath(), map));
+	DS_CHECK(map["panel"] != nullptr);
+	if (map["panel"]) DS_CHECK_EQUAL(map["panel"]->getHeight(), 60.0f);
+
+	// Same time, so the first compile is reused
+	files.writeXml("70", FIRST_TIME);
+	map.clear();
+	DS_CHECK(XmlImporter::loadXMLto(&root, files.mXml.getPath(), map));
+	if (map["panel"]) DS_CHECK_EQUAL(map["panel"]->getHeight(), 60.0f);
+
+	files.writeXml("70", SECOND_TIME);
+	map.clear();
+	DS_CHECK(XmlImporter::loadXMLto(&root, files.mXml.getPath(), map));
+	if (map["panel"]) DS_CHECK_EQUAL(map["panel"]->getHeight(), 70.0f);
+}
@@ -0,0 +1,234 @@
+#include "ds_test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "ds/ui/ip/ip_kernels.h"
+
+using namespace ds::ui::ip;
+
+namespace {
+// Deterministic noise, so a failure repeats
+std::vector<uint8_t>		make_noise(const size_t size, uint32_t seed) {
+	std::vector<uint8_t>	out(size);
+	for (size_t k=0; k<size; ++k) {
+		seed = seed * 1664525 + 1013904223;
+		out[k] = static_cast<uint8_t>(seed >> 24);
+	}
+	return out;
+}
+
+float						reference_coverage(const float d, const float radius) {
+	if (d > radius) return 0.0f;
+	if (d > radius - 1.0f) return 1.0f - (d - (radius - 1.0f));
+	return 1.0f;
+}
+
+uint8_t						reference_scale(const uint8_t a, const float f) {
+	const int				v = static_cast<int>(static_cast<float>(a) * f);
+	return static_cast<uint8_t>(std::max(0, std::min(255, v)));
+}
+}
+
+DS_TEST(ip_parallel_rows_covers_every_row_once) {
+	const int				counts[] = { 0, 1, 31, 32, 33, 1000, 4097 };
+	for (int c=0; c<7; ++c) {
+		const int			count = counts[c];
+		std::vector<std::atomic<int>>	hits(count);
+		for (int k=0; k<count; ++k) hits[k] = 0;
+		parallel_rows(count, [&hits](const int begin, const int end) {
+			for (int k=begin; k<end; ++k) ++hits[k];
+		}, 8);
+		for (int k=0; k<count; ++k) DS_CHECK_EQUAL(hits[k].load(), 1);
+	}
+}
+
+DS_TEST(ip_parallel_rows_finishes_when_jobs_throw) {
+	// Not a std::exception, so nothing but a catch-all stops it. The pool jobs swallow
+	// theirs, and the calling thread's comes out once every job is done.
+	const int				count = 1000;
+	std::vector<std::atomic<int>>	hits(count);
+	for (int k=0; k<count; ++k) hits[k] = 0;
+	bool					thrown = false;
+	try {
+		parallel_rows(count, [&hits](const int begin, const int end) {
+			for (int k=begin; k<end; ++k) ++hits[k];
+			throw 1;
+		}, 8);
+	} catch (int) {
+		thrown = true;
+	}
+	DS_CHECK(thrown);
+	for (int k=0; k<count; ++k) DS_CHECK_EQUAL(hits[k].load(), 1);
+}
+
+DS_TEST(ip_premultiply_rounds_exactly) {
+	// Every colour against every alpha, at every alpha offset, with a width that
+	// leaves a scalar tail after the wide path
+	for (int offset=0; offset<4; ++offset) {
+		for (int a=0; a<256; ++a) {
+			const int		width = 259;
+			std::vector<uint8_t>	px(width * 4);
+			for (int x=0; x<width; ++x) {
+				for (int c=0; c<4; ++c) px[x * 4 + c] = static_cast<uint8_t>((x + c * 61) & 0xff);
+				px[x * 4 + offset] = static_cast<uint8_t>(a);
+			}
+			const std::vector<uint8_t>	src(px);
+			premultiply_row(px.data(), 4, width, offset);
+			for (int x=0; x<width; ++x) {
+				for (int c=0; c<4; ++c) {
+					const int	in = src[x * 4 + c];
+					const int	expected = (c == offset ? in : (2 * in * a + 255) / 510);
+					DS_CHECK_EQUAL(static_cast<int>(px[x * 4 + c]), expected);
+				}
+			}
+		}
+	}
+}
+
+DS_TEST(ip_premultiply_odd_pixel_sizes) {
+	std::vector<uint8_t>	px = make_noise(3 * 37, 7);
+	const std::vector<uint8_t>	src(px);
+	premultiply_row(px.data(), 3, 37, 2);
+	for (int x=0; x<37; ++x) {
+		const int			a = src[x * 3 + 2];
+		for (int c=0; c<2; ++c) DS_CHECK_EQUAL(static_cast<int>(px[x * 3 + c]), (2 * src[x * 3 + c] * a + 255) / 510);
+		DS_CHECK_EQUAL(px[x * 3 + 2], src[x * 3 + 2]);
+	}
+	// Bad offsets leave the pixels alone
+	premultiply_row(px.data(), 3, 37, 3);
+	premultiply_row(px.data(), 3, 37, -1);
+}
+
+DS_TEST(ip_circle_mask_matches_reference) {
+	const float				radii[] = { 0.5f, 3.0f, 17.25f, 64.0f };
+	for (int r=0; r<4; ++r) {
+		const float			radius = radii[r];
+		const int			size = static_cast<int>(std::ceil(radius * 2.0f)) + 3;
+		const float			cen = static_cast<float>(size) / 2.0f;
+		for (int y=0; y<size; ++y) {
+			std::vector<uint8_t>	px = make_noise(size * 4, y + 1);
+			const std::vector<uint8_t>	src(px);
+			circle_mask_row(px.data() + 3, 4, size, y, cen, cen, radius);
+			const float		dy = cen - static_cast<float>(y);
+			for (int x=0; x<size; ++x) {
+				const float	dx = cen - static_cast<float>(x);
+				const uint8_t	expected = reference_scale(src[x * 4 + 3], reference_coverage(std::sqrt(dx * dx + dy * dy), radius));
+				DS_CHECK_EQUAL(static_cast<int>(px[x * 4 + 3]), static_cast<int>(expected));
+				// Colour is never touched
+				for (int c=0; c<3; ++c) DS_CHECK_EQUAL(px[x * 4 + c], src[x * 4 + c]);
+			}
+		}
+	}
+}
+
+DS_TEST(ip_rounded_rect_mask_only_touches_corners) {
+	const int				w = 40, h = 30;
+	const float				radius = 7.5f;
+	for (int y=0; y<h; ++y) {
+		std::vector<uint8_t>	px(w * 4, 255);
+		rounded_rect_mask_row(px.data() + 3, 4, w, y, h, radius);
+		const float			py = static_cast<float>(y) + 0.5f;
+		for (int x=0; x<w; ++x) {
+			const float		pxf = static_cast<float>(x) + 0.5f;
+			const float		cx = (pxf < radius ? radius : (pxf > w - radius ? w - radius : pxf));
+			const float		cy = (py < radius ? radius : (py > h - radius ? h - radius : py));
+			const float		dx = pxf - cx, dy = py - cy;
+			const bool		corner = (dx != 0.0f && dy != 0.0f);
+			const uint8_t	expected = (corner ? reference_scale(255, reference_coverage(std::sqrt(dx * dx + dy * dy), radius)) : 255);
+			DS_CHECK_EQUAL(static_cast<int>(px[x * 4 + 3]), static_cast<int>(expected));
+		}
+	}
+}
+
+DS_TEST(ip_box_keeps_flat_images_flat) {
+	for (int radius=1; radius<=255; radius+=13) {
+		for (int v=0; v<256; v+=51) {
+			std::vector<uint8_t>	src(64 * 4, static_cast<uint8_t>(v)), dst(64 * 4, 0);
+			box_row(src.data(), dst.data(), 64, 4, radius);
+			for (size_t k=0; k<dst.size(); ++k) DS_CHECK_EQUAL(static_cast<int>(dst[k]), v);
+			box_columns(src.data(), dst.data(), 64, 4, 0, 4, radius);
+			for (size_t k=0; k<dst.size(); ++k) DS_CHECK_EQUAL(static_cast<int>(dst[k]), v);
+		}
+	}
+}
+
+DS_TEST(ip_box_is_close_to_the_true_mean) {
+	const int				w = 97;
+	const std::vector<uint8_t>	src = make_noise(w, 3);
+	for (int radius=1; radius<40; radius+=3) {
+		std::vector<uint8_t>	dst(w);
+		box_row(src.data(), dst.data(), w, 1, radius);
+		for (int x=0; x<w; ++x) {
+			int				sum = 0;
+			for (int k=-radius; k<=radius; ++k) sum += src[std::max(0, std::min(w - 1, x + k))];
+			const double	mean = static_cast<double>(sum) / (radius * 2 + 1);
+			DS_CHECK(std::abs(dst[x] - mean) <= 1.0);
+		}
+	}
+}
+
+DS_TEST(ip_box_row_wide_matches_per_channel) {
+	// Four byte pixels take the wide path; one channel at a time takes the scalar one.
+	const int				w = 131;
+	const std::vector<uint8_t>	src = make_noise(w * 4, 11);
+	const int				radii[] = { 1, 2, 5, 64, 200 };
+	for (int r=0; r<5; ++r) {
+		std::vector<uint8_t>	wide(w * 4);
+		box_row(src.data(), wide.data(), w, 4, radii[r]);
+		for (int c=0; c<4; ++c) {
+			std::vector<uint8_t>	chan(w), out(w);
+			for (int x=0; x<w; ++x) chan[x] = src[x * 4 + c];
+			box_row(chan.data(), out.data(), w, 1, radii[r]);
+			for (int x=0; x<w; ++x) DS_CHECK_EQUAL(static_cast<int>(wide[x * 4 + c]), static_cast<int>(out[x]));
+		}
+	}
+}
+
+DS_TEST(ip_box_columns_wide_matches_single_columns) {
+	// 16 byte groups take the wide path; a single column is always scalar.
+	const int				row_bytes = 16 * 5 + 7, h = 73;
+	const std::vector<uint8_t>	src = make_noise(row_bytes * h, 5);
+	const int				radii[] = { 1, 3, 36, 255 };
+	for (int r=0; r<4; ++r) {
+		std::vector<uint8_t>	wide(row_bytes * h), single(row_bytes * h);
+		box_columns(src.data(), wide.data(), h, row_bytes, 0, row_bytes, radii[r]);
+		for (int k=0; k<row_bytes; ++k) box_columns(src.data(), single.data(), h, row_bytes, k, k + 1, radii[r]);
+		for (size_t k=0; k<wide.size(); ++k) DS_CHECK_EQUAL(static_cast<int>(wide[k]), static_cast<int>(single[k]));
+	}
+}
+
+DS_BENCHMARK(ip_kernels) {
+	const int				w = 1920, h = 1080, row_bytes = w * 4;
+	std::vector<uint8_t>	img = make_noise(row_bytes * h, 1), tmp(row_bytes * h);
+	uint8_t*				data = img.data();
+	uint8_t*				buf = tmp.data();
+
+	ds::test::report("premultiply 1920x1080", ds::test::time_ms([data, row_bytes, w, h]() {
+		parallel_rows(h, [data, row_bytes, w](const int begin, const int end) {
+			for (int y=begin; y<end; ++y) premultiply_row(data + y * row_bytes, 4, w, 3);
+		});
+	}));
+	ds::test::report("circle mask 1080x1080", ds::test::time_ms([data, row_bytes, h]() {
+		parallel_rows(h, [data, row_bytes, h](const int begin, const int end) {
+			for (int y=begin; y<end; ++y) circle_mask_row(data + y * row_bytes + 3, 4, h, y, h / 2.0f, h / 2.0f, h / 2.0f);
+		});
+	}));
+	const int				radii[] = { 2, 16, 128 };
+	for (int r=0; r<3; ++r) {
+		const int			radius = radii[r];
+		std::stringstream	name;
+		name << "box pass 1920x1080 radius " << radius;
+		ds::test::report(name.str(), ds::test::time_ms([data, buf, row_bytes, w, h, radius]() {
+			parallel_rows(h, [data, buf, row_bytes, w, radius](const int begin, const int end) {
+				for (int y=begin; y<end; ++y) box_row(data + y * row_bytes, buf + y * row_bytes, w, 4, radius);
+			});
+			parallel_rows(row_bytes, [data, buf, row_bytes, h, radius](const int begin, const int end) {
+				box_columns(buf, data, h, row_bytes, begin, end, radius);
+			}, 64);
+		}));
+	}
+}
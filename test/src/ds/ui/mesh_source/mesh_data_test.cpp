@@ -0,0 +1,145 @@
+#include "ds_test.h"
+
+#include <fstream>
+#include <vector>
+#include "ds/ui/mesh_source/mesh_data.h"
+#include "ds/ui/mesh_source/mesh_file_loader.h"
+
+using namespace ds::ui;
+
+namespace {
+// A small strip of quads, with something distinct in every field
+MeshData					make_mesh(const int quads) {
+	MeshData				m;
+	for (int k=0; k<=quads; ++k) {
+		const float			x = static_cast<float>(k);
+		m.mPositions.push_back(ci::Vec3f(x, 0.0f, x * 0.5f));
+		m.mPositions.push_back(ci::Vec3f(x, 1.0f, x * -0.25f));
+		m.mNormals.push_back(ci::Vec3f(0.0f, 0.0f, 1.0f + x));
+		m.mNormals.push_back(ci::Vec3f(0.0f, 1.0f, -x));
+		m.mTexCoords.push_back(ci::Vec2f(x / quads, 0.0f));
+		m.mTexCoords.push_back(ci::Vec2f(x / quads, 1.0f));
+	}
+	for (int k=0; k<quads; ++k) {
+		const uint32_t		i = static_cast<uint32_t>(k * 2);
+		const uint32_t		tri[6] = { i, i + 1, i + 2, i + 2, i + 1, i + 3 };
+		m.mIndices.insert(m.mIndices.end(), tri, tri + 6);
+	}
+	return m;
+}
+
+void						check_vec3s(const std::vector<ci::Vec3f>& a, const std::vector<ci::Vec3f>& b) {
+	DS_CHECK_EQUAL(a.size(), b.size());
+	for (size_t k=0; k<a.size(); ++k) {
+		DS_CHECK(a[k].x == b[k].x && a[k].y == b[k].y && a[k].z == b[k].z);
+	}
+}
+
+void						check_same(const MeshData& a, const MeshData& b) {
+	check_vec3s(a.mPositions, b.mPositions);
+	check_vec3s(a.mNormals, b.mNormals);
+	DS_CHECK(a.mIndices == b.mIndices);
+	DS_CHECK_EQUAL(a.mTexCoords.size(), b.mTexCoords.size());
+	for (size_t k=0; k<a.mTexCoords.size(); ++k) {
+		DS_CHECK(a.mTexCoords[k].x == b.mTexCoords[k].x && a.mTexCoords[k].y == b.mTexCoords[k].y);
+	}
+}
+
+std::vector<char>			read_all(const std::string& path) {
+	std::ifstream			is(path.c_str(), std::ios::in | std::ios::binary);
+	return std::vector<char>(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+}
+
+void						write_all(const std::string& path, const std::vector<char>& bytes) {
+	std::ofstream			os(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	os.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+}
+
+DS_TEST(mesh_data_round_trip) {
+	const ds::test::TempFile	file("round_trip.ds3d");
+	const MeshData			src = make_mesh(9);
+	DS_CHECK(src.write(file.getPath()));
+
+	MeshData				dst;
+	DS_CHECK(dst.load(file.getPath()));
+	check_same(src, dst);
+	DS_CHECK_EQUAL(dst.getVboBytes(), src.getVboBytes());
+
+	// Every section starts 16 byte aligned after a 64 byte header
+	const std::vector<char>	bytes = read_all(file.getPath());
+	DS_CHECK(bytes.size() >= 64);
+	const uint32_t*			header = reinterpret_cast<const uint32_t*>(bytes.data());
+	DS_CHECK_EQUAL(header[1], MeshData::FORMAT_VERSION);
+	DS_CHECK_EQUAL(header[3], static_cast<uint32_t>(bytes.size()));
+	for (int k=0; k<4; ++k) DS_CHECK_EQUAL(header[5 + k * 2] % 16, 0u);
+}
+
+DS_TEST(mesh_data_round_trip_without_optional_sections) {
+	const ds::test::TempFile	file("bare.ds3d");
+	MeshData				src = make_mesh(3);
+	src.mNormals.clear();
+	src.mTexCoords.clear();
+	DS_CHECK(src.write(file.getPath()));
+
+	MeshData				dst;
+	DS_CHECK(dst.load(file.getPath()));
+	check_same(src, dst);
+}
+
+DS_TEST(mesh_data_converts_legacy_files) {
+	const ds::test::TempFile	legacy("legacy.mesh"), converted("legacy.ds3d");
+	const MeshData			src = make_mesh(5);
+	{
+		util::MeshFileLoader	writer;
+		writer.setVerts(src.mPositions);
+		writer.setNorms(src.mNormals);
+		writer.setInd(std::vector<unsigned>(src.mIndices.begin(), src.mIndices.end()));
+		writer.setTexs(src.mTexCoords);
+		writer.Write(legacy.getPath());
+	}
+
+	MeshData				direct;
+	DS_CHECK(direct.load(legacy.getPath()));
+	check_same(src, direct);
+
+	DS_CHECK(MeshData::convert(legacy.getPath(), converted.getPath()));
+	MeshData				dst;
+	DS_CHECK(dst.load(converted.getPath()));
+	check_same(src, dst);
+}
+
+DS_TEST(mesh_data_rejects_bad_files) {
+	const ds::test::TempFile	good("good.ds3d"), bad("bad.ds3d");
+	MeshData				out;
+	DS_CHECK(!out.load(bad.getPath()));
+	DS_CHECK(make_mesh(4).write(good.getPath()));
+	const std::vector<char>	bytes = read_all(good.getPath());
+
+	// Truncated, anywhere from inside the header to the last byte
+	const size_t			lengths[] = { 0, 3, 63, 64, bytes.size() / 2, bytes.size() - 1 };
+	for (int k=0; k<6; ++k) {
+		write_all(bad.getPath(), std::vector<char>(bytes.begin(), bytes.begin() + lengths[k]));
+		DS_CHECK(!out.load(bad.getPath()));
+		DS_CHECK(out.empty());
+	}
+
+	// An index past the last vertex
+	{
+		MeshData			m = make_mesh(4);
+		m.mIndices.back() = static_cast<uint32_t>(m.mPositions.size());
+		DS_CHECK(m.write(bad.getPath()));
+		DS_CHECK(!out.load(bad.getPath()));
+	}
+
+	// A newer version, and a section pointing past the end
+	std::vector<char>		edited(bytes);
+	reinterpret_cast<uint32_t*>(edited.data())[1] = MeshData::FORMAT_VERSION + 1;
+	write_all(bad.getPath(), edited);
+	DS_CHECK(!out.load(bad.getPath()));
+
+	edited = bytes;
+	reinterpret_cast<uint32_t*>(edited.data())[4] = 0x10000000;
+	write_all(bad.getPath(), edited);
+	DS_CHECK(!out.load(bad.getPath()));
+}
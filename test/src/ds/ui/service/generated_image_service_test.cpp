@@ -0,0 +1,85 @@
+#include "ds_test.h"
+
+#include <fstream>
+#include <Poco/File.h>
+#include <Poco/Timestamp.h>
+#include "ds/ui/service/generated_image_service.h"
+#include "ds/ui/service/glsl_image_service.h"
+
+using namespace ds::ui;
+
+namespace {
+void						write_file(const std::string& path, const std::string& contents) {
+	std::ofstream			os(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	os << contents;
+}
+
+uint64_t					file_key(const std::string& path) {
+	GeneratedImageKey		key("test", 1);
+	key.addFile(path);
+	return key.getValue();
+}
+}
+
+DS_TEST(generated_key_covers_every_field) {
+	GeneratedImageKey		a("arc", 1), b("arc", 1);
+	a.add("shadow");
+	b.add("shadow");
+	DS_CHECK_EQUAL(a.getValue(), b.getValue());
+
+	// Type, version and parameters all count
+	GeneratedImageKey		type("blur", 1), version("arc", 2);
+	type.add("shadow");
+	version.add("shadow");
+	DS_CHECK(type.getValue() != a.getValue());
+	DS_CHECK(version.getValue() != a.getValue());
+
+	// Strings can't run together
+	GeneratedImageKey		ab("arc", 1), a_b("arc", 1);
+	ab.add("ab");
+	ab.add("");
+	a_b.add("a");
+	a_b.add("b");
+	DS_CHECK(ab.getValue() != a_b.getValue());
+}
+
+DS_TEST(generated_key_follows_file_edits) {
+	ds::test::TempFile		tmp("generated_key.arc");
+	write_file(tmp.getPath(), "<arc/>");
+	const uint64_t			first = file_key(tmp.getPath());
+	DS_CHECK_EQUAL(file_key(tmp.getPath()), first);
+
+	// A missing file still keys on its name
+	DS_CHECK(file_key(tmp.getPath() + ".missing") != first);
+
+	// Same size, new time
+	Poco::File(tmp.getPath()).setLastModified(Poco::Timestamp() - 10 * Poco::Timestamp::resolution());
+	const uint64_t			touched = file_key(tmp.getPath());
+	DS_CHECK(touched != first);
+
+	// New size
+	write_file(tmp.getPath(), "<arc type=\"map\"/>");
+	Poco::File(tmp.getPath()).setLastModified(Poco::Timestamp() - 10 * Poco::Timestamp::resolution());
+	DS_CHECK(file_key(tmp.getPath()) != touched);
+}
+
+DS_TEST(generated_key_resources_include_their_module) {
+	// A rebuild can change a compiled-in resource, so its name alone isn't enough
+	GeneratedImageKey		name_only("test", 1);
+	name_only.add("resource:drop_shadow");
+	DS_CHECK(file_key("resource:drop_shadow") != name_only.getValue());
+	DS_CHECK_EQUAL(file_key("resource:drop_shadow"), file_key("resource:drop_shadow"));
+}
+
+DS_TEST(glsl_image_key_hashes_flags) {
+	const ds::gl::Uniform	uniform;
+	ds::glsl::ImageKey		a, b, c;
+	a.setTo("vert", "frag", uniform, 64, 32, 0);
+	b.setTo("vert", "frag", uniform, 64, 32, 0);
+	c.setTo("vert", "frag", uniform, 64, 32, 1);
+	const ds::glsl::ImageKeyHash	hash;
+	DS_CHECK(a == b);
+	DS_CHECK_EQUAL(hash(a), hash(b));
+	DS_CHECK(!(a == c));
+	DS_CHECK(hash(a) != hash(c));
+}
@@ -0,0 +1,142 @@
+#include "ds_test.h"
+
+#include <vector>
+#include "ds/app/engine/engine_data.h"
+#include "ds/app/event_client.h"
+#include "ds/cfg/settings.h"
+#include "ds/ui/sprite/idle_tracker.h"
+#include "ds/ui/sprite/sprite.h"
+#include "headless_engine.h"
+
+using namespace ds::ui;
+
+namespace {
+// One tracked sprite, with every IdleEvent kept in order
+struct Scene {
+	Scene()
+			: mData(mSettings)
+			, mEngine(mData)
+			, mTracker(mEngine.getIdleTracker())
+			, mSprite(*mEngine.getRootSprite().addChildPtr(new Sprite(mEngine)))
+			, mClient(mEngine.getNotifier(), nullptr) {
+		mClient.listenToEvents<IdleEvent>([this](const IdleEvent& e) { mIdled.push_back(&e.mSprite); });
+	}
+
+	// Move the clock and run a frame's worth of tracking
+	void					updateAt(const double seconds) {
+		mEngine.setElapsedTimeSeconds(seconds);
+		mTracker.update();
+	}
+
+	ds::cfg::Settings		mSettings;
+	ds::EngineData			mData;
+	ds::test::HeadlessEngine	mEngine;
+	IdleTracker&			mTracker;
+	Sprite&					mSprite;
+	ds::EventClient			mClient;
+	std::vector<const Sprite*>
+							mIdled;
+};
+}
+
+DS_TEST(idle_expiry_sends_one_event) {
+	Scene					scene;
+	scene.mSprite.setSecondBeforeIdle(1.0);
+	DS_CHECK_EQUAL(scene.mTracker.size(), 1u);
+
+	scene.updateAt(0.5);
+	DS_CHECK(scene.mIdled.empty());
+	DS_CHECK(!scene.mSprite.isIdling());
+	DS_CHECK_EQUAL(scene.mSprite.secondsToIdle(), 0.5);
+
+	scene.updateAt(2.0);
+	DS_CHECK_EQUAL(scene.mIdled.size(), 1u);
+	if (!scene.mIdled.empty()) DS_CHECK(scene.mIdled.front() == &scene.mSprite);
+	DS_CHECK(scene.mSprite.isIdling());
+
+	// Staying idle, or being told to idle again, says nothing more
+	scene.updateAt(10.0);
+	scene.mSprite.startIdling();
+	DS_CHECK_EQUAL(scene.mIdled.size(), 1u);
+}
+
+DS_TEST(idle_reset_pushes_the_deadline_back) {
+	Scene					scene;
+	scene.mSprite.setSecondBeforeIdle(5.0);
+	scene.updateAt(4.0);
+	scene.mSprite.resetIdleTimer();
+	DS_CHECK_EQUAL(scene.mSprite.secondsToIdle(), 5.0);
+	DS_CHECK_EQUAL(scene.mTracker.pending(), 1u);
+
+	// The first deadline comes due and goes back into the heap for 9
+	scene.updateAt(6.0);
+	DS_CHECK(scene.mIdled.empty());
+	DS_CHECK_EQUAL(scene.mTracker.pending(), 1u);
+	scene.updateAt(8.5);
+	DS_CHECK(scene.mIdled.empty());
+	scene.updateAt(9.5);
+	DS_CHECK_EQUAL(scene.mIdled.size(), 1u);
+	DS_CHECK_EQUAL(scene.mTracker.pending(), 0u);
+
+	// Once idle, a reset starts a new wait
+	scene.mSprite.resetIdleTimer();
+	DS_CHECK(!scene.mSprite.isIdling());
+	scene.updateAt(12.0);
+	DS_CHECK_EQUAL(scene.mIdled.size(), 1u);
+	scene.updateAt(15.0);
+	DS_CHECK_EQUAL(scene.mIdled.size(), 2u);
+}
+
+DS_TEST(idle_set_retires_old_deadlines) {
+	Scene					scene;
+	// Shorter, then longer: the early deadline is stale and dropped, not pushed back
+	scene.mSprite.setSecondBeforeIdle(2.0);
+	scene.mSprite.setSecondBeforeIdle(10.0);
+	DS_CHECK_EQUAL(scene.mTracker.pending(), 2u);
+	scene.updateAt(3.0);
+	DS_CHECK(scene.mIdled.empty());
+	DS_CHECK_EQUAL(scene.mTracker.pending(), 1u);
+	scene.updateAt(11.0);
+	DS_CHECK_EQUAL(scene.mIdled.size(), 1u);
+	DS_CHECK_EQUAL(scene.mTracker.pending(), 0u);
+
+	// Longer, then shorter: the new one fires early, and the old one is dropped when it comes due
+	scene.mSprite.setSecondBeforeIdle(10.0);
+	scene.mSprite.setSecondBeforeIdle(2.0);
+	DS_CHECK(!scene.mSprite.isIdling());
+	scene.updateAt(14.0);
+	DS_CHECK_EQUAL(scene.mIdled.size(), 2u);
+	DS_CHECK_EQUAL(scene.mTracker.pending(), 1u);
+	scene.mSprite.resetIdleTimer();
+	DS_CHECK_EQUAL(scene.mTracker.pending(), 2u);
+	scene.updateAt(21.5);
+	DS_CHECK_EQUAL(scene.mIdled.size(), 3u);
+	DS_CHECK_EQUAL(scene.mTracker.pending(), 0u);
+	DS_CHECK_EQUAL(scene.mTracker.size(), 1u);
+}
+
+DS_TEST(idle_removed_and_deleted_sprites_never_fire) {
+	Scene					scene;
+	scene.mSprite.setSecondBeforeIdle(1.0);
+	scene.mSprite.clearIdleTimer();
+	DS_CHECK_EQUAL(scene.mTracker.size(), 0u);
+	DS_CHECK(!scene.mSprite.isIdling());
+	DS_CHECK_EQUAL(scene.mSprite.secondsToIdle(), 0.0);
+	scene.updateAt(2.0);
+	DS_CHECK(scene.mIdled.empty());
+
+	Sprite*					gone = scene.mEngine.getRootSprite().addChildPtr(new Sprite(scene.mEngine));
+	gone->setSecondBeforeIdle(1.0);
+	DS_CHECK_EQUAL(scene.mTracker.size(), 1u);
+	gone->release();
+	DS_CHECK_EQUAL(scene.mTracker.size(), 0u);
+	scene.updateAt(4.0);
+	DS_CHECK(scene.mIdled.empty());
+	DS_CHECK_EQUAL(scene.mTracker.pending(), 0u);
+
+	// Untracked sprites answer the defaults, and removing them is harmless
+	scene.mTracker.remove(scene.mSprite);
+	scene.mTracker.reset(scene.mSprite);
+	scene.mTracker.startIdling(scene.mSprite);
+	DS_CHECK(scene.mIdled.empty());
+}
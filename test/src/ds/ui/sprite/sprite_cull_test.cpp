@@ -0,0 +1,140 @@
+#include "ds_test.h"
+
+#include "ds/app/engine/engine_data.h"
+#include "ds/cfg/settings.h"
+#include "ds/ui/sprite/sprite.h"
+#include "headless_engine.h"
+
+using namespace ds::ui;
+
+namespace ds {
+namespace test {
+// The cull bounds are private; this does what a culled draw does to them, minus the GL.
+class SpriteAccess {
+public:
+	static void					update(Sprite& s) {
+		if (!s.visible()) return;
+		for (auto it=s.mChildren.begin(), end=s.mChildren.end(); it!=end; ++it) update(**it);
+		s.getTransform();
+		if (s.mCullBoundsDirty) s.updateCullBounds();
+	}
+
+	static bool					isDirty(const Sprite& s)		{ return s.mCullBoundsDirty; }
+	static bool					isUnbounded(const Sprite& s)	{ return s.mCullUnbounded; }
+	static bool					isEmpty(const Sprite& s)		{ return s.mCullEmpty; }
+	static const ci::Rectf&		getBounds(const Sprite& s)		{ return s.mCullBounds; }
+	static size_t				getSprites(const Sprite& s)		{ return s.mCullSprites; }
+};
+} // namespace test
+} // namespace ds
+
+using ds::test::SpriteAccess;
+
+namespace {
+Sprite&						add_quad(Sprite& parent, const float x, const float y, const float w, const float h) {
+	Sprite*					s = parent.addChildPtr(new Sprite(parent.getEngine(), w, h));
+	s->setPosition(x, y);
+	s->setTransparent(false);
+	return *s;
+}
+
+bool						same_rect(const ci::Rectf& a, const float x1, const float y1, const float x2, const float y2) {
+	return a.x1 == x1 && a.y1 == y1 && a.x2 == x2 && a.y2 == y2;
+}
+
+// A transparent group at (100, 100) holding one 10x10 quad at (5, 5)
+struct Scene {
+	Scene()
+			: mData(mSettings)
+			, mEngine(mData)
+			, mGroup(*mEngine.getRootSprite().addChildPtr(new Sprite(mEngine)))
+			, mQuad(add_quad(mGroup, 5.0f, 5.0f, 10.0f, 10.0f)) {
+		mGroup.setPosition(100.0f, 100.0f);
+		SpriteAccess::update(mEngine.getRootSprite());
+	}
+
+	bool					allDirty() const {
+		return SpriteAccess::isDirty(mQuad) && SpriteAccess::isDirty(mGroup) && SpriteAccess::isDirty(mEngine.getRootSprite());
+	}
+
+	ds::cfg::Settings		mSettings;
+	ds::EngineData			mData;
+	ds::test::HeadlessEngine	mEngine;
+	Sprite&					mGroup;
+	Sprite&					mQuad;
+};
+}
+
+DS_TEST(cull_bounds_gather_children_into_parent_space) {
+	Scene					scene;
+	DS_CHECK(!SpriteAccess::isDirty(scene.mGroup));
+	DS_CHECK(!SpriteAccess::isUnbounded(scene.mGroup));
+	DS_CHECK(!SpriteAccess::isEmpty(scene.mGroup));
+	DS_CHECK(same_rect(SpriteAccess::getBounds(scene.mQuad), 5.0f, 5.0f, 15.0f, 15.0f));
+	DS_CHECK(same_rect(SpriteAccess::getBounds(scene.mGroup), 105.0f, 105.0f, 115.0f, 115.0f));
+	DS_CHECK_EQUAL(SpriteAccess::getSprites(scene.mGroup), 2u);
+}
+
+DS_TEST(cull_bounds_dirty_up_the_tree_on_move_and_size) {
+	Scene					scene;
+	scene.mQuad.setPosition(20.0f, 20.0f);
+	DS_CHECK(scene.allDirty());
+	SpriteAccess::update(scene.mEngine.getRootSprite());
+	DS_CHECK(same_rect(SpriteAccess::getBounds(scene.mGroup), 120.0f, 120.0f, 130.0f, 130.0f));
+
+	scene.mQuad.setSize(40.0f, 30.0f);
+	DS_CHECK(scene.allDirty());
+	SpriteAccess::update(scene.mEngine.getRootSprite());
+	DS_CHECK(same_rect(SpriteAccess::getBounds(scene.mGroup), 120.0f, 120.0f, 160.0f, 150.0f));
+
+	// Moving the group leaves the quad's own bounds alone
+	scene.mGroup.setPosition(0.0f, 0.0f);
+	DS_CHECK(!SpriteAccess::isDirty(scene.mQuad));
+	DS_CHECK(SpriteAccess::isDirty(scene.mGroup));
+	SpriteAccess::update(scene.mEngine.getRootSprite());
+	DS_CHECK(same_rect(SpriteAccess::getBounds(scene.mGroup), 20.0f, 20.0f, 60.0f, 50.0f));
+}
+
+DS_TEST(cull_bounds_dirty_on_children_and_visibility) {
+	Scene					scene;
+	Sprite&					other = add_quad(scene.mGroup, 50.0f, 0.0f, 10.0f, 10.0f);
+	DS_CHECK(SpriteAccess::isDirty(scene.mGroup));
+	SpriteAccess::update(scene.mEngine.getRootSprite());
+	DS_CHECK(same_rect(SpriteAccess::getBounds(scene.mGroup), 105.0f, 100.0f, 160.0f, 115.0f));
+	DS_CHECK_EQUAL(SpriteAccess::getSprites(scene.mGroup), 3u);
+
+	// A hidden child drops out
+	other.hide();
+	DS_CHECK(SpriteAccess::isDirty(scene.mGroup));
+	SpriteAccess::update(scene.mEngine.getRootSprite());
+	DS_CHECK(same_rect(SpriteAccess::getBounds(scene.mGroup), 105.0f, 105.0f, 115.0f, 115.0f));
+
+	// Showing it again marks upwards, even though it was dirty while hidden
+	other.show();
+	DS_CHECK(SpriteAccess::isDirty(scene.mGroup));
+	SpriteAccess::update(scene.mEngine.getRootSprite());
+	DS_CHECK_EQUAL(SpriteAccess::getSprites(scene.mGroup), 3u);
+
+	scene.mGroup.removeChild(other);
+	DS_CHECK(SpriteAccess::isDirty(scene.mGroup));
+	SpriteAccess::update(scene.mEngine.getRootSprite());
+	DS_CHECK(same_rect(SpriteAccess::getBounds(scene.mGroup), 105.0f, 105.0f, 115.0f, 115.0f));
+	DS_CHECK_EQUAL(SpriteAccess::getSprites(scene.mGroup), 2u);
+	other.release();
+}
+
+DS_TEST(cull_bounds_unbounded_for_opaque_without_size) {
+	Scene					scene;
+	Sprite&					blank = add_quad(scene.mGroup, 0.0f, 0.0f, 0.0f, 0.0f);
+	SpriteAccess::update(scene.mEngine.getRootSprite());
+	DS_CHECK(SpriteAccess::isUnbounded(blank));
+	DS_CHECK(SpriteAccess::isUnbounded(scene.mGroup));
+	DS_CHECK(SpriteAccess::isUnbounded(scene.mEngine.getRootSprite()));
+
+	// Transparent, it draws nothing of its own and stops counting
+	blank.setTransparent(true);
+	DS_CHECK(SpriteAccess::isDirty(scene.mGroup));
+	SpriteAccess::update(scene.mEngine.getRootSprite());
+	DS_CHECK(!SpriteAccess::isUnbounded(scene.mGroup));
+	DS_CHECK(same_rect(SpriteAccess::getBounds(scene.mGroup), 105.0f, 105.0f, 115.0f, 115.0f));
+}
@@ -0,0 +1,102 @@
+#include "ds_test.h"
+
+#include "ds/cfg/settings.h"
+#include "ds/ui/sprite/text_layout_cache.h"
+
+using namespace ds::ui;
+
+namespace {
+TextLayoutCache::Key		make_key(const std::wstring& text) {
+	TextLayoutCache::Key	key;
+	key.mText = text;
+	key.mFont = "font.ttf";
+	key.mFontSize = 12.0f;
+	return key;
+}
+
+// No font lays out as no lines, which is all the cache needs
+TextLayoutCache::EntryRef	get(TextLayoutCache& cache, const std::wstring& text) {
+	return cache.get(make_key(text), nullptr);
+}
+
+void						set_max_entries(TextLayoutCache& cache, const int n) {
+	ds::cfg::Settings		settings;
+	ds::cfg::Settings::Editor(settings).setInt("text:layout_cache", n);
+	cache.setup(settings);
+}
+}
+
+DS_TEST(text_cache_keys_cover_every_field) {
+	const TextLayoutCache::Key	a = make_key(L"a");
+	DS_CHECK(a == make_key(L"a"));
+	DS_CHECK(!(a == make_key(L"b")));
+
+	TextLayoutCache::Key	k = a;
+	k.mFont = "other.ttf";
+	DS_CHECK(!(a == k));
+	k = a;
+	k.mFontSize = 13.0f;
+	DS_CHECK(!(a == k));
+	k = a;
+	k.mKind = TextLayoutCache::VERTICAL;
+	DS_CHECK(!(a == k));
+	k.mWidth = 100.0f;
+	TextLayoutCache::Key	tall = k;
+	tall.mHeight = 50.0f;
+	DS_CHECK(!(k == tall));
+	TextLayoutCache::Key	led = k;
+	led.mLeading = 1.5f;
+	DS_CHECK(!(k == led));
+	TextLayoutCache::Key	right = k;
+	right.mAlignment = Alignment::kRight;
+	DS_CHECK(!(k == right));
+}
+
+DS_TEST(text_cache_counts_hits_and_misses) {
+	TextLayoutCache			cache;
+	const TextLayoutCache::EntryRef	first = get(cache, L"hello");
+	DS_CHECK(first != nullptr);
+	DS_CHECK(get(cache, L"hello") == first);
+	get(cache, L"world");
+	DS_CHECK_EQUAL(cache.size(), 2u);
+	DS_CHECK_EQUAL(cache.getHits(), 1u);
+	DS_CHECK_EQUAL(cache.getMisses(), 2u);
+}
+
+DS_TEST(text_cache_evicts_least_recently_used) {
+	TextLayoutCache			cache;
+	set_max_entries(cache, 3);
+	const TextLayoutCache::EntryRef	a = get(cache, L"a");
+	const TextLayoutCache::EntryRef	b = get(cache, L"b");
+	get(cache, L"c");
+	// Touching a makes b the oldest
+	DS_CHECK(get(cache, L"a") == a);
+	get(cache, L"d");
+	DS_CHECK_EQUAL(cache.size(), 3u);
+	DS_CHECK(get(cache, L"a") == a);
+	const size_t			misses = cache.getMisses();
+	DS_CHECK(get(cache, L"b") != b);
+	DS_CHECK_EQUAL(cache.getMisses(), misses + 1);
+
+	// Shrinking drops the oldest right away
+	set_max_entries(cache, 1);
+	DS_CHECK_EQUAL(cache.size(), 1u);
+	set_max_entries(cache, 0);
+	DS_CHECK(!cache.isEnabled());
+	DS_CHECK_EQUAL(cache.size(), 0u);
+}
+
+DS_TEST(text_cache_prefetch_lands_on_update) {
+	TextLayoutCache			cache;
+	const TextLayoutCache::Key	key = make_key(L"later");
+	DS_CHECK(cache.prefetch(key, nullptr) == nullptr);
+	// Asking again while it's queued isn't another miss
+	DS_CHECK(cache.prefetch(key, nullptr) == nullptr);
+	DS_CHECK_EQUAL(cache.getMisses(), 1u);
+	DS_CHECK_EQUAL(cache.size(), 0u);
+
+	cache.update();
+	DS_CHECK_EQUAL(cache.size(), 1u);
+	DS_CHECK(cache.prefetch(key, nullptr) != nullptr);
+	DS_CHECK_EQUAL(cache.getHits(), 1u);
+}
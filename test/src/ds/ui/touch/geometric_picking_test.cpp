@@ -0,0 +1,198 @@
+#include "ds_test.h"
+
+#include <cstdint>
+#include <vector>
+#include <cinder/Camera.h>
+#include "ds/app/engine/engine_data.h"
+#include "ds/cfg/settings.h"
+#include "ds/ui/touch/geometric_picking.h"
+#include "headless_engine.h"
+
+using namespace ds::ui;
+
+namespace {
+const float					W = 1920.0f, H = 1080.0f;
+
+// Deterministic, so a failure repeats
+class Random {
+public:
+	Random(const uint32_t seed) : mSeed(seed) { }
+	float					next(const float lo, const float hi) {
+		mSeed = mSeed * 1664525 + 1013904223;
+		return lo + (hi - lo) * static_cast<float>(mSeed >> 8) / static_cast<float>(1 << 24);
+	}
+private:
+	uint32_t				mSeed;
+};
+
+// Sprites start out transparent and disabled, which picking passes through
+Sprite&						add_quad(Sprite& parent, const float x, const float y, const float z, const float w, const float h) {
+	Sprite*					s = parent.addChildPtr(new Sprite(parent.getEngine(), w, h));
+	s->setPosition(x, y, z);
+	s->setTransparent(false);
+	s->enable(true);
+	return *s;
+}
+
+// What the exact point GL select would answer: the projected quad holds the
+// point on screen. Layers in these tests never interpenetrate, so the one
+// nearest the eye is the one with the greatest z.
+bool						projects_over(const ci::Camera& cam, const Sprite& s, const ci::Vec2f& pt) {
+	const ci::Matrix44f&	m = s.getGlobalTransform();
+	const ci::Vec3f			local[4] = { ci::Vec3f(0.0f, 0.0f, 0.0f), ci::Vec3f(s.getWidth(), 0.0f, 0.0f),
+										 ci::Vec3f(s.getWidth(), s.getHeight(), 0.0f), ci::Vec3f(0.0f, s.getHeight(), 0.0f) };
+	ci::Vec2f				screen[4];
+	for (int k=0; k<4; ++k) screen[k] = cam.worldToScreen(m.transformPointAffine(local[k]), W, H);
+	int						sign = 0;
+	for (int k=0; k<4; ++k) {
+		const ci::Vec2f		a = screen[k], b = screen[(k + 1) % 4];
+		const float			cross = (b.x - a.x) * (pt.y - a.y) - (b.y - a.y) * (pt.x - a.x);
+		const int			side = (cross > 0.0f ? 1 : -1);
+		if (sign == 0) sign = side;
+		else if (side != sign) return false;
+	}
+	return true;
+}
+
+ci::CameraPersp				make_persp() {
+	ci::CameraPersp			cam(static_cast<int>(W), static_cast<int>(H), 60.0f, 1.0f, 10000.0f);
+	cam.setEyePoint(ci::Vec3f(W / 2.0f, H / 2.0f, 1500.0f));
+	cam.setCenterOfInterestPoint(ci::Vec3f(W / 2.0f, H / 2.0f, 0.0f));
+	return cam;
+}
+
+ci::CameraOrtho				make_ortho() {
+	// As OrthRoot sets it up, with y down the screen
+	ci::CameraOrtho			cam;
+	cam.setOrtho(0.0f, W, H, 0.0f, -1000.0f, 1000.0f);
+	return cam;
+}
+
+struct Scene {
+	Scene() : mData(mSettings), mEngine(mData) { mEngine.getRootSprite().setSize(W, H); }
+
+	ds::cfg::Settings		mSettings;
+	ds::EngineData			mData;
+	ds::test::HeadlessEngine	mEngine;
+};
+}
+
+DS_TEST(picking_overlapping_last_drawn_wins) {
+	Scene					scene;
+	Sprite&					root = scene.mEngine.getRootSprite();
+	Sprite&					under = add_quad(root, 100.0f, 100.0f, 0.0f, 400.0f, 400.0f);
+	Sprite&					over = add_quad(root, 300.0f, 300.0f, 0.0f, 400.0f, 400.0f);
+	const ci::CameraOrtho	cam = make_ortho();
+	ds::GeometricPicking	pick(cam);
+	pick.setWorldSize(ci::Vec2f(W, H));
+
+	DS_CHECK(pick.pickAt(ci::Vec2f(150.0f, 150.0f), root) == &under);
+	DS_CHECK(pick.pickAt(ci::Vec2f(400.0f, 400.0f), root) == &over);
+	DS_CHECK(pick.pickAt(ci::Vec2f(650.0f, 650.0f), root) == &over);
+	// The exact point, where select picked anything in an 8x8 region around it
+	DS_CHECK(pick.pickAt(ci::Vec2f(703.0f, 650.0f), root) == nullptr);
+	DS_CHECK(pick.pickAt(ci::Vec2f(97.0f, 150.0f), root) == nullptr);
+}
+
+DS_TEST(picking_ortho_matches_sprite_hits) {
+	// Overlapping, rotated, scaled and nested quads, against the ortho hit test
+	Scene					scene;
+	Sprite&					root = scene.mEngine.getRootSprite();
+	Random					rnd(17);
+	for (int k=0; k<24; ++k) {
+		Sprite&				s = add_quad(root, rnd.next(0.0f, W), rnd.next(0.0f, H), 0.0f, rnd.next(20.0f, 500.0f), rnd.next(20.0f, 500.0f));
+		s.setRotation(rnd.next(0.0f, 360.0f));
+		s.setScale(rnd.next(0.5f, 2.0f), rnd.next(0.5f, 2.0f), 1.0f);
+		if (k % 3 == 0) {
+			Sprite&			child = add_quad(s, rnd.next(-50.0f, 50.0f), rnd.next(-50.0f, 50.0f), 0.0f, rnd.next(20.0f, 200.0f), rnd.next(20.0f, 200.0f));
+			child.setRotation(rnd.next(0.0f, 360.0f));
+		}
+	}
+	const ci::CameraOrtho	cam = make_ortho();
+	ds::GeometricPicking	pick(cam);
+	pick.setWorldSize(ci::Vec2f(W, H));
+
+	for (int k=0; k<2000; ++k) {
+		const ci::Vec2f		pt(rnd.next(0.0f, W), rnd.next(0.0f, H));
+		DS_CHECK(pick.pickAt(pt, root) == root.getHit(ci::Vec3f(pt.x, pt.y, 0.0f)));
+	}
+}
+
+DS_TEST(picking_perspective_matches_projected_quads) {
+	// Quads tilted out of the screen on separate z layers, seen in perspective
+	Scene					scene;
+	Sprite&					root = scene.mEngine.getRootSprite();
+	Random					rnd(29);
+	std::vector<Sprite*>	quads;
+	for (int k=0; k<12; ++k) {
+		// Tilted 20 degrees at most, a quad reaches 70 either side of its z, short of the next layer
+		Sprite&				s = add_quad(root, rnd.next(0.0f, W - 200.0f), rnd.next(0.0f, H - 200.0f), -900.0f + 150.0f * k, 200.0f, 200.0f);
+		s.setCenter(0.5f, 0.5f);
+		s.setRotation(rnd.next(-20.0f, 20.0f), rnd.next(-20.0f, 20.0f), rnd.next(0.0f, 360.0f));
+		quads.push_back(&s);
+	}
+	const ci::CameraPersp	cam = make_persp();
+	ds::GeometricPicking	pick(cam);
+	pick.setWorldSize(ci::Vec2f(W, H));
+
+	for (int k=0; k<2000; ++k) {
+		const ci::Vec2f		pt(rnd.next(0.0f, W), rnd.next(0.0f, H));
+		// Later quads are nearer the eye
+		Sprite*				expected = nullptr;
+		for (auto it=quads.begin(), end=quads.end(); it!=end; ++it) {
+			if (projects_over(cam, **it, pt)) expected = *it;
+		}
+		DS_CHECK(pick.pickAt(pt, root) == expected);
+	}
+}
+
+DS_TEST(picking_nearest_wins_over_draw_order) {
+	// Drawn first but nearer the eye, so it's what the depth test would show
+	Scene					scene;
+	Sprite&					root = scene.mEngine.getRootSprite();
+	Sprite&					front = add_quad(root, 800.0f, 400.0f, 300.0f, 300.0f, 300.0f);
+	Sprite&					behind = add_quad(root, 700.0f, 300.0f, -300.0f, 600.0f, 600.0f);
+	const ci::CameraPersp	cam = make_persp();
+	ds::GeometricPicking	pick(cam);
+	pick.setWorldSize(ci::Vec2f(W, H));
+
+	const ci::Vec2f			centre = cam.worldToScreen(ci::Vec3f(950.0f, 550.0f, 300.0f), W, H);
+	DS_CHECK(pick.pickAt(centre, root) == &front);
+	// Out past the front one's silhouette
+	const ci::Vec2f			edge = cam.worldToScreen(ci::Vec3f(710.0f, 310.0f, -300.0f), W, H);
+	DS_CHECK(pick.pickAt(edge, root) == &behind);
+}
+
+DS_TEST(picking_follows_select_rules) {
+	Scene					scene;
+	Sprite&					root = scene.mEngine.getRootSprite();
+	Sprite&					back = add_quad(root, 0.0f, 0.0f, 0.0f, 1000.0f, 1000.0f);
+	const ci::CameraOrtho	cam = make_ortho();
+	ds::GeometricPicking	pick(cam);
+	pick.setWorldSize(ci::Vec2f(W, H));
+
+	// Transparent and disabled sprites are passed through
+	Sprite&					glass = add_quad(root, 100.0f, 100.0f, 0.0f, 100.0f, 100.0f);
+	glass.setTransparent(true);
+	DS_CHECK(pick.pickAt(ci::Vec2f(150.0f, 150.0f), root) == &back);
+	glass.setTransparent(false);
+	glass.enable(false);
+	DS_CHECK(pick.pickAt(ci::Vec2f(150.0f, 150.0f), root) == &back);
+
+	// Invisible sprites hide their children too
+	Sprite&					hidden = add_quad(root, 300.0f, 300.0f, 0.0f, 100.0f, 100.0f);
+	Sprite&					hidden_child = add_quad(hidden, 10.0f, 10.0f, 0.0f, 50.0f, 50.0f);
+	hidden.hide();
+	DS_CHECK(pick.pickAt(ci::Vec2f(320.0f, 320.0f), root) == &back);
+	hidden.show();
+	DS_CHECK(pick.pickAt(ci::Vec2f(320.0f, 320.0f), root) == &hidden_child);
+
+	// Clipping bounds the children
+	Sprite&					clip = add_quad(root, 500.0f, 500.0f, 0.0f, 100.0f, 100.0f);
+	Sprite&					clipped = add_quad(clip, 50.0f, 50.0f, 0.0f, 200.0f, 200.0f);
+	clip.setClipping(true);
+	DS_CHECK(pick.pickAt(ci::Vec2f(580.0f, 580.0f), root) == &clipped);
+	DS_CHECK(pick.pickAt(ci::Vec2f(650.0f, 650.0f), root) == &back);
+	clip.setClipping(false);
+	DS_CHECK(pick.pickAt(ci::Vec2f(650.0f, 650.0f), root) == &clipped);
+}
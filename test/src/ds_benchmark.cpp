@@ -0,0 +1,33 @@
+#include <iostream>
+#include <string>
+#include "ds/app/engine/engine_data.h"
+#include "ds/cfg/settings.h"
+#include "ds/debug/benchmark.h"
+#include "headless_engine.h"
+
+/* Usage: ds_benchmark [settings.xml]
+ * Runs ds::Benchmark on a HeadlessEngine, with no window or GL, so it can
+ * run anywhere the platform builds. The settings file takes the same
+ * "benchmark:" keys as debug.xml; enabled and quit are ignored, and the
+ * touch scene is skipped. Prints the results file and answers 0 if it was
+ * written.
+ ******************************************************************/
+int main(int argc, char* argv[]) {
+	ds::cfg::Settings			settings;
+	if (argc > 1) settings.readFrom(argv[1], false);
+
+	const ds::cfg::Settings		engine_settings;
+	ds::EngineData				data(engine_settings);
+	std::string					results;
+	{
+		ds::test::HeadlessEngine	engine(data);
+		ds::Benchmark			benchmark(engine, engine.getRootSprite(), settings);
+		results = benchmark.run();
+	}
+	if (results.empty()) {
+		std::cerr << "Benchmark failed" << std::endl;
+		return 1;
+	}
+	std::cout << results << std::endl;
+	return 0;
+}
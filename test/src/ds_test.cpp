@@ -0,0 +1,130 @@
+#include "ds_test.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include <Poco/Timestamp.h>
+
+namespace ds {
+namespace test {
+
+namespace {
+class Entry {
+public:
+	Entry(const char* name, void (*fn)(), const bool benchmark) : mName(name), mFn(fn), mBenchmark(benchmark) { }
+	const char*				mName;
+	void					(*mFn)();
+	bool					mBenchmark;
+};
+
+// Filled during static construction, so it has to construct itself first
+std::vector<Entry>&			get_cases() {
+	static std::vector<Entry>	CASES;
+	return CASES;
+}
+}
+
+/**
+ * \class ds::test::Case
+ */
+Case::Case(const char* name, void (*fn)(), const bool benchmark) {
+	get_cases().push_back(Entry(name, fn, benchmark));
+}
+
+/**
+ * \class ds::test::Failure
+ */
+Failure::Failure(const std::string& what)
+		: mWhat(what) {
+}
+
+/**
+ * \class ds::test::TempFile
+ */
+TempFile::TempFile(const std::string& name)
+		: mPath(Poco::Path(Poco::Path::temp()).append("ds_tests_" + name).toString()) {
+	try {
+		Poco::File(mPath).remove(true);
+	} catch (std::exception const&) {
+	}
+}
+
+TempFile::~TempFile() {
+	try {
+		Poco::File(mPath).remove(true);
+	} catch (std::exception const&) {
+	}
+}
+
+const std::string& TempFile::getPath() const {
+	return mPath;
+}
+
+void fail(const char* file, const int line, const std::string& what) {
+	std::stringstream		buf;
+	buf << file << "(" << line << "): " << what;
+	throw Failure(buf.str());
+}
+
+double time_ms(const std::function<void(void)>& fn, const int runs) {
+	double					best = -1.0;
+	for (int k=0; k<std::max(1, runs); ++k) {
+		const Poco::Timestamp	start;
+		fn();
+		const double		ms = static_cast<double>(start.elapsed()) / 1000.0;
+		if (best < 0.0 || ms < best) best = ms;
+	}
+	return best;
+}
+
+void report(const std::string& name, const double ms, const std::string& note) {
+	std::cout << "  " << name << ": " << ms << " ms";
+	if (!note.empty()) std::cout << " (" << note << ")";
+	std::cout << std::endl;
+}
+
+} // namespace test
+} // namespace ds
+
+/* Usage: ds_tests [--bench] [name...]
+ * Runs every test, or every benchmark with --bench. Names pick out the cases
+ * that contain any of them. Answers the number of failed tests.
+ ******************************************************************/
+int main(int argc, char* argv[]) {
+	bool						bench = false;
+	std::vector<std::string>	names;
+	for (int k=1; k<argc; ++k) {
+		const std::string		arg(argv[k]);
+		if (arg == "--bench") bench = true;
+		else names.push_back(arg);
+	}
+
+	int							run = 0, failed = 0;
+	const std::vector<ds::test::Entry>&	cases = ds::test::get_cases();
+	for (auto it=cases.begin(), end=cases.end(); it!=end; ++it) {
+		if (it->mBenchmark != bench) continue;
+		if (!names.empty()) {
+			const std::string	n(it->mName);
+			bool				found = false;
+			for (auto nit=names.begin(), nend=names.end(); nit!=nend && !found; ++nit) found = (n.find(*nit) != std::string::npos);
+			if (!found) continue;
+		}
+
+		++run;
+		std::cout << (bench ? "[bench] " : "[ run ] ") << it->mName << std::endl;
+		try {
+			it->mFn();
+			if (!bench) std::cout << "[  ok ] " << it->mName << std::endl;
+		} catch (ds::test::Failure const& f) {
+			++failed;
+			std::cout << "[ FAIL] " << it->mName << ": " << f.mWhat << std::endl;
+		} catch (std::exception const& ex) {
+			++failed;
+			std::cout << "[ FAIL] " << it->mName << ": exception " << ex.what() << std::endl;
+		}
+	}
+	std::cout << run << " run, " << failed << " failed" << std::endl;
+	return failed;
+}
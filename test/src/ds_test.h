@@ -0,0 +1,71 @@
+#pragma once
+#ifndef DS_TEST_DSTEST_H_
+#define DS_TEST_DSTEST_H_
+
+#include <functional>
+#include <sstream>
+#include <string>
+
+namespace ds {
+namespace test {
+
+/**
+ * \class ds::test::Case
+ * \brief A test or benchmark, registered statically through DS_TEST() or
+ * DS_BENCHMARK() and run by the ds_tests console app. Nothing here opens a
+ * window or a GL context. A test stops at its first failed check. Benchmarks
+ * only run when asked for (--bench), and print their timings via report().
+ */
+class Case {
+public:
+	Case(const char* name, void (*fn)(), const bool benchmark);
+};
+
+/**
+ * \class ds::test::Failure
+ * \brief Thrown by a failed check to end the test.
+ */
+class Failure {
+public:
+	Failure(const std::string& what);
+	std::string				mWhat;
+};
+
+/**
+ * \class ds::test::TempFile
+ * \brief A path in the system temp folder, removed when I go away.
+ */
+class TempFile {
+public:
+	TempFile(const std::string& name);
+	~TempFile();
+
+	const std::string&		getPath() const;
+
+private:
+	TempFile(const TempFile&);
+	TempFile&				operator=(const TempFile&);
+
+	std::string				mPath;
+};
+
+void						fail(const char* file, const int line, const std::string& what);
+// Answer the best time of a few runs of fn, in milliseconds.
+double						time_ms(const std::function<void(void)>& fn, const int runs = 5);
+// Print one benchmark result.
+void						report(const std::string& name, const double ms, const std::string& note = "");
+
+} // namespace test
+} // namespace ds
+
+#define DS_TEST(name)			static void ds_test_##name(); \
+								static ds::test::Case ds_test_case_##name(#name, &ds_test_##name, false); \
+								static void ds_test_##name()
+#define DS_BENCHMARK(name)		static void ds_bench_##name(); \
+								static ds::test::Case ds_bench_case_##name(#name, &ds_bench_##name, true); \
+								static void ds_bench_##name()
+
+#define DS_CHECK(exp)			{ if (!(exp)) ds::test::fail(__FILE__, __LINE__, #exp); }
+#define DS_CHECK_EQUAL(a, b)	{ if (!((a) == (b))) { std::stringstream buf; buf << #a << " == " << #b << " (" << (a) << " vs " << (b) << ")"; ds::test::fail(__FILE__, __LINE__, buf.str()); } }
+
+#endif // DS_TEST_DSTEST_H_
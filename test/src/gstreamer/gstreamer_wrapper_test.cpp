@@ -0,0 +1,145 @@
+#include "ds_test.h"
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "gstreamer/gstreamer_wrapper.h"
+
+using namespace gstwrapper;
+
+namespace {
+// Pump the bus until done() or the timeout, so EOS and state changes get handled
+bool						pump(GStreamerWrapper& gst, const std::function<bool(void)>& done, const int timeout_ms = 5000) {
+	const auto				end = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+	while (std::chrono::steady_clock::now() < end) {
+		gst.update();
+		if (done()) return true;
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	return false;
+}
+
+void						sleep_pumping(GStreamerWrapper& gst, const int ms) {
+	pump(gst, []() { return false; }, ms);
+}
+
+size_t						frame_bytes(const int colorSpace, const int w, const int h) {
+	GStreamerWrapper::VideoPlane	planes[3];
+	size_t					bytes = 0;
+	GStreamerWrapper::getVideoPlanes(colorSpace, w, h, planes, &bytes);
+	return bytes;
+}
+}
+
+DS_TEST(gst_plane_layout_matches_gstreamer) {
+	gst_init(NULL, NULL);
+	const int				sizes[][2] = { { 64, 48 }, { 68, 50 }, { 100, 75 }, { 36, 21 }, { 1920, 1080 } };
+	const int				spaces[] = { GStreamerWrapper::kColorSpaceTransparent, GStreamerWrapper::kColorSpaceSolid, GStreamerWrapper::kColorSpaceI420 };
+	const GstVideoFormat	formats[] = { GST_VIDEO_FORMAT_BGRA, GST_VIDEO_FORMAT_BGR, GST_VIDEO_FORMAT_I420 };
+	for (int s=0; s<5; ++s) {
+		for (int c=0; c<3; ++c) {
+			GstVideoInfo	info;
+			gst_video_info_init(&info);
+			gst_video_info_set_format(&info, formats[c], sizes[s][0], sizes[s][1]);
+
+			GStreamerWrapper::VideoPlane	planes[3];
+			size_t			bytes = 0;
+			const int		count = GStreamerWrapper::getVideoPlanes(spaces[c], sizes[s][0], sizes[s][1], planes, &bytes);
+			DS_CHECK_EQUAL(count, static_cast<int>(GST_VIDEO_INFO_N_PLANES(&info)));
+			DS_CHECK_EQUAL(bytes, GST_VIDEO_INFO_SIZE(&info));
+			for (int p=0; p<count; ++p) {
+				DS_CHECK_EQUAL(planes[p].m_Offset, GST_VIDEO_INFO_PLANE_OFFSET(&info, p));
+				DS_CHECK_EQUAL(planes[p].m_Stride, GST_VIDEO_INFO_PLANE_STRIDE(&info, p));
+				DS_CHECK_EQUAL(planes[p].m_Width, GST_VIDEO_INFO_COMP_WIDTH(&info, p));
+				DS_CHECK_EQUAL(planes[p].m_Height, GST_VIDEO_INFO_COMP_HEIGHT(&info, p));
+			}
+		}
+	}
+}
+
+DS_TEST(gst_pipeline_delivers_every_frame) {
+	GStreamerWrapper		gst;
+	bool					complete = false;
+	DS_CHECK(gst.openPipeline("videotestsrc num-buffers=30", GStreamerWrapper::kColorSpaceTransparent, 64, 48));
+	gst.setLoopMode(NO_LOOP);
+	gst.setVideoCompleteCallback([&complete](GStreamerWrapper*) { complete = true; });
+
+	const size_t			expected = frame_bytes(GStreamerWrapper::kColorSpaceTransparent, 64, 48);
+	bool					sizes_ok = true;
+	auto					lock_one = [&gst, &sizes_ok, expected]() {
+		int					size = 0;
+		if (gst.lockVideoFrame(&size) && static_cast<size_t>(size) != expected) sizes_ok = false;
+		gst.unlockVideoFrame();
+	};
+	DS_CHECK(pump(gst, [&complete, &lock_one]() { lock_one(); return complete; }));
+	lock_one();
+	DS_CHECK(sizes_ok);
+
+	// Every buffer is either locked or replaced; the preroll can add one more
+	const int				seen = gst.getDeliveredFrames() + gst.getDroppedFrames();
+	DS_CHECK(seen >= 30 && seen <= 31);
+}
+
+DS_TEST(gst_locked_frame_outlives_newer_frames) {
+	GStreamerWrapper		gst;
+	DS_CHECK(gst.openPipeline("videotestsrc pattern=ball", GStreamerWrapper::kColorSpaceTransparent, 64, 48));
+
+	int						size = 0;
+	const unsigned char*	frame = NULL;
+	DS_CHECK(pump(gst, [&gst, &frame, &size]() { frame = gst.lockVideoFrame(&size); return frame != NULL; }));
+	const std::vector<unsigned char>	copy(frame, frame + size);
+
+	// Newer frames queue as pending while this one stays mapped and untouched
+	const int				delivered = gst.getDeliveredFrames();
+	sleep_pumping(gst, 300);
+	DS_CHECK(gst.isNewVideoFrame());
+	DS_CHECK(memcmp(frame, copy.data(), copy.size()) == 0);
+	DS_CHECK_EQUAL(gst.getDeliveredFrames(), delivered);
+
+	// The ball has moved on in the newest one
+	int						next_size = 0;
+	const unsigned char*	next = gst.lockVideoFrame(&next_size);
+	DS_CHECK(next != NULL);
+	DS_CHECK_EQUAL(next_size, size);
+	DS_CHECK(memcmp(next, copy.data(), copy.size()) != 0);
+	gst.unlockVideoFrame();
+}
+
+DS_TEST(gst_slow_consumer_drops_frames) {
+	GStreamerWrapper		gst;
+	DS_CHECK(gst.openPipeline("videotestsrc", GStreamerWrapper::kColorSpaceSolid, 64, 48));
+	DS_CHECK(pump(gst, [&gst]() { return gst.getDroppedFrames() > 0; }));
+
+	// Nothing was locked, so nothing was delivered
+	DS_CHECK_EQUAL(gst.getDeliveredFrames(), 0);
+	DS_CHECK(pump(gst, [&gst]() { return gst.lockVideoFrame() != NULL; }));
+	gst.unlockVideoFrame();
+	DS_CHECK_EQUAL(gst.getDeliveredFrames(), 1);
+	DS_CHECK(gst.getFrameLatencyMs() > 0.0);
+}
+
+DS_TEST(gst_i420_planes_hold_flat_color) {
+	// 68 wide gives 34 byte chroma rows, padded to 36, which the upload has to skip
+	const int				w = 68, h = 50;
+	GStreamerWrapper		gst;
+	DS_CHECK(gst.openPipeline("videotestsrc pattern=white", GStreamerWrapper::kColorSpaceI420, w, h));
+
+	int						size = 0;
+	const unsigned char*	frame = NULL;
+	DS_CHECK(pump(gst, [&gst, &frame, &size]() { frame = gst.lockVideoFrame(&size); return frame != NULL; }));
+
+	GStreamerWrapper::VideoPlane	planes[3];
+	size_t					bytes = 0;
+	DS_CHECK_EQUAL(GStreamerWrapper::getVideoPlanes(GStreamerWrapper::kColorSpaceI420, w, h, planes, &bytes), 3);
+	DS_CHECK_EQUAL(static_cast<size_t>(size), bytes);
+	const int				values[] = { 235, 128, 128 };
+	for (int p=0; p<3; ++p) {
+		for (int y=0; y<planes[p].m_Height; ++y) {
+			const unsigned char*	row = frame + planes[p].m_Offset + y * planes[p].m_Stride;
+			for (int x=0; x<planes[p].m_Width; ++x) DS_CHECK_EQUAL(static_cast<int>(row[x]), values[p]);
+		}
+	}
+	gst.unlockVideoFrame();
+}
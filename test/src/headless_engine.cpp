@@ -0,0 +1,111 @@
+#include "headless_engine.h"
+
+#include <stdexcept>
+#include "ds/params/camera_params.h"
+#include "ds/ui/sprite/sprite.h"
+
+namespace ds {
+namespace test {
+
+/**
+ * \class ds::test::HeadlessEngine
+ */
+HeadlessEngine::HeadlessEngine(ds::EngineData& ed)
+		: ds::ui::SpriteEngine(ed)
+		, mNextId(ds::EMPTY_SPRITE_ID)
+		, mUniqueColor(0, 0, 0)
+		, mElapsedTime(0.0)
+		, mIdleTracker(*this)
+		, mTimeline(ci::Timeline::create())
+		, mTweenline(*mTimeline)
+		, mLoadImageService(mLoadImageThread, mIpFunctions)
+		, mRenderTextService(mRenderTextThread)
+		, mRoot(nullptr) {
+	// The service threads run, so nothing waiting on them blocks, but never touch GL
+	mLoadImageThread.start(false);
+	mRenderTextThread.start(false);
+	mRoot = new ds::ui::Sprite(*this);
+}
+
+HeadlessEngine::~HeadlessEngine() {
+	if (mRoot) mRoot->release();
+	mRoot = nullptr;
+}
+
+ds::ui::Sprite& HeadlessEngine::getRootSprite() {
+	return *mRoot;
+}
+
+ds::EventNotifier& HeadlessEngine::getChannel(const std::string& name) {
+	if (name.empty()) throw std::runtime_error("HeadlessEngine::getChannel() on empty name");
+	return mChannels[name];
+}
+
+ds::AutoUpdateList& HeadlessEngine::getAutoUpdateList(const int mask) {
+	if ((mask&AutoUpdateType::SERVER) != 0) return mAutoUpdateServer;
+	if ((mask&AutoUpdateType::CLIENT) != 0) return mAutoUpdateClient;
+	throw std::runtime_error("HeadlessEngine::getAutoUpdateList() on illegal param");
+}
+
+ds::sprite_id_t HeadlessEngine::nextSpriteId() {
+	return ++mNextId;
+}
+
+void HeadlessEngine::registerSprite(ds::ui::Sprite& s) {
+	if (s.getId() == ds::EMPTY_SPRITE_ID) return;
+	mSprites[s.getId()] = &s;
+}
+
+void HeadlessEngine::unregisterSprite(ds::ui::Sprite& s) {
+	mSprites.erase(s.getId());
+}
+
+ds::ui::Sprite* HeadlessEngine::findSprite(const ds::sprite_id_t id) {
+	auto it = mSprites.find(id);
+	if (it == mSprites.end()) return nullptr;
+	return it->second;
+}
+
+ci::Color8u HeadlessEngine::getUniqueColor() {
+	int32_t			i = (mUniqueColor.r << 16) | (mUniqueColor.g << 8) | mUniqueColor.b;
+	++i;
+	mUniqueColor.r = (i>>16)&0xff;
+	mUniqueColor.g = (i>>8)&0xff;
+	mUniqueColor.b = (i)&0xff;
+	return mUniqueColor;
+}
+
+ds::PerspCameraParams HeadlessEngine::getPerspectiveCamera(const size_t) const {
+	throw std::runtime_error("HeadlessEngine has no cameras");
+}
+
+const ci::CameraPersp& HeadlessEngine::getPerspectiveCameraRef(const size_t) const {
+	throw std::runtime_error("HeadlessEngine has no cameras");
+}
+
+void HeadlessEngine::setPerspectiveCamera(const size_t, const ds::PerspCameraParams&) {
+	throw std::runtime_error("HeadlessEngine has no cameras");
+}
+
+void HeadlessEngine::setPerspectiveCameraRef(const size_t, const ci::CameraPersp&) {
+	throw std::runtime_error("HeadlessEngine has no cameras");
+}
+
+float HeadlessEngine::getOrthoFarPlane(const size_t) const {
+	throw std::runtime_error("HeadlessEngine has no cameras");
+}
+
+float HeadlessEngine::getOrthoNearPlane(const size_t) const {
+	throw std::runtime_error("HeadlessEngine has no cameras");
+}
+
+void HeadlessEngine::setOrthoViewPlanes(const size_t, const float, const float) {
+	throw std::runtime_error("HeadlessEngine has no cameras");
+}
+
+ds::ui::Sprite* HeadlessEngine::getHit(const ci::Vec3f& point) {
+	return mRoot ? mRoot->getHit(point) : nullptr;
+}
+
+} // namespace test
+} // namespace ds
@@ -0,0 +1,121 @@
+#pragma once
+#ifndef DS_TEST_HEADLESSENGINE_H_
+#define DS_TEST_HEADLESSENGINE_H_
+
+#include <string>
+#include <unordered_map>
+#include <cinder/Timeline.h>
+#include "ds/app/auto_update_list.h"
+#include "ds/app/event_notifier.h"
+#include "ds/app/image_registry.h"
+#include "ds/cfg/settings.h"
+#include "ds/data/font_list.h"
+#include "ds/data/resource_list.h"
+#include "ds/thread/gl_thread.h"
+#include "ds/thread/work_manager.h"
+#include "ds/ui/ip/ip_function_list.h"
+#include "ds/ui/service/load_image_service.h"
+#include "ds/ui/service/render_text_service.h"
+#include "ds/ui/sprite/idle_tracker.h"
+#include "ds/ui/sprite/sprite_engine.h"
+#include "ds/ui/sprite/text_layout_cache.h"
+#include "ds/ui/tween/tweenline.h"
+
+namespace ds {
+class EngineData;
+
+namespace test {
+
+/**
+ * \class ds::test::HeadlessEngine
+ * \brief A SpriteEngine with no app, window or GL context, for running the
+ * sprite update, serialize and hit test paths from a console. Sprites are
+ * registered and found as they are in ds::Engine. The image and text
+ * services exist so those sprites can be built, but their threads make no
+ * GL calls, so nothing is ever rendered. There are no cameras or touches.
+ */
+class HeadlessEngine : public ds::ui::SpriteEngine {
+public:
+	// The data must outlive me, as it does for ds::Engine.
+	HeadlessEngine(ds::EngineData&);
+	~HeadlessEngine();
+
+	// Everything built for a run goes under here
+	ds::ui::Sprite&						getRootSprite();
+
+	virtual ds::EventNotifier&			getChannel(const std::string&);
+	virtual ds::WorkManager&			getWorkManager()		{ return mWorkManager; }
+	virtual ds::ResourceList&			getResources()			{ return mResources; }
+	virtual const ds::FontList&			getFonts() const		{ return mFonts; }
+	virtual ds::AutoUpdateList&			getAutoUpdateList(const int = AutoUpdateType::SERVER);
+	virtual ds::ui::LoadImageService&	getLoadImageService()	{ return mLoadImageService; }
+	virtual ds::ui::RenderTextService&	getRenderTextService()	{ return mRenderTextService; }
+	virtual ds::ImageRegistry&			getImageRegistry()		{ return mImageRegistry; }
+	virtual ds::ui::Tweenline&			getTweenline()			{ return mTweenline; }
+	virtual ds::ui::IdleTracker&		getIdleTracker()		{ return mIdleTracker; }
+	virtual ds::ui::TextLayoutCache&	getTextLayoutCache()	{ return mTextLayoutCache; }
+	virtual const ds::cfg::Settings&	getDebugSettings()		{ return mDebugSettings; }
+	virtual ci::app::WindowRef			getWindow()				{ return ci::app::WindowRef(); }
+
+	// There's no app clock; time only moves when a test says so.
+	virtual double						getElapsedTimeSeconds() const	{ return mElapsedTime; }
+	void								setElapsedTimeSeconds(const double t)	{ mElapsedTime = t; }
+
+	virtual ds::sprite_id_t				nextSpriteId();
+	virtual void						registerSprite(ds::ui::Sprite&);
+	virtual void						unregisterSprite(ds::ui::Sprite&);
+	virtual ds::ui::Sprite*				findSprite(const ds::sprite_id_t);
+	virtual void						spriteDeleted(const ds::sprite_id_t&) { }
+	virtual ci::Color8u					getUniqueColor();
+
+	// There are no cameras; these all throw.
+	virtual ds::PerspCameraParams		getPerspectiveCamera(const size_t index) const;
+	virtual const ci::CameraPersp&		getPerspectiveCameraRef(const size_t index) const;
+	virtual void						setPerspectiveCamera(const size_t index, const ds::PerspCameraParams&);
+	virtual void						setPerspectiveCameraRef(const size_t index, const ci::CameraPersp&);
+	virtual float						getOrthoFarPlane(const size_t index) const;
+	virtual float						getOrthoNearPlane(const size_t index) const;
+	virtual void						setOrthoViewPlanes(const size_t index, const float nearPlane, const float farPlane);
+
+	virtual void						setSpriteForFinger(const int, ds::ui::Sprite*) { }
+	virtual ds::ui::Sprite*				getSpriteForFinger(const int) { return nullptr; }
+	virtual void						translateTouchPoint(ci::Vec2f&) { }
+	virtual bool						getRotateTouchesDefault() { return false; }
+	virtual ds::ui::Sprite*				getHit(const ci::Vec3f& point);
+	virtual int							getMode() const { return STANDALONE_MODE; }
+
+private:
+	HeadlessEngine(const HeadlessEngine&);
+	HeadlessEngine&						operator=(const HeadlessEngine&);
+
+	// Ahead of everything that can hold a sprite
+	std::unordered_map<ds::sprite_id_t, ds::ui::Sprite*>
+										mSprites;
+	ds::sprite_id_t						mNextId;
+	ci::Color8u							mUniqueColor;
+	double								mElapsedTime;
+	std::unordered_map<std::string, ds::EventNotifier>
+										mChannels;
+	ds::cfg::Settings					mDebugSettings;
+	ds::ui::IdleTracker					mIdleTracker;
+	ds::ui::TextLayoutCache				mTextLayoutCache;
+	ds::ResourceList					mResources;
+	ds::FontList						mFonts;
+	ds::AutoUpdateList					mAutoUpdateServer,
+										mAutoUpdateClient;
+	ds::ImageRegistry					mImageRegistry;
+	ci::TimelineRef						mTimeline;
+	ds::ui::Tweenline					mTweenline;
+	ds::WorkManager						mWorkManager;
+	ds::ui::ip::FunctionList			mIpFunctions;
+	ds::GlThread						mLoadImageThread;
+	ds::ui::LoadImageService			mLoadImageService;
+	ds::GlThread						mRenderTextThread;
+	ds::ui::RenderTextService			mRenderTextService;
+	ds::ui::Sprite*						mRoot;
+};
+
+} // namespace test
+} // namespace ds
+
+#endif // DS_TEST_HEADLESSENGINE_H_
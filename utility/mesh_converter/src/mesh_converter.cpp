@@ -0,0 +1,39 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <Poco/Path.h>
+#include "ds/ui/mesh_source/mesh_data.h"
+
+/* Usage: mesh_converter [-o output] input...
+ * Rewrites mesh files, in the old 0x1ee7ed format or the current one, in
+ * the current ds::ui::MeshData format. Each input is written beside itself
+ * with a .ds3d extension, unless a single input is given an output with -o.
+ * Answers the number of files that couldn't be converted.
+ ******************************************************************/
+int main(int argc, char* argv[]) {
+	std::string					output;
+	std::vector<std::string>	inputs;
+	for (int k=1; k<argc; ++k) {
+		const std::string		arg(argv[k]);
+		if (arg == "-o" && k + 1 < argc) output = argv[++k];
+		else inputs.push_back(arg);
+	}
+	if (inputs.empty() || (!output.empty() && inputs.size() > 1)) {
+		std::cerr << "Usage: mesh_converter [-o output] input..." << std::endl;
+		return 1;
+	}
+
+	int							failed = 0;
+	for (auto it=inputs.begin(), end=inputs.end(); it!=end; ++it) {
+		std::string				dst(output);
+		if (dst.empty()) dst = Poco::Path(*it).setExtension("ds3d").toString();
+		// Converting in place goes through a temp file, so the source is never half written
+		if (ds::ui::MeshData::convert(*it, dst)) {
+			std::cout << *it << " -> " << dst << std::endl;
+		} else {
+			++failed;
+			std::cerr << "Can't convert " << *it << std::endl;
+		}
+	}
+	return failed;
+}